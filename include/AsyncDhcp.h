@@ -0,0 +1,88 @@
+/**
+ * Non-blocking DHCP client for the W5500.
+ * Ethernet.begin(mac) blocks for up to a minute while it waits for a DHCP
+ * server. This client sends the same DISCOVER/REQUEST messages over a UDP
+ * socket but is driven from loop(), so the display keeps running while the
+ * network comes up. It also renews the lease, which Ethernet.maintain() no
+ * longer does once the interface was started with a static address.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Ethernet_Generic.hpp>
+
+/// @brief Largest DHCP message handled (RFC 2131 minimum MTU payload)
+const size_t DHCP_PACKET_SIZE = 548;
+
+class AsyncDhcp {
+public:
+  enum class State {
+    IDLE,        // Not started
+    DISCOVERING, // DISCOVER sent, waiting for an OFFER
+    REQUESTING,  // REQUEST sent (new lease or renewal), waiting for an ACK
+    BOUND,       // Lease held
+    FAILED       // No usable answer before the timeout
+  };
+
+  AsyncDhcp();
+
+  /// @brief Start acquiring a new lease
+  /// @param mac MAC address (6 bytes)
+  /// @param timeoutMs Time before giving up (state becomes FAILED)
+  void begin(const uint8_t mac[6], unsigned long timeoutMs = 10000);
+
+  /// @brief Renew the current lease (REQUEST for the bound address)
+  /// @param timeoutMs Time before giving up (state becomes FAILED)
+  void renew(unsigned long timeoutMs = 10000);
+
+  /// @brief Stop and release the UDP socket
+  void stop();
+
+  /// @brief Send/receive as needed (call from loop, never blocks)
+  /// @return Current state
+  State poll();
+
+  /// @brief Get the current state
+  State getState() const { return _state; }
+
+  /// @brief Check if half the lease has passed and it should be renewed
+  bool renewalDue() const;
+
+  /// @brief Check if the lease has run out
+  bool leaseExpired() const;
+
+  IPAddress getLocalIP() const { return _localIP; }
+  IPAddress getSubnetMask() const { return _subnetMask; }
+  IPAddress getGatewayIP() const { return _gatewayIP; }
+  IPAddress getDnsServerIP() const { return _dnsServerIP; }
+
+  /// @brief Get the lease time in seconds
+  uint32_t getLeaseTime() const { return _leaseSeconds; }
+
+private:
+  EthernetUDP _udp;
+  bool _udpOpen;
+  uint8_t _mac[6];
+  uint32_t _xid;
+  State _state;
+
+  unsigned long _startMs;    // Start of the current exchange
+  unsigned long _timeoutMs;  // Give up after this long
+  unsigned long _lastSendMs; // Last (re)transmission
+  unsigned long _retryMs;    // Current retransmission interval
+  unsigned long _leaseStartMs;
+  uint32_t _leaseSeconds;
+
+  IPAddress _localIP;
+  IPAddress _subnetMask;
+  IPAddress _gatewayIP;
+  IPAddress _dnsServerIP;
+  IPAddress _serverId; // Server that made the offer
+
+  uint8_t _packet[DHCP_PACKET_SIZE];
+
+  void start(State state, unsigned long timeoutMs);
+  bool send(uint8_t messageType);
+  uint8_t receive(); // Returns the DHCP message type, 0 if none/not ours
+};
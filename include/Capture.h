@@ -0,0 +1,114 @@
+/**
+ * Capture - Record and replay of WebSocket traffic for Arena Timer
+ * While enabled, every frame WebSocketClient receives is stored with its
+ * arrival time in a compact binary log on LittleFS, so field issues (e.g.
+ * a FightTimer burst at round end) can be downloaded and reproduced. Frames
+ * are staged in RAM and written while the timer is idle (or once they have
+ * waited too long); the log is a ring of two files, the older one dropped
+ * when the newer one fills.
+ *
+ * A capture can be replayed into the client, in real time or as fast as
+ * possible, from loop() a few frames at a time; the replay reports the
+ * per-frame processing cost and leaves the resulting timer state to
+ * inspect.
+ *
+ * Download format (little-endian): FileHeader, then for each frame a
+ * FrameHeader followed by `length` payload bytes.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace Capture {
+/// @brief Download identifier ("ATCP" little-endian)
+const uint32_t MAGIC = 0x50435441;
+const uint16_t VERSION = 1;
+
+/// @brief Payload bytes kept per frame (longer frames are truncated)
+const size_t MAX_FRAME = 1024;
+
+/// @brief RAM staging buffer
+const size_t BUFFER_SIZE = 4096;
+
+/// @brief Size at which the current file becomes the old one
+const size_t FILE_LIMIT = 32768;
+
+struct FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t frameHeaderSize; // sizeof(FrameHeader)
+};
+
+struct FrameHeader {
+  uint32_t timeMs; // millis() on arrival
+  uint16_t length; // Payload bytes that follow
+  uint8_t type;    // WStype_t
+  uint8_t flags;
+};
+
+/// @brief Frame flags
+const uint8_t FLAG_TRUNCATED = 1 << 0; // Payload cut to MAX_FRAME
+
+struct Stats {
+  uint32_t frames;       // Frames captured
+  uint32_t truncated;    // Frames cut to MAX_FRAME
+  uint32_t dropped;      // Frames lost because the RAM buffer was full
+  uint32_t flushes;      // Buffer writes to flash
+  uint32_t failedWrites; // Short flash writes (buffer lost, capture stopped)
+  uint32_t maxFlushUs;
+};
+
+struct ReplayStats {
+  bool active;
+  bool realtime;
+  uint32_t frames;     // Frames handed to the client
+  uint32_t totalUs;    // Time spent processing them
+  uint32_t maxUs;      // Slowest frame
+  uint32_t durationMs; // Wall time of the replay
+};
+
+/// @brief Receives replayed frames
+typedef void (*FrameHandler)(uint8_t type, const uint8_t *payload,
+                             size_t length);
+
+/// @brief Start or stop capturing
+void setEnabled(bool enabled);
+
+bool isEnabled();
+
+/// @brief Store a received frame (cheap: copies into the RAM buffer)
+void record(uint8_t type, const uint8_t *payload, size_t length);
+
+/// @brief Write buffered frames to flash (call in loop). Writes wait for
+/// the timer to be idle unless the buffer is nearly full or the oldest
+/// frame has waited 10 s.
+/// @param idle true when a flash write won't disturb the display
+/// @return true if frames were written
+bool service(bool idle);
+
+/// @brief Delete the capture (files and buffer)
+void clear();
+
+/// @brief Bytes captured (on flash and buffered)
+size_t storedBytes();
+
+/// @brief Write the capture in download format
+void download(Print &out);
+
+const Stats &getStats();
+
+/// @brief Start replaying the capture (capture must be stopped)
+/// @param handler Receives each frame
+/// @param realtime true to keep the recorded spacing, false for as fast as
+/// possible
+/// @return false if capturing, already replaying or nothing captured
+bool startReplay(FrameHandler handler, bool realtime);
+
+void stopReplay();
+
+/// @brief Feed due frames to the handler (call in loop)
+void serviceReplay();
+
+const ReplayStats &getReplayStats();
+} // namespace Capture
@@ -0,0 +1,154 @@
+/**
+ * Config Store - Versioned binary configuration record for Arena Timer
+ * Holds display and WebSocket settings in one CRC-protected, fixed-layout
+ * record (/config.bin) that loads with a single read. Migrates the legacy
+ * /settings.json and EEPROM WebSocket blob, and converts to/from JSON only
+ * on demand.
+ */
+
+#pragma once
+
+#include "SettingsPersistence.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+
+namespace ConfigStore {
+/// @brief Record identifier ("ATCF" little-endian)
+const uint32_t MAGIC = 0x46435441;
+
+/// @brief Current record version. New fields are only ever appended; older
+/// records load with defaults for the fields they lack.
+const uint16_t VERSION = 5;
+
+const size_t MAX_THRESHOLDS = 10;
+const size_t HOST_SIZE = 101; // 100 chars + NUL (legacy EEPROM limit)
+const size_t PATH_SIZE = 101;
+const size_t MAX_WS_SPARES = 2; // Fallback servers after the primary
+
+/// @brief Longest timer duration the web UI can set (60:59)
+const uint32_t MAX_DURATION_SECONDS = 60 * 60 + 59;
+
+/// @brief Number of selectable fonts (ids 0 to FONT_COUNT - 1)
+const uint8_t FONT_COUNT = 19;
+
+/// @brief Letter spacing range offered by the web UI, in pixels
+const int8_t MIN_LETTER_SPACING = -2;
+const int8_t MAX_LETTER_SPACING = 5;
+
+/// @brief Deepest matrix bit depth (RefreshControl::MAX_BIT_DEPTH)
+const uint8_t MAX_BIT_DEPTH = 6;
+
+/// @brief Highest refresh target and broadcast rate accepted
+/// (RefreshControl::MAX_BROADCAST_HZ)
+const uint16_t MAX_REFRESH_HZ = 10000;
+
+/// @brief Which parts of the record hold saved values
+enum Section : uint8_t {
+  SECTION_DISPLAY = 1 << 0,   // Timer/display settings
+  SECTION_WEBSOCKET = 1 << 1, // WebSocket server (auto-connect on boot)
+};
+
+/// @brief Where the current configuration came from
+enum class Source { DEFAULTS, RECORD, LEGACY };
+
+struct Threshold {
+  uint32_t seconds;
+  uint8_t r, g, b;
+  uint8_t reserved;
+};
+
+/// @brief A WebSocket server to fail over to
+struct Upstream {
+  uint16_t port;
+  char host[HOST_SIZE];
+  char path[PATH_SIZE];
+};
+
+/// @brief On-flash record. The layout is the in-memory layout on the
+/// target; fields must only be appended (and VERSION bumped).
+struct Config {
+  // Header (not covered by the CRC)
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size; // Record size in bytes as written, header included
+  uint32_t crc;  // CRC-32 of the bytes following the header
+
+  // Version 1
+  uint8_t sections; // Bitwise OR of Section flags
+  uint8_t fontId;
+  int8_t letterSpacing;
+  uint8_t brightness;
+  uint32_t durationSeconds;
+  uint8_t defaultR, defaultG, defaultB;
+  uint8_t thresholdCount;
+  Threshold thresholds[MAX_THRESHOLDS];
+  uint16_t wsPort;
+  char wsHost[HOST_SIZE];
+  char wsPath[PATH_SIZE];
+
+  // Version 2
+  uint8_t wsSpareCount;
+  uint8_t reserved2[3];
+  Upstream wsSpares[MAX_WS_SPARES]; // In order of preference
+
+  // Version 3
+  uint8_t bitDepth; // Matrix bitplanes (1-6), 0 = auto
+  uint8_t reserved3;
+  uint16_t refreshTargetHz; // Refresh rate the auto bit depth sustains
+
+  // Version 4
+  uint8_t broadcast; // Camera-safe high refresh mode (0/1)
+  uint8_t reserved4;
+  uint16_t broadcastHz; // Refresh rate in broadcast mode
+
+  // Version 5
+  uint8_t rotation; // Display rotation, quarter turns clockwise (0-3)
+  uint8_t reserved5[3];
+};
+
+/// @brief Size of the record header
+const size_t HEADER_SIZE = offsetof(Config, sections);
+
+/// @brief Get the current configuration (edit in place, then scheduleSave)
+Config &get();
+
+/// @brief Load the configuration: /config.bin if valid, otherwise migrate
+/// the legacy formats, otherwise defaults
+/// @return true if saved settings (record or legacy) were found
+bool load();
+
+/// @brief Get where the current configuration was loaded from
+Source getSource();
+
+/// @brief Reset a record to defaults
+void setDefaults(Config &config);
+
+/// @brief Schedule a debounced, atomic save of the current configuration
+void scheduleSave();
+
+/// @brief Save the current configuration immediately
+/// @return true on success
+bool saveNow();
+
+/// @brief Write a scheduled save once changes settled (call in loop)
+/// @param idle true when a flash write won't disturb the display
+/// @return true if a save completed
+bool service(bool idle);
+
+/// @brief Get the persistence layer (for statistics)
+const SettingsPersistence &getPersistence();
+
+/// @brief Export the configuration as JSON
+void toJson(JsonDocument &doc);
+
+/// @brief Import any subset of the exported JSON fields
+///
+/// Numbers are clamped to the ranges the web UI accepts. Fields of the wrong
+/// type, unknown font ids, malformed colors and out-of-range ports leave the
+/// record unchanged and are named in rejected.
+/// @param doc Parsed JSON document
+/// @param rejected Array to add the names of refused fields to (optional)
+/// @return Bitwise OR of the Section flags that were changed
+uint8_t fromJson(const JsonDocument &doc, JsonArray rejected = JsonArray());
+} // namespace ConfigStore
@@ -0,0 +1,80 @@
+/**
+ * Non-blocking DNS lookup for the W5500.
+ * The Ethernet library's DNSClient (and so EthernetClient::connect() with a
+ * host name) waits for the answer in a loop. This sends the same A query
+ * over a UDP socket and only checks for the answer on each poll(), so a
+ * server configured by name can be resolved from loop() and then probed
+ * like one given by address.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Ethernet_Generic.hpp>
+
+/// @brief Largest DNS message handled (RFC 1035 UDP limit)
+const size_t DNS_PACKET_SIZE = 512;
+
+/// @brief Largest query: header, a name of up to 255 bytes, type and class
+const size_t DNS_QUERY_SIZE = 12 + 256 + 4;
+
+class DnsLookup {
+public:
+  enum class State {
+    IDLE,      // Not started
+    RESOLVING, // Query sent, waiting for the answer
+    RESOLVED,  // Address known
+    FAILED     // Name unknown, or no answer before the timeout
+  };
+
+  DnsLookup();
+
+  /// @brief Start resolving a host name
+  /// @param name Host name
+  /// @param server DNS server address
+  /// @param timeoutMs Time before giving up (state becomes FAILED)
+  /// @return false if the name can't be queried (too long, no DNS server,
+  /// no free socket)
+  bool begin(const char *name, const IPAddress &server,
+             unsigned long timeoutMs);
+
+  /// @brief Check for the answer and retransmit (call from loop, never
+  /// blocks)
+  /// @return Current state
+  State poll();
+
+  /// @brief Stop and release the UDP socket
+  void stop();
+
+  /// @brief Get the current state
+  State getState() const { return _state; }
+
+  /// @brief Get the resolved address (valid once RESOLVED)
+  IPAddress getAddress() const { return _address; }
+
+  /// @brief Get how long the answer may be cached, in seconds
+  uint32_t getTtl() const { return _ttl; }
+
+  /// @brief Time from begin() to the answer
+  unsigned long getResolveTimeMs() const { return _resolveTimeMs; }
+
+private:
+  EthernetUDP _udp;
+  bool _udpOpen;
+  State _state;
+  uint16_t _id; // Query id, matched against the answer
+  IPAddress _server;
+  unsigned long _startMs;
+  unsigned long _timeoutMs;
+  unsigned long _lastSendMs;
+  unsigned long _resolveTimeMs;
+  IPAddress _address;
+  uint32_t _ttl;
+
+  uint8_t _query[DNS_QUERY_SIZE]; // Kept for retransmissions
+  size_t _queryLength;
+  uint8_t _packet[DNS_PACKET_SIZE];
+
+  bool send();
+  State receive(); // RESOLVING while nothing usable arrived
+};
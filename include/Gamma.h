@@ -0,0 +1,40 @@
+/**
+ * Gamma - Color correction for the matrix for Arena Timer
+ * LEDs are linear in their on-time, so UI colors sent straight through
+ * color565 look washed out, and once truncated to a few bitplanes nearby
+ * colors (orange and yellow) land on the same levels. Colors are instead
+ * gamma-corrected and rounded to the nearest level the current bit depth
+ * can show, from lookup tables built at compile time, one per bit depth.
+ *
+ * This is done when a color is set (or the bit depth changes), never per
+ * pixel or per frame. Brightness is applied by the matrix driver and isn't
+ * part of the color.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace Gamma {
+/// @brief Exponent from UI (sRGB-like) values to LED on-time
+constexpr float GAMMA = 2.2f;
+
+/// @brief Bit depths with a table (the matrix supports 1-6 bitplanes)
+const uint8_t MIN_DEPTH = 1;
+const uint8_t MAX_DEPTH = 6;
+
+/// @brief Gamma-correct one channel and quantise it to a bit depth
+/// @param value Channel value (0-255)
+/// @param depth Bits the channel is shown with (out of range is clamped)
+/// @return 8-bit value whose top `depth` bits hold the nearest level
+uint8_t correct(uint8_t value, uint8_t depth);
+
+/// @brief Convert a color for a matrix running at a bit depth. Red and blue
+/// have at most 5 bits in RGB565, green up to 6.
+/// @param r Red (0-255)
+/// @param g Green (0-255)
+/// @param b Blue (0-255)
+/// @param bitDepth Matrix bitplanes
+/// @return RGB565 color
+uint16_t color565(uint8_t r, uint8_t g, uint8_t b, uint8_t bitDepth);
+} // namespace Gamma
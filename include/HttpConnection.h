@@ -0,0 +1,203 @@
+/**
+ * Persistent (keep-alive) HTTP connections for the W5500 web server.
+ * Keeps a few client sockets open between requests and serves every
+ * complete request buffered on one, including pipelined ones. Header-only
+ * and templated on the client type, like the route table, so the
+ * connection policy can be exercised on a host.
+ */
+
+#pragma once
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "Log.h"
+#include <Arduino.h>
+
+/// @brief A fixed set of connection slots.
+///
+/// The W5500 only has 8 sockets and the WebSocket client needs one, so only
+/// a couple are kept open; each is recycled after an idle timeout or a fixed
+/// number of requests, and the least recently used one is dropped when a new
+/// client arrives with every slot busy.
+template <typename ClientT, uint8_t N> class HttpConnectionPool {
+public:
+  /// @brief Maximum time to wait for the rest of a started request before
+  /// answering 408
+  static const unsigned long REQUEST_TIMEOUT_MS = 1000;
+
+  /// @brief Idle time after which a kept-alive connection is closed
+  static const unsigned long KEEPALIVE_TIMEOUT_MS = 5000;
+
+  /// @brief Requests served on one connection before it is closed
+  static const uint16_t KEEPALIVE_MAX_REQUESTS = 32;
+
+  struct Connection {
+    char rxBuffer[HTTP_RX_BUFFER_SIZE];
+    HttpRequestReader reader;
+    ClientT client;
+    bool active;
+    uint16_t requests;          // Requests served on this connection
+    unsigned long lastActivity; // millis() of the last byte received or sent
+
+    Connection()
+        : reader(rxBuffer, sizeof(rxBuffer)), active(false), requests(0),
+          lastActivity(0) {}
+  };
+
+  /// @brief Attach a client with pending data to its existing slot, or a
+  /// free one (recycling the least recently used if none is free)
+  /// @param client Client returned by the server
+  /// @return The connection slot serving this client
+  Connection *accept(ClientT &client) {
+    unsigned long now = millis();
+    Connection *slot = nullptr;
+    Connection *oldest = nullptr;
+    for (uint8_t i = 0; i < N; i++) {
+      Connection &conn = _connections[i];
+      if (conn.active && conn.client == client) {
+        return &conn;
+      }
+      if (!conn.active && slot == nullptr) {
+        slot = &conn;
+      }
+      if (conn.active &&
+          (oldest == nullptr ||
+           now - conn.lastActivity > now - oldest->lastActivity)) {
+        oldest = &conn;
+      }
+    }
+
+    if (slot == nullptr) {
+      // All slots busy: recycle the least recently used connection
+      close(*oldest);
+      slot = oldest;
+    }
+
+    slot->client = client;
+    slot->reader.reset();
+    slot->active = true;
+    slot->requests = 0;
+    slot->lastActivity = now;
+    _connectionsOpened++;
+    return slot;
+  }
+
+  /// @brief Serve every complete request buffered on each open connection
+  /// @param txBuffer Staging buffer for responses
+  /// @param txSize Size of txBuffer in bytes
+  /// @param dispatch Called as dispatch(HttpRequest &, HttpResponseWriter &)
+  /// to answer one request
+  template <typename Dispatch>
+  void serviceAll(uint8_t *txBuffer, size_t txSize, Dispatch &&dispatch) {
+    for (uint8_t i = 0; i < N; i++) {
+      if (_connections[i].active) {
+        service(_connections[i], txBuffer, txSize, dispatch);
+      }
+    }
+  }
+
+  /// @brief Serve every complete request buffered on one connection, and
+  /// close it on error, timeout or when the response ends it
+  template <typename Dispatch>
+  void service(Connection &conn, uint8_t *txBuffer, size_t txSize,
+               Dispatch &&dispatch) {
+    HttpResponseWriter out(conn.client, txBuffer, txSize);
+    HttpRequest request;
+
+    while (conn.active) {
+      uint32_t bytesBefore = conn.reader.getBytesRead();
+      HttpRequestReader::Status status = conn.reader.poll(conn.client, request);
+      if (conn.reader.getBytesRead() != bytesBefore) {
+        conn.lastActivity = millis();
+      }
+
+      if (status == HttpRequestReader::Status::INCOMPLETE) {
+        unsigned long idle = millis() - conn.lastActivity;
+        if (!conn.client.connected()) {
+          close(conn);
+        } else if (conn.reader.hasPartial() && idle > REQUEST_TIMEOUT_MS) {
+          out.setKeepAlive(false); // May still be set from the last request
+          sendError(out, 408);
+          close(conn);
+        } else if (idle > KEEPALIVE_TIMEOUT_MS) {
+          close(conn);
+        }
+        return;
+      }
+
+      if (status != HttpRequestReader::Status::READY) {
+        int code = 400;
+        if (status == HttpRequestReader::Status::TOO_LARGE) {
+          code = 413;
+        } else if (status == HttpRequestReader::Status::UNSUPPORTED) {
+          code = 501;
+        }
+        LOG_WARN(Log::TAG_HTTP, "Request rejected: %u", code);
+        out.setKeepAlive(false);
+        sendError(out, code);
+        close(conn);
+        return;
+      }
+
+      conn.requests++;
+      _requestsServed++;
+      if (conn.requests > 1) {
+        _requestsReused++;
+      }
+      bool keepAlive =
+          request.keepAlive && conn.requests < KEEPALIVE_MAX_REQUESTS;
+      out.setKeepAlive(keepAlive);
+      out.setHttp11(request.http11);
+      dispatch(request, out);
+      conn.lastActivity = millis();
+
+      // The writer closes the connection itself for a body it had to end
+      // that way (HTTP/1.0) or for headers it couldn't send
+      if (!keepAlive || !out.getKeepAlive()) {
+        close(conn);
+        return;
+      }
+
+      // Keep any pipelined request that arrived behind this one
+      conn.reader.consume(request.length);
+    }
+  }
+
+  /// @brief Close a connection and free its slot
+  void close(Connection &conn) {
+    conn.client.stop();
+    conn.reader.reset();
+    conn.active = false;
+  }
+
+  /// @brief Number of connections currently open
+  uint8_t getOpenCount() const {
+    uint8_t open = 0;
+    for (uint8_t i = 0; i < N; i++) {
+      open += _connections[i].active;
+    }
+    return open;
+  }
+
+  /// @brief Connections accepted since boot (sockets opened by clients)
+  uint32_t getConnectionsOpened() const { return _connectionsOpened; }
+
+  /// @brief Requests answered since boot
+  uint32_t getRequestsServed() const { return _requestsServed; }
+
+  /// @brief Requests answered on an already-used connection
+  uint32_t getRequestsReused() const { return _requestsReused; }
+
+private:
+  Connection _connections[N];
+  uint32_t _connectionsOpened = 0;
+  uint32_t _requestsServed = 0;
+  uint32_t _requestsReused = 0;
+
+  static void sendError(HttpResponseWriter &out, int code) {
+    const char *text = HttpResponseWriter::statusText(code);
+    out.begin(code, "text/plain");
+    out.print(text);
+    out.end();
+  }
+};
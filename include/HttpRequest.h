@@ -0,0 +1,122 @@
+/**
+ * Zero-allocation HTTP request ingestion for the W5500 web server.
+ * Requests are pulled from the socket in blocks into a fixed buffer and
+ * parsed in place; all fields point into that buffer.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Size of the per-connection request buffer (request line, headers and
+// body must fit; anything larger is rejected with 413)
+#ifndef HTTP_RX_BUFFER_SIZE
+#define HTTP_RX_BUFFER_SIZE 2048
+#endif
+
+/// @brief A parsed request. All pointers reference the reader's buffer and
+/// are only valid until the reader is reset or the request is consumed.
+struct HttpRequest {
+  const char *method; // e.g. "GET" (NUL-terminated)
+  const char *path;   // Target without query string, e.g. "/api/status"
+  const char *query;  // Query string after '?', or "" if none
+  const char *body;   // Request body (NOT NUL-terminated)
+  size_t bodyLength;  // Length of body in bytes
+  size_t length;      // Total bytes of this request (headers + body)
+  bool keepAlive;     // Client allows the connection to stay open
+  bool http11;        // Client speaks HTTP/1.1 (accepts chunked responses)
+
+  /// @brief Look up a field in an application/x-www-form-urlencoded body
+  /// @param key Field name
+  /// @param out Destination for the URL-decoded value (NUL-terminated)
+  /// @param size Size of out in bytes
+  /// @return true if the field was present
+  bool formField(const char *key, char *out, size_t size) const;
+
+  /// @brief Look up a parameter in the query string
+  /// @param key Parameter name
+  /// @param out Destination for the URL-decoded value (NUL-terminated)
+  /// @param size Size of out in bytes
+  /// @return true if the parameter was present
+  bool queryParam(const char *key, char *out, size_t size) const;
+};
+
+class HttpRequestReader {
+public:
+  enum class Status {
+    INCOMPLETE, // Need more bytes from the client
+    READY,      // A complete request has been parsed
+    TOO_LARGE,  // Request (or its Content-Length) does not fit the buffer
+    MALFORMED,  // Request line or Content-Length could not be parsed
+    UNSUPPORTED // Body framing the server can't read (Transfer-Encoding)
+  };
+
+  /// @brief Construct a reader over a caller-provided buffer
+  /// @param buffer Receive buffer (must outlive the reader)
+  /// @param capacity Size of buffer in bytes
+  HttpRequestReader(char *buffer, size_t capacity);
+
+  /// @brief Discard all buffered data and start a new request
+  void reset();
+
+  /// @brief Drop a handled request from the buffer, keeping any bytes of a
+  /// pipelined request that followed it
+  /// @param length Request length (HttpRequest::length)
+  void consume(size_t length);
+
+  /// @brief Check whether any bytes of an unfinished request are buffered
+  bool hasPartial() const { return _length > 0; }
+
+  /// @brief Read whatever the client has available in block reads and try
+  /// to complete the current request
+  /// @param client Client to read from
+  /// @param request Filled in when READY is returned
+  /// @return Parse status
+  Status poll(Client &client, HttpRequest &request);
+
+  /// @brief Number of client.read() calls issued since construction
+  uint32_t getReadCalls() const { return _readCalls; }
+
+  /// @brief Number of bytes read since construction
+  uint32_t getBytesRead() const { return _bytesRead; }
+
+  /// @brief Decode a URL-encoded string ('%XX' escapes and '+' for space)
+  /// @param src Encoded input
+  /// @param length Length of input in bytes
+  /// @param out Destination (always NUL-terminated, truncated if needed)
+  /// @param size Size of out in bytes
+  /// @return Decoded length
+  static size_t urlDecode(const char *src, size_t length, char *out,
+                          size_t size);
+
+  /// @brief Find a key in a '&'-separated key=value list and decode it
+  /// @param data Start of the list
+  /// @param length Length of the list in bytes
+  /// @param key Key to look for
+  /// @param out Destination for the decoded value
+  /// @param size Size of out in bytes
+  /// @return true if the key was present
+  static bool findParam(const char *data, size_t length, const char *key,
+                        char *out, size_t size);
+
+private:
+  char *_buffer;
+  size_t _capacity;
+  size_t _length;        // Bytes currently in _buffer
+  size_t _headerEnd;     // Offset of body start, 0 while headers incomplete
+  size_t _scanPos;       // Where to resume the end-of-headers search
+  size_t _contentLength; // From Content-Length header
+  HttpRequest _pending;  // Parsed request line/headers awaiting the body
+
+  uint32_t _readCalls;
+  uint32_t _bytesRead;
+
+  /// @brief Search for the blank line ending the header block
+  /// @return Offset just past the blank line, or 0 if not found yet
+  size_t findHeaderEnd();
+
+  /// @brief Parse the request line and headers in place
+  /// @return READY if the request can be read, otherwise why it can't
+  Status parseHeaders();
+};
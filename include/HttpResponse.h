@@ -0,0 +1,117 @@
+/**
+ * Buffered HTTP response writer for the W5500 web server.
+ * Coalesces headers and body into a fixed TX buffer so each response goes
+ * out in as few socket writes (SPI bursts) as possible.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Size of the TX staging buffer. Matches the W5500's default per-socket TX
+// window (16 KB shared across 8 sockets) so one flush is one full burst.
+#ifndef HTTP_TX_BUFFER_SIZE
+#define HTTP_TX_BUFFER_SIZE 2048
+#endif
+
+class HttpResponseWriter : public Print {
+public:
+  /// @brief Bytes reserved at the front of the buffer for the status line,
+  /// headers and chunk-size prefix so they go out in the same write as data
+  static const size_t HEADER_RESERVE = 192;
+
+  /// @brief Construct a writer bound to a client
+  /// @param client Connected client to send the response to
+  /// @param buffer Staging buffer (must outlive the writer)
+  /// @param capacity Size of buffer in bytes (at least HEADER_RESERVE + 64)
+  HttpResponseWriter(Client &client, uint8_t *buffer, size_t capacity);
+
+  /// @brief Start a response. Headers are deferred until the first flush so
+  /// a body that fits in the buffer is sent with Content-Length; a larger
+  /// body is streamed with chunked transfer encoding (HTTP/1.1) or ended by
+  /// closing the connection (HTTP/1.0). Headers that don't fit in
+  /// HEADER_RESERVE are replaced by a bodyless 500 response.
+  /// @param code HTTP status code
+  /// @param contentType Value of the Content-Type header
+  void begin(int code, const char *contentType);
+
+  /// @brief Add one extra header line (without CRLF), e.g. "Allow: GET".
+  /// Must be called after begin() and before any data is flushed.
+  /// @param line Header line; must stay valid until the headers are sent
+  void setExtraHeader(const char *line);
+
+  /// @brief Choose the Connection header for subsequent responses
+  /// @param keepAlive true for "keep-alive", false for "close" (default)
+  void setKeepAlive(bool keepAlive) { _keepAlive = keepAlive; }
+
+  /// @brief Check whether the connection may stay open after the response
+  /// @return false if the writer had to close it (body ended by the close,
+  /// or headers too long to send)
+  bool getKeepAlive() const { return _keepAlive; }
+
+  /// @brief Set the client's protocol for subsequent responses
+  /// @param http11 true if the client accepts chunked encoding (HTTP/1.1,
+  /// the default), false for HTTP/1.0
+  void setHttp11(bool http11) { _http11 = http11; }
+
+  /// @brief Buffer a single byte of body data
+  size_t write(uint8_t c) override;
+
+  /// @brief Buffer a block of body data, flushing in full-buffer bursts
+  size_t write(const uint8_t *data, size_t size) override;
+  using Print::write;
+
+  /// @brief Finish the response: send headers (if not yet sent), remaining
+  /// body and, for chunked responses, the terminating chunk
+  void end();
+
+  /// @brief Number of client.write() calls issued for this response
+  uint32_t getWriteCount() const { return _writeCount; }
+
+  /// @brief Total bytes handed to the client (headers + framing + body)
+  uint32_t getByteCount() const { return _byteCount; }
+
+  /// @brief Body bytes written by the caller
+  uint32_t getBodyBytes() const { return _bodyBytes; }
+
+  /// @brief Get the standard reason phrase for a status code
+  /// @param code HTTP status code
+  /// @return Reason phrase (e.g. "Not Found")
+  static const char *statusText(int code);
+
+private:
+  Client &_client;
+  uint8_t *_buffer;
+  size_t _capacity;
+  size_t _pos; // Write position of body data within _buffer
+
+  int _code;
+  const char *_contentType;
+  const char *_extraHeader;
+  bool _headersSent;
+  bool _chunked;
+  bool _aborted; // Headers didn't fit: an error went out, body is dropped
+  bool _keepAlive;
+  bool _http11;
+
+  uint32_t _writeCount;
+  uint32_t _byteCount;
+  uint32_t _bodyBytes;
+
+  /// @brief Send buffered body data as one chunk (emitting headers first if
+  /// needed), optionally followed by the terminating zero-length chunk
+  /// @param last true to append the final "0\r\n\r\n"
+  void flushChunk(bool last);
+
+  /// @brief Format the status line and headers, or the error response if
+  /// they don't fit (setting _aborted)
+  /// @param out Destination buffer
+  /// @param size Size of destination
+  /// @param contentLength Body length, LENGTH_CHUNKED or LENGTH_UNTIL_CLOSE
+  /// @return Number of characters written
+  size_t formatHeaders(char *out, size_t size, long contentLength);
+
+  /// @brief Issue a single client write and update statistics
+  void send(const uint8_t *data, size_t size);
+};
@@ -0,0 +1,265 @@
+/**
+ * Compile-time HTTP route table.
+ * Routes are declared in a constexpr array that is checked for ordering at
+ * compile time; exact paths are found by binary search and patterns with
+ * {param} segments by a short linear pass. Header-only and free of Arduino
+ * dependencies so it can be built on a host.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Maximum number of {param} segments captured per route
+#ifndef HTTP_ROUTE_MAX_PARAMS
+#define HTTP_ROUTE_MAX_PARAMS 2
+#endif
+
+/// @brief Request methods as bit flags so a set of them fits in one byte
+enum HttpMethod : uint8_t {
+  HTTP_UNKNOWN = 0,
+  HTTP_GET = 1 << 0,
+  HTTP_POST = 1 << 1,
+  HTTP_PUT = 1 << 2,
+  HTTP_PATCH = 1 << 3,
+  HTTP_DELETE = 1 << 4,
+};
+
+/// @brief Convert a request method token to its flag
+/// @param method Method as sent by the client (e.g. "GET")
+/// @return Method flag, or HTTP_UNKNOWN
+inline HttpMethod httpMethodFromString(const char *method) {
+  if (strcmp(method, "GET") == 0)
+    return HTTP_GET;
+  if (strcmp(method, "POST") == 0)
+    return HTTP_POST;
+  if (strcmp(method, "PUT") == 0)
+    return HTTP_PUT;
+  if (strcmp(method, "PATCH") == 0)
+    return HTTP_PATCH;
+  if (strcmp(method, "DELETE") == 0)
+    return HTTP_DELETE;
+  return HTTP_UNKNOWN;
+}
+
+/// @brief Format an "Allow: ..." header line for a set of methods
+/// @param methods Bitwise OR of HttpMethod flags
+/// @param out Destination buffer
+/// @param size Size of out in bytes
+/// @return Length of the formatted line
+inline size_t formatAllowHeader(uint8_t methods, char *out, size_t size) {
+  static const char *const names[] = {"GET", "POST", "PUT", "PATCH", "DELETE"};
+  size_t len = 0;
+  const char *prefix = "Allow: ";
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if ((methods & (1 << i)) == 0) {
+      continue;
+    }
+    size_t need = strlen(prefix) + strlen(names[i]);
+    if (len + need + 1 > size) {
+      break;
+    }
+    memcpy(out + len, prefix, strlen(prefix));
+    len += strlen(prefix);
+    memcpy(out + len, names[i], strlen(names[i]));
+    len += strlen(names[i]);
+    prefix = ", ";
+  }
+  if (size > 0) {
+    out[len] = '\0';
+  }
+  return len;
+}
+
+/// @brief Values captured from {param} segments of a matched route. Values
+/// point into the request path and are not NUL-terminated.
+struct RouteParams {
+  const char *value[HTTP_ROUTE_MAX_PARAMS];
+  size_t length[HTTP_ROUTE_MAX_PARAMS];
+  uint8_t count;
+
+  /// @brief Copy a parameter into a NUL-terminated buffer
+  /// @param index Parameter index in pattern order
+  /// @param out Destination buffer
+  /// @param size Size of out in bytes
+  /// @return true if the parameter exists and fit
+  bool get(size_t index, char *out, size_t size) const {
+    if (index >= count || length[index] >= size) {
+      return false;
+    }
+    memcpy(out, value[index], length[index]);
+    out[length[index]] = '\0';
+    return true;
+  }
+};
+
+/// @brief One entry of a route table
+template <typename Handler> struct Route {
+  uint8_t method;   // Single HttpMethod flag
+  const char *path; // Exact path, or pattern such as "/api/items/{id}"
+  Handler handler;
+};
+
+/// @brief Result of looking up a request in a route table
+template <typename Handler> struct RouteMatch {
+  enum Result { FOUND, NOT_FOUND, METHOD_NOT_ALLOWED };
+
+  Result result;
+  Handler handler;   // Valid when result is FOUND
+  uint8_t allowed;   // Methods the path accepts (for METHOD_NOT_ALLOWED)
+  RouteParams params;
+};
+
+namespace RouteTableDetail {
+constexpr int compare(const char *a, const char *b) {
+  while (*a != '\0' && *a == *b) {
+    a++;
+    b++;
+  }
+  return (unsigned char)*a - (unsigned char)*b;
+}
+
+constexpr bool isPattern(const char *path) {
+  for (; *path != '\0'; path++) {
+    if (*path == '{') {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace RouteTableDetail
+
+/// @brief Immutable view over a constexpr route array.
+///
+/// The array must list every exact route first, sorted by path and then by
+/// method flag, followed by the pattern routes; isValid() checks this and is
+/// meant to be used in a static_assert next to the table.
+template <typename Handler, size_t N> class RouteTable {
+public:
+  constexpr RouteTable(const Route<Handler> (&routes)[N])
+      : _routes(routes), _exactCount(countExact(routes)) {}
+
+  /// @brief Check table ordering (for static_assert)
+  constexpr bool isValid() const {
+    for (size_t i = 0; i < N; i++) {
+      bool pattern = RouteTableDetail::isPattern(_routes[i].path);
+      if (pattern != (i >= _exactCount)) {
+        return false; // Exact route listed after a pattern route
+      }
+      if (_routes[i].method == HTTP_UNKNOWN) {
+        return false;
+      }
+      if (i > 0 && i < _exactCount) {
+        int c = RouteTableDetail::compare(_routes[i - 1].path, _routes[i].path);
+        if (c > 0 || (c == 0 && _routes[i - 1].method >= _routes[i].method)) {
+          return false; // Out of order or duplicate
+        }
+      }
+    }
+    return true;
+  }
+
+  /// @brief Number of routes in the table
+  constexpr size_t size() const { return N; }
+
+  /// @brief Resolve a request to a handler
+  /// @param method Request method flag
+  /// @param path Request path (without query string)
+  /// @return Match result with handler and captured parameters
+  RouteMatch<Handler> match(uint8_t method, const char *path) const {
+    RouteMatch<Handler> m{};
+    m.result = RouteMatch<Handler>::NOT_FOUND;
+
+    // Exact routes: binary search for the first entry with this path
+    size_t lo = 0;
+    size_t hi = _exactCount;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (strcmp(_routes[mid].path, path) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    for (size_t i = lo; i < _exactCount && strcmp(_routes[i].path, path) == 0;
+         i++) {
+      if (_routes[i].method == method) {
+        m.result = RouteMatch<Handler>::FOUND;
+        m.handler = _routes[i].handler;
+        return m;
+      }
+      m.allowed |= _routes[i].method;
+    }
+    if (m.allowed != 0) {
+      m.result = RouteMatch<Handler>::METHOD_NOT_ALLOWED;
+      return m;
+    }
+
+    // Pattern routes
+    for (size_t i = _exactCount; i < N; i++) {
+      RouteParams params{};
+      if (!matchPattern(_routes[i].path, path, params)) {
+        continue;
+      }
+      if (_routes[i].method == method) {
+        m.result = RouteMatch<Handler>::FOUND;
+        m.handler = _routes[i].handler;
+        m.params = params;
+        return m;
+      }
+      m.allowed |= _routes[i].method;
+    }
+    if (m.allowed != 0) {
+      m.result = RouteMatch<Handler>::METHOD_NOT_ALLOWED;
+    }
+    return m;
+  }
+
+  /// @brief Match a path against a pattern, capturing {param} segments
+  /// @param pattern Route pattern
+  /// @param path Request path
+  /// @param params Receives captured values
+  /// @return true if the path matches
+  static bool matchPattern(const char *pattern, const char *path,
+                           RouteParams &params) {
+    params.count = 0;
+    while (*pattern != '\0') {
+      if (*pattern == '{') {
+        // Capture one non-empty path segment
+        const char *start = path;
+        while (*path != '\0' && *path != '/') {
+          path++;
+        }
+        if (path == start || params.count >= HTTP_ROUTE_MAX_PARAMS) {
+          return false;
+        }
+        params.value[params.count] = start;
+        params.length[params.count] = path - start;
+        params.count++;
+        while (*pattern != '\0' && *pattern != '}') {
+          pattern++;
+        }
+        if (*pattern == '}') {
+          pattern++;
+        }
+      } else if (*pattern++ != *path++) {
+        return false;
+      }
+    }
+    return *path == '\0';
+  }
+
+private:
+  const Route<Handler> (&_routes)[N];
+  size_t _exactCount;
+
+  static constexpr size_t countExact(const Route<Handler> (&routes)[N]) {
+    size_t count = 0;
+    while (count < N && !RouteTableDetail::isPattern(routes[count].path)) {
+      count++;
+    }
+    return count;
+  }
+};
@@ -0,0 +1,103 @@
+/**
+ * Fixed-size ArduinoJson allocator.
+ * Hands out memory from a static buffer with a bump pointer so a
+ * JsonDocument can be filled without touching the heap. The whole pool is
+ * released at once with reset() before each parse; a parse that does not
+ * fit fails with DeserializationError::NoMemory instead of growing.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+template <size_t SIZE> class JsonPool : public ArduinoJson::Allocator {
+public:
+  JsonPool() : _used(0), _last(NONE), _peak(0), _failures(0) {}
+
+  /// @brief Release everything (documents using the pool must be gone)
+  void reset() {
+    _used = 0;
+    _last = NONE;
+  }
+
+  /// @brief Most bytes in use at once since boot
+  size_t getPeak() const { return _peak; }
+
+  /// @brief Allocations refused because the pool was full
+  uint32_t getFailures() const { return _failures; }
+
+  void *allocate(size_t size) override {
+    size_t total = HEADER + align(size);
+    if (total > SIZE - _used) {
+      _failures++;
+      return nullptr;
+    }
+    uint8_t *block = _buffer + _used;
+    memcpy(block, &size, sizeof(size));
+    _last = _used;
+    _used += total;
+    if (_used > _peak) {
+      _peak = _used;
+    }
+    return block + HEADER;
+  }
+
+  void deallocate(void *ptr) override {
+    // Only the newest block can be given back; the rest goes with reset()
+    if (ptr != nullptr && _last != NONE && ptr == _buffer + _last + HEADER) {
+      _used = _last;
+      _last = NONE;
+    }
+  }
+
+  void *reallocate(void *ptr, size_t newSize) override {
+    if (ptr == nullptr) {
+      return allocate(newSize);
+    }
+    uint8_t *block = static_cast<uint8_t *>(ptr) - HEADER;
+    size_t oldSize;
+    memcpy(&oldSize, block, sizeof(oldSize));
+
+    // The newest block grows or shrinks in place
+    if (_last != NONE && block == _buffer + _last) {
+      size_t total = HEADER + align(newSize);
+      if (total > SIZE - _last) {
+        _failures++;
+        return nullptr;
+      }
+      memcpy(block, &newSize, sizeof(newSize));
+      _used = _last + total;
+      if (_used > _peak) {
+        _peak = _used;
+      }
+      return ptr;
+    }
+
+    if (newSize <= oldSize) {
+      return ptr;
+    }
+    void *moved = allocate(newSize);
+    if (moved != nullptr) {
+      memcpy(moved, ptr, oldSize);
+    }
+    return moved;
+  }
+
+private:
+  static const size_t ALIGNMENT = 8;
+  static const size_t HEADER = ALIGNMENT; // Block size, keeps data aligned
+  static const size_t NONE = SIZE_MAX;
+
+  static size_t align(size_t size) {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  }
+
+  alignas(ALIGNMENT) uint8_t _buffer[SIZE];
+  size_t _used;
+  size_t _last; // Offset of the newest block, or NONE
+  size_t _peak;
+  uint32_t _failures;
+};
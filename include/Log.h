@@ -0,0 +1,125 @@
+/**
+ * Log - Levelled, tagged logging into a RAM ring buffer for Arena Timer
+ * A log call stores a compact binary record (sequence number, timestamp,
+ * format string pointer and up to three numeric arguments, or one short
+ * copied string) and returns; nothing is formatted or printed on the hot
+ * path. Records are formatted and drained to Serial from loop() only while
+ * the USB CDC buffer has room, and can be read back over HTTP
+ * (/api/logs?since=).
+ *
+ * Format strings must be string literals (only the pointer is stored). A
+ * record written with a text argument formats it with the first "%s"; any
+ * numeric arguments follow it. Numbers are 32-bit: use %u, %d or %x. (A
+ * literal 0 argument is ambiguous between the two write() overloads; write
+ * 0U.)
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/// @brief Most verbose level compiled in (calls above it compile to nothing)
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 3 // Log::LEVEL_DEBUG
+#endif
+
+namespace Log {
+enum Level : uint8_t {
+  LEVEL_ERROR = 0,
+  LEVEL_WARN = 1,
+  LEVEL_INFO = 2,
+  LEVEL_DEBUG = 3,
+};
+
+/// @brief Subsystem a record comes from
+enum Tag : uint8_t {
+  TAG_SYSTEM,
+  TAG_NETWORK,
+  TAG_DHCP,
+  TAG_HTTP,
+  TAG_WEBSOCKET,
+  TAG_CONFIG,
+  TAG_DISPLAY,
+  TAG_COUNT
+};
+
+/// @brief Number of records kept (oldest are overwritten)
+const size_t CAPACITY = 128;
+
+/// @brief Longest copied string argument (including NUL; longer is cut)
+const size_t TEXT_SIZE = 20;
+
+/// @brief Longest formatted line
+const size_t LINE_SIZE = 96;
+
+/// @brief Record flags
+const uint8_t FLAG_TEXT = 1 << 0; // text holds a copied string argument
+
+/// @brief One binary log record (48 bytes)
+struct Record {
+  uint32_t seq;       // Sequence number (monotonic, starts at 1)
+  uint32_t timeMs;    // millis() when written
+  const char *format; // Format string literal (identifies the message)
+  uint8_t level;
+  uint8_t tag;
+  uint8_t flags;
+  uint8_t reserved;
+  uint32_t args[3];
+  char text[TEXT_SIZE];
+};
+
+/// @brief Set the least important level recorded (default LEVEL_DEBUG)
+void setLevel(Level level);
+
+/// @brief Get the least important level recorded
+Level getLevel();
+
+/// @brief Record a message with numeric arguments
+void write(Level level, Tag tag, const char *format, uint32_t a0 = 0,
+           uint32_t a1 = 0, uint32_t a2 = 0);
+
+/// @brief Record a message with a copied string argument (for the first %s)
+/// followed by numeric arguments
+void write(Level level, Tag tag, const char *format, const char *text,
+           uint32_t a0 = 0, uint32_t a1 = 0);
+
+/// @brief Print pending records to Serial without blocking (call from loop
+/// once the time-critical work is done)
+/// @param maxRecords Most records to print in one call
+void drain(uint8_t maxRecords = 4);
+
+/// @brief Get a record by sequence number
+/// @return false if it was overwritten or not written yet
+bool get(uint32_t seq, Record &record);
+
+/// @brief Sequence number of the oldest record still in the buffer
+uint32_t oldestSeq();
+
+/// @brief Sequence number the next record will get
+uint32_t nextSeq();
+
+/// @brief Records overwritten before they were drained to Serial
+uint32_t getDropped();
+
+/// @brief Format a record's message (without timestamp, level or tag)
+/// @return Number of characters written
+size_t formatMessage(const Record &record, char *out, size_t size);
+
+/// @brief Short name of a level ("E", "W", "I", "D")
+const char *levelName(uint8_t level);
+
+/// @brief Short name of a tag ("sys", "net", ...)
+const char *tagName(uint8_t tag);
+} // namespace Log
+
+#define LOG_AT(level, tag, ...)                                                \
+  do {                                                                         \
+    if (LOG_COMPILE_LEVEL >= (level)) {                                        \
+      Log::write((level), (tag), __VA_ARGS__);                                 \
+    }                                                                          \
+  } while (0)
+
+#define LOG_ERROR(tag, ...) LOG_AT(Log::LEVEL_ERROR, tag, __VA_ARGS__)
+#define LOG_WARN(tag, ...) LOG_AT(Log::LEVEL_WARN, tag, __VA_ARGS__)
+#define LOG_INFO(tag, ...) LOG_AT(Log::LEVEL_INFO, tag, __VA_ARGS__)
+#define LOG_DEBUG(tag, ...) LOG_AT(Log::LEVEL_DEBUG, tag, __VA_ARGS__)
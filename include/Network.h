@@ -0,0 +1,104 @@
+/**
+ * Network - Background network bring-up and supervision for Arena Timer
+ * Starts the W5500 and acquires an address (DHCP, falling back to a static
+ * IP) as a state machine driven from loop(), so the timer is on screen and
+ * usable while the network comes up. Once up, it watches the PHY link,
+ * keeps the DHCP lease without blocking, fails over to the static IP when
+ * the lease is lost (and back when DHCP returns), and reports the events
+ * dependent services need to react to.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Ethernet_Generic.hpp>
+
+namespace Network {
+/// @brief Supervisor state
+enum class State {
+  OFF,         // begin() not called yet
+  STARTING,    // W5500 initialization pending
+  DHCP,        // Waiting for a first DHCP lease
+  UP,          // Address configured (DHCP or static fallback), link up
+  LINK_DOWN,   // Cable unplugged (or switch port down)
+  NO_HARDWARE, // W5500 not found
+};
+
+/// @brief Change reported by service()
+enum class Event {
+  NONE,
+  UP,              // Network usable (first time, or link back)
+  DOWN,            // Link lost
+  ADDRESS_CHANGED, // New address (new lease, failover or failback)
+};
+
+/// @brief Network calls whose duration is recorded
+enum Call : uint8_t {
+  CALL_HARDWARE_INIT, // W5500 reset and configuration
+  CALL_LINK_CHECK,    // PHY link status read
+  CALL_DHCP,          // DHCP client poll
+  CALL_HTTP,          // Web server (and mDNS responder) service
+  CALL_WEBSOCKET,     // WebSocket client poll
+  CALL_COUNT
+};
+
+/// @brief Duration statistics for one kind of network call
+struct CallStats {
+  uint32_t count;
+  uint32_t totalUs;
+  uint32_t maxUs;
+};
+
+/// @brief Supervisor statistics
+struct Stats {
+  uint32_t linkFlaps;           // Link up -> down transitions
+  uint32_t linkDownMs;          // Total time spent with the link down
+  unsigned long lastLinkChange; // millis() of the last link transition
+  uint32_t dhcpLeases;          // Leases acquired (initial and failback)
+  uint32_t dhcpRenewals;        // Successful renewals
+  uint32_t dhcpFailures;        // Acquisitions/renewals that timed out
+  uint32_t staticFailovers;     // Switches to the static IP
+};
+
+/// @brief Start bringing the network up in the background
+/// @param mac MAC address (6 bytes)
+/// @param fallbackIp Static IP used if DHCP fails (4 bytes)
+/// @param dhcpTimeoutMs Time to wait for DHCP before using the static IP
+void begin(const uint8_t mac[6], const uint8_t fallbackIp[4],
+           unsigned long dhcpTimeoutMs = 10000);
+
+/// @brief Advance the state machine (call in loop, never blocks once the
+/// W5500 is initialized)
+/// @return What changed on this call (NONE most of the time)
+Event service();
+
+/// @brief Get the supervisor state
+State getState();
+
+/// @brief Check if an address is configured and the link is up
+bool isUp();
+
+/// @brief Check if the address came from DHCP (false for the static fallback)
+bool usingDhcp();
+
+/// @brief Get the time the network first came up, in milliseconds since boot
+/// @return 0 if not up yet
+unsigned long getUpTimeMs();
+
+/// @brief Get the state as a short string ("dhcp", "static", ...)
+const char *getStateString();
+
+/// @brief Get supervisor statistics
+const Stats &getStats();
+
+/// @brief Record the duration of a network call
+/// @param call Kind of call
+/// @param us Duration in microseconds
+void recordCall(Call call, uint32_t us);
+
+/// @brief Get the duration statistics for a kind of call
+const CallStats &getCallStats(Call call);
+
+/// @brief Get the name of a kind of call (for status output)
+const char *getCallName(Call call);
+} // namespace Network
@@ -0,0 +1,106 @@
+/**
+ * RefreshControl - Matrix bit depth selection for Arena Timer
+ * The number of bitplanes trades color resolution against refresh rate:
+ * every plane added roughly halves the rate. The depth is either fixed
+ * (1-6) or chosen automatically: auto mode starts at the deepest setting
+ * and steps down until the refresh rate, measured with the driver's frame
+ * counter, meets the target. Changing the depth reallocates the matrix
+ * buffers, so it is only done from service() in loop().
+ *
+ * Broadcast mode is for filming the matrix: cameras show bands at the
+ * normal ~250 Hz. It raises the driver's refresh cap to the broadcast rate
+ * and runs the auto search against that (typically ending at 1-2 planes);
+ * the interrupt CPU load is measured so the rate can be chosen as low as
+ * the cameras allow. Turning it off restores the normal settings.
+ */
+
+#pragma once
+
+#include <Adafruit_Protomatter.h>
+
+class RefreshControl {
+public:
+  /// @brief Bit depth setting for automatic selection
+  static const uint8_t AUTO = 0;
+
+  static const uint8_t MIN_BIT_DEPTH = 1;
+  static const uint8_t MAX_BIT_DEPTH = 6; // GFXcanvas16 (565) limit
+
+  /// @brief Default refresh target for auto mode
+  static const uint16_t DEFAULT_TARGET_HZ = 120;
+
+  /// @brief Default refresh rate in broadcast mode
+  static const uint16_t DEFAULT_BROADCAST_HZ = 1920;
+
+  /// @brief Highest broadcast rate accepted
+  static const uint16_t MAX_BROADCAST_HZ = 10000;
+
+  struct Stats {
+    uint32_t refreshHz; // Measured over the last interval (0 until known)
+    uint16_t isrLoad;   // Refresh interrupt CPU load, per mille
+    uint8_t bitDepth;   // Bitplanes in use
+    bool settled;       // Auto mode meets the target at this depth
+    uint32_t changes;   // Bit depth changes applied
+    uint32_t failures;  // Changes refused (buffers didn't fit)
+  };
+
+  /// @brief Construct a new RefreshControl object
+  /// @param matrix Matrix whose bit depth is controlled
+  RefreshControl(Adafruit_Protomatter &matrix);
+
+  /// @brief Select the bit depth (applied by the next service())
+  /// @param depth Bitplanes (1-6), or AUTO
+  void setBitDepth(uint8_t depth);
+
+  /// @brief Get the bit depth setting
+  /// @return Bitplanes, or AUTO
+  uint8_t getBitDepth() const { return _setting; }
+
+  /// @brief Set the refresh rate auto mode has to sustain
+  /// @param hz Target in frames per second
+  void setTargetHz(uint16_t hz);
+
+  uint16_t getTargetHz() const { return _targetHz; }
+
+  /// @brief Switch broadcast (camera-safe high refresh) mode on or off
+  /// (applied by the next service())
+  void setBroadcast(bool enabled);
+
+  bool isBroadcast() const { return _broadcast; }
+
+  /// @brief Set the refresh rate for broadcast mode
+  /// @param hz Frames per second
+  void setBroadcastHz(uint16_t hz);
+
+  uint16_t getBroadcastHz() const { return _broadcastHz; }
+
+  /// @brief Measure the refresh rate and apply bit depth changes (call in
+  /// loop)
+  /// @return true if the bit depth was changed (the matrix buffers were
+  /// cleared, everything has to be drawn again)
+  bool service();
+
+  const Stats &getStats() const { return _stats; }
+
+private:
+  Adafruit_Protomatter &_matrix;
+  uint8_t _setting;
+  uint16_t _targetHz;
+  bool _broadcast;
+  uint16_t _broadcastHz;
+  uint16_t _normalMaxHz; // Driver refresh cap outside broadcast mode
+  bool _pending;  // Setting changed since the last service()
+  bool _settling; // Discard the current interval (depth just changed)
+  unsigned long _intervalStartMs;
+  Stats _stats;
+
+  /// @brief Get the refresh rate the auto search has to reach
+  uint16_t activeTargetHz() const;
+
+  /// @brief Switch the matrix to a bit depth
+  /// @return true if the matrix was reconfigured
+  bool apply(uint8_t depth);
+
+  /// @brief Start a new measurement interval
+  void restartInterval(bool settling);
+};
@@ -0,0 +1,88 @@
+/**
+ * Debounced, atomic settings persistence on LittleFS.
+ * Changes are coalesced for a quiet period and written while the timer is
+ * idle (or, once a save has waited long enough, in the next gap between
+ * frames), to a temporary file that is then renamed over the old one so a
+ * power cut never leaves a half-written file behind.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class SettingsPersistence {
+public:
+  /// @brief Writes the settings to a stream
+  /// @param out Destination (file, or a checksum sink)
+  /// @param context Caller-supplied pointer passed through unchanged
+  /// @return Number of bytes written (0 or short on failure)
+  typedef size_t (*SerializeFn)(Print &out, void *context);
+
+  /// @brief Persistence statistics
+  struct Stats {
+    uint32_t writes;      // Successful file writes
+    uint32_t failures;    // Failed writes (open, serialize or rename)
+    uint32_t coalesced;   // Changes merged into an already pending save
+    uint32_t skipped;     // Saves dropped because content was unchanged
+    uint32_t forced;      // Writes made while busy, after maxDeferMs
+    uint32_t lastWriteUs; // Duration of the last write
+    uint32_t maxWriteUs;  // Longest write
+    uint32_t totalWriteUs;
+  };
+
+  /// @brief Construct a persistence layer for one file
+  /// @param path File path on LittleFS (the temp file is path + ".tmp")
+  /// @param quietPeriodMs Time without changes before a save is written
+  /// @param maxDeferMs How long a due save may wait for an idle slot before
+  /// it is written anyway
+  SettingsPersistence(const char *path, unsigned long quietPeriodMs = 2000,
+                      unsigned long maxDeferMs = 10000);
+
+  /// @brief Set the quiet period
+  /// @param quietPeriodMs Time without changes before a save is written
+  void setQuietPeriod(unsigned long quietPeriodMs);
+
+  /// @brief Get the quiet period in milliseconds
+  unsigned long getQuietPeriod() const { return _quietPeriodMs; }
+
+  /// @brief Get how long a due save may wait for an idle slot
+  unsigned long getMaxDefer() const { return _maxDeferMs; }
+
+  /// @brief Record a change; the save happens once changes stop for the
+  /// quiet period
+  void markDirty();
+
+  /// @brief Check if a save is pending
+  bool isDirty() const { return _dirty; }
+
+  /// @brief Write a pending save if the quiet period has passed (call from
+  /// loop, right after a frame has been shown). While busy the save waits
+  /// up to maxDeferMs more, so a change made mid-bout is still on flash
+  /// before a reset can lose it.
+  /// @param idle true when a flash write won't disturb anything (timer not
+  /// running)
+  /// @param serialize Settings serializer
+  /// @param context Passed to serialize
+  /// @return true if the pending save completed
+  bool service(bool idle, SerializeFn serialize, void *context);
+
+  /// @brief Write immediately, bypassing debouncing
+  /// @param serialize Settings serializer
+  /// @param context Passed to serialize
+  /// @return true on success (or if content was unchanged)
+  bool writeNow(SerializeFn serialize, void *context);
+
+  /// @brief Get persistence statistics
+  const Stats &getStats() const { return _stats; }
+
+private:
+  const char *_path;
+  char _tempPath[32];
+  unsigned long _quietPeriodMs;
+  unsigned long _maxDeferMs;
+  unsigned long _lastChangeMs;
+  bool _dirty;
+  uint32_t _lastCrc; // Checksum of the content last written
+  bool _crcValid;
+  Stats _stats;
+};
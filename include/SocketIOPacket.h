@@ -0,0 +1,153 @@
+/**
+ * Engine.IO / Socket.IO packet classification.
+ * Works directly on the received frame buffer: the packet types are read
+ * from the leading digits and the JSON body is returned as a span into the
+ * same buffer, so nothing is copied before it reaches the JSON parser.
+ * Header-only and free of Arduino dependencies so it can be built on a host.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace SocketIO {
+/// @brief Engine.IO packet type (first character of a frame)
+enum class EngineType : uint8_t {
+  OPEN,    // '0' + handshake JSON
+  CLOSE,   // '1'
+  PING,    // '2'
+  PONG,    // '3'
+  MESSAGE, // '4' + Socket.IO packet
+  UPGRADE, // '5'
+  NOOP,    // '6'
+  JSON,    // Plain WebSocket frame carrying a bare JSON object/array
+  INVALID,
+};
+
+/// @brief Socket.IO packet type (first character after Engine.IO '4')
+enum class PacketType : uint8_t {
+  CONNECT,       // '0'
+  DISCONNECT,    // '1'
+  EVENT,         // '2'
+  ACK,           // '3'
+  CONNECT_ERROR, // '4'
+  BINARY_EVENT,  // '5'
+  BINARY_ACK,    // '6'
+  NONE,          // Not a Socket.IO message
+};
+
+/// @brief A classified frame; body points into the frame buffer
+struct Packet {
+  EngineType engine;
+  PacketType type;
+  const char *body; // JSON (or other payload) after the headers
+  size_t bodyLength;
+  uint32_t ackId; // Socket.IO ack id, if hasAckId
+  bool hasAckId;
+};
+
+/// @brief Classify a frame
+/// @param data Frame payload (need not be NUL-terminated)
+/// @param length Payload length
+/// @param packet Classification result
+/// @return false if the frame is empty or not a recognized packet
+inline bool parse(const char *data, size_t length, Packet &packet) {
+  packet.engine = EngineType::INVALID;
+  packet.type = PacketType::NONE;
+  packet.body = data;
+  packet.bodyLength = 0;
+  packet.ackId = 0;
+  packet.hasAckId = false;
+  if (data == nullptr || length == 0) {
+    return false;
+  }
+
+  if (data[0] == '{' || data[0] == '[') {
+    packet.engine = EngineType::JSON;
+    packet.bodyLength = length;
+    return true;
+  }
+  if (data[0] < '0' || data[0] > '6') {
+    return false;
+  }
+  packet.engine = static_cast<EngineType>(data[0] - '0');
+  size_t pos = 1;
+
+  if (packet.engine == EngineType::MESSAGE && pos < length &&
+      data[pos] >= '0' && data[pos] <= '6') {
+    packet.type = static_cast<PacketType>(data[pos] - '0');
+    pos++;
+
+    // Binary packets carry an attachment count: "<n>-"
+    if (packet.type == PacketType::BINARY_EVENT ||
+        packet.type == PacketType::BINARY_ACK) {
+      while (pos < length && data[pos] >= '0' && data[pos] <= '9') {
+        pos++;
+      }
+      if (pos < length && data[pos] == '-') {
+        pos++;
+      }
+    }
+
+    // Optional namespace: "/name,"
+    if (pos < length && data[pos] == '/') {
+      const char *comma =
+          static_cast<const char *>(memchr(data + pos, ',', length - pos));
+      pos = comma != nullptr ? (size_t)(comma - data) + 1 : length;
+    }
+
+    // Optional ack id
+    while (pos < length && data[pos] >= '0' && data[pos] <= '9') {
+      packet.ackId = packet.ackId * 10 + (uint32_t)(data[pos] - '0');
+      packet.hasAckId = true;
+      pos++;
+    }
+  }
+
+  packet.body = data + pos;
+  packet.bodyLength = length - pos;
+  return true;
+}
+
+/// @brief Match the event name of an event body ["name", ...]
+/// @param body Event body (Packet::body)
+/// @param length Body length
+/// @param name Expected event name
+/// @param args Set to the first argument after the name on a match
+/// @param argsLength Set to the length from args to the end of the body
+/// @return true if the body is an array whose first element is name
+inline bool matchEvent(const char *body, size_t length, const char *name,
+                       const char **args, size_t *argsLength) {
+  size_t nameLength = strlen(name);
+  size_t pos = 0;
+  auto skipSpace = [&]() {
+    while (pos < length && (body[pos] == ' ' || body[pos] == '\t' ||
+                            body[pos] == '\r' || body[pos] == '\n')) {
+      pos++;
+    }
+  };
+
+  skipSpace();
+  if (pos >= length || body[pos] != '[') {
+    return false;
+  }
+  pos++;
+  skipSpace();
+  if (length - pos < nameLength + 2 || body[pos] != '"' ||
+      memcmp(body + pos + 1, name, nameLength) != 0 ||
+      body[pos + 1 + nameLength] != '"') {
+    return false;
+  }
+  pos += nameLength + 2;
+  skipSpace();
+  if (pos < length && body[pos] == ',') {
+    pos++;
+    skipSpace();
+  }
+  *args = body + pos;
+  *argsLength = length - pos;
+  return true;
+}
+} // namespace SocketIO
@@ -0,0 +1,56 @@
+/**
+ * Non-blocking TCP reachability probe for the W5500.
+ * EthernetClient::connect() waits in a loop until the handshake completes
+ * or times out, which stalls loop() for seconds when the server is down or
+ * unreachable. The probe issues the CONNECT command on a free hardware
+ * socket and then only reads the socket status on each poll(), so the
+ * caller can find out whether a server answers before handing the
+ * connection to a library that connects synchronously.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Ethernet_Generic.hpp>
+
+class TcpProbe {
+public:
+  enum class State {
+    IDLE,       // Not started
+    CONNECTING, // SYN sent, waiting for the handshake
+    CONNECTED,  // Server accepted the connection
+    FAILED      // Refused, or no answer before the timeout
+  };
+
+  TcpProbe();
+
+  /// @brief Start connecting
+  /// @param ip Server address
+  /// @param port Server port
+  /// @param timeoutMs Time before giving up (state becomes FAILED)
+  /// @return false if no hardware socket is free
+  bool begin(const IPAddress &ip, uint16_t port, unsigned long timeoutMs);
+
+  /// @brief Check the connection (call from loop, never blocks)
+  /// @return Current state
+  State poll();
+
+  /// @brief Close the connection and free the hardware socket
+  void stop();
+
+  /// @brief Get the current state
+  State getState() const { return _state; }
+
+  /// @brief Time from begin() to the connection being accepted
+  unsigned long getConnectTimeMs() const { return _connectTimeMs; }
+
+private:
+  State _state;
+  uint8_t _socket; // Hardware socket, or MAX_SOCK_NUM if none
+  unsigned long _startMs;
+  unsigned long _timeoutMs;
+  unsigned long _connectTimeMs;
+
+  uint8_t readStatus();
+  void command(SockCMD cmd);
+};
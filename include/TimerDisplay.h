@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "RefreshControl.h"
 #include "Timer.h"
 #include <Adafruit_Protomatter.h>
 
@@ -23,6 +24,17 @@ public:
     uint8_t b;            // Blue (0-255)
   };
 
+  /// @brief Maximum number of color thresholds
+  static const size_t MAX_THRESHOLDS = 10;
+
+  /// @brief Timer frame drawing statistics (see draw())
+  struct DrawStats {
+    uint32_t frames;     // Timer frames drawn
+    uint32_t maskFrames; // Frames drawn from cached glyphs
+    uint32_t lastUs;     // Duration of the last frame, including the show
+    uint32_t maxUs;      // Slowest frame
+  };
+
   /// @brief Construct a new TimerDisplay object
   /// @param matrix Reference to the Adafruit_Protomatter matrix
   /// @param mode Timer mode (TIMER or STOPWATCH)
@@ -87,7 +99,8 @@ public:
   /// @param b Blue (0-255)
   void setDefaultColor(uint8_t r, uint8_t g, uint8_t b);
 
-  /// @brief Set display brightness
+  /// @brief Set display brightness (done by the matrix driver, which
+  /// shortens the lit time of each bitplane; colors keep full resolution)
   /// @param brightness Brightness level (0-255, where 0 is off and 255 is full
   /// brightness)
   void setBrightness(uint8_t brightness);
@@ -96,23 +109,51 @@ public:
   /// @return Current brightness (0-255)
   uint8_t getBrightness() const;
 
+  /// @brief Rotate the display (done by the matrix driver while converting
+  /// frames, so drawing costs the same in every orientation)
+  /// @param rotation Quarter turns clockwise (0-3)
+  void setRotation(uint8_t rotation);
+
+  /// @brief Get the display rotation
+  /// @return Quarter turns clockwise (0-3)
+  uint8_t getRotation() const;
+
   /// @brief Get the underlying Timer object
   /// @return Reference to the Timer
   Timer &getTimer();
 
+  /// @brief Get the matrix the timer is drawn on
+  /// @return Reference to the matrix
+  Adafruit_Protomatter &getMatrix();
+
+  /// @brief Get the bit depth / refresh rate control of the matrix
+  /// @return Reference to the control
+  RefreshControl &getRefresh();
+
   /// @brief Update and draw the timer on the display. Call this in loop()
   void update();
 
-  /// @brief Draw the timer immediately (without auto-update logic)
+  /// @brief Draw the timer immediately (without auto-update logic). The
+  /// time is built from pre-rasterised glyphs and shown as a 1-bit mask
+  /// when the matrix supports it, otherwise drawn on the canvas.
   void draw();
 
-  /// @brief Display a message on the matrix for a specified duration (blocking)
+  /// @brief Get timer frame drawing statistics
+  const DrawStats &getDrawStats() const;
+
+  /// @brief Display a message on the matrix in place of the timer. Returns
+  /// immediately; update() draws (and scrolls) the message until it is done.
   /// @param msg The message string to display (e.g. IP address)
-  /// @param duration_ms Duration to show the message in milliseconds
+  /// @param duration_ms Duration to show the message in milliseconds (a
+  /// message wider than the display scrolls across once instead)
   void showMessage(const String &msg, uint16_t duration_ms = 3000);
 
+  /// @brief Check if a message is being shown instead of the timer
+  bool isShowingMessage() const;
+
 private:
   Adafruit_Protomatter &_matrix;
+  RefreshControl _refresh;
   Timer _timer;
   Mode _mode;
 
@@ -123,17 +164,24 @@ private:
   int8_t _letter_spacing; // Extra spacing between characters (pixels)
   uint16_t _color;
   uint8_t _default_r, _default_g, _default_b; // Default color (no threshold)
-  uint8_t _brightness;                        // Display brightness (0-255)
+  uint16_t _default_color; // Gamma-corrected for the current bit depth
 
   // Color thresholds (sorted by seconds, descending)
-  static const size_t MAX_THRESHOLDS = 10;
   ColorThreshold _thresholds[MAX_THRESHOLDS];
+  uint16_t _threshold_colors[MAX_THRESHOLDS]; // Gamma-corrected
   size_t _threshold_count;
 
   unsigned long _last_blink_ms;
   bool _blink_state;
   bool _was_expired; // Track if we were expired in the last update
 
+  // Message shown in place of the timer (see showMessage)
+  String _message;
+  bool _message_active;
+  unsigned long _message_start_ms;
+  uint16_t _message_duration_ms;
+  uint16_t _message_width;
+
   // Cached positions for different time formats to prevent jitter
   struct CachedPosition {
     int16_t x;
@@ -145,6 +193,36 @@ private:
   CachedPosition _pos_double_digit_minutes; // "99:99"
   CachedPosition _pos_seconds_mode;         // "99.9"
 
+  // Time characters rasterised once per font and text size, so a timer
+  // frame is a few byte copies into a 1-bit mask instead of per-pixel
+  // drawing on the 16-bit canvas
+  struct Glyph {
+    int16_t x1, y1;  // Bitmap offset from the cursor
+    uint16_t w, h;   // Bitmap size (rows padded to whole bytes)
+    int16_t advance; // Cursor advance
+    uint16_t offset; // Start of the bitmap in _glyph_bits
+  };
+
+  enum class GlyphCache {
+    STALE,      // Font or text size changed since rasterising
+    READY,      // Timer frames are drawn as masks
+    UNAVAILABLE // Glyphs don't fit, or the matrix can't show masks
+  };
+
+  static const size_t GLYPH_COUNT = 12; // "0123456789:."
+  static const size_t GLYPH_POOL_SIZE = 2048;
+
+  Glyph _glyphs[GLYPH_COUNT];
+  uint8_t _glyph_bits[GLYPH_POOL_SIZE];
+  GlyphCache _glyph_cache;
+  int16_t _colon_offset; // Colon centering for GFX fonts (see
+                         // drawTimeWithCenteredColon)
+  uint8_t *_frame_mask;  // Timer frame, GFXcanvas1 layout
+  DrawStats _draw_stats;
+
+  /// @brief Draw the current message frame, ending the message when done
+  void drawMessage();
+
   /// @brief Calculate and cache centered positions for all time formats
   void calculateCachedPositions();
 
@@ -158,6 +236,24 @@ private:
   void drawTimeWithCenteredColon(const String &time_str, int16_t base_x,
                                  int16_t base_y, bool show_ms);
 
+  /// @brief Rasterise the time characters for the current font and size
+  /// @return false if they don't fit the glyph pool
+  bool rasteriseGlyphs();
+
+  /// @brief Draw the time from cached glyphs and show it as a mask
+  /// @param time_str The formatted time string
+  /// @param pos Position, as for the canvas drawing
+  /// @param color Text color
+  /// @return false if the canvas has to be used instead
+  bool drawMask(const String &time_str, const CachedPosition &pos,
+                uint16_t color);
+
+  /// @brief OR a glyph bitmap into the frame mask, clipped to the display
+  /// @param glyph Glyph to draw
+  /// @param x Left edge of the bitmap
+  /// @param y Top edge of the bitmap
+  void blitGlyph(const Glyph &glyph, int16_t x, int16_t y);
+
   /// @brief Get the cached position for the current display format
   /// @param show_milliseconds Whether in seconds mode
   /// @return Cached position to use
@@ -178,9 +274,7 @@ private:
   /// @return 16-bit color value
   uint16_t getCurrentColor();
 
-  /// @brief Apply brightness scaling to RGB color
-  /// @param r Red (0-255), modified in place
-  /// @param g Green (0-255), modified in place
-  /// @param b Blue (0-255), modified in place
-  void applyBrightness(uint8_t &r, uint8_t &g, uint8_t &b);
+  /// @brief Gamma-correct the default and threshold colors for the current
+  /// bit depth (when a color or the depth changes, not per frame)
+  void updateColors();
 };
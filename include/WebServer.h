@@ -18,11 +18,10 @@ extern const int SCK;
 extern const int MOSI;
 extern const int MISO;
 
-/// @brief Initialize the Ethernet connection with static IP
-/// @param mac MAC address (6 bytes)
-/// @param ip IP address (4 bytes)
+/// @brief Mount the settings filesystem (formatting it if needed). The
+/// network itself is brought up in the background by Network.
 /// @return true if successful, false otherwise
-bool init(uint8_t mac[6], uint8_t ip[4]);
+bool initStorage();
 
 /// @brief Initialize mDNS responder for hostname resolution
 /// @param hostname Hostname (without .local suffix)
@@ -47,18 +46,30 @@ void setWebSocketClient(WebSocketClient *wsClient);
 /// @brief Get the current Ethernet server
 EthernetServer &getServer();
 
-/// @brief Load settings from filesystem
+/// @brief Load the configuration record (migrating legacy settings if
+/// needed) and apply its display settings
 /// @param timerDisplay Reference to the TimerDisplay object to apply settings
 /// to
-/// @return true if successful, false otherwise
+/// @return true if saved display settings were applied, false otherwise
 bool loadSettings(TimerDisplay &timerDisplay);
 
-/// @brief Save settings to filesystem
+/// @brief Save settings to filesystem immediately
 /// @param timerDisplay Reference to the TimerDisplay object to save settings
 /// from
 /// @return true if successful, false otherwise
 bool saveSettings(TimerDisplay &timerDisplay);
 
+/// @brief Schedule a debounced save of the settings
+/// @param timerDisplay Reference to the TimerDisplay object to save settings
+/// from
+void scheduleSave(TimerDisplay &timerDisplay);
+
+/// @brief Write scheduled settings once changes have settled and the timer
+/// is idle (call in loop)
+/// @param timerDisplay Reference to the TimerDisplay object to save settings
+/// from
+void servicePersistence(TimerDisplay &timerDisplay);
+
 /// @brief Get the IP address as a string
 /// @return IP address string (e.g., "192.168.1.100")
 String getIPAddressString();
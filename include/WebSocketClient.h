@@ -1,28 +1,115 @@
 #ifndef WEBSOCKET_CLIENT_H
 #define WEBSOCKET_CLIENT_H
 
+#include "ConfigStore.h"
+#include "DnsLookup.h"
+#include "JsonPool.h"
+#include "TcpProbe.h"
 #include "Timer.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <EEPROM.h>
 #include <WebSocketsClient.h>
 
+// Memory for one parsed (filtered) message; FightTimer messages need a few
+// hundred bytes
+#define WS_JSON_POOL_SIZE 2048
+
+// Largest message rebuilt from fragments (longer ones are dropped)
+#define WS_MAX_MESSAGE_SIZE 4096
+
+// Commands kept for the rolling apply latency statistics
+#define WS_LATENCY_WINDOW 32
+
+// Primary server plus the configured spares
+#define WS_MAX_UPSTREAMS (1 + ConfigStore::MAX_WS_SPARES)
+
 class WebSocketClient {
 public:
+  // Message parsing statistics
+  struct ParserStats {
+    uint32_t messages;    // Frames received
+    uint32_t parseErrors; // JSON that failed to parse (incl. pool overflow)
+    uint32_t totalUs;     // Time spent handling text frames
+    uint32_t maxUs;
+    uint32_t reassembled; // Messages rebuilt from fragments
+    uint32_t oversized;   // Fragmented messages over WS_MAX_MESSAGE_SIZE
+    uint32_t dropped;     // Fragments lost (out of order, link closed)
+  };
+
   WebSocketClient(Timer *timer);
 
+  // Heartbeat state and statistics
+  struct HeartbeatStats {
+    uint32_t pingIntervalMs; // Negotiated in the Engine.IO open packet
+    uint32_t pingTimeoutMs;
+    uint32_t lastRttMs;      // WebSocket ping -> pong round trip
+    uint32_t maxRttMs;
+    uint32_t timeouts;       // Connections declared dead by the watchdog
+  };
+
+  // Acknowledgements sent after applying each timer command, and the time
+  // from receiving a command to having applied it (over the last
+  // WS_LATENCY_WINDOW commands)
+  struct AckStats {
+    uint32_t commands;     // Timer commands applied
+    uint32_t sendFailures; // Acks the library could not send
+    uint32_t lastSeq;      // Sequence of the last command
+    uint32_t lastUs;       // Apply latency of the last command
+    uint32_t avgUs;
+    uint32_t maxUs;
+  };
+
+  // A server to connect to, with its health. The score (0-100) combines
+  // how reliably it accepts connections and keeps its heartbeat (raised by
+  // successes, lowered by failures and missed heartbeats) with a penalty
+  // for slow round trips.
+  struct Upstream {
+    String host;
+    uint16_t port;
+    String path;
+    uint8_t reliability; // 0-100
+    uint32_t srttMs;     // Smoothed WebSocket ping RTT
+    uint32_t connects;
+    uint32_t failures;        // Failed attempts and dropped connections
+    uint32_t heartbeatMisses; // Connections declared dead by the watchdog
+    IPAddress address;        // Host name resolved to, while ttlMs lasts
+    unsigned long resolvedMs;
+    unsigned long ttlMs; // 0 until the name was resolved
+
+    uint8_t score() const;
+  };
+
   // Connection management
   bool connect(const char *host, uint16_t port,
                const char *path = "/socket.io/");
   void disconnect();
   bool isConnected();
 
+  // Reconnect at once (e.g. after the network came back), skipping the
+  // backoff. Does nothing if no server was configured or the user
+  // disconnected.
+  void reconnectNow();
+
   // Must be called in loop()
   void poll();
 
+  // Feed a captured frame through the message handling (see Capture). Only
+  // text frames are replayed, and nothing is sent to the live connection.
+  void replayFrame(uint8_t type, const uint8_t *payload, size_t length);
+
   // Status
   const char *getStatus();
   const char *getServerUrl();
+  uint8_t getUpstreamCount() { return _upstreamCount; }
+  const Upstream &getUpstream(uint8_t index) { return _upstreams[index]; }
+  uint8_t getActiveUpstream() { return _active; }
+  uint32_t getFailovers() { return _failovers; }
+  const ParserStats &getParserStats() { return _parserStats; }
+  size_t getJsonPoolPeak() { return _jsonPool.getPeak(); }
+  const HeartbeatStats &getHeartbeatStats() { return _heartbeat; }
+  AckStats getAckStats();
+  // Time since anything was received on the current connection
+  unsigned long getLastMessageAgeMs() { return millis() - _lastMessageMs; }
 
 private:
   Timer *_timer;
@@ -36,35 +123,119 @@ private:
   bool _connected;
   bool _connectionAttempted;  // Track if user has tried to connect
   bool _manuallyDisconnected; // Track if user manually disconnected
-  bool _connectInProgress;    // Prevent overlapping connection attempts
-  unsigned long _lastReconnectAttempt;
-  unsigned long _reconnectInterval;
-  unsigned int _consecutiveFailures; // For exponential backoff
+  unsigned long _lastReconnectAttempt; // Start of the backoff wait
+  unsigned long _reconnectInterval;    // Backoff base
+  unsigned long _reconnectDelay;       // Jittered wait before next attempt
+  unsigned int _consecutiveFailures;   // For exponential backoff
   bool _autoReconnect;
 
+  // Connection attempts: the library resolves and connects synchronously
+  // inside loop(), so a host name is first resolved with a DnsLookup and a
+  // TcpProbe checks without blocking that the server answers. The library
+  // is then given the address, never the name.
+  enum class Phase : uint8_t {
+    IDLE,      // Connected, or waiting for the next attempt
+    RESOLVING, // Non-blocking DNS query in flight
+    PROBING,   // Non-blocking TCP connect in flight
+    HANDSHAKE, // Server reachable, library connecting/upgrading
+  };
+  Phase _phase;
+  unsigned long _phaseStartMs;
+  DnsLookup _dns;
+  TcpProbe _probe;
+  IPAddress _serverAddress; // Address of the server being connected to
+
+  void startAttempt();
+  void probeServer(const IPAddress &ip);
+  bool upstreamAddress(const Upstream &u, IPAddress &ip);
+  void beginHandshake();
+  void connectFailed();
+  unsigned long backoffDelay();
+
+  // Failover: after a failure the next healthiest server is tried at once;
+  // only a full round of failures backs off. While on a spare, the primary
+  // is probed now and then and taken back once it is as healthy.
+  Upstream _upstreams[WS_MAX_UPSTREAMS];
+  uint8_t _upstreamCount;
+  uint8_t _active;
+  uint8_t _roundFailures; // Servers failed in a row since the last success
+  uint32_t _failovers;
+  bool _failbackProbing;
+  unsigned long _lastFailbackProbe;
+
+  void loadUpstreams(const char *host, uint16_t port, const char *path);
+  void selectUpstream(uint8_t index);
+  uint8_t bestUpstream(int exclude);
+  void adjustReliability(int delta);
+  void pollFailback();
+
   // Socket.IO support
   bool _isSocketIO;
   bool _socketIOFallback; // Try WebSocket if Socket.IO fails
   String _socketIOSessionId;
 
+  // Heartbeat watchdog: Engine.IO pings are expected every pingInterval,
+  // and a WebSocket ping probes a silent link (and measures the RTT)
+  HeartbeatStats _heartbeat;
+  unsigned long _lastMessageMs;    // Last frame of any kind received
+  unsigned long _lastEnginePingMs; // Last Engine.IO ping (if _engineOpen)
+  unsigned long _probeSentMs;      // When the outstanding probe was sent
+  unsigned long _lastProbeMs;
+  bool _probePending; // WebSocket ping sent, no pong yet
+  bool _engineOpen; // Engine.IO handshake received on this connection
+
+  void resetHeartbeat();
+  void checkHeartbeat();
+  void handleOpen(const char *json, size_t length);
+
   // Event handler
   static void webSocketEvent(WStype_t type, uint8_t *payload, size_t length);
   static WebSocketClient *_instance; // For static callback
 
   void handleWebSocketEvent(WStype_t type, uint8_t *payload, size_t length);
 
-  // Message parsing
+  // Message parsing: frames are classified in place and the JSON is parsed
+  // through a filter into a document backed by a fixed pool
+  JsonDocument _filter;
+  JsonPool<WS_JSON_POOL_SIZE> _jsonPool;
+  ParserStats _parserStats;
+  bool _replaying; // Handling a captured frame, not live traffic
+
+  // Fragment reassembly into a fixed buffer
+  enum class Fragments { NONE, TEXT, SKIP };
+  Fragments _fragments;
+  size_t _fragmentLength;
+  char _fragmentBuffer[WS_MAX_MESSAGE_SIZE + 1]; // + NUL for logging
+
+  void handleFragment(WStype_t type, const uint8_t *payload, size_t length);
+  void dispatchText(const char *data, size_t length);
+
+  void buildFilter();
+  void handleText(const char *data, size_t length);
+  void handleMessage(const char *json, size_t length);
   void handleTimerUpdate(JsonObject &obj);
 
+  // Command acknowledgements: 42["timer_ack",{...}] (or a plain JSON
+  // object on a bare WebSocket) once a command is applied, so the
+  // controller can measure its end-to-end latency to each display
+  unsigned long _frameStartUs; // Arrival of the frame being handled
+  uint32_t _commandCount;
+  uint32_t _ackFailures;
+  uint32_t _lastSeq;
+  uint32_t _latencyUs[WS_LATENCY_WINDOW];
+  uint8_t _latencyIndex;
+
+  void sendAck(const char *action, uint32_t seq, uint32_t latencyUs);
+
   // Persistence
   void loadSettings();
   void saveSettings();
 
 public:
-  // Getters for UI persistence
-  String getHost() { return _serverHost; }
-  uint16_t getPort() { return _serverPort; }
-  String getPath() { return _serverPath; }
+  // Getters for UI persistence (the primary server)
+  String getHost() { return _upstreams[0].host; }
+  uint16_t getPort() { return _upstreams[0].port; }
+  String getPath() { return _upstreams[0].path; }
 
 private:
 #ifdef ARDUINO_ARCH_RP2040
@@ -67,19 +67,205 @@ Adafruit_Protomatter::Adafruit_Protomatter(uint16_t bitWidth, uint8_t bitDepth,
 Adafruit_Protomatter::~Adafruit_Protomatter(void) {
   _PM_deallocate(&core);
   _PM_protoPtr = NULL;
+  free(shadow);
+  free(maskShadow);
 }
 
 ProtomatterStatus Adafruit_Protomatter::begin(void) {
   _PM_protoPtr = &core;
-  return _PM_begin(&core);
+  ProtomatterStatus status = _PM_begin(&core);
+  if (status == PROTOMATTER_OK && !shadow) {
+    // Without the copy, every show() simply converts the whole canvas
+    shadow = (uint16_t *)malloc(WIDTH * HEIGHT * sizeof(uint16_t));
+  }
+  invalidate();
+  return status;
+}
+
+ProtomatterStatus Adafruit_Protomatter::setBitDepth(uint8_t bitDepth) {
+  if (bitDepth > 6)
+    return PROTOMATTER_ERR_ARG; // GFXcanvas16 color limit (565)
+  ProtomatterStatus status = _PM_setBitDepth(&core, bitDepth);
+  invalidate(); // Both buffers were cleared
+  return status;
+}
+
+// The converters read the canvas in the rotated scan order. For a quarter
+// turn the same buffer is drawn height x width, so the canvas dimensions
+// swap; the GFX rotation is reapplied to update width() and height().
+void Adafruit_Protomatter::setMatrixRotation(uint8_t rotation) {
+  rotation &= 3;
+  if (rotation == core.rotation)
+    return;
+  if ((rotation ^ core.rotation) & 1) {
+    int16_t w = WIDTH;
+    WIDTH = HEIGHT;
+    HEIGHT = w;
+    setRotation(getRotation());
+  }
+  free(maskShadow); // Laid out for the old dimensions
+  maskShadow = NULL;
+  _PM_setRotation(&core, rotation);
+  invalidate();
+}
+
+// Matrix row (0 to height - 1, before tiling) showing canvas pixel x, y.
+// Inverse of the mapping in _PM_rowSource().
+int16_t Adafruit_Protomatter::matrixRow(int16_t x, int16_t y) {
+  switch (core.rotation) {
+  case 1:
+    return x;
+  case 2:
+    return HEIGHT - 1 - y;
+  case 3:
+    return WIDTH - 1 - x;
+  default:
+    return y;
+  }
+}
+
+// Row pair holding matrix row y: row y % numRowPairs of its tile
+// (mirrored on odd serpentine tiles), as in the converters.
+uint32_t Adafruit_Protomatter::rowPairBit(int16_t y) {
+  uint8_t pairs = core.numRowPairs;
+  uint8_t tiles = core.tile ? abs(core.tile) : 1;
+  uint8_t row = y % pairs;
+  if ((((y / (pairs * 2)) % tiles) & 1) && (core.tile < 0))
+    row = pairs - 1 - row;
+  return 1UL << row;
+}
+
+// Find the row pairs whose canvas rows differ from the last frame shown,
+// updating the copy as it goes. With a quarter turn a canvas row crosses
+// every row pair, so only its changed pixels count.
+uint32_t Adafruit_Protomatter::changedRows(void) {
+  const uint16_t *canvas = getBuffer();
+  size_t rowBytes = WIDTH * sizeof(uint16_t);
+  uint32_t changed = 0;
+
+  for (int16_t y = 0; y < HEIGHT; y++) {
+    const uint16_t *src = canvas + y * WIDTH;
+    uint16_t *copy = shadow + y * WIDTH;
+    if (!memcmp(src, copy, rowBytes))
+      continue;
+    if (core.rotation & 1) {
+      for (int16_t x = 0; x < WIDTH; x++)
+        if (src[x] != copy[x])
+          changed |= rowPairBit(matrixRow(x, y));
+    } else {
+      changed |= rowPairBit(matrixRow(0, y));
+    }
+    memcpy(copy, src, rowBytes);
+  }
+  return changed;
+}
+
+// Same for a mask passed to showMask(); a new color changes every row.
+uint32_t Adafruit_Protomatter::changedMaskRows(const uint8_t *mask,
+                                               uint16_t color) {
+  size_t rowBytes = (WIDTH + 7) / 8;
+  if (!maskShadow) {
+    maskShadow = (uint8_t *)malloc(rowBytes * HEIGHT);
+    if (!maskShadow)
+      return 0xFFFFFFFF;
+    memcpy(maskShadow, mask, rowBytes * HEIGHT);
+    maskColor = color;
+    return 0xFFFFFFFF;
+  }
+
+  uint32_t changed = 0;
+  if (color != maskColor) {
+    maskColor = color;
+    changed = 0xFFFFFFFF;
+  }
+  for (int16_t y = 0; y < HEIGHT; y++) {
+    const uint8_t *src = mask + y * rowBytes;
+    uint8_t *copy = maskShadow + y * rowBytes;
+    if (!memcmp(src, copy, rowBytes))
+      continue;
+    if (core.rotation & 1) {
+      for (int16_t x = 0; x < WIDTH; x++)
+        if ((src[x / 8] ^ copy[x / 8]) & (0x80 >> (x & 7)))
+          changed |= rowPairBit(matrixRow(x, y));
+    } else {
+      changed |= rowPairBit(matrixRow(0, y));
+    }
+    memcpy(copy, src, rowBytes);
+  }
+  return changed;
+}
+
+// Convert the changed row pairs from the canvas (mask NULL) or a mask into
+// the back buffer and swap. A row pair is converted into a buffer only if
+// it changed since that buffer last received it, so each buffer of a
+// double-buffered matrix keeps its own dirty mask. Returns false if the
+// mask can't be converted in this configuration (nothing is changed then).
+bool Adafruit_Protomatter::update(uint32_t start, uint32_t changed,
+                                  const uint8_t *mask, uint16_t color) {
+  uint8_t back = core.doubleBuffer ? 1 - core.activeBuffer : 0;
+  uint32_t rows = dirtyRows[back] | changed;
+  uint32_t all = (core.numRowPairs < 32) ? (1UL << core.numRowPairs) - 1
+                                         : 0xFFFFFFFF;
+  rows &= all;
+  if (rows) {
+    if (!mask)
+      _PM_convert_565_rows(&core, getBuffer(), core.width, rows);
+    else if (!_PM_convert_mask(&core, mask, core.width, color, rows))
+      return false;
+  }
+  dirtyRows[0] |= changed;
+  dirtyRows[1] |= changed;
+  dirtyRows[back] = 0;
+
+  uint32_t elapsed = micros() - start;
+  convertStats.frames++;
+  convertStats.lastUs = elapsed;
+  if (elapsed > convertStats.maxUs)
+    convertStats.maxUs = elapsed;
+  if (rows == all)
+    convertStats.fullUs = elapsed;
+  for (uint32_t r = rows; r; r &= r - 1)
+    convertStats.rowPairs++;
+
+  // The displayed buffer is already current if nothing changed since it
+  // was converted either; don't wait on the interrupt for a no-op swap
+  if (!rows && (!core.doubleBuffer || !(dirtyRows[1 - back] & all))) {
+    convertStats.skipped++;
+    return true;
+  }
+  _PM_swapbuffer_maybe(&core);
+  return true;
 }
 
 // Transfer data from GFXcanvas16 to the matrix framebuffer's weird
 // internal format. The actual conversion functions referenced below
 // are in core.c, reasoning is explained there.
 void Adafruit_Protomatter::show(void) {
-  _PM_convert_565(&core, getBuffer(), WIDTH);
-  _PM_swapbuffer_maybe(&core);
+  uint32_t start = micros();
+  uint32_t changed = shadow ? changedRows() : 0xFFFFFFFF;
+  if (maskShown) {
+    // The matrix holds mask frames, whatever the canvas copy says
+    maskShown = false;
+    changed = 0xFFFFFFFF;
+  }
+  update(start, changed, NULL, 0);
+}
+
+// As show(), from a 1-bit mask instead of the canvas, which is left as is.
+bool Adafruit_Protomatter::showMask(const uint8_t *mask, uint16_t color) {
+  if (getRotation() != 0)
+    return false; // The converter reads the mask as the canvas is stored
+  uint32_t start = micros();
+  uint32_t changed = changedMaskRows(mask, color);
+  if (!maskShown)
+    changed = 0xFFFFFFFF; // The matrix holds canvas frames
+  if (!update(start, changed, mask, color)) {
+    free(maskShadow); // Not converted, so the copy is wrong
+    maskShadow = NULL;
+    return false;
+  }
+  maskShown = true;
+  return true;
 }
 
 // Returns current value of frame counter and resets its value to zero.
@@ -13,6 +13,18 @@
 */
 class Adafruit_Protomatter : public GFXcanvas16 {
 public:
+  /*!
+    @brief  Canvas-to-matrix conversion statistics, see show().
+  */
+  typedef struct {
+    uint32_t frames;   ///< show() and showMask() calls
+    uint32_t rowPairs; ///< Row pairs converted, over all frames
+    uint32_t skipped;  ///< Frames with nothing to convert or swap
+    uint32_t lastUs;   ///< Duration of the last show() (without swap wait)
+    uint32_t maxUs;    ///< Longest show()
+    uint32_t fullUs;   ///< Duration of the last full-frame show()
+  } ConvertStats;
+
   /*!
     @brief  Adafruit_Protomatter constructor.
     @param  bitWidth      Total width of RGB matrix chain, in pixels.
@@ -88,10 +100,116 @@ public:
 
   /*!
     @brief Process data from GFXcanvas16 to the matrix framebuffer's
-           internal format for display.
+           internal format for display. Only row pairs whose canvas rows
+           changed since the target buffer was last converted are
+           processed (the canvas is compared with a copy of the last frame
+           shown), and the buffer swap is skipped if nothing changed.
   */
   void show(void);
 
+  /*!
+    @brief  Display a 1-bit mask (e.g. text rendered into a GFXcanvas1 of
+            the matrix size) in a single color on black, without going
+            through the 16-bit canvas, which is left untouched. Changed
+            rows are tracked as in show(); a following show() redraws the
+            whole canvas.
+    @param  mask   Mask data in GFXcanvas1 layout (rows padded to whole
+                   bytes, leftmost pixel in the most significant bit), in
+                   canvas orientation (see setMatrixRotation()).
+    @param  color  RGB565 color of set pixels.
+    @return true if displayed. false if not supported with this matrix
+            setup (more than one parallel chain, more than 5 bitplanes, a
+            GFX setRotation() or, rotated a quarter turn, a matrix height
+            that isn't a multiple of 8), in which case the caller should draw to
+            the canvas and use show().
+  */
+  bool showMask(const uint8_t *mask, uint16_t color);
+
+  /*!
+    @brief Force the next show() calls to convert every row into both
+           buffers, e.g. after changing how the matrix data is built.
+  */
+  void invalidate(void) { dirtyRows[0] = dirtyRows[1] = 0xFFFFFFFF; }
+
+  /*!
+    @brief  Get conversion statistics.
+    @return Reference to the counters, updated by each show() and
+            showMask().
+  */
+  const ConvertStats &getConvertStats(void) const { return convertStats; }
+
+  /*!
+    @brief  Set the approximate maximum refresh rate (default 250 Hz).
+            Raising it lets a low bit depth refresh at several kHz, e.g.
+            for cameras, at the cost of CPU time and brightness.
+    @param  hz  Refresh cap in frames per second.
+  */
+  void setMaxRefresh(uint16_t hz) { _PM_setMaxRefresh(&core, hz); }
+
+  /*!
+    @brief  Get the refresh cap.
+    @return Frames per second.
+  */
+  uint16_t getMaxRefresh(void) const { return core.maxRefresh; }
+
+  /*!
+    @brief  Get the time spent refreshing the matrix (in the row interrupt)
+            since the previous call, which resets it. Divided by the time
+            between calls, this is the refresh CPU load.
+    @return Microseconds (0 if not measurable on this architecture).
+  */
+  uint32_t getIsrMicros(void) { return _PM_getIsrMicros(&core); }
+
+  /*!
+    @brief  Set the brightness in the driver by shortening the time each
+            bitplane is lit, keeping full color resolution (unlike scaling
+            the colors). Costs nothing per frame drawn.
+    @param  brightness  0 (dark) to 255 (full, default).
+  */
+  void setBrightness(uint8_t brightness) {
+    _PM_setBrightness(&core, brightness);
+  }
+
+  /*!
+    @brief  Get the brightness.
+    @return 0 (dark) to 255 (full).
+  */
+  uint8_t getBrightness(void) const { return core.brightness; }
+
+  /*!
+    @brief  Rotate the display in the conversion stage: show() reads the
+            canvas in the rotated matrix's scan order, so drawing needs no
+            per-pixel transform (unlike GFX setRotation()) and every
+            orientation converts equally fast. For 1 and 3 the canvas
+            becomes height x width; width() and height() follow. Draw
+            everything again after a change.
+    @param  rotation  0-3, quarter turns clockwise.
+  */
+  void setMatrixRotation(uint8_t rotation);
+
+  /*!
+    @brief  Get the conversion stage rotation.
+    @return 0-3, quarter turns clockwise.
+  */
+  uint8_t getMatrixRotation(void) const { return core.rotation; }
+
+  /*!
+    @brief  Change the number of bitplanes while running. The matrix
+            buffers are reallocated and cleared, so the next show()
+            converts the whole canvas.
+    @param  bitDepth  Bitplanes, 1 to 6.
+    @return PROTOMATTER_OK on success, PROTOMATTER_ERR_MALLOC if the
+            buffers don't fit (the previous depth stays in use) or
+            PROTOMATTER_ERR_ARG for a bad value.
+  */
+  ProtomatterStatus setBitDepth(uint8_t bitDepth);
+
+  /*!
+    @brief  Get the number of bitplanes in use.
+    @return Bit depth, 1 to 6.
+  */
+  uint8_t getBitDepth(void) const { return core.numPlanes; }
+
   /*!
     @brief Disable (but do not deallocate) a Protomatter matrix.
   */
@@ -156,6 +274,18 @@ public:
 
 private:
   Protomatter_core core;             // Underlying C struct
+  uint16_t *shadow = NULL;           // Canvas as of the last show()
+  uint32_t dirtyRows[2] = {0xFFFFFFFF, 0xFFFFFFFF}; // Per matrix buffer
+  ConvertStats convertStats = {};
+  uint8_t *maskShadow = NULL;        // Mask as of the last showMask()
+  uint16_t maskColor = 0;            // Color of that mask
+  bool maskShown = false;            // Matrix holds showMask() frames
+  int16_t matrixRow(int16_t x, int16_t y); // Matrix row of canvas pixel
+  uint32_t rowPairBit(int16_t y);    // Row pair bit for matrix row y
+  uint32_t changedRows(void);        // Compare canvas to shadow
+  uint32_t changedMaskRows(const uint8_t *mask, uint16_t color);
+  bool update(uint32_t start, uint32_t changed, const uint8_t *mask,
+              uint16_t color);       // Convert dirty rows and swap
   void convert_byte(uint8_t *dest);  // GFXcanvas16-to-matrix
   void convert_word(uint16_t *dest); // conversion functions
   void convert_long(uint32_t *dest); // for 8/16/32 bit bufs
@@ -131,6 +131,10 @@ _PM_clockHoldLow:            Additional code (e.g. NOPs) needed to delay
 _PM_minMinPeriod:            Mininum value for the "minPeriod" class member,
                              so bit-angle-modulation time always doubles with
                              each bitplane (else lower bits may be the same).
+_PM_cpuClock():              Optional free-running counter (any rate, may
+                             wrap) used to measure time spent in the row
+                             interrupt, with _PM_cpuClockFreq its rate in
+                             Hz. If undefined, ISR time reads as zero.
 _PM_allocate:                Memory allocation function, should return a
                              pointer to a buffer of requested size, aligned
                              to the architecture's largest native type.
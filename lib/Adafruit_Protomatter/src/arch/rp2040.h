@@ -231,6 +231,12 @@ inline uint32_t _PM_timerGetCount(Protomatter_core *core) {
 #endif
 }
 
+// The 1 MHz system timer is free-running for either timing peripheral.
+// Its resolution is coarse next to one interrupt, but the rounding errors
+// average out over the thousands of interrupts in a measurement.
+#define _PM_cpuClock() (timer_hw->timerawl)
+#define _PM_cpuClockFreq 1000000
+
 // Disable timer and return current count value.
 // Timer must be previously initialized.
 uint32_t _PM_timerStop(Protomatter_core *core) {
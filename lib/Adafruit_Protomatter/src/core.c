@@ -146,6 +146,11 @@ ProtomatterStatus _PM_init(Protomatter_core *core, uint16_t bitWidth,
   core->doubleBuffer = doubleBuffer;
   core->addr = NULL;
   core->screenData = NULL;
+  core->maxRefresh = _PM_MAX_REFRESH_HZ;
+  core->isrTime = 0;
+  core->brightness = 255;
+  core->rotation = 0;
+  core->lightPending = false;
 
   // Make a copy of the rgbList and addrList tables in case they're
   // passed from local vars on the stack or some other non-persistent
@@ -168,6 +173,17 @@ ProtomatterStatus _PM_init(Protomatter_core *core, uint16_t bitWidth,
   return PROTOMATTER_ERR_MALLOC;
 }
 
+// Minimum bitplane #0 period for the maxRefresh rate (see the comment on
+// _PM_MAX_REFRESH_HZ)
+static void _PM_calcMinPeriod(Protomatter_core *core) {
+  uint32_t minPeriodPerFrame = _PM_timerFreq / core->maxRefresh;
+  uint32_t minPeriodPerLine = minPeriodPerFrame / core->numRowPairs;
+  core->minPeriod = minPeriodPerLine / ((1 << core->numPlanes) - 1);
+  if (core->minPeriod < _PM_minMinPeriod) {
+    core->minPeriod = _PM_minMinPeriod;
+  }
+}
+
 // Allocate display buffers and populate additional elements.
 ProtomatterStatus _PM_begin(Protomatter_core *core) {
   if (!core)
@@ -338,13 +354,8 @@ ProtomatterStatus _PM_begin(Protomatter_core *core) {
     }
   }
 
-  // Estimate minimum bitplane #0 period for _PM_MAX_REFRESH_HZ rate.
-  uint32_t minPeriodPerFrame = _PM_timerFreq / _PM_MAX_REFRESH_HZ;
-  uint32_t minPeriodPerLine = minPeriodPerFrame / core->numRowPairs;
-  core->minPeriod = minPeriodPerLine / ((1 << core->numPlanes) - 1);
-  if (core->minPeriod < _PM_minMinPeriod) {
-    core->minPeriod = _PM_minMinPeriod;
-  }
+  // Estimate minimum bitplane #0 period for maxRefresh rate.
+  _PM_calcMinPeriod(core);
   core->bitZeroPeriod = core->minPeriod;
   // Actual frame rate may be lower than this...it's only an estimate
   // and does not factor in things like address line selection delays
@@ -456,6 +467,7 @@ void _PM_resume(Protomatter_core *core) {
     core->prevRow = (core->numRowPairs > 1) ? (core->row - 1) : 1;
     core->swapBuffers = 0;
     core->frameCount = 0;
+    core->lightPending = false;
 
     for (uint8_t line = 0, bit = 1; line < core->numAddressLines;
          line++, bit <<= 1) {
@@ -488,6 +500,58 @@ void _PM_deallocate(Protomatter_core *core) {
   }
 }
 
+// The ISR only ever raises bitZeroPeriod to the data issue time and clamps
+// it to minPeriod, so restarting from the new minimum is enough for it to
+// settle within a few frames.
+void _PM_setMaxRefresh(Protomatter_core *core, uint16_t hz) {
+  if (!core || !hz)
+    return;
+  core->maxRefresh = hz;
+  if (core->screenData) { // Else _PM_begin() does this
+    _PM_calcMinPeriod(core);
+    core->bitZeroPeriod = core->minPeriod;
+  }
+}
+
+void _PM_setBrightness(Protomatter_core *core, uint8_t brightness) {
+  if ((core)) {
+    core->brightness = brightness;
+  }
+}
+
+void _PM_setRotation(Protomatter_core *core, uint8_t rotation) {
+  if ((core)) {
+    core->rotation = rotation & 3;
+  }
+}
+
+// Change the number of bitplanes of a running matrix. The matrix is
+// stopped (so the ISR no longer reads screenData), its buffers are freed and
+// _PM_begin() allocates and clears them for the new depth and restarts it.
+// If the new buffers can't be allocated, the previous depth is restored.
+ProtomatterStatus _PM_setBitDepth(Protomatter_core *core, uint8_t bitDepth) {
+  if (!core || !bitDepth)
+    return PROTOMATTER_ERR_ARG;
+  if (!core->screenData) { // Not begun (or begin failed), nothing to move
+    core->numPlanes = bitDepth;
+    return PROTOMATTER_OK;
+  }
+  if (bitDepth == core->numPlanes)
+    return PROTOMATTER_OK;
+
+  uint8_t previous = core->numPlanes;
+  _PM_stop(core);
+  _PM_free(core->screenData);
+  core->screenData = NULL;
+  core->numPlanes = bitDepth;
+  ProtomatterStatus status = _PM_begin(core);
+  if (status != PROTOMATTER_OK) {
+    core->numPlanes = previous; // Buffers for this depth fit before
+    (void)_PM_begin(core);
+  }
+  return status;
+}
+
 // ISR function (in arch.h) calls this function which it extern'd.
 // Profuse apologies for the ESP32-specific IRAM_ATTR here -- the goal was
 // for all architecture-specific detauls to be in arch.h -- but the need
@@ -498,6 +562,23 @@ void _PM_deallocate(Protomatter_core *core) {
 // specific section of arch.h. Sorry. :/
 // Any functions called by this function should also be IRAM_ATTR'd.
 IRAM_ATTR void _PM_row_handler(Protomatter_core *core) {
+#if defined(_PM_cpuClock)
+  uint32_t isrStart = _PM_cpuClock();
+#endif
+
+  // When dimmed, each plane is shown as a dark phase followed by a lit
+  // phase. Dark first: its end is what gets delayed when issuing the next
+  // plane's data overruns it, and the lit time has to stay exact.
+  if (core->lightPending) { // Dark phase over, light the plane
+    core->lightPending = false;
+    (void)_PM_timerStop(core);
+    _PM_timerStart(core, core->lightPeriod);
+    _PM_clearReg(core->oe); // Enable LED output
+#if defined(_PM_cpuClock)
+    core->isrTime += _PM_cpuClock() - isrStart;
+#endif
+    return;
+  }
 
   _PM_setReg(core->oe); // Disable LED output
 
@@ -576,10 +657,15 @@ IRAM_ATTR void _PM_row_handler(Protomatter_core *core) {
   // 'prevPlane' is the previously-loaded data, which gets displayed
   // now while the next plane data is loaded.
 
-  // Set timer and enable LED output for data loaded on PRIOR pass:
-  _PM_timerStart(core, core->bitZeroPeriod << prevPlane);
-  _PM_delayMicroseconds(1); // Appease Teensy4
-  _PM_clearReg(core->oe);   // Enable LED output
+  // Set timer and enable LED output for data loaded on PRIOR pass
+  // (if dimmed, output stays disabled until the lit phase):
+  uint32_t period = core->bitZeroPeriod << prevPlane;
+  uint8_t brightness = core->brightness;
+  _PM_timerStart(core, period);
+  if (brightness == 255) {
+    _PM_delayMicroseconds(1); // Appease Teensy4
+    _PM_clearReg(core->oe);   // Enable LED output
+  }
 
   uint32_t elementsPerLine =
       _PM_chunkSize * ((core->chainBits + (_PM_chunkSize - 1)) / _PM_chunkSize);
@@ -618,6 +704,30 @@ IRAM_ATTR void _PM_row_handler(Protomatter_core *core) {
       core->bitZeroPeriod = core->minPeriod;
     }
   }
+
+  // Dimmed: the timer was started for the whole period (so the data issue
+  // time above is measured the same way), now split off the lit phase.
+  // At 0 the plane simply stays dark.
+  if ((brightness < 255) && (brightness > 0)) {
+    uint32_t light = (period * (brightness + 1)) >> 8;
+    if (light == 0) {
+      light = 1;
+    }
+    uint32_t dark = period - light;
+    uint32_t elapsed = _PM_timerStop(core);
+    if (elapsed < dark) {
+      core->lightPeriod = light;
+      core->lightPending = true;
+      _PM_timerStart(core, dark - elapsed);
+    } else { // Issuing the data took up the dark phase, light now
+      _PM_timerStart(core, light);
+      _PM_clearReg(core->oe);
+    }
+  }
+
+#if defined(_PM_cpuClock)
+  core->isrTime += _PM_cpuClock() - isrStart;
+#endif
 }
 
 #if !defined _PM_CUSTOM_BLAST
@@ -868,6 +978,20 @@ uint32_t _PM_getFrameCount(Protomatter_core *core) {
   return count;
 }
 
+uint32_t _PM_getIsrMicros(Protomatter_core *core) {
+#if defined(_PM_cpuClock)
+  uint32_t ticks = 0;
+  if ((core)) {
+    ticks = core->isrTime;
+    core->isrTime = 0;
+  }
+  return (uint32_t)((uint64_t)ticks * 1000000 / _PM_cpuClockFreq);
+#else
+  (void)core; // isrTime is only accumulated with a cycle counter
+  return 0;
+#endif
+}
+
 void _PM_swapbuffer_maybe(Protomatter_core *core) {
   if (core->doubleBuffer) {
     core->swapBuffers = 1;
@@ -943,6 +1067,150 @@ void _PM_setDuty(uint8_t d) { _PM_duty = (d > _PM_maxDuty) ? _PM_maxDuty : d; }
 // Different runtime environments (which might not use the 565 canvas
 // format) will need their own conversion functions.
 
+// FAST PATH: the bit-test loops below read every pixel once per bitplane
+// and test six bits each time, which dominates show() on cores without
+// SIMD (e.g. Cortex-M0+). For a single matrix chain of up to 5 bitplanes,
+// each row is instead converted in two passes over short chunks of pixels:
+// the first transposes each upper/lower pixel pair into one 32-bit word
+// holding, in 6-bit field N, the rgbMask index (upper R,G,B = bits 0-2,
+// lower R,G,B = bits 3-5) for bitplane N; the second walks each bitplane
+// in order, mapping those indices through a 64-entry table of PORT bit
+// combinations. Output is bit-for-bit what the loops below produce.
+
+#define _PM_FAST_MAX_PLANES 5 ///< 6-bit fields in a 32-bit word
+#define _PM_FAST_CHUNK 32     ///< Pixels transposed per pass
+
+// Plane bits of a 565 pixel's high and low byte, laid out as above for the
+// upper pixel (the lower pixel's are the same shifted up by 3). Built for
+// _PM_fastPlanes bitplanes, on first use and when the depth changes.
+static uint32_t _PM_fastHigh[256], _PM_fastLow[256];
+static uint8_t _PM_fastPlanes = 0;
+
+static bool _PM_fastTables(Protomatter_core *core) {
+  if ((core->parallel != 1) || (core->numPlanes > _PM_FAST_MAX_PLANES))
+    return false;
+  if (_PM_fastPlanes == core->numPlanes)
+    return true;
+
+  // Same per-plane color bits the bit-test loops step through
+  uint16_t redBit[_PM_FAST_MAX_PLANES], greenBit[_PM_FAST_MAX_PLANES],
+      blueBit[_PM_FAST_MAX_PLANES];
+  uint8_t shiftLeft = 5 - core->numPlanes;
+  for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
+    redBit[plane] = 0b0000100000000000 << (shiftLeft + plane);
+    greenBit[plane] = 0b0000000001000000 << (shiftLeft + plane);
+    blueBit[plane] = 0b0000000000000001 << (shiftLeft + plane);
+  }
+
+  for (uint16_t i = 0; i < 256; i++) {
+    uint32_t high = 0, low = 0;
+    for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
+      uint8_t shift = plane * 6;
+      uint16_t h = i << 8;
+      if (h & redBit[plane])
+        high |= 1UL << shift;
+      if (h & greenBit[plane])
+        high |= 2UL << shift;
+      if (h & blueBit[plane])
+        high |= 4UL << shift;
+      if (i & redBit[plane])
+        low |= 1UL << shift;
+      if (i & greenBit[plane])
+        low |= 2UL << shift;
+      if (i & blueBit[plane])
+        low |= 4UL << shift;
+    }
+    _PM_fastHigh[i] = high;
+    _PM_fastLow[i] = low;
+  }
+  _PM_fastPlanes = core->numPlanes;
+  return true;
+}
+
+// Single-color 1-bit mask being converted by _PM_convert_mask() in place of
+// a 565 canvas (NULL otherwise), and the color's plane fields
+static const uint8_t *_PM_fastMask = NULL;
+static uint32_t _PM_fastMaskBits;
+
+// Canvas elements of the first pixel a tile's row pair issues (upper and
+// lower half) and the step to the next one. The matrix scans an unrotated
+// canvas of width x (parallel * tiles * row pairs * 2) pixels; a rotation
+// maps that scan onto the canvas as drawn, the same way GFX's
+// setRotation() maps drawing, so every orientation converts at the same
+// cost. For rotations 1 and 3 the canvas as drawn is height x width.
+static void _PM_rowSource(Protomatter_core *core, uint16_t width,
+                          uint8_t chain, int8_t tile, uint8_t row,
+                          int32_t *upper, int32_t *lower, int32_t *step) {
+  uint8_t tiles = abs(core->tile);
+  int32_t height = (int32_t)core->parallel * tiles * core->numRowPairs * 2;
+  int32_t tileTop = (int32_t)(chain * tiles + tile) * core->numRowPairs * 2;
+  int32_t x, upperY, lowerY, dx;
+  if ((tile & 1) && (core->tile < 0)) {
+    // Special handling for serpentine tiles
+    lowerY = tileTop + core->numRowPairs - 1 - row;
+    upperY = lowerY + core->numRowPairs;
+    x = width - 1; // Work right to left
+    dx = -1;
+  } else {
+    // Progressive tile
+    upperY = tileTop + row;              // Top row
+    lowerY = upperY + core->numRowPairs; // Bottom row
+    x = 0;                               // Left to right
+    dx = 1;
+  }
+
+  switch (core->rotation) {
+  case 1: // Matrix column x is canvas row width - 1 - x
+    *upper = (width - 1 - x) * height + upperY;
+    *lower = (width - 1 - x) * height + lowerY;
+    *step = -dx * height;
+    break;
+  case 2: // Upside down
+    *upper = (height - 1 - upperY) * width + (width - 1 - x);
+    *lower = (height - 1 - lowerY) * width + (width - 1 - x);
+    *step = -dx;
+    break;
+  case 3: // Matrix column x is canvas row x, rows mirrored
+    *upper = x * height + (height - 1 - upperY);
+    *lower = x * height + (height - 1 - lowerY);
+    *step = dx * height;
+    break;
+  default:
+    *upper = upperY * width + x;
+    *lower = lowerY * width + x;
+    *step = dx;
+  }
+}
+
+// First pass: transpose count pixel pairs (canvas elements upperIdx and
+// lowerIdx onwards, srcInc apart) into per-plane index fields
+static void _PM_fastIndices(const uint16_t *source, int32_t upperIdx,
+                            int32_t lowerIdx, int32_t srcInc, uint8_t count,
+                            uint32_t *out) {
+  if (_PM_fastMask) {
+    // GFXcanvas1 layout, MSB leftmost. Rows are whole bytes (checked by
+    // _PM_convert_mask()), so the bit index is the pixel index.
+    uint32_t upperBits = _PM_fastMaskBits, lowerBits = _PM_fastMaskBits << 3;
+    for (uint8_t i = 0; i < count;
+         i++, upperIdx += srcInc, lowerIdx += srcInc) {
+      uint8_t upper = _PM_fastMask[upperIdx >> 3] << (upperIdx & 7);
+      uint8_t lower = _PM_fastMask[lowerIdx >> 3] << (lowerIdx & 7);
+      out[i] = ((upper & 0x80) ? upperBits : 0) |
+               ((lower & 0x80) ? lowerBits : 0);
+    }
+    return;
+  }
+
+  for (uint8_t i = 0; i < count;
+       i++, upperIdx += srcInc, lowerIdx += srcInc) {
+    uint16_t upperRGB = source[upperIdx];
+    uint16_t lowerRGB = source[lowerIdx];
+    out[i] = _PM_fastHigh[upperRGB >> 8] | _PM_fastLow[upperRGB & 0xFF] |
+             ((_PM_fastHigh[lowerRGB >> 8] | _PM_fastLow[lowerRGB & 0xFF])
+              << 3);
+  }
+}
+
 // There are THREE COPIES of the following function -- one each for byte,
 // word and long. If changes are made in any one of them, the others MUST
 // be updated to match! Note that they are not simple duplicates of each
@@ -951,10 +1219,13 @@ void _PM_setDuty(uint8_t d) { _PM_duty = (d > _PM_maxDuty) ? _PM_maxDuty : d; }
 
 // width argument comes from GFX canvas width, which may be less than
 // core's bitWidth (due to padding). height isn't needed, it can be
-// inferred from core->numRowPairs and core->tile.
+// inferred from core->numRowPairs and core->tile. rowMask has a bit set
+// for each row pair to convert (bit 0 = row pair 0); the others are left
+// as they are in the destination buffer.
 __attribute__((noinline)) void _PM_convert_565_byte(Protomatter_core *core,
                                                     const uint16_t *source,
-                                                    uint16_t width) {
+                                                    uint16_t width,
+                                                    uint32_t rowMask) {
   uint8_t *pinMask = (uint8_t *)core->rgbMask; // Pin bitmasks
   uint8_t *dest = (uint8_t *)core->screenData;
   if (core->doubleBuffer) {
@@ -972,9 +1243,9 @@ __attribute__((noinline)) void _PM_convert_565_byte(Protomatter_core *core,
 #endif
 #endif
 
-  // No need to clear matrix buffer, loops below do a full overwrite
-  // (except for any scanline pad, which was already initialized in the
-  // begin() function and won't be touched here).
+  // No need to clear matrix buffer, loops below do a full overwrite of
+  // each converted row (except for any scanline pad, which was already
+  // initialized in the begin() function and won't be touched here).
 
   // Determine matrix bytes per bitplane & row (row pair really):
 
@@ -1013,10 +1284,73 @@ __attribute__((noinline)) void _PM_convert_565_byte(Protomatter_core *core,
     initialBlueBit = 0b0000000000000001 << shiftLeft;
   }
 
+  // PORT bits for each rgbMask index, for the fast path
+  bool fast = _PM_fastTables(core);
+  uint8_t portBits[64];
+  if (fast) {
+    portBits[0] = 0;
+    for (uint8_t i = 1; i < 64; i++) // Add lowest set bit to a known entry
+      portBits[i] = portBits[i & (i - 1)] | pinMask[__builtin_ctz(i)];
+  }
+
   // This works sequentially-ish through the destination buffer,
   // reading from the canvas source pixels in repeated passes,
   // beginning from the least bit.
   for (uint8_t row = 0; row < core->numRowPairs; row++) {
+    if (!(rowMask & (1UL << row))) {
+      dest += bitplaneSize * core->numPlanes; // Unchanged, skip all planes
+      continue;
+    }
+
+    if (fast) {
+#if defined(_PM_USE_TOGGLE_FORMAT)
+      uint8_t prior[_PM_FAST_MAX_PLANES]; // Per plane, across chunks
+      for (uint8_t plane = 0; plane < core->numPlanes; plane++)
+        prior[plane] = clockMask;
+#endif
+      uint8_t *d2 = dest; // Incremented per-chunk across all tiles
+      for (int8_t tile = abs(core->tile) - 1; tile >= 0; tile--) {
+        int32_t upperIdx, lowerIdx, srcInc; // As in the loop below
+        _PM_rowSource(core, width, 0, tile, row, &upperIdx, &lowerIdx,
+                      &srcInc);
+
+        for (uint16_t x = 0; x < width; x += _PM_FAST_CHUNK) {
+          uint8_t count =
+              (width - x < _PM_FAST_CHUNK) ? width - x : _PM_FAST_CHUNK;
+          uint32_t indices[_PM_FAST_CHUNK];
+          _PM_fastIndices(source, upperIdx, lowerIdx, srcInc, count,
+                          indices);
+          upperIdx += srcInc * count;
+          lowerIdx += srcInc * count;
+          for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
+            uint8_t shift = plane * 6;
+            uint8_t *d3 = d2 + plane * bitplaneSize;
+#if defined(_PM_USE_TOGGLE_FORMAT)
+            uint8_t p = prior[plane];
+            for (uint8_t i = 0; i < count; i++) {
+              uint8_t result = portBits[(indices[i] >> shift) & 63];
+              *d3++ = result ^ p;
+              p = result | clockMask;
+            }
+            prior[plane] = p;
+#else
+            for (uint8_t i = 0; i < count; i++) {
+              *d3++ = portBits[(indices[i] >> shift) & 63];
+            }
+#endif
+          }
+          d2 += count;
+        }
+      }
+#if defined(_PM_USE_TOGGLE_FORMAT)
+      for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
+        (dest + plane * bitplaneSize)[-pad] &= ~clockMask; // As below
+      }
+#endif
+      dest += bitplaneSize * core->numPlanes;
+      continue;
+    }
+
     uint32_t redBit = initialRedBit;
     uint32_t greenBit = initialGreenBit;
     uint32_t blueBit = initialBlueBit;
@@ -1029,26 +1363,14 @@ __attribute__((noinline)) void _PM_convert_565_byte(Protomatter_core *core,
 
       // Work from bottom tile to top, because data is issued in that order
       for (int8_t tile = abs(core->tile) - 1; tile >= 0; tile--) {
-        const uint16_t *upperSrc, *lowerSrc; // Canvas scanline pointers
-        int16_t srcIdx;
-        int8_t srcInc;
-
-        // Source pointer to tile's upper-left pixel
-        const uint16_t *srcTileUL =
-            source + tile * width * core->numRowPairs * 2;
-        if ((tile & 1) && (core->tile < 0)) {
-          // Special handling for serpentine tiles
-          lowerSrc = srcTileUL + width * (core->numRowPairs - 1 - row);
-          upperSrc = lowerSrc + width * core->numRowPairs;
-          srcIdx = width - 1; // Work right to left
-          srcInc = -1;
-        } else {
-          // Progressive tile
-          upperSrc = srcTileUL + width * row;              // Top row
-          lowerSrc = upperSrc + width * core->numRowPairs; // Bottom row
-          srcIdx = 0;                                      // Left to right
-          srcInc = 1;
-        }
+        // Tile's first pixel of the row pair in each half, and the step
+        // to the next (serpentine tiles and rotation are handled there)
+        int32_t upperIdx, lowerIdx, srcInc;
+        _PM_rowSource(core, width, 0, tile, row, &upperIdx, &lowerIdx,
+                      &srcInc);
+        const uint16_t *upperSrc = source + upperIdx; // Canvas scanline
+        const uint16_t *lowerSrc = source + lowerIdx; // pointers
+        int32_t srcIdx = 0;
 
         for (uint16_t x = 0; x < width; x++, srcIdx += srcInc) {
           uint16_t upperRGB = upperSrc[srcIdx]; // Pixel in upper half
@@ -1111,7 +1433,7 @@ __attribute__((noinline)) void _PM_convert_565_byte(Protomatter_core *core,
 // largely the same operation, but changes are noted.
 // WORD OUTPUT IS UNTESTED AND ROW TILING MAY ESPECIALLY PRESENT ISSUES.
 void _PM_convert_565_word(Protomatter_core *core, uint16_t *source,
-                          uint16_t width) {
+                          uint16_t width, uint32_t rowMask) {
   uint16_t *pinMask = (uint16_t *)core->rgbMask; // Pin bitmasks
   uint16_t *dest = (uint16_t *)core->screenData;
   if (core->doubleBuffer) {
@@ -1136,31 +1458,91 @@ void _PM_convert_565_word(Protomatter_core *core, uint16_t *source,
   }
 
   // Unlike the 565 byte converter, the word converter DOES clear out the
-  // matrix buffer (because each chain is OR'd into place). If a toggle
-  // register exists, "clear" really means the clock mask is set in all
-  // but the first element on a scanline (per bitplane). If no toggle
-  // register, can just zero everything out.
+  // matrix buffer (because each chain is OR'd into place), for the rows
+  // being converted. If a toggle register exists, "clear" really means the
+  // clock mask is set in all but the first element on a scanline (per
+  // bitplane). If no toggle register, can just zero everything out.
+  uint32_t rowSize = bitplaneSize * core->numPlanes; // Elements per row pair
+  for (uint8_t row = 0; row < core->numRowPairs; row++) {
+    if (!(rowMask & (1UL << row))) {
+      continue;
+    }
+    uint16_t *rowStart = dest + row * rowSize;
 // #if defined(_PM_portToggleRegister)
 #if defined(_PM_USE_TOGGLE_FORMAT)
-  // No per-chain loop is required; one clock bit handles all chains
-  uint32_t offset = 0; // Current position in the 'dest' buffer
-  uint16_t mask = core->clockMask >> (core->portOffset * 16);
-  for (uint8_t row = 0; row < core->numRowPairs; row++) {
+    // No per-chain loop is required; one clock bit handles all chains
+    uint32_t offset = 0; // Current position in the row pair
+    uint16_t mask = core->clockMask >> (core->portOffset * 16);
     for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
-      dest[offset++] = 0; // First element of each plane
+      rowStart[offset++] = 0; // First element of each plane
       for (uint16_t x = 1; x < bitplaneSize; x++) { // All subsequent items
-        dest[offset++] = mask;
+        rowStart[offset++] = mask;
       }
     }
-  }
 #else
-  memset(dest, 0, core->bufferSize);
+    memset(rowStart, 0, rowSize * sizeof(uint16_t));
 #endif
+  }
 
   dest += pad; // Pad value is in 'elements,' not bytes, so this is OK
 
+  // PORT bits for each rgbMask index, for the fast path (one chain only)
+  bool fast = _PM_fastTables(core);
+  uint16_t portBits[64];
+  if (fast) {
+    portBits[0] = 0;
+    for (uint8_t i = 1; i < 64; i++) // Add lowest set bit to a known entry
+      portBits[i] = portBits[i & (i - 1)] | pinMask[__builtin_ctz(i)];
+  }
+
   for (uint8_t chain = 0; chain < core->parallel; chain++) {
     for (uint8_t row = 0; row < core->numRowPairs; row++) {
+      if (!(rowMask & (1UL << row))) {
+        dest += rowSize; // Unchanged, skip all planes
+        continue;
+      }
+
+      if (fast) {
+#if defined(_PM_USE_TOGGLE_FORMAT)
+        uint16_t prior[_PM_FAST_MAX_PLANES] = {0}; // ORed over clock bits
+#endif
+        uint16_t *d2 = dest; // Incremented per-chunk across all tiles
+        for (int8_t tile = abs(core->tile) - 1; tile >= 0; tile--) {
+          int32_t upperIdx, lowerIdx, srcInc; // As in the loop below
+          _PM_rowSource(core, width, 0, tile, row, &upperIdx, &lowerIdx,
+                        &srcInc);
+
+          for (uint16_t x = 0; x < width; x += _PM_FAST_CHUNK) {
+            uint8_t count =
+                (width - x < _PM_FAST_CHUNK) ? width - x : _PM_FAST_CHUNK;
+            uint32_t indices[_PM_FAST_CHUNK];
+            _PM_fastIndices(source, upperIdx, lowerIdx, srcInc, count,
+                            indices);
+            upperIdx += srcInc * count;
+            lowerIdx += srcInc * count;
+            for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
+              uint8_t shift = plane * 6;
+              uint16_t *d3 = d2 + plane * bitplaneSize;
+#if defined(_PM_USE_TOGGLE_FORMAT)
+              uint16_t p = prior[plane];
+              for (uint8_t i = 0; i < count; i++) {
+                uint16_t result = portBits[(indices[i] >> shift) & 63];
+                *d3++ |= result ^ p;
+                p = result;
+              }
+              prior[plane] = p;
+#else
+              for (uint8_t i = 0; i < count; i++) {
+                *d3++ |= portBits[(indices[i] >> shift) & 63];
+              }
+#endif
+            }
+            d2 += count;
+          }
+        }
+        dest += rowSize;
+        continue;
+      }
       uint32_t redBit = initialRedBit;
       uint32_t greenBit = initialGreenBit;
       uint32_t blueBit = initialBlueBit;
@@ -1175,26 +1557,12 @@ void _PM_convert_565_word(Protomatter_core *core, uint16_t *source,
 
         // Work from bottom tile to top, because data is issued in that order
         for (int8_t tile = abs(core->tile) - 1; tile >= 0; tile--) {
-          uint16_t *upperSrc, *lowerSrc; // Canvas scanline pointers
-          int16_t srcIdx;
-          int8_t srcInc;
-
-          // Source pointer to tile's upper-left pixel
-          uint16_t *srcTileUL = source + (chain * abs(core->tile) + tile) *
-                                             width * core->numRowPairs * 2;
-          if ((tile & 1) && (core->tile < 0)) {
-            // Special handling for serpentine tiles
-            lowerSrc = srcTileUL + width * (core->numRowPairs - 1 - row);
-            upperSrc = lowerSrc + width * core->numRowPairs;
-            srcIdx = width - 1; // Work right to left
-            srcInc = -1;
-          } else {
-            // Progressive tile
-            upperSrc = srcTileUL + width * row;              // Top row
-            lowerSrc = upperSrc + width * core->numRowPairs; // Bottom row
-            srcIdx = 0;                                      // Left to right
-            srcInc = 1;
-          }
+          int32_t upperIdx, lowerIdx, srcInc;
+          _PM_rowSource(core, width, chain, tile, row, &upperIdx, &lowerIdx,
+                        &srcInc);
+          uint16_t *upperSrc = source + upperIdx; // Canvas scanline pointers
+          uint16_t *lowerSrc = source + lowerIdx;
+          int32_t srcIdx = 0;
 
           for (uint16_t x = 0; x < width; x++, srcIdx += srcInc) {
             uint16_t upperRGB = upperSrc[srcIdx]; // Pixel in upper half
@@ -1240,6 +1608,9 @@ void _PM_convert_565_word(Protomatter_core *core, uint16_t *source,
         dest += bitplaneSize; // Advance one scanline in dest buffer
       } // end plane
     } // end row
+    // Every chain ORs into the same rows (the buffer has no per-chain
+    // copy), so go back to the first row for the next one
+    dest -= rowSize * core->numRowPairs;
     pinMask += 6; // Next chain's RGB pin masks
   }
 }
@@ -1249,7 +1620,7 @@ void _PM_convert_565_word(Protomatter_core *core, uint16_t *source,
 // Same deal, comments are pared back, see above functions for explanations.
 // LONG OUTPUT IS UNTESTED AND ROW TILING MAY ESPECIALLY PRESENT ISSUES.
 void _PM_convert_565_long(Protomatter_core *core, uint16_t *source,
-                          uint16_t width) {
+                          uint16_t width, uint32_t rowMask) {
   uint32_t *pinMask = (uint32_t *)core->rgbMask; // Pin bitmasks
   uint32_t *dest = (uint32_t *)core->screenData;
   if (core->doubleBuffer) {
@@ -1273,26 +1644,86 @@ void _PM_convert_565_long(Protomatter_core *core, uint16_t *source,
     initialBlueBit = 0b0000000000000001 << shiftLeft;
   }
 
+  uint32_t rowSize = bitplaneSize * core->numPlanes; // Elements per row pair
+  for (uint8_t row = 0; row < core->numRowPairs; row++) {
+    if (!(rowMask & (1UL << row))) {
+      continue;
+    }
+    uint32_t *rowStart = dest + row * rowSize;
 // #if defined(_PM_portToggleRegister)
 #if defined(_PM_USE_TOGGLE_FORMAT)
-  // No per-chain loop is required; one clock bit handles all chains
-  uint32_t offset = 0; // Current position in the 'dest' buffer
-  for (uint8_t row = 0; row < core->numRowPairs; row++) {
+    // No per-chain loop is required; one clock bit handles all chains
+    uint32_t offset = 0; // Current position in the row pair
     for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
-      dest[offset++] = 0; // First element of each plane
+      rowStart[offset++] = 0; // First element of each plane
       for (uint16_t x = 1; x < bitplaneSize; x++) { // All subsequent items
-        dest[offset++] = core->clockMask;
+        rowStart[offset++] = core->clockMask;
       }
     }
-  }
 #else
-  memset(dest, 0, core->bufferSize);
+    memset(rowStart, 0, rowSize * sizeof(uint32_t));
 #endif
+  }
 
   dest += pad; // Pad value is in 'elements,' not bytes, so this is OK
 
+  // PORT bits for each rgbMask index, for the fast path (one chain only)
+  bool fast = _PM_fastTables(core);
+  uint32_t portBits[64];
+  if (fast) {
+    portBits[0] = 0;
+    for (uint8_t i = 1; i < 64; i++) // Add lowest set bit to a known entry
+      portBits[i] = portBits[i & (i - 1)] | pinMask[__builtin_ctz(i)];
+  }
+
   for (uint8_t chain = 0; chain < core->parallel; chain++) {
     for (uint8_t row = 0; row < core->numRowPairs; row++) {
+      if (!(rowMask & (1UL << row))) {
+        dest += rowSize; // Unchanged, skip all planes
+        continue;
+      }
+
+      if (fast) {
+#if defined(_PM_USE_TOGGLE_FORMAT)
+        uint32_t prior[_PM_FAST_MAX_PLANES] = {0}; // ORed over clock bits
+#endif
+        uint32_t *d2 = dest; // Incremented per-chunk across all tiles
+        for (int8_t tile = abs(core->tile) - 1; tile >= 0; tile--) {
+          int32_t upperIdx, lowerIdx, srcInc; // As in the loop below
+          _PM_rowSource(core, width, 0, tile, row, &upperIdx, &lowerIdx,
+                        &srcInc);
+
+          for (uint16_t x = 0; x < width; x += _PM_FAST_CHUNK) {
+            uint8_t count =
+                (width - x < _PM_FAST_CHUNK) ? width - x : _PM_FAST_CHUNK;
+            uint32_t indices[_PM_FAST_CHUNK];
+            _PM_fastIndices(source, upperIdx, lowerIdx, srcInc, count,
+                            indices);
+            upperIdx += srcInc * count;
+            lowerIdx += srcInc * count;
+            for (uint8_t plane = 0; plane < core->numPlanes; plane++) {
+              uint8_t shift = plane * 6;
+              uint32_t *d3 = d2 + plane * bitplaneSize;
+#if defined(_PM_USE_TOGGLE_FORMAT)
+              uint32_t p = prior[plane];
+              for (uint8_t i = 0; i < count; i++) {
+                uint32_t result = portBits[(indices[i] >> shift) & 63];
+                *d3++ |= result ^ p;
+                p = result;
+              }
+              prior[plane] = p;
+#else
+              for (uint8_t i = 0; i < count; i++) {
+                *d3++ |= portBits[(indices[i] >> shift) & 63];
+              }
+#endif
+            }
+            d2 += count;
+          }
+        }
+        dest += rowSize;
+        continue;
+      }
       uint32_t redBit = initialRedBit;
       uint32_t greenBit = initialGreenBit;
       uint32_t blueBit = initialBlueBit;
@@ -1305,26 +1736,12 @@ void _PM_convert_565_long(Protomatter_core *core, uint16_t *source,
 
         // Work from bottom tile to top, because data is issued in that order
         for (int8_t tile = abs(core->tile) - 1; tile >= 0; tile--) {
-          uint16_t *upperSrc, *lowerSrc; // Canvas scanline pointers
-          int16_t srcIdx;
-          int8_t srcInc;
-
-          // Source pointer to tile's upper-left pixel
-          uint16_t *srcTileUL = source + (chain * abs(core->tile) + tile) *
-                                             width * core->numRowPairs * 2;
-          if ((tile & 1) && (core->tile < 0)) {
-            // Special handling for serpentine tiles
-            lowerSrc = srcTileUL + width * (core->numRowPairs - 1 - row);
-            upperSrc = lowerSrc + width * core->numRowPairs;
-            srcIdx = width - 1; // Work right to left
-            srcInc = -1;
-          } else {
-            // Progressive tile
-            upperSrc = srcTileUL + width * row;              // Top row
-            lowerSrc = upperSrc + width * core->numRowPairs; // Bottom row
-            srcIdx = 0;                                      // Left to right
-            srcInc = 1;
-          }
+          int32_t upperIdx, lowerIdx, srcInc;
+          _PM_rowSource(core, width, chain, tile, row, &upperIdx, &lowerIdx,
+                        &srcInc);
+          uint16_t *upperSrc = source + upperIdx; // Canvas scanline pointers
+          uint16_t *lowerSrc = source + lowerIdx;
+          int32_t srcIdx = 0;
 
           for (uint16_t x = 0; x < width; x++, srcIdx += srcInc) {
             uint16_t upperRGB = upperSrc[srcIdx]; // Pixel in upper half
@@ -1370,24 +1787,48 @@ void _PM_convert_565_long(Protomatter_core *core, uint16_t *source,
         dest += bitplaneSize; // Advance one scanline in dest buffer
       } // end plane
     } // end row
+    // Every chain ORs into the same rows (the buffer has no per-chain
+    // copy), so go back to the first row for the next one
+    dest -= rowSize * core->numRowPairs;
     pinMask += 6; // Next chain's RGB pin masks
   }
 }
 
 void _PM_convert_565(Protomatter_core *core, uint16_t *source, uint16_t width) {
+  _PM_convert_565_rows(core, source, width, 0xFFFFFFFF);
+}
+
+void _PM_convert_565_rows(Protomatter_core *core, uint16_t *source,
+                          uint16_t width, uint32_t rowMask) {
   // Destination address is computed in convert function
   // (based on active buffer value, if double-buffering),
   // just need to pass in the canvas buffer address and
   // width in pixels.
   if (core->bytesPerElement == 1) {
-    _PM_convert_565_byte(core, source, width);
+    _PM_convert_565_byte(core, source, width, rowMask);
   } else if (core->bytesPerElement == 2) {
-    _PM_convert_565_word(core, source, width);
+    _PM_convert_565_word(core, source, width, rowMask);
   } else {
-    _PM_convert_565_long(core, source, width);
+    _PM_convert_565_long(core, source, width, rowMask);
   }
 }
 
+bool _PM_convert_mask(Protomatter_core *core, const uint8_t *mask,
+                      uint16_t width, uint16_t color, uint32_t rowMask) {
+  if (!_PM_fastTables(core))
+    return false; // Only the fast path reads masks
+  uint16_t maskWidth = width; // As drawn
+  if (core->rotation & 1)
+    maskWidth = abs(core->tile) * core->numRowPairs * 2;
+  if (maskWidth & 7)
+    return false; // Padded rows; _PM_fastIndices() indexes bits linearly
+  _PM_fastMask = mask;
+  _PM_fastMaskBits = _PM_fastHigh[color >> 8] | _PM_fastLow[color & 0xFF];
+  _PM_convert_565_rows(core, NULL, width, rowMask); // Source not read
+  _PM_fastMask = NULL;
+  return true;
+}
+
 #endif // END ARDUINO || CIRCUITPY
 
 /* NOTES TO FUTURE SELF ----------------------------------------------------
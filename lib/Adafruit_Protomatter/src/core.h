@@ -70,7 +70,7 @@ typedef struct {
   _PM_pin *addr;                 ///< Array of address pins
   uint32_t bufferSize;           ///< Bytes per matrix buffer
   uint32_t bitZeroPeriod;        ///< Bitplane 0 timer period
-  uint32_t minPeriod;            ///< Plane 0 timer period for ~250Hz
+  uint32_t minPeriod;            ///< Plane 0 timer period for maxRefresh
   volatile uint32_t frameCount;  ///< For estimating refresh rate
   uint16_t width;                ///< Matrix chain width only in bits
   uint16_t chainBits;            ///< Matrix chain width*tiling in bits
@@ -89,6 +89,12 @@ typedef struct {
   volatile uint8_t row;          ///< Current scanline (changes in ISR)
   volatile uint8_t prevRow;      ///< Scanline from prior ISR
   volatile bool swapBuffers;     ///< If 1, awaiting double-buf switch
+  uint16_t maxRefresh;           ///< Refresh cap (Hz) for minPeriod
+  volatile uint32_t isrTime;     ///< _PM_cpuClock ticks spent in ISR
+  uint32_t lightPeriod;          ///< Lit part of the plane being shown
+  volatile uint8_t brightness;   ///< OE on-time per plane, 255 = all
+  volatile bool lightPending;    ///< Next interrupt ends a dark phase
+  uint8_t rotation;              ///< Canvas rotation applied on convert
 } Protomatter_core;
 
 // Protomatter core function prototypes. Environment-specific code (like the
@@ -193,6 +199,53 @@ extern void _PM_stop(Protomatter_core *core);
 */
 extern void _PM_resume(Protomatter_core *core);
 
+/*!
+  @brief  Set the approximate maximum refresh rate. Higher rates let fewer
+          bitplanes refresh faster (e.g. for filming the matrix) at the cost
+          of more CPU time in the interrupt and, with the fixed row change
+          delay weighing more, lower brightness.
+  @param  core  Pointer to Protomatter_core structure.
+  @param  hz    Refresh cap in frames per second (default 250).
+*/
+extern void _PM_setMaxRefresh(Protomatter_core *core, uint16_t hz);
+
+/*!
+  @brief  Set the matrix brightness. Below full brightness each bitplane is
+          shown dark for part of its period and lit (OE active) for the
+          rest, so the planes keep their binary weights and the colors keep
+          their full resolution. Takes effect with the next bitplane; costs
+          one extra interrupt per plane while dimmed.
+  @param  core        Pointer to Protomatter_core structure.
+  @param  brightness  0 (dark) to 255 (full, default).
+*/
+extern void _PM_setBrightness(Protomatter_core *core, uint8_t brightness);
+
+/*!
+  @brief  Set the rotation the 565 and mask converters apply: they read the
+          canvas in the scan order of the rotated matrix, so drawing needs
+          no per-pixel transform. Same orientations as the GFX
+          setRotation() values; for 1 and 3 the canvas passed in is drawn
+          height x width. Convert every row pair after a change.
+  @param  core      Pointer to Protomatter_core structure.
+  @param  rotation  0-3, quarter turns clockwise.
+*/
+extern void _PM_setRotation(Protomatter_core *core, uint8_t rotation);
+
+/*!
+  @brief  Change the bit depth of a running matrix, reallocating (and
+          clearing) its display buffers. The matrix is stopped meanwhile.
+  @param  core      Pointer to Protomatter_core structure.
+  @param  bitDepth  Number of bitplanes (1 or more; the GFX canvas limits
+                    this to 6).
+  @return A ProtomatterStatus status, one of:
+          PROTOMATTER_OK if the new depth is in use.
+          PROTOMATTER_ERR_MALLOC if insufficient RAM for the new depth (the
+          previous depth is restored).
+          PROTOMATTER_ERR_ARG if a bad value.
+*/
+extern ProtomatterStatus _PM_setBitDepth(Protomatter_core *core,
+                                         uint8_t bitDepth);
+
 /*!
   @brief  Deallocate memory associated with Protomatter_core structure
           (e.g. screen data, pin lists for data and rows). Does not
@@ -224,6 +277,16 @@ extern void _PM_row_handler(Protomatter_core *core);
 */
 extern uint32_t _PM_getFrameCount(Protomatter_core *core);
 
+/*!
+  @brief  Returns the time spent in the row interrupt since the previous
+          call (like _PM_getFrameCount(), resets on read). Divided by the
+          time between calls, this is the CPU load of refreshing the matrix.
+  @param  core  Pointer to Protomatter_core structure.
+  @return Microseconds, or 0 if the architecture has no clock to measure
+          with.
+*/
+extern uint32_t _PM_getIsrMicros(Protomatter_core *core);
+
 /*!
   @brief  Start (or restart) a timer/counter peripheral.
   @param  core    Pointer to Protomatter core structure, from which timer
@@ -279,6 +342,40 @@ extern void _PM_setDuty(uint8_t d);
 extern void _PM_convert_565(Protomatter_core *core, uint16_t *source,
                             uint16_t width);
 
+/*!
+  @brief  Converts only some row pairs of a GFX16 canvas to the matrices
+          internal format; the rest of the (back) buffer is left as it is.
+          Used to skip rows that have not changed since that buffer was
+          last converted.
+  @param  core     Pointer to Protomatter_core structure.
+  @param  source   Pointer to source image data (see Adafruit_GFX 16-bit
+                   canvas type for format).
+  @param  width    Width of canvas in pixels, as this may be different than
+                   the matrix pixel width due to row padding. With a
+                   rotation of 1 or 3 this is the canvas height.
+  @param  rowMask  Bit N set to convert row pair N (matrix row N and
+                   N + numRowPairs, in every tile and chain).
+*/
+extern void _PM_convert_565_rows(Protomatter_core *core, uint16_t *source,
+                                 uint16_t width, uint32_t rowMask);
+
+/*!
+  @brief  Converts a 1-bit mask drawn in a single color (e.g. text on
+          black) to the matrices internal format, without a 565 canvas.
+  @param  core     Pointer to Protomatter_core structure.
+  @param  mask     Pointer to mask data (see Adafruit_GFX 1-bit canvas type
+                   for format), same dimensions as the 16-bit canvas.
+  @param  width    Width of mask in pixels, as for _PM_convert_565_rows().
+  @param  color    565 color of set pixels; clear pixels are black.
+  @param  rowMask  Row pairs to convert, as for _PM_convert_565_rows().
+  @return true if converted, false if the matrix configuration is not
+          supported (more than one chain, more than 5 bitplanes or mask
+          rows, as drawn, that aren't whole bytes).
+*/
+extern bool _PM_convert_mask(Protomatter_core *core, const uint8_t *mask,
+                             uint16_t width, uint16_t color,
+                             uint32_t rowMask);
+
 #endif // END ARDUINO || CIRCUITPY
 
 #ifdef __cplusplus
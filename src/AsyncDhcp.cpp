@@ -0,0 +1,285 @@
+/**
+ * Source code for the non-blocking DHCP client
+ */
+
+#include "AsyncDhcp.h"
+#include "Log.h"
+
+// Ports and message layout (RFC 2131 / RFC 2132)
+const uint16_t DHCP_SERVER_PORT = 67;
+const uint16_t DHCP_CLIENT_PORT = 68;
+const size_t DHCP_OPTIONS_OFFSET = 240; // Fixed header + magic cookie
+const uint8_t DHCP_MAGIC[4] = {99, 130, 83, 99};
+
+// Message types (option 53)
+const uint8_t DHCP_DISCOVER = 1;
+const uint8_t DHCP_OFFER = 2;
+const uint8_t DHCP_REQUEST = 3;
+const uint8_t DHCP_ACK = 5;
+const uint8_t DHCP_NAK = 6;
+
+// Options
+const uint8_t OPT_PAD = 0;
+const uint8_t OPT_SUBNET_MASK = 1;
+const uint8_t OPT_ROUTER = 3;
+const uint8_t OPT_DNS = 6;
+const uint8_t OPT_REQUESTED_IP = 50;
+const uint8_t OPT_LEASE_TIME = 51;
+const uint8_t OPT_MESSAGE_TYPE = 53;
+const uint8_t OPT_SERVER_ID = 54;
+const uint8_t OPT_PARAM_REQUEST = 55;
+const uint8_t OPT_CLIENT_ID = 61;
+const uint8_t OPT_END = 255;
+
+// Longest lease honoured, so lease arithmetic in milliseconds can't overflow
+// (an "infinite" lease is 0xFFFFFFFF seconds)
+const uint32_t MAX_LEASE_SECONDS = 7UL * 24 * 3600;
+
+// Retransmit after 1 s, doubling up to 4 s
+const unsigned long RETRY_INITIAL_MS = 1000;
+const unsigned long RETRY_MAX_MS = 4000;
+
+static void putIP(uint8_t *dst, const IPAddress &ip) {
+  for (int i = 0; i < 4; i++) {
+    dst[i] = ip[i];
+  }
+}
+
+static uint32_t getUint32(const uint8_t *src) {
+  return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) |
+         ((uint32_t)src[2] << 8) | src[3];
+}
+
+AsyncDhcp::AsyncDhcp()
+    : _udpOpen(false), _xid(0), _state(State::IDLE), _startMs(0),
+      _timeoutMs(0), _lastSendMs(0), _retryMs(RETRY_INITIAL_MS),
+      _leaseStartMs(0), _leaseSeconds(0) {
+  memset(_mac, 0, sizeof(_mac));
+}
+
+void AsyncDhcp::begin(const uint8_t mac[6], unsigned long timeoutMs) {
+  memcpy(_mac, mac, sizeof(_mac));
+  _localIP = IPAddress(0, 0, 0, 0);
+  _serverId = IPAddress(0, 0, 0, 0);
+  start(State::DISCOVERING, timeoutMs);
+}
+
+void AsyncDhcp::renew(unsigned long timeoutMs) {
+  start(State::REQUESTING, timeoutMs);
+}
+
+void AsyncDhcp::stop() {
+  if (_udpOpen) {
+    _udp.stop();
+    _udpOpen = false;
+  }
+  _state = State::IDLE;
+}
+
+void AsyncDhcp::start(State state, unsigned long timeoutMs) {
+  if (!_udpOpen) {
+    _udpOpen = _udp.begin(DHCP_CLIENT_PORT) != 0;
+  }
+  _xid = ((uint32_t)micros() << 8) ^ ((uint32_t)_mac[4] << 8) ^ _mac[5];
+  _state = state;
+  _startMs = millis();
+  _timeoutMs = timeoutMs;
+  _retryMs = RETRY_INITIAL_MS;
+  send(state == State::DISCOVERING ? DHCP_DISCOVER : DHCP_REQUEST);
+}
+
+bool AsyncDhcp::renewalDue() const {
+  // T1 is half the lease (RFC 2131 4.4.5)
+  return _state == State::BOUND &&
+         millis() - _leaseStartMs >= _leaseSeconds * 500UL;
+}
+
+bool AsyncDhcp::leaseExpired() const {
+  return _leaseSeconds != 0 &&
+         millis() - _leaseStartMs >= _leaseSeconds * 1000UL;
+}
+
+AsyncDhcp::State AsyncDhcp::poll() {
+  if (_state != State::DISCOVERING && _state != State::REQUESTING) {
+    return _state;
+  }
+
+  uint8_t type = receive();
+  if (type == DHCP_OFFER && _state == State::DISCOVERING) {
+    char offered[16];
+    snprintf(offered, sizeof(offered), "%u.%u.%u.%u", _localIP[0],
+             _localIP[1], _localIP[2], _localIP[3]);
+    LOG_DEBUG(Log::TAG_DHCP, "Offer %s", offered);
+    _state = State::REQUESTING;
+    _retryMs = RETRY_INITIAL_MS;
+    send(DHCP_REQUEST);
+    return _state;
+  }
+  if (type == DHCP_ACK && _state == State::REQUESTING) {
+    _state = State::BOUND;
+    _leaseStartMs = millis();
+    LOG_INFO(Log::TAG_DHCP, "Bound, lease %u s, after %u ms", _leaseSeconds,
+             _leaseStartMs - _startMs);
+    return _state;
+  }
+  if (type == DHCP_NAK) {
+    // Address refused (e.g. moved to another subnet): start over
+    LOG_WARN(Log::TAG_DHCP, "NAK, restarting discovery");
+    _localIP = IPAddress(0, 0, 0, 0);
+    _state = State::DISCOVERING;
+    _retryMs = RETRY_INITIAL_MS;
+    send(DHCP_DISCOVER);
+    return _state;
+  }
+
+  unsigned long now = millis();
+  if (now - _startMs >= _timeoutMs) {
+    LOG_WARN(Log::TAG_DHCP, "Timed out");
+    _state = State::FAILED;
+    return _state;
+  }
+  if (now - _lastSendMs >= _retryMs) {
+    _retryMs = min(_retryMs * 2, RETRY_MAX_MS);
+    send(_state == State::DISCOVERING ? DHCP_DISCOVER : DHCP_REQUEST);
+  }
+  return _state;
+}
+
+bool AsyncDhcp::send(uint8_t messageType) {
+  _lastSendMs = millis();
+  if (!_udpOpen) {
+    return false;
+  }
+
+  memset(_packet, 0, DHCP_OPTIONS_OFFSET);
+  _packet[0] = 1; // BOOTREQUEST
+  _packet[1] = 1; // Ethernet
+  _packet[2] = 6; // Hardware address length
+  _packet[4] = _xid >> 24;
+  _packet[5] = _xid >> 16;
+  _packet[6] = _xid >> 8;
+  _packet[7] = _xid;
+  uint16_t secs = (millis() - _startMs) / 1000;
+  _packet[8] = secs >> 8;
+  _packet[9] = secs;
+  _packet[10] = 0x80; // Ask for broadcast replies: we may have no address yet
+  if (messageType == DHCP_REQUEST && _serverId == IPAddress(0, 0, 0, 0)) {
+    putIP(&_packet[12], _localIP); // ciaddr: renewing a bound lease
+  }
+  memcpy(&_packet[28], _mac, sizeof(_mac));
+  memcpy(&_packet[236], DHCP_MAGIC, sizeof(DHCP_MAGIC));
+
+  uint8_t *opt = &_packet[DHCP_OPTIONS_OFFSET];
+  *opt++ = OPT_MESSAGE_TYPE;
+  *opt++ = 1;
+  *opt++ = messageType;
+
+  *opt++ = OPT_CLIENT_ID;
+  *opt++ = 7;
+  *opt++ = 1; // Ethernet
+  memcpy(opt, _mac, sizeof(_mac));
+  opt += sizeof(_mac);
+
+  if (messageType == DHCP_REQUEST && _serverId != IPAddress(0, 0, 0, 0)) {
+    // Accepting an offer (SELECTING): name the address and the server
+    *opt++ = OPT_REQUESTED_IP;
+    *opt++ = 4;
+    putIP(opt, _localIP);
+    opt += 4;
+    *opt++ = OPT_SERVER_ID;
+    *opt++ = 4;
+    putIP(opt, _serverId);
+    opt += 4;
+  }
+
+  *opt++ = OPT_PARAM_REQUEST;
+  *opt++ = 4;
+  *opt++ = OPT_SUBNET_MASK;
+  *opt++ = OPT_ROUTER;
+  *opt++ = OPT_DNS;
+  *opt++ = OPT_LEASE_TIME;
+  *opt++ = OPT_END;
+
+  size_t length = opt - _packet;
+  if (!_udp.beginPacket(IPAddress(255, 255, 255, 255), DHCP_SERVER_PORT)) {
+    return false;
+  }
+  _udp.write(_packet, length);
+  return _udp.endPacket() != 0;
+}
+
+uint8_t AsyncDhcp::receive() {
+  int size = _udp.parsePacket();
+  if (size <= 0) {
+    return 0;
+  }
+
+  size_t length = _udp.read(_packet, sizeof(_packet));
+  // Drop the rest of an oversized packet
+  while (_udp.available() > 0) {
+    _udp.read();
+  }
+
+  if (length < DHCP_OPTIONS_OFFSET || _packet[0] != 2 ||
+      getUint32(&_packet[4]) != _xid || memcmp(&_packet[28], _mac, 6) != 0 ||
+      memcmp(&_packet[236], DHCP_MAGIC, sizeof(DHCP_MAGIC)) != 0) {
+    return 0; // Not a reply to us
+  }
+
+  uint8_t type = 0;
+  IPAddress subnet, router, dns, server;
+  uint32_t lease = 0;
+  size_t i = DHCP_OPTIONS_OFFSET;
+  while (i < length && _packet[i] != OPT_END) {
+    uint8_t code = _packet[i++];
+    if (code == OPT_PAD) {
+      continue;
+    }
+    if (i >= length) {
+      break;
+    }
+    uint8_t len = _packet[i++];
+    if (i + len > length) {
+      break;
+    }
+    const uint8_t *value = &_packet[i];
+    i += len;
+    if (len < (code == OPT_MESSAGE_TYPE ? 1 : 4)) {
+      continue;
+    }
+    switch (code) {
+    case OPT_MESSAGE_TYPE:
+      type = value[0];
+      break;
+    case OPT_SUBNET_MASK:
+      subnet = IPAddress(value[0], value[1], value[2], value[3]);
+      break;
+    case OPT_ROUTER:
+      router = IPAddress(value[0], value[1], value[2], value[3]);
+      break;
+    case OPT_DNS:
+      dns = IPAddress(value[0], value[1], value[2], value[3]);
+      break;
+    case OPT_SERVER_ID:
+      server = IPAddress(value[0], value[1], value[2], value[3]);
+      break;
+    case OPT_LEASE_TIME:
+      lease = getUint32(value);
+      break;
+    }
+  }
+
+  if (type == DHCP_OFFER || type == DHCP_ACK) {
+    _localIP = IPAddress(_packet[16], _packet[17], _packet[18], _packet[19]);
+    _subnetMask = subnet;
+    _gatewayIP = router;
+    _dnsServerIP = dns;
+    // The server id is only sent back while selecting an offer; a renewal
+    // REQUEST identifies the lease by ciaddr instead
+    _serverId = type == DHCP_OFFER ? server : IPAddress(0, 0, 0, 0);
+    if (type == DHCP_ACK) {
+      _leaseSeconds = lease != 0 ? min(lease, MAX_LEASE_SECONDS) : 3600;
+    }
+  }
+  return type;
+}
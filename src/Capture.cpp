@@ -0,0 +1,292 @@
+/**
+ * Source code for WebSocket traffic capture and replay
+ */
+
+#include "Capture.h"
+#include "Log.h"
+#include <LittleFS.h>
+
+namespace Capture {
+
+const char *CURRENT_PATH = "/capture.bin";
+const char *OLD_PATH = "/capture.old";
+
+// Written even while the timer runs past this fill level, so a burst is
+// not lost to an idle wait
+const size_t FORCE_FLUSH_LEVEL = BUFFER_SIZE * 3 / 4;
+
+// Buffered frames are written after this long even if few
+const unsigned long FLUSH_INTERVAL_MS = 1000;
+
+// ... and after this long even while the timer runs, so a reset mid-bout
+// loses at most this much of the capture
+const unsigned long MAX_DEFER_MS = 10000;
+
+// Frames per serviceReplay() call in fast mode, to keep the display going
+const uint8_t REPLAY_BATCH = 8;
+
+static_assert(sizeof(FrameHeader) == 8, "Capture frame header layout");
+
+bool enabled = false;
+uint8_t buffer[BUFFER_SIZE];
+size_t used = 0;
+unsigned long firstBufferedMs = 0;
+Stats stats = {};
+
+// Replay state
+ReplayStats replay = {};
+FrameHandler replayHandler = nullptr;
+File replayFile;
+uint8_t replayPart = 0; // 0: old file, 1: current file
+bool framePending = false;
+FrameHeader pending;
+uint8_t frame[MAX_FRAME + 1]; // + NUL, text frames are handled as strings
+uint32_t firstFrameMs = 0;
+unsigned long replayStartMs = 0;
+
+void setEnabled(bool enable) {
+  if (enable != enabled) {
+    LOG_INFO(Log::TAG_WEBSOCKET, "Capture %s", enable ? "started" : "stopped");
+  }
+  enabled = enable;
+}
+
+bool isEnabled() { return enabled; }
+
+const Stats &getStats() { return stats; }
+
+const ReplayStats &getReplayStats() { return replay; }
+
+void record(uint8_t type, const uint8_t *payload, size_t length) {
+  if (!enabled) {
+    return;
+  }
+
+  FrameHeader header;
+  header.timeMs = millis();
+  header.type = type;
+  header.flags = 0;
+  if (length > MAX_FRAME) {
+    length = MAX_FRAME;
+    header.flags |= FLAG_TRUNCATED;
+    stats.truncated++;
+  }
+  header.length = length;
+
+  if (used + sizeof(header) + length > BUFFER_SIZE) {
+    stats.dropped++;
+    return;
+  }
+  if (used == 0) {
+    firstBufferedMs = header.timeMs;
+  }
+  memcpy(buffer + used, &header, sizeof(header));
+  if (length > 0) {
+    memcpy(buffer + used + sizeof(header), payload, length);
+  }
+  used += sizeof(header) + length;
+  stats.frames++;
+}
+
+static bool flush() {
+  unsigned long start = micros();
+  File file = LittleFS.open(CURRENT_PATH, "a");
+  if (!file) {
+    LOG_WARN(Log::TAG_WEBSOCKET, "Capture file open failed");
+    return false;
+  }
+  size_t before = file.size();
+  size_t written = file.write(buffer, used);
+  if (written != used) {
+    // Filesystem full: cut off the partial frame so the file still parses,
+    // and stop rather than fail again on every flush
+    file.truncate(before);
+    file.close();
+    LOG_WARN(Log::TAG_WEBSOCKET, "Capture write short (%u of %u), stopped",
+             (unsigned)written, (unsigned)used);
+    stats.failedWrites++;
+    used = 0;
+    setEnabled(false);
+    return false;
+  }
+  size_t size = file.size();
+  file.close();
+  used = 0;
+
+  // Rotate: the full file becomes the old half of the ring
+  if (size >= FILE_LIMIT) {
+    LittleFS.remove(OLD_PATH);
+    LittleFS.rename(CURRENT_PATH, OLD_PATH);
+  }
+
+  uint32_t elapsed = micros() - start;
+  stats.flushes++;
+  if (elapsed > stats.maxFlushUs) {
+    stats.maxFlushUs = elapsed;
+  }
+  return true;
+}
+
+bool service(bool idle) {
+  if (used == 0) {
+    return false;
+  }
+  unsigned long age = millis() - firstBufferedMs;
+  if (used >= FORCE_FLUSH_LEVEL || age >= MAX_DEFER_MS ||
+      (idle && age >= FLUSH_INTERVAL_MS)) {
+    return flush();
+  }
+  return false;
+}
+
+void clear() {
+  stopReplay();
+  used = 0;
+  LittleFS.remove(OLD_PATH);
+  LittleFS.remove(CURRENT_PATH);
+  stats = {};
+}
+
+static size_t fileSize(const char *path) {
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return 0;
+  }
+  size_t size = file.size();
+  file.close();
+  return size;
+}
+
+size_t storedBytes() {
+  return fileSize(OLD_PATH) + fileSize(CURRENT_PATH) + used;
+}
+
+static void copyFile(const char *path, Print &out) {
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return;
+  }
+  uint8_t chunk[256];
+  size_t n;
+  while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+    out.write(chunk, n);
+  }
+  file.close();
+}
+
+void download(Print &out) {
+  FileHeader header = {MAGIC, VERSION, sizeof(FrameHeader)};
+  out.write(reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+  copyFile(OLD_PATH, out);
+  copyFile(CURRENT_PATH, out);
+  out.write(buffer, used);
+}
+
+// Open the next file of the ring; false when both are done
+static bool openNextPart() {
+  if (replayFile) {
+    replayFile.close();
+  }
+  while (replayPart < 2) {
+    const char *path = replayPart == 0 ? OLD_PATH : CURRENT_PATH;
+    replayPart++;
+    if (LittleFS.exists(path)) {
+      replayFile = LittleFS.open(path, "r");
+      if (replayFile) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Read the next frame into `pending`/`frame`
+static bool readFrame() {
+  while (true) {
+    if (replayFile &&
+        replayFile.read(reinterpret_cast<uint8_t *>(&pending),
+                        sizeof(pending)) == sizeof(pending)) {
+      size_t length = min((size_t)pending.length, MAX_FRAME);
+      if (replayFile.read(frame, length) == length) {
+        pending.length = length;
+        frame[length] = '\0';
+        return true;
+      }
+    }
+    // End of this file (or a torn frame from a power cut)
+    if (!openNextPart()) {
+      return false;
+    }
+  }
+}
+
+bool startReplay(FrameHandler handler, bool realtime) {
+  if (enabled || replay.active || handler == nullptr) {
+    return false;
+  }
+  if (used > 0) {
+    flush();
+  }
+
+  replayPart = 0;
+  if (!openNextPart()) {
+    return false;
+  }
+  framePending = readFrame();
+  if (!framePending) {
+    return false;
+  }
+
+  replay = {};
+  replay.active = true;
+  replay.realtime = realtime;
+  replayHandler = handler;
+  firstFrameMs = pending.timeMs;
+  replayStartMs = millis();
+  LOG_INFO(Log::TAG_WEBSOCKET, "Replay started (%s)",
+           realtime ? "realtime" : "fast");
+  return true;
+}
+
+void stopReplay() {
+  if (replayFile) {
+    replayFile.close();
+  }
+  framePending = false;
+  if (replay.active) {
+    replay.active = false;
+    replay.durationMs = millis() - replayStartMs;
+    LOG_INFO(Log::TAG_WEBSOCKET, "Replay done: %u frames in %u ms",
+             replay.frames, replay.durationMs);
+  }
+}
+
+void serviceReplay() {
+  if (!replay.active) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < REPLAY_BATCH && framePending; i++) {
+    if (replay.realtime &&
+        millis() - replayStartMs < pending.timeMs - firstFrameMs) {
+      return; // Not due yet
+    }
+
+    unsigned long start = micros();
+    replayHandler(pending.type, frame, pending.length);
+    uint32_t elapsed = micros() - start;
+    replay.frames++;
+    replay.totalUs += elapsed;
+    if (elapsed > replay.maxUs) {
+      replay.maxUs = elapsed;
+    }
+
+    framePending = readFrame();
+  }
+
+  if (!framePending) {
+    stopReplay();
+  }
+}
+
+} // namespace Capture
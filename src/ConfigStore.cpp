@@ -0,0 +1,471 @@
+/**
+ * Source code for the binary configuration store
+ */
+
+#include "ConfigStore.h"
+#include "Log.h"
+#include <EEPROM.h>
+#include <LittleFS.h>
+#include <limits.h>
+
+namespace ConfigStore {
+
+const char *CONFIG_PATH = "/config.bin";
+const char *LEGACY_SETTINGS_PATH = "/settings.json";
+
+// Legacy WebSocketClient EEPROM layout
+const uint8_t LEGACY_EEPROM_MAGIC = 0x42;
+const int LEGACY_HOST_LEN = 1;   // Length byte, host bytes follow
+const int LEGACY_PORT = 120;     // Port, little-endian
+const int LEGACY_PATH_LEN = 122; // Length byte, path bytes follow
+
+Config config;
+Source source = Source::DEFAULTS;
+SettingsPersistence persistence(CONFIG_PATH);
+
+static uint32_t crc32(const uint8_t *data, size_t length,
+                      uint32_t crc = 0xFFFFFFFF) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
+
+static void parseHexColor(const char *hex, uint8_t &r, uint8_t &g,
+                          uint8_t &b) {
+  if (hex != nullptr && *hex == '#') {
+    hex++;
+  }
+  long number = hex != nullptr ? strtol(hex, NULL, 16) : 0;
+  r = (number >> 16) & 0xFF;
+  g = (number >> 8) & 0xFF;
+  b = number & 0xFF;
+}
+
+// Serialize the record (SettingsPersistence::SerializeFn)
+static size_t writeRecord(Print &out, void *) {
+  config.magic = MAGIC;
+  config.version = VERSION;
+  config.size = sizeof(Config);
+  config.crc = ~crc32(reinterpret_cast<const uint8_t *>(&config) + HEADER_SIZE,
+                      sizeof(Config) - HEADER_SIZE);
+  return out.write(reinterpret_cast<const uint8_t *>(&config), sizeof(Config));
+}
+
+Config &get() { return config; }
+
+Source getSource() { return source; }
+
+const SettingsPersistence &getPersistence() { return persistence; }
+
+void setDefaults(Config &c) {
+  memset(&c, 0, sizeof(c));
+  c.magic = MAGIC;
+  c.version = VERSION;
+  c.size = sizeof(Config);
+  c.fontId = 4;
+  c.letterSpacing = 3;
+  c.brightness = 255;
+  c.durationSeconds = 180;
+  c.defaultR = 0;
+  c.defaultG = 255;
+  c.defaultB = 0;
+  c.thresholdCount = 2;
+  c.thresholds[0] = {120, 255, 255, 0, 0};
+  c.thresholds[1] = {60, 255, 0, 0, 0};
+  c.wsPort = 8765;
+  strlcpy(c.wsPath, "/socket.io/", sizeof(c.wsPath));
+  c.bitDepth = 4;
+  c.refreshTargetHz = 120;
+  c.broadcast = 0;
+  c.broadcastHz = 1920;
+  c.rotation = 0;
+}
+
+// Read /config.bin with a single read; fields missing from older (shorter)
+// records keep their defaults
+static bool readRecord() {
+  File file = LittleFS.open(CONFIG_PATH, "r");
+  if (!file) {
+    return false;
+  }
+
+  Config stored;
+  size_t bytes = file.read(reinterpret_cast<uint8_t *>(&stored),
+                           sizeof(Config));
+  if (bytes < HEADER_SIZE || stored.magic != MAGIC ||
+      stored.size < HEADER_SIZE) {
+    file.close();
+    LOG_WARN(Log::TAG_CONFIG, "Config record header invalid");
+    return false;
+  }
+
+  // A record written by newer firmware may be longer than ours; the tail
+  // still has to be read for the CRC
+  size_t storedSize = stored.size;
+  size_t used = storedSize < bytes ? storedSize : bytes;
+  uint32_t crc = crc32(reinterpret_cast<const uint8_t *>(&stored) +
+                           HEADER_SIZE,
+                       used - HEADER_SIZE);
+  size_t remaining = storedSize - used;
+  uint8_t chunk[32];
+  while (remaining > 0) {
+    size_t n = file.read(chunk, remaining < sizeof(chunk) ? remaining
+                                                          : sizeof(chunk));
+    if (n == 0) {
+      break;
+    }
+    crc = crc32(chunk, n, crc);
+    remaining -= n;
+  }
+  file.close();
+
+  if (remaining > 0 || ~crc != stored.crc) {
+    LOG_WARN(Log::TAG_CONFIG, "Config record CRC mismatch");
+    return false;
+  }
+
+  memcpy(&config, &stored, used);
+  config.wsHost[HOST_SIZE - 1] = '\0';
+  config.wsPath[PATH_SIZE - 1] = '\0';
+  if (config.thresholdCount > MAX_THRESHOLDS) {
+    config.thresholdCount = MAX_THRESHOLDS;
+  }
+  if (config.wsSpareCount > MAX_WS_SPARES) {
+    config.wsSpareCount = MAX_WS_SPARES;
+  }
+  for (size_t i = 0; i < MAX_WS_SPARES; i++) {
+    config.wsSpares[i].host[HOST_SIZE - 1] = '\0';
+    config.wsSpares[i].path[PATH_SIZE - 1] = '\0';
+  }
+  // Records written before imports were range-checked may hold values the
+  // display can't use; fix them rather than apply them at every boot
+  if (config.bitDepth > MAX_BIT_DEPTH) {
+    config.bitDepth = 0;
+  }
+  if (config.fontId >= FONT_COUNT) {
+    config.fontId = 4;
+  }
+  config.durationSeconds = min(config.durationSeconds, MAX_DURATION_SECONDS);
+  config.letterSpacing = constrain(config.letterSpacing, MIN_LETTER_SPACING,
+                                   MAX_LETTER_SPACING);
+  config.refreshTargetHz = constrain(config.refreshTargetHz, 1,
+                                     MAX_REFRESH_HZ);
+  config.broadcastHz = constrain(config.broadcastHz, 1, MAX_REFRESH_HZ);
+  for (size_t i = 0; i < config.thresholdCount; i++) {
+    config.thresholds[i].seconds =
+        min(config.thresholds[i].seconds, MAX_DURATION_SECONDS);
+  }
+  config.broadcast = config.broadcast ? 1 : 0;
+  config.rotation &= 3;
+
+  LOG_INFO(Log::TAG_CONFIG, "Config record v%u loaded (%u bytes)",
+           stored.version, storedSize);
+  return true;
+}
+
+// Import display settings from the legacy /settings.json
+static bool migrateSettingsJson() {
+  File file = LittleFS.open(LEGACY_SETTINGS_PATH, "r");
+  if (!file) {
+    return false;
+  }
+
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    LOG_WARN(Log::TAG_CONFIG, "Legacy settings file unreadable");
+    return false;
+  }
+
+  fromJson(doc);
+  config.sections |= SECTION_DISPLAY;
+  LOG_INFO(Log::TAG_CONFIG, "Migrated /settings.json");
+  return true;
+}
+
+// Import the WebSocket server from the legacy EEPROM blob
+static bool migrateEeprom() {
+  EEPROM.begin(512);
+  if (EEPROM.read(0) != LEGACY_EEPROM_MAGIC) {
+    return false;
+  }
+
+  int len = EEPROM.read(LEGACY_HOST_LEN);
+  for (int i = 0; i < len && i < (int)HOST_SIZE - 1; i++) {
+    config.wsHost[i] = EEPROM.read(LEGACY_HOST_LEN + 1 + i);
+  }
+  config.wsHost[min(len, (int)HOST_SIZE - 1)] = '\0';
+
+  config.wsPort =
+      EEPROM.read(LEGACY_PORT) | (EEPROM.read(LEGACY_PORT + 1) << 8);
+
+  len = EEPROM.read(LEGACY_PATH_LEN);
+  for (int i = 0; i < len && i < (int)PATH_SIZE - 1; i++) {
+    config.wsPath[i] = EEPROM.read(LEGACY_PATH_LEN + 1 + i);
+  }
+  config.wsPath[min(len, (int)PATH_SIZE - 1)] = '\0';
+
+  config.sections |= SECTION_WEBSOCKET;
+  LOG_INFO(Log::TAG_CONFIG, "Migrated WebSocket settings from EEPROM");
+  return true;
+}
+
+bool load() {
+  setDefaults(config);
+  source = Source::DEFAULTS;
+
+  if (readRecord()) {
+    source = Source::RECORD;
+    return true;
+  }
+
+  // No valid record: fold both legacy stores into a new one. The legacy
+  // data is left in place so older firmware can still boot from it.
+  bool migrated = migrateSettingsJson();
+  migrated = migrateEeprom() || migrated;
+  if (migrated) {
+    source = Source::LEGACY;
+    saveNow();
+    return true;
+  }
+
+  LOG_INFO(Log::TAG_CONFIG, "No saved configuration, using defaults");
+  return false;
+}
+
+void scheduleSave() { persistence.markDirty(); }
+
+bool saveNow() { return persistence.writeNow(writeRecord, nullptr); }
+
+bool service(bool idle) {
+  return persistence.service(idle, writeRecord, nullptr);
+}
+
+void toJson(JsonDocument &doc) {
+  doc["version"] = VERSION;
+  doc["duration"] = config.durationSeconds;
+  doc["font"] = config.fontId;
+  doc["spacing"] = config.letterSpacing;
+  doc["brightness"] = config.brightness;
+  if (config.bitDepth == 0) {
+    doc["bitDepth"] = "auto";
+  } else {
+    doc["bitDepth"] = config.bitDepth;
+  }
+  doc["refreshTarget"] = config.refreshTargetHz;
+  doc["broadcast"] = config.broadcast != 0;
+  doc["broadcastHz"] = config.broadcastHz;
+  doc["orientation"] = config.rotation * 90;
+
+  char hex[8];
+  snprintf(hex, sizeof(hex), "#%02X%02X%02X", config.defaultR,
+           config.defaultG, config.defaultB);
+  doc["defaultColor"] = hex;
+
+  JsonArray thresholds = doc["thresholds"].to<JsonArray>();
+  for (size_t i = 0; i < config.thresholdCount; i++) {
+    JsonObject t = thresholds.add<JsonObject>();
+    t["seconds"] = config.thresholds[i].seconds;
+    snprintf(hex, sizeof(hex), "#%02X%02X%02X", config.thresholds[i].r,
+             config.thresholds[i].g, config.thresholds[i].b);
+    t["color"] = hex;
+  }
+
+  JsonObject ws = doc["websocket"].to<JsonObject>();
+  ws["enabled"] = (config.sections & SECTION_WEBSOCKET) != 0;
+  ws["host"] = config.wsHost;
+  ws["port"] = config.wsPort;
+  ws["path"] = config.wsPath;
+  JsonArray spares = ws["spares"].to<JsonArray>();
+  for (size_t i = 0; i < config.wsSpareCount; i++) {
+    JsonObject spare = spares.add<JsonObject>();
+    spare["host"] = config.wsSpares[i].host;
+    spare["port"] = config.wsSpares[i].port;
+    spare["path"] = config.wsSpares[i].path;
+  }
+}
+
+// Read an integer field clamped to [low, high], as the web UI constrains
+// it. A value that isn't a whole number is named in rejected.
+static bool readInteger(JsonVariantConst value, const char *name, long low,
+                        long high, long &out, JsonArray rejected) {
+  if (value.isNull()) {
+    return false;
+  }
+  if (!value.is<long>()) {
+    rejected.add(name);
+    return false;
+  }
+  out = constrain(value.as<long>(), low, high);
+  return true;
+}
+
+// Read a "#RRGGBB" color field. Anything else is named in rejected.
+static bool readColor(JsonVariantConst value, const char *name, uint8_t &r,
+                      uint8_t &g, uint8_t &b, JsonArray rejected) {
+  const char *hex = value.as<const char *>();
+  bool valid = hex != nullptr;
+  if (valid && *hex == '#') {
+    hex++;
+  }
+  for (int i = 0; valid && i < 6; i++) {
+    valid = isxdigit((unsigned char)hex[i]);
+  }
+  if (!valid || hex[6] != '\0') {
+    rejected.add(name);
+    return false;
+  }
+  parseHexColor(hex, r, g, b);
+  return true;
+}
+
+uint8_t fromJson(const JsonDocument &doc, JsonArray rejected) {
+  uint8_t changed = 0;
+  long value = 0;
+
+  if (readInteger(doc["duration"], "duration", 0, MAX_DURATION_SECONDS, value,
+                  rejected)) {
+    config.durationSeconds = value;
+    changed |= SECTION_DISPLAY;
+  }
+  if (readInteger(doc["font"], "font", LONG_MIN, LONG_MAX, value, rejected)) {
+    // The display would silently fall back to the default font
+    if (value >= 0 && value < FONT_COUNT) {
+      config.fontId = value;
+      changed |= SECTION_DISPLAY;
+    } else {
+      rejected.add("font");
+    }
+  }
+  if (readInteger(doc["spacing"], "spacing", MIN_LETTER_SPACING,
+                  MAX_LETTER_SPACING, value, rejected)) {
+    config.letterSpacing = value;
+    changed |= SECTION_DISPLAY;
+  }
+  if (readInteger(doc["brightness"], "brightness", 0, 255, value, rejected)) {
+    config.brightness = value;
+    changed |= SECTION_DISPLAY;
+  }
+  JsonVariantConst bitDepth = doc["bitDepth"];
+  if (bitDepth.is<const char *>() &&
+      strcmp(bitDepth.as<const char *>(), "auto") == 0) {
+    config.bitDepth = 0;
+    changed |= SECTION_DISPLAY;
+  } else if (readInteger(bitDepth, "bitDepth", 0, MAX_BIT_DEPTH, value,
+                         rejected)) {
+    config.bitDepth = value;
+    changed |= SECTION_DISPLAY;
+  }
+  if (readInteger(doc["refreshTarget"], "refreshTarget", 1, MAX_REFRESH_HZ,
+                  value, rejected)) {
+    config.refreshTargetHz = value;
+    changed |= SECTION_DISPLAY;
+  }
+  if (!doc["broadcast"].isNull()) {
+    config.broadcast = doc["broadcast"].as<bool>() ? 1 : 0;
+    changed |= SECTION_DISPLAY;
+  }
+  if (readInteger(doc["broadcastHz"], "broadcastHz", 1, MAX_REFRESH_HZ, value,
+                  rejected)) {
+    config.broadcastHz = value;
+    changed |= SECTION_DISPLAY;
+  }
+  if (readInteger(doc["orientation"], "orientation", LONG_MIN, LONG_MAX,
+                  value, rejected)) {
+    // Degrees, rounded to a quarter turn
+    config.rotation = ((value % 360 + 360 + 45) / 90) & 3;
+    changed |= SECTION_DISPLAY;
+  }
+  if (!doc["defaultColor"].isNull() &&
+      readColor(doc["defaultColor"], "defaultColor", config.defaultR,
+                config.defaultG, config.defaultB, rejected)) {
+    changed |= SECTION_DISPLAY;
+  }
+  if (!doc["thresholds"].isNull()) {
+    if (doc["thresholds"].is<JsonArrayConst>()) {
+      // Invalid entries are dropped; the rest are kept highest time first,
+      // as the web UI sends them
+      bool invalid = false;
+      config.thresholdCount = 0;
+      for (JsonVariantConst v : doc["thresholds"].as<JsonArrayConst>()) {
+        Threshold t = {0, 0, 0, 0, 0};
+        if (!v["seconds"].is<long>() ||
+            !readColor(v["color"], "thresholds", t.r, t.g, t.b, JsonArray())) {
+          invalid = true;
+          continue;
+        }
+        if (config.thresholdCount >= MAX_THRESHOLDS) {
+          continue;
+        }
+        t.seconds = constrain(v["seconds"].as<long>(), 0L,
+                              (long)MAX_DURATION_SECONDS);
+
+        size_t i = config.thresholdCount++;
+        while (i > 0 && config.thresholds[i - 1].seconds < t.seconds) {
+          config.thresholds[i] = config.thresholds[i - 1];
+          i--;
+        }
+        config.thresholds[i] = t;
+      }
+      if (invalid) {
+        rejected.add("thresholds");
+      }
+      changed |= SECTION_DISPLAY;
+    } else {
+      rejected.add("thresholds");
+    }
+  }
+
+  JsonObjectConst ws = doc["websocket"];
+  if (!ws.isNull()) {
+    if (!ws["host"].isNull()) {
+      strlcpy(config.wsHost, ws["host"] | "", sizeof(config.wsHost));
+    }
+    if (readInteger(ws["port"], "websocket.port", LONG_MIN, LONG_MAX, value,
+                    rejected)) {
+      if (value >= 1 && value <= 65535) {
+        config.wsPort = value;
+      } else {
+        rejected.add("websocket.port");
+      }
+    }
+    if (!ws["path"].isNull()) {
+      strlcpy(config.wsPath, ws["path"] | "", sizeof(config.wsPath));
+    }
+    if (!ws["spares"].isNull()) {
+      config.wsSpareCount = 0;
+      for (JsonVariantConst v : ws["spares"].as<JsonArrayConst>()) {
+        const char *host = v["host"];
+        long port = v["port"] | (long)config.wsPort;
+        if (host == nullptr || host[0] == '\0' || port < 1 || port > 65535) {
+          rejected.add("websocket.spares");
+          continue;
+        }
+        if (config.wsSpareCount >= MAX_WS_SPARES) {
+          continue;
+        }
+        Upstream &spare = config.wsSpares[config.wsSpareCount++];
+        strlcpy(spare.host, host, sizeof(spare.host));
+        spare.port = port;
+        strlcpy(spare.path, v["path"] | config.wsPath, sizeof(spare.path));
+      }
+    }
+    bool enabled = ws["enabled"] | (config.wsHost[0] != '\0');
+    if (enabled) {
+      config.sections |= SECTION_WEBSOCKET;
+    } else {
+      config.sections &= ~SECTION_WEBSOCKET;
+    }
+    changed |= SECTION_WEBSOCKET;
+  }
+
+  config.sections |= changed & SECTION_DISPLAY;
+  return changed;
+}
+
+} // namespace ConfigStore
@@ -0,0 +1,199 @@
+/**
+ * Source code for the non-blocking DNS lookup
+ */
+
+#include "DnsLookup.h"
+
+// Message layout (RFC 1035 4.1)
+const uint16_t DNS_SERVER_PORT = 53;
+const size_t DNS_HEADER_SIZE = 12;
+const uint8_t FLAG_RESPONSE = 0x80;  // QR, first flags byte
+const uint8_t FLAG_RECURSION = 0x01; // RD, first flags byte
+const uint8_t RCODE_MASK = 0x0F;     // Second flags byte
+const uint16_t TYPE_A = 1;
+const uint16_t CLASS_IN = 1;
+
+// Retransmit every second until the timeout (most resolvers answer a lost
+// query on the next try)
+const unsigned long RETRY_MS = 1000;
+
+static uint16_t getUint16(const uint8_t *src) {
+  return ((uint16_t)src[0] << 8) | src[1];
+}
+
+static uint32_t getUint32(const uint8_t *src) {
+  return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) |
+         ((uint32_t)src[2] << 8) | src[3];
+}
+
+// Skip an encoded name (labels, ending in a zero length or a compression
+// pointer); returns the offset after it, or 0 if it runs past the end
+static size_t skipName(const uint8_t *packet, size_t length, size_t i) {
+  while (i < length) {
+    uint8_t len = packet[i];
+    if (len == 0) {
+      return i + 1;
+    }
+    if ((len & 0xC0) == 0xC0) {
+      return i + 2 <= length ? i + 2 : 0;
+    }
+    i += 1 + len;
+  }
+  return 0;
+}
+
+DnsLookup::DnsLookup()
+    : _udpOpen(false), _state(State::IDLE), _id(0), _startMs(0),
+      _timeoutMs(0), _lastSendMs(0), _resolveTimeMs(0), _ttl(0),
+      _queryLength(0) {}
+
+bool DnsLookup::begin(const char *name, const IPAddress &server,
+                      unsigned long timeoutMs) {
+  stop();
+  if (name == nullptr || name[0] == '\0' ||
+      strlen(name) + 2 > DNS_QUERY_SIZE - DNS_HEADER_SIZE - 4 ||
+      server == IPAddress(0, 0, 0, 0)) {
+    return false;
+  }
+
+  // Header: one question, recursion desired
+  _id = random(0x10000);
+  memset(_query, 0, DNS_HEADER_SIZE);
+  _query[0] = _id >> 8;
+  _query[1] = _id;
+  _query[2] = FLAG_RECURSION;
+  _query[5] = 1;
+
+  // Question: "timer.lan" is encoded as 5 "timer" 3 "lan" 0
+  size_t i = DNS_HEADER_SIZE;
+  const char *label = name;
+  while (*label != '\0') {
+    const char *dot = strchr(label, '.');
+    size_t len = dot != nullptr ? dot - label : strlen(label);
+    if (len == 0 || len > 63) {
+      return false; // Empty or overlong label
+    }
+    _query[i++] = len;
+    memcpy(&_query[i], label, len);
+    i += len;
+    label += len;
+    if (*label == '.') {
+      label++;
+    }
+  }
+  _query[i++] = 0;
+  _query[i++] = TYPE_A >> 8;
+  _query[i++] = TYPE_A;
+  _query[i++] = CLASS_IN >> 8;
+  _query[i++] = CLASS_IN;
+  _queryLength = i;
+
+  // Ephemeral source port, like TcpProbe
+  _udpOpen = _udp.begin(49152 + random(16384)) != 0;
+  if (!_udpOpen) {
+    return false;
+  }
+
+  _server = server;
+  _address = IPAddress(0, 0, 0, 0);
+  _ttl = 0;
+  _resolveTimeMs = 0;
+  _state = State::RESOLVING;
+  _startMs = millis();
+  _timeoutMs = timeoutMs;
+  send();
+  return true;
+}
+
+void DnsLookup::stop() {
+  if (_udpOpen) {
+    _udp.stop();
+    _udpOpen = false;
+  }
+  _state = State::IDLE;
+}
+
+DnsLookup::State DnsLookup::poll() {
+  if (_state != State::RESOLVING) {
+    return _state;
+  }
+
+  _state = receive();
+  if (_state == State::RESOLVED) {
+    _resolveTimeMs = millis() - _startMs;
+  }
+  if (_state != State::RESOLVING) {
+    return _state;
+  }
+
+  unsigned long now = millis();
+  if (now - _startMs >= _timeoutMs) {
+    _state = State::FAILED;
+  } else if (now - _lastSendMs >= RETRY_MS) {
+    send();
+  }
+  return _state;
+}
+
+bool DnsLookup::send() {
+  _lastSendMs = millis();
+  if (!_udp.beginPacket(_server, DNS_SERVER_PORT)) {
+    return false;
+  }
+  _udp.write(_query, _queryLength);
+  return _udp.endPacket() != 0;
+}
+
+DnsLookup::State DnsLookup::receive() {
+  int size = _udp.parsePacket();
+  if (size <= 0) {
+    return State::RESOLVING;
+  }
+
+  size_t length = _udp.read(_packet, sizeof(_packet));
+  // Drop the rest of an oversized packet
+  while (_udp.available() > 0) {
+    _udp.read();
+  }
+
+  if (_udp.remotePort() != DNS_SERVER_PORT || length < DNS_HEADER_SIZE ||
+      getUint16(&_packet[0]) != _id || !(_packet[2] & FLAG_RESPONSE)) {
+    return State::RESOLVING; // Not an answer to us
+  }
+  if ((_packet[3] & RCODE_MASK) != 0) {
+    return State::FAILED; // No such name, or the server refused
+  }
+
+  uint16_t questions = getUint16(&_packet[4]);
+  uint16_t answers = getUint16(&_packet[6]);
+  size_t i = DNS_HEADER_SIZE;
+  for (uint16_t q = 0; q < questions && i != 0; q++) {
+    i = skipName(_packet, length, i);
+    i = i != 0 && i + 4 <= length ? i + 4 : 0; // Type, class
+  }
+
+  // The first A record; an alias (CNAME) comes before the records it
+  // points to and is skipped
+  for (uint16_t a = 0; a < answers && i != 0; a++) {
+    i = skipName(_packet, length, i);
+    if (i == 0 || i + 10 > length) {
+      break;
+    }
+    uint16_t type = getUint16(&_packet[i]);
+    uint16_t cls = getUint16(&_packet[i + 2]);
+    uint32_t ttl = getUint32(&_packet[i + 4]);
+    uint16_t dataLength = getUint16(&_packet[i + 8]);
+    i += 10;
+    if (i + dataLength > length) {
+      break;
+    }
+    if (type == TYPE_A && cls == CLASS_IN && dataLength == 4) {
+      _address = IPAddress(_packet[i], _packet[i + 1], _packet[i + 2],
+                           _packet[i + 3]);
+      _ttl = ttl;
+      return State::RESOLVED;
+    }
+    i += dataLength;
+  }
+  return State::FAILED; // Answered, but without an address
+}
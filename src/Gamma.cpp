@@ -0,0 +1,125 @@
+/**
+ * Source code for the gamma lookup tables
+ */
+
+#include "Gamma.h"
+
+namespace Gamma {
+
+// <cmath> isn't constexpr, so the tables are built with series
+// expansions. Only used at compile time.
+
+constexpr double LN2 = 0.6931471805599453;
+
+// Natural log of x > 0: scale into [0.5, 1], then the atanh series
+constexpr double naturalLog(double x) {
+  int exponent = 0;
+  while (x < 0.5) {
+    x *= 2;
+    exponent--;
+  }
+  double t = (x - 1) / (x + 1); // |t| <= 1/3
+  double term = t, sum = 0;
+  for (int k = 1; k < 40; k += 2) {
+    sum += term / k;
+    term *= t * t;
+  }
+  return 2 * sum + exponent * LN2;
+}
+
+// e^y for y <= 0: Taylor series on y / 2^n, squared back n times
+constexpr double naturalExp(double y) {
+  int halvings = 0;
+  while (y < -0.5) {
+    y /= 2;
+    halvings++;
+  }
+  double term = 1, sum = 1;
+  for (int k = 1; k < 20; k++) {
+    term *= y / k;
+    sum += term;
+  }
+  while (halvings-- > 0) {
+    sum *= sum;
+  }
+  return sum;
+}
+
+// Linear on-time (0-1) for a channel value
+constexpr double linear(int value) {
+  if (value <= 0) {
+    return 0;
+  }
+  return naturalExp((double)GAMMA * naturalLog(value / 255.0));
+}
+
+struct Table {
+  uint8_t value[256];
+};
+
+constexpr Table makeTable(uint8_t depth) {
+  Table table = {};
+  int top = (1 << depth) - 1;
+  for (int v = 0; v < 256; v++) {
+    int level = (int)(linear(v) * top + 0.5);
+    table.value[v] = level << (8 - depth);
+  }
+  return table;
+}
+
+constexpr Table TABLES[MAX_DEPTH] = {makeTable(1), makeTable(2),
+                                     makeTable(3), makeTable(4),
+                                     makeTable(5), makeTable(6)};
+
+// Compile-time checks of the tables: the series against reference values,
+// every entry within half a level of the exact curve, and no level
+// skipped backwards
+
+constexpr double absolute(double x) { return x < 0 ? -x : x; }
+
+static_assert(absolute(linear(128) - 0.2195197) < 1e-6, "Gamma curve");
+static_assert(absolute(linear(1) - 5.0770519e-6) < 1e-11, "Gamma curve");
+static_assert(linear(255) > 0.999999 && linear(255) < 1.000001,
+              "Gamma curve");
+
+constexpr bool tableValid(uint8_t depth) {
+  const Table &table = TABLES[depth - 1];
+  int top = (1 << depth) - 1;
+  for (int v = 0; v < 256; v++) {
+    int level = table.value[v] >> (8 - depth);
+    if ((table.value[v] & ((1 << (8 - depth)) - 1)) != 0 ||
+        absolute(level - linear(v) * top) > 0.5 ||
+        (v > 0 && table.value[v] < table.value[v - 1])) {
+      return false;
+    }
+  }
+  return table.value[0] == 0 && table.value[255] >> (8 - depth) == top;
+}
+
+static_assert(tableValid(1) && tableValid(2) && tableValid(3) &&
+                  tableValid(4) && tableValid(5) && tableValid(6),
+              "Gamma table quantisation");
+
+// Orange and yellow stay apart at the default 4 planes
+static_assert(TABLES[3].value[165] >> 4 == 6 &&
+                  TABLES[3].value[255] >> 4 == 15,
+              "Gamma table levels");
+
+uint8_t correct(uint8_t value, uint8_t depth) {
+  if (depth < MIN_DEPTH) {
+    depth = MIN_DEPTH;
+  } else if (depth > MAX_DEPTH) {
+    depth = MAX_DEPTH;
+  }
+  return TABLES[depth - 1].value[value];
+}
+
+uint16_t color565(uint8_t r, uint8_t g, uint8_t b, uint8_t bitDepth) {
+  uint8_t redBlueDepth = bitDepth > 5 ? 5 : bitDepth;
+  r = correct(r, redBlueDepth);
+  g = correct(g, bitDepth);
+  b = correct(b, redBlueDepth);
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+} // namespace Gamma
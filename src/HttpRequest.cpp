@@ -0,0 +1,289 @@
+/**
+ * Source code for the block-reading HTTP request parser
+ */
+
+#include "HttpRequest.h"
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+bool HttpRequest::formField(const char *key, char *out, size_t size) const {
+  return HttpRequestReader::findParam(body, bodyLength, key, out, size);
+}
+
+bool HttpRequest::queryParam(const char *key, char *out, size_t size) const {
+  return HttpRequestReader::findParam(query, strlen(query), key, out, size);
+}
+
+HttpRequestReader::HttpRequestReader(char *buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _readCalls(0), _bytesRead(0) {
+  reset();
+}
+
+void HttpRequestReader::reset() {
+  _length = 0;
+  _headerEnd = 0;
+  _scanPos = 0;
+  _contentLength = 0;
+  memset(&_pending, 0, sizeof(_pending));
+}
+
+void HttpRequestReader::consume(size_t length) {
+  if (length >= _length) {
+    reset();
+    return;
+  }
+  memmove(_buffer, _buffer + length, _length - length);
+  size_t remaining = _length - length;
+  reset();
+  _length = remaining;
+}
+
+HttpRequestReader::Status HttpRequestReader::poll(Client &client,
+                                                  HttpRequest &request) {
+  // Pull everything the socket has buffered in as few reads as possible;
+  // one byte is kept free for the NUL terminator of the request line
+  int available = client.available();
+  while (available > 0 && _length < _capacity - 1) {
+    size_t room = _capacity - 1 - _length;
+    size_t want = (size_t)available < room ? (size_t)available : room;
+    int n = client.read((uint8_t *)_buffer + _length, want);
+    _readCalls++;
+    if (n <= 0) {
+      break;
+    }
+    _length += n;
+    _bytesRead += n;
+    available = client.available();
+  }
+
+  if (_headerEnd == 0) {
+    _headerEnd = findHeaderEnd();
+    if (_headerEnd == 0) {
+      return _length >= _capacity - 1 ? Status::TOO_LARGE
+                                       : Status::INCOMPLETE;
+    }
+    Status parsed = parseHeaders();
+    if (parsed != Status::READY) {
+      return parsed;
+    }
+  }
+
+  if (_headerEnd + _contentLength > _capacity - 1) {
+    return Status::TOO_LARGE;
+  }
+  if (_length - _headerEnd < _contentLength) {
+    return Status::INCOMPLETE;
+  }
+
+  request = _pending;
+  request.body = _buffer + _headerEnd;
+  request.bodyLength = _contentLength;
+  request.length = _headerEnd + _contentLength;
+  return Status::READY;
+}
+
+size_t HttpRequestReader::findHeaderEnd() {
+  // Accept both CRLF and bare LF line endings; resume where the previous
+  // poll left off so repeated partial reads stay linear
+  for (size_t i = _scanPos; i < _length; i++) {
+    if (_buffer[i] != '\n') {
+      continue;
+    }
+    size_t next = i + 1;
+    if (next < _length && _buffer[next] == '\r') {
+      next++;
+    }
+    if (next < _length && _buffer[next] == '\n') {
+      return next + 1;
+    }
+  }
+  // Back up two bytes: a read can end between the "\n\r" and the final
+  // "\n", and the search has to see that first '\n' again
+  _scanPos = _length >= 2 ? _length - 2 : 0;
+  return 0;
+}
+
+// Parse a Content-Length value: digits only, optionally followed by
+// whitespace. Values above limit are reported as TOO_LARGE without being
+// accumulated any further, so they can't overflow.
+static HttpRequestReader::Status parseContentLength(const char *value,
+                                                   size_t limit,
+                                                   size_t &length) {
+  if (*value < '0' || *value > '9') {
+    return HttpRequestReader::Status::MALFORMED;
+  }
+  size_t n = 0;
+  bool tooLarge = false;
+  for (; *value >= '0' && *value <= '9'; value++) {
+    if (!tooLarge) {
+      n = n * 10 + (*value - '0');
+      tooLarge = n > limit;
+    }
+  }
+  while (*value == ' ' || *value == '\t') {
+    value++;
+  }
+  if (*value != '\0') {
+    return HttpRequestReader::Status::MALFORMED;
+  }
+  if (tooLarge) {
+    return HttpRequestReader::Status::TOO_LARGE;
+  }
+  length = n;
+  return HttpRequestReader::Status::READY;
+}
+
+HttpRequestReader::Status HttpRequestReader::parseHeaders() {
+  // Terminate the header block so the string functions below stop there
+  char *end = _buffer + _headerEnd - 1;
+  *end = '\0';
+
+  // Request line: METHOD SP target SP version
+  char *line = _buffer;
+  char *eol = strchr(line, '\n');
+  if (eol == nullptr) {
+    return Status::MALFORMED;
+  }
+  *eol = '\0';
+  if (eol > line && eol[-1] == '\r') {
+    eol[-1] = '\0';
+  }
+
+  char *sp1 = strchr(line, ' ');
+  if (sp1 == nullptr || sp1 == line) {
+    return Status::MALFORMED;
+  }
+  *sp1 = '\0';
+  char *target = sp1 + 1;
+  char *sp2 = strchr(target, ' ');
+  const char *version = "HTTP/1.0";
+  if (sp2 != nullptr) {
+    *sp2 = '\0';
+    version = sp2 + 1;
+  }
+  if (*target != '/') {
+    return Status::MALFORMED;
+  }
+
+  // HTTP/1.1 connections are persistent unless the client says otherwise
+  _pending.http11 = strcmp(version, "HTTP/1.1") == 0;
+  _pending.keepAlive = _pending.http11;
+
+  _pending.method = line;
+  _pending.path = target;
+  _pending.query = "";
+  char *q = strchr(target, '?');
+  if (q != nullptr) {
+    *q = '\0';
+    _pending.query = q + 1;
+  }
+
+  // Header lines: only the ones the server acts on are inspected
+  _contentLength = 0;
+  bool haveLength = false;
+  line = eol + 1;
+  while (line < end && *line != '\0') {
+    eol = strchr(line, '\n');
+    if (eol != nullptr) {
+      *eol = '\0';
+      if (eol > line && eol[-1] == '\r') {
+        eol[-1] = '\0';
+      }
+    }
+    char *colon = strchr(line, ':');
+    if (colon != nullptr) {
+      *colon = '\0';
+      char *value = colon + 1;
+      while (*value == ' ' || *value == '\t') {
+        value++;
+      }
+      if (strcasecmp(line, "Content-Length") == 0) {
+        size_t length = 0;
+        Status status = parseContentLength(value, _capacity, length);
+        if (status != Status::READY) {
+          return status;
+        }
+        if (haveLength && length != _contentLength) {
+          return Status::MALFORMED; // Conflicting lengths (RFC 9112 6.3)
+        }
+        _contentLength = length;
+        haveLength = true;
+      } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+        // Only Content-Length framing is read; treating a chunked body as
+        // empty would parse its chunks as the next pipelined request
+        return Status::UNSUPPORTED;
+      } else if (strcasecmp(line, "Connection") == 0) {
+        if (strncasecmp(value, "close", 5) == 0) {
+          _pending.keepAlive = false;
+        } else if (strncasecmp(value, "keep-alive", 10) == 0) {
+          _pending.keepAlive = true;
+        }
+      }
+    }
+    if (eol == nullptr) {
+      break;
+    }
+    line = eol + 1;
+  }
+
+  return Status::READY;
+}
+
+size_t HttpRequestReader::urlDecode(const char *src, size_t length, char *out,
+                                    size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+  size_t len = 0;
+  for (size_t i = 0; i < length && len < size - 1; i++) {
+    char c = src[i];
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && i + 2 < length) {
+      int hi = hexValue(src[i + 1]);
+      int lo = hexValue(src[i + 2]);
+      if (hi >= 0 && lo >= 0) {
+        c = (char)((hi << 4) | lo);
+        i += 2;
+      }
+    }
+    out[len++] = c;
+  }
+  out[len] = '\0';
+  return len;
+}
+
+bool HttpRequestReader::findParam(const char *data, size_t length,
+                                  const char *key, char *out, size_t size) {
+  size_t keyLength = strlen(key);
+  const char *p = data;
+  const char *end = data + length;
+
+  while (p < end) {
+    const char *amp = (const char *)memchr(p, '&', end - p);
+    const char *pairEnd = amp != nullptr ? amp : end;
+    const char *eq = (const char *)memchr(p, '=', pairEnd - p);
+    const char *nameEnd = eq != nullptr ? eq : pairEnd;
+
+    if ((size_t)(nameEnd - p) == keyLength &&
+        strncmp(p, key, keyLength) == 0) {
+      if (eq != nullptr) {
+        urlDecode(eq + 1, pairEnd - eq - 1, out, size);
+      } else if (size > 0) {
+        out[0] = '\0';
+      }
+      return true;
+    }
+    p = pairEnd + 1;
+  }
+  return false;
+}
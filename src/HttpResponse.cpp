@@ -0,0 +1,208 @@
+/**
+ * Source code for the buffered HTTP response writer
+ */
+
+#include "HttpResponse.h"
+#include <stdarg.h>
+
+// Space kept free at the end of the buffer for the chunk trailer
+// ("\r\n" after the data, plus "0\r\n\r\n" on the last chunk)
+static const size_t TRAILER_RESERVE = 7;
+
+// Body lengths for formatHeaders() when the length isn't known up front
+static const long LENGTH_CHUNKED = -1;
+static const long LENGTH_UNTIL_CLOSE = -2; // HTTP/1.0: ends with the close
+
+// Sent instead of headers that don't fit in HEADER_RESERVE
+static const char OVERFLOW_RESPONSE[] =
+    "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n"
+    "Connection: close\r\n\r\n";
+
+// Append to a header buffer; once something didn't fit, len stays at size
+static void appendf(char *out, size_t size, size_t &len, const char *format,
+                    ...) {
+  if (len >= size) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(out + len, size - len, format, args);
+  va_end(args);
+  len = (n < 0 || (size_t)n >= size - len) ? size : len + n;
+}
+
+HttpResponseWriter::HttpResponseWriter(Client &client, uint8_t *buffer,
+                                       size_t capacity)
+    : _client(client), _buffer(buffer), _capacity(capacity),
+      _pos(HEADER_RESERVE), _code(200), _contentType("text/plain"),
+      _extraHeader(nullptr), _headersSent(false), _chunked(false),
+      _aborted(false), _keepAlive(false), _http11(true), _writeCount(0),
+      _byteCount(0), _bodyBytes(0) {}
+
+void HttpResponseWriter::begin(int code, const char *contentType) {
+  _code = code;
+  _contentType = contentType;
+  _extraHeader = nullptr;
+  _pos = HEADER_RESERVE;
+  _headersSent = false;
+  _chunked = false;
+  _aborted = false;
+  _writeCount = 0;
+  _byteCount = 0;
+  _bodyBytes = 0;
+}
+
+void HttpResponseWriter::setExtraHeader(const char *line) {
+  _extraHeader = line;
+}
+
+size_t HttpResponseWriter::write(uint8_t c) { return write(&c, 1); }
+
+size_t HttpResponseWriter::write(const uint8_t *data, size_t size) {
+  size_t limit = _capacity - TRAILER_RESERVE;
+  size_t remaining = _aborted ? 0 : size;
+
+  while (remaining > 0) {
+    size_t room = limit - _pos;
+    if (room == 0) {
+      flushChunk(false);
+      room = limit - _pos;
+    }
+    size_t n = remaining < room ? remaining : room;
+    memcpy(_buffer + _pos, data, n);
+    _pos += n;
+    data += n;
+    remaining -= n;
+  }
+
+  _bodyBytes += size;
+  return size;
+}
+
+void HttpResponseWriter::end() {
+  if (!_headersSent) {
+    // Whole body fits in the buffer: send it with a Content-Length in a
+    // single write, headers placed right in front of the data
+    char header[HEADER_RESERVE];
+    size_t bodyLength = _pos - HEADER_RESERVE;
+    size_t len = formatHeaders(header, sizeof(header), (long)bodyLength);
+    if (_aborted) {
+      bodyLength = 0;
+    }
+    uint8_t *start = _buffer + HEADER_RESERVE - len;
+    memcpy(start, header, len);
+    send(start, len + bodyLength);
+    _headersSent = true;
+  } else if (!_aborted) {
+    flushChunk(true);
+  }
+  _pos = HEADER_RESERVE;
+}
+
+void HttpResponseWriter::flushChunk(bool last) {
+  size_t dataLength = _pos - HEADER_RESERVE;
+
+  // Chunk-size line, and the headers in front of it for the first chunk.
+  // HTTP/1.0 has no chunked encoding: the body is sent as is and ends when
+  // the connection is closed.
+  char prefix[HEADER_RESERVE];
+  size_t len = 0;
+  if (!_headersSent) {
+    _chunked = _http11;
+    if (!_chunked) {
+      _keepAlive = false;
+    }
+    len = formatHeaders(prefix, sizeof(prefix),
+                        _chunked ? LENGTH_CHUNKED : LENGTH_UNTIL_CLOSE);
+    _headersSent = true;
+    if (_aborted) {
+      send(reinterpret_cast<const uint8_t *>(prefix), len);
+      _pos = HEADER_RESERVE;
+      return;
+    }
+  }
+  bool framed = _chunked && dataLength > 0;
+  if (framed) {
+    len += snprintf(prefix + len, sizeof(prefix) - len, "%X\r\n",
+                    (unsigned int)dataLength);
+  }
+
+  uint8_t *start = _buffer + HEADER_RESERVE - len;
+  memcpy(start, prefix, len);
+
+  size_t end = _pos;
+  if (framed) {
+    _buffer[end++] = '\r';
+    _buffer[end++] = '\n';
+  }
+  if (last && _chunked) {
+    memcpy(_buffer + end, "0\r\n\r\n", 5);
+    end += 5;
+  }
+
+  send(start, end - (start - _buffer));
+  _pos = HEADER_RESERVE;
+}
+
+size_t HttpResponseWriter::formatHeaders(char *out, size_t size,
+                                         long contentLength) {
+  // Leave room for the chunk-size line after the headers
+  size -= 8;
+
+  size_t len = 0;
+  appendf(out, size, len, "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n", _code,
+          statusText(_code), _contentType);
+  if (contentLength >= 0) {
+    appendf(out, size, len, "Content-Length: %ld\r\n", contentLength);
+  } else if (contentLength == LENGTH_CHUNKED) {
+    appendf(out, size, len, "Transfer-Encoding: chunked\r\n");
+  }
+  if (_extraHeader != nullptr) {
+    appendf(out, size, len, "%s\r\n", _extraHeader);
+  }
+  appendf(out, size, len, "Connection: %s\r\n\r\n",
+          _keepAlive ? "keep-alive" : "close");
+  if (len < size) {
+    return len;
+  }
+
+  // A truncated header block would corrupt the response: send a complete
+  // error instead and drop the body
+  static_assert(sizeof(OVERFLOW_RESPONSE) <= HEADER_RESERVE - 8,
+                "Fallback response must fit the header reserve");
+  _aborted = true;
+  _keepAlive = false;
+  memcpy(out, OVERFLOW_RESPONSE, sizeof(OVERFLOW_RESPONSE) - 1);
+  return sizeof(OVERFLOW_RESPONSE) - 1;
+}
+
+void HttpResponseWriter::send(const uint8_t *data, size_t size) {
+  _client.write(data, size);
+  _writeCount++;
+  _byteCount += size;
+}
+
+const char *HttpResponseWriter::statusText(int code) {
+  switch (code) {
+  case 200:
+    return "OK";
+  case 400:
+    return "Bad Request";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 408:
+    return "Request Timeout";
+  case 409:
+    return "Conflict";
+  case 413:
+    return "Payload Too Large";
+  case 500:
+    return "Internal Server Error";
+  case 501:
+    return "Not Implemented";
+  default:
+    return code < 400 ? "OK" : "Error";
+  }
+}
@@ -0,0 +1,132 @@
+/**
+ * Source code for the ring-buffer logger
+ */
+
+#include "Log.h"
+
+namespace Log {
+
+static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+              "Log capacity must be a power of two");
+
+Record records[CAPACITY];
+uint32_t next = 1;    // Sequence number of the next record
+uint32_t drained = 1; // Next sequence number to print to Serial
+uint32_t dropped = 0;
+Level minLevel = LEVEL_DEBUG;
+
+const char *const LEVEL_NAMES[] = {"E", "W", "I", "D"};
+const char *const TAG_NAMES[TAG_COUNT] = {"sys", "net",    "dhcp",    "http",
+                                          "ws",  "config", "display"};
+
+// Claim the next slot and fill in the common fields
+static Record &append(Level level, Tag tag, const char *format) {
+  Record &r = records[next & (CAPACITY - 1)];
+  r.seq = next++;
+  r.timeMs = millis();
+  r.format = format;
+  r.level = level;
+  r.tag = tag;
+  r.flags = 0;
+  return r;
+}
+
+void setLevel(Level level) { minLevel = level; }
+
+Level getLevel() { return minLevel; }
+
+void write(Level level, Tag tag, const char *format, uint32_t a0, uint32_t a1,
+           uint32_t a2) {
+  if (level > minLevel) {
+    return;
+  }
+  Record &r = append(level, tag, format);
+  r.args[0] = a0;
+  r.args[1] = a1;
+  r.args[2] = a2;
+}
+
+void write(Level level, Tag tag, const char *format, const char *text,
+           uint32_t a0, uint32_t a1) {
+  if (level > minLevel) {
+    return;
+  }
+  Record &r = append(level, tag, format);
+  r.flags = FLAG_TEXT;
+  // Copy at most what fits (strlcpy would scan all of a long frame buffer)
+  const char *src = text != nullptr ? text : "";
+  size_t i = 0;
+  for (; i < sizeof(r.text) - 1 && src[i] != '\0'; i++) {
+    r.text[i] = src[i];
+  }
+  r.text[i] = '\0';
+  r.args[0] = a0;
+  r.args[1] = a1;
+  r.args[2] = 0;
+}
+
+uint32_t nextSeq() { return next; }
+
+uint32_t oldestSeq() { return next > CAPACITY ? next - CAPACITY : 1; }
+
+uint32_t getDropped() { return dropped; }
+
+bool get(uint32_t seq, Record &record) {
+  if (seq < oldestSeq() || seq >= next) {
+    return false;
+  }
+  record = records[seq & (CAPACITY - 1)];
+  return true;
+}
+
+size_t formatMessage(const Record &record, char *out, size_t size) {
+  int n;
+  if (record.flags & FLAG_TEXT) {
+    n = snprintf(out, size, record.format, record.text,
+                 (unsigned)record.args[0], (unsigned)record.args[1]);
+  } else {
+    n = snprintf(out, size, record.format, (unsigned)record.args[0],
+                 (unsigned)record.args[1], (unsigned)record.args[2]);
+  }
+  if (n < 0) {
+    out[0] = '\0';
+    return 0;
+  }
+  return (size_t)n < size ? n : size - 1;
+}
+
+const char *levelName(uint8_t level) {
+  return level <= LEVEL_DEBUG ? LEVEL_NAMES[level] : "?";
+}
+
+const char *tagName(uint8_t tag) {
+  return tag < TAG_COUNT ? TAG_NAMES[tag] : "?";
+}
+
+void drain(uint8_t maxRecords) {
+  if (drained < oldestSeq()) {
+    dropped += oldestSeq() - drained;
+    drained = oldestSeq();
+  }
+
+  char line[LINE_SIZE];
+  for (uint8_t i = 0; i < maxRecords && drained < next; i++) {
+    const Record &r = records[drained & (CAPACITY - 1)];
+    int prefix = snprintf(line, sizeof(line), "[%7lu] %s %-6s ",
+                          (unsigned long)r.timeMs, levelName(r.level),
+                          tagName(r.tag));
+    size_t length = prefix;
+    length += formatMessage(r, line + length, sizeof(line) - length - 2);
+    line[length++] = '\r';
+    line[length++] = '\n';
+
+    // Never block: leave the record for a later loop if USB is backed up
+    if ((size_t)Serial.availableForWrite() < length) {
+      return;
+    }
+    Serial.write(reinterpret_cast<const uint8_t *>(line), length);
+    drained++;
+  }
+}
+
+} // namespace Log
@@ -0,0 +1,311 @@
+/**
+ * Source code for background network bring-up and supervision
+ */
+
+#include "Network.h"
+#include "AsyncDhcp.h"
+#include "Log.h"
+
+namespace Network {
+
+// PHY link is read over SPI; a few times a second catches a cable pull
+// without adding SPI traffic to every loop
+const unsigned long LINK_CHECK_INTERVAL_MS = 250;
+
+// While on the static fallback, look for a DHCP server this often
+const unsigned long DHCP_RETRY_INTERVAL_MS = 60000;
+
+State state = State::OFF;
+uint8_t macAddress[6];
+IPAddress staticIP;
+unsigned long dhcpTimeout = 10000;
+AsyncDhcp dhcp;
+bool dhcpActive = false;  // Address is a DHCP lease
+bool addressSet = false;  // An address (lease or static) is configured
+bool linkUp = true;       // Last PHY link state seen
+unsigned long lastLinkCheck = 0;
+unsigned long lastDhcpAttempt = 0; // Start of the last failback attempt
+unsigned long upTimeMs = 0;
+
+Stats stats = {};
+CallStats calls[CALL_COUNT] = {};
+
+const char *const CALL_NAMES[CALL_COUNT] = {"hardwareInit", "linkCheck",
+                                            "dhcp", "http", "websocket"};
+
+void recordCall(Call call, uint32_t us) {
+  CallStats &c = calls[call];
+  c.count++;
+  c.totalUs += us;
+  if (us > c.maxUs) {
+    c.maxUs = us;
+  }
+}
+
+const CallStats &getCallStats(Call call) { return calls[call]; }
+
+const char *getCallName(Call call) { return CALL_NAMES[call]; }
+
+const Stats &getStats() { return stats; }
+
+// Poll the DHCP client, timing the call
+AsyncDhcp::State pollDhcp() {
+  unsigned long start = micros();
+  AsyncDhcp::State result = dhcp.poll();
+  recordCall(CALL_DHCP, micros() - start);
+  return result;
+}
+
+// Configure the interface from the current lease
+void applyLease() {
+  Ethernet.setLocalIP(dhcp.getLocalIP());
+  Ethernet.setSubnetMask(dhcp.getSubnetMask());
+  Ethernet.setGatewayIP(dhcp.getGatewayIP());
+  Ethernet.setDnsServerIP(dhcp.getDnsServerIP());
+  dhcpActive = true;
+  addressSet = true;
+}
+
+// Same defaults Ethernet.begin(mac, ip) uses: /24 with the gateway and DNS
+// at .1
+void applyStaticIP() {
+  IPAddress gateway(staticIP[0], staticIP[1], staticIP[2], 1);
+  Ethernet.setLocalIP(staticIP);
+  Ethernet.setSubnetMask(IPAddress(255, 255, 255, 0));
+  Ethernet.setGatewayIP(gateway);
+  Ethernet.setDnsServerIP(gateway);
+  dhcpActive = false;
+  addressSet = true;
+  // Free the DHCP socket until the next failback attempt
+  dhcp.stop();
+  lastDhcpAttempt = millis();
+}
+
+// Log the current address (format must take the IP text, then the mode)
+void logAddress(const char *format) {
+  IPAddress ip = Ethernet.localIP();
+  char text[16];
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  LOG_INFO(Log::TAG_NETWORK, format, text, (uint32_t)dhcpActive);
+}
+
+// Read the PHY link; returns DOWN/UP on a transition
+Event checkLink() {
+  unsigned long now = millis();
+  if (now - lastLinkCheck < LINK_CHECK_INTERVAL_MS) {
+    return Event::NONE;
+  }
+  lastLinkCheck = now;
+
+  unsigned long start = micros();
+  bool up = Ethernet.linkStatus() != LinkOFF;
+  recordCall(CALL_LINK_CHECK, micros() - start);
+  if (up == linkUp) {
+    return Event::NONE;
+  }
+
+  linkUp = up;
+  if (!up) {
+    stats.linkFlaps++;
+    stats.lastLinkChange = now;
+    LOG_WARN(Log::TAG_NETWORK, "Ethernet link down");
+    return Event::DOWN;
+  }
+  LOG_INFO(Log::TAG_NETWORK, "Ethernet link up after %u ms",
+           now - stats.lastLinkChange);
+  stats.linkDownMs += now - stats.lastLinkChange;
+  stats.lastLinkChange = now;
+  return Event::UP;
+}
+
+// Link came back: keep the address we have and confirm it in the
+// background (we may have been plugged into a different network)
+Event onLinkUp() {
+  if (!addressSet) {
+    LOG_INFO(Log::TAG_NETWORK, "Attempting DHCP");
+    dhcp.begin(macAddress, dhcpTimeout);
+    state = State::DHCP;
+    return Event::NONE;
+  }
+  if (dhcpActive && !dhcp.leaseExpired()) {
+    dhcp.renew(dhcpTimeout);
+  } else {
+    dhcp.begin(macAddress, dhcpTimeout);
+  }
+  lastDhcpAttempt = millis();
+  state = State::UP;
+  logAddress("Network back up: %s (dhcp %u)");
+  return Event::UP;
+}
+
+// Keep the lease, fail over to the static IP when it is lost, and fail
+// back when a DHCP server answers again
+Event maintainAddress() {
+  if (dhcpActive && dhcp.renewalDue()) {
+    LOG_DEBUG(Log::TAG_NETWORK, "Renewing DHCP lease");
+    dhcp.renew(dhcpTimeout);
+  }
+
+  AsyncDhcp::State dhcpState = dhcp.getState();
+  if (dhcpState == AsyncDhcp::State::IDLE) {
+    // Static fallback: periodically look for a DHCP server
+    if (!dhcpActive &&
+        millis() - lastDhcpAttempt >= DHCP_RETRY_INTERVAL_MS) {
+      dhcp.begin(macAddress, dhcpTimeout);
+      lastDhcpAttempt = millis();
+    }
+    return Event::NONE;
+  }
+  if (dhcpState == AsyncDhcp::State::BOUND) {
+    return Event::NONE; // Nothing in flight
+  }
+
+  switch (pollDhcp()) {
+  case AsyncDhcp::State::BOUND:
+    if (dhcpActive && dhcp.getLocalIP() == Ethernet.localIP()) {
+      stats.dhcpRenewals++;
+      return Event::NONE;
+    }
+    applyLease();
+    stats.dhcpLeases++;
+    logAddress("DHCP address acquired: %s (dhcp %u)");
+    return Event::ADDRESS_CHANGED;
+
+  case AsyncDhcp::State::FAILED:
+    stats.dhcpFailures++;
+    if (!dhcpActive) {
+      dhcp.stop(); // Still no server; try again later
+      lastDhcpAttempt = millis();
+    } else if (dhcp.leaseExpired()) {
+      LOG_WARN(Log::TAG_NETWORK, "DHCP lease lost, failing over");
+      stats.staticFailovers++;
+      applyStaticIP();
+      logAddress("Static address: %s (dhcp %u)");
+      return Event::ADDRESS_CHANGED;
+    } else {
+      dhcp.renew(dhcpTimeout); // Keep trying until the lease runs out
+    }
+    return Event::NONE;
+
+  default:
+    return Event::NONE;
+  }
+}
+
+void begin(const uint8_t mac[6], const uint8_t fallbackIp[4],
+           unsigned long dhcpTimeoutMs) {
+  memcpy(macAddress, mac, sizeof(macAddress));
+  staticIP = IPAddress(fallbackIp[0], fallbackIp[1], fallbackIp[2],
+                       fallbackIp[3]);
+  dhcpTimeout = dhcpTimeoutMs;
+  state = State::STARTING;
+}
+
+Event service() {
+  switch (state) {
+  case State::OFF:
+  case State::NO_HARDWARE:
+    return Event::NONE;
+
+  case State::STARTING: {
+    // Reset and configure the W5500 with no address yet; this is the only
+    // step that blocks (the chip's reset time)
+    unsigned long start = micros();
+    Ethernet.begin(macAddress, IPAddress(0, 0, 0, 0));
+    recordCall(CALL_HARDWARE_INIT, micros() - start);
+    LOG_INFO(Log::TAG_NETWORK, "W5500 initialized in %u ms",
+             (micros() - start) / 1000);
+
+    if (Ethernet.hardwareStatus() == EthernetNoHardware) {
+      LOG_ERROR(Log::TAG_NETWORK, "Ethernet hardware not found");
+      state = State::NO_HARDWARE;
+      return Event::NONE;
+    }
+    linkUp = Ethernet.linkStatus() != LinkOFF;
+    lastLinkCheck = millis();
+    stats.lastLinkChange = lastLinkCheck;
+    if (!linkUp) {
+      LOG_WARN(Log::TAG_NETWORK, "Ethernet cable not connected");
+      state = State::LINK_DOWN;
+      return Event::NONE;
+    }
+
+    LOG_INFO(Log::TAG_NETWORK, "Attempting DHCP");
+    dhcp.begin(macAddress, dhcpTimeout);
+    state = State::DHCP;
+    return Event::NONE;
+  }
+
+  case State::LINK_DOWN:
+    if (checkLink() == Event::UP) {
+      return onLinkUp();
+    }
+    return Event::NONE;
+
+  case State::DHCP: {
+    if (checkLink() == Event::DOWN) {
+      dhcp.stop();
+      state = State::LINK_DOWN;
+      return Event::NONE;
+    }
+    AsyncDhcp::State result = pollDhcp();
+    if (result == AsyncDhcp::State::BOUND) {
+      applyLease();
+      stats.dhcpLeases++;
+    } else if (result == AsyncDhcp::State::FAILED) {
+      LOG_WARN(Log::TAG_NETWORK, "DHCP failed, using static IP");
+      stats.dhcpFailures++;
+      stats.staticFailovers++;
+      applyStaticIP();
+    } else {
+      return Event::NONE;
+    }
+    state = State::UP;
+    if (upTimeMs == 0) {
+      upTimeMs = millis();
+    }
+    logAddress("Network up: %s (dhcp %u)");
+    return Event::UP;
+  }
+
+  case State::UP:
+    if (checkLink() == Event::DOWN) {
+      // Keep the address (and lease) for when the link comes back
+      if (dhcp.getState() != AsyncDhcp::State::BOUND) {
+        dhcp.stop();
+      }
+      state = State::LINK_DOWN;
+      return Event::DOWN;
+    }
+    return maintainAddress();
+  }
+  return Event::NONE;
+}
+
+State getState() { return state; }
+
+bool isUp() { return state == State::UP; }
+
+bool usingDhcp() { return dhcpActive; }
+
+unsigned long getUpTimeMs() { return upTimeMs; }
+
+const char *getStateString() {
+  switch (state) {
+  case State::OFF:
+    return "off";
+  case State::STARTING:
+    return "starting";
+  case State::DHCP:
+    return "dhcp-pending";
+  case State::UP:
+    return dhcpActive ? "dhcp" : "static";
+  case State::LINK_DOWN:
+    return "link-down";
+  case State::NO_HARDWARE:
+    return "no-hardware";
+  }
+  return "unknown";
+}
+
+} // namespace Network
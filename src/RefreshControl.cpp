@@ -0,0 +1,152 @@
+/**
+ * Source code for matrix bit depth selection
+ */
+
+#include "RefreshControl.h"
+#include "Log.h"
+
+// Refresh rate measurement interval
+const unsigned long MEASURE_INTERVAL_MS = 1000;
+
+RefreshControl::RefreshControl(Adafruit_Protomatter &matrix)
+    : _matrix(matrix), _setting(matrix.getBitDepth()),
+      _targetHz(DEFAULT_TARGET_HZ), _broadcast(false),
+      _broadcastHz(DEFAULT_BROADCAST_HZ),
+      _normalMaxHz(matrix.getMaxRefresh()), _pending(false), _settling(true),
+      _intervalStartMs(0), _stats() {
+  _stats.bitDepth = _setting;
+}
+
+void RefreshControl::setBitDepth(uint8_t depth) {
+  if (depth > MAX_BIT_DEPTH) {
+    depth = MAX_BIT_DEPTH;
+  }
+  _setting = depth;
+  _pending = true;
+}
+
+void RefreshControl::setTargetHz(uint16_t hz) {
+  if (hz == 0) {
+    hz = DEFAULT_TARGET_HZ;
+  }
+  if (hz > _normalMaxHz) {
+    hz = _normalMaxHz; // The driver never refreshes faster outside broadcast
+  }
+  if (hz != _targetHz) {
+    _targetHz = hz;
+    // Search again from the top
+    _pending = _pending || (_setting == AUTO && !_broadcast);
+  }
+}
+
+void RefreshControl::setBroadcast(bool enabled) {
+  if (enabled != _broadcast) {
+    _broadcast = enabled;
+    _pending = true;
+  }
+}
+
+void RefreshControl::setBroadcastHz(uint16_t hz) {
+  if (hz == 0) {
+    hz = DEFAULT_BROADCAST_HZ;
+  }
+  if (hz > MAX_BROADCAST_HZ) {
+    hz = MAX_BROADCAST_HZ;
+  }
+  if (hz != _broadcastHz) {
+    _broadcastHz = hz;
+    _pending = _pending || _broadcast;
+  }
+}
+
+uint16_t RefreshControl::activeTargetHz() const {
+  return _broadcast ? _broadcastHz : _targetHz;
+}
+
+void RefreshControl::restartInterval(bool settling) {
+  _matrix.getFrameCount(); // Resets the driver's counters
+  _matrix.getIsrMicros();
+  _intervalStartMs = millis();
+  _settling = settling;
+}
+
+bool RefreshControl::apply(uint8_t depth) {
+  if (depth == _matrix.getBitDepth()) {
+    _stats.bitDepth = depth;
+    return false;
+  }
+
+  unsigned long start = micros();
+  ProtomatterStatus status = _matrix.setBitDepth(depth);
+  _stats.bitDepth = _matrix.getBitDepth();
+  if (status != PROTOMATTER_OK) {
+    _stats.failures++;
+    LOG_WARN(Log::TAG_DISPLAY, "Bit depth %u refused (status %u)", depth,
+             (uint32_t)status);
+  } else {
+    _stats.changes++;
+    LOG_INFO(Log::TAG_DISPLAY, "Bit depth %u (%u us)", depth,
+             (uint32_t)(micros() - start));
+  }
+  return true; // Reconfigured either way: the buffers were cleared
+}
+
+bool RefreshControl::service() {
+  if (_pending) {
+    _pending = false;
+    _stats.settled = false;
+    // Broadcast mode always searches: a fixed depth can't be trusted to
+    // reach the camera-safe rate
+    bool search = _setting == AUTO || _broadcast;
+    _matrix.setMaxRefresh(_broadcast ? _broadcastHz : _normalMaxHz);
+    bool changed = apply(search ? MAX_BIT_DEPTH : _setting);
+    restartInterval(changed);
+    return changed;
+  }
+
+  unsigned long elapsed = millis() - _intervalStartMs;
+  if (elapsed < MEASURE_INTERVAL_MS) {
+    return false;
+  }
+  uint32_t frames = _matrix.getFrameCount();
+  uint32_t isrUs = _matrix.getIsrMicros();
+  _intervalStartMs = millis();
+  if (_settling) {
+    // The driver tunes its plane periods over the first frames
+    _settling = false;
+    return false;
+  }
+  _stats.bitDepth = _matrix.getBitDepth();
+  _stats.refreshHz = (frames * 1000 + elapsed / 2) / elapsed;
+  uint32_t load = isrUs / elapsed; // us per ms = per mille
+  _stats.isrLoad = load > 1000 ? 1000 : load;
+
+  if (_setting != AUTO && !_broadcast) {
+    return false;
+  }
+  // The driver caps the rate at the broadcast target, so measurement jitter
+  // must not count as a miss
+  uint32_t target = activeTargetHz();
+  if (_broadcast) {
+    target -= target / 20;
+  }
+  if (_stats.refreshHz >= target || _stats.bitDepth <= MIN_BIT_DEPTH) {
+    _stats.settled = true;
+    return false;
+  }
+
+  // Too slow: one plane less about doubles the rate, so drop as many
+  // planes as the shortfall predicts
+  LOG_INFO(Log::TAG_DISPLAY, "Refresh %u Hz below %u Hz target",
+           _stats.refreshHz, target);
+  uint8_t depth = _stats.bitDepth - 1;
+  uint32_t predicted = _stats.refreshHz * 2;
+  while (predicted < target && depth > MIN_BIT_DEPTH) {
+    predicted *= 2;
+    depth--;
+  }
+  _stats.settled = false;
+  bool changed = apply(depth);
+  restartInterval(true);
+  return changed;
+}
@@ -0,0 +1,116 @@
+/**
+ * Source code for debounced, atomic settings persistence
+ */
+
+#include "SettingsPersistence.h"
+#include <LittleFS.h>
+
+namespace {
+// Print sink that only computes a CRC-32 and length of what is written to
+// it, used to skip flash writes when the serialized settings haven't changed
+// and to check that the file got all of them
+class CrcPrint : public Print {
+public:
+  CrcPrint() : _crc(0xFFFFFFFF), _length(0) {}
+
+  size_t write(uint8_t c) override {
+    _length++;
+    _crc ^= c;
+    for (int i = 0; i < 8; i++) {
+      _crc = (_crc >> 1) ^ (0xEDB88320 & (0 - (_crc & 1)));
+    }
+    return 1;
+  }
+  using Print::write;
+
+  uint32_t value() const { return ~_crc; }
+  size_t length() const { return _length; }
+
+private:
+  uint32_t _crc;
+  size_t _length;
+};
+} // namespace
+
+SettingsPersistence::SettingsPersistence(const char *path,
+                                         unsigned long quietPeriodMs,
+                                         unsigned long maxDeferMs)
+    : _path(path), _quietPeriodMs(quietPeriodMs), _maxDeferMs(maxDeferMs),
+      _lastChangeMs(0), _dirty(false), _lastCrc(0), _crcValid(false) {
+  snprintf(_tempPath, sizeof(_tempPath), "%s.tmp", path);
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void SettingsPersistence::setQuietPeriod(unsigned long quietPeriodMs) {
+  _quietPeriodMs = quietPeriodMs;
+}
+
+void SettingsPersistence::markDirty() {
+  if (_dirty) {
+    _stats.coalesced++;
+  }
+  _dirty = true;
+  _lastChangeMs = millis();
+}
+
+bool SettingsPersistence::service(bool idle, SerializeFn serialize,
+                                  void *context) {
+  unsigned long waited = millis() - _lastChangeMs;
+  if (!_dirty || waited < _quietPeriodMs) {
+    return false;
+  }
+  // A whole bout can run for minutes: only postpone a due save so long
+  if (!idle && waited - _quietPeriodMs < _maxDeferMs) {
+    return false;
+  }
+  if (!writeNow(serialize, context)) {
+    _lastChangeMs = millis(); // Retry after another quiet period
+    return false;
+  }
+  if (!idle) {
+    _stats.forced++;
+  }
+  return true;
+}
+
+bool SettingsPersistence::writeNow(SerializeFn serialize, void *context) {
+  unsigned long start = micros();
+
+  CrcPrint crc;
+  serialize(crc, context);
+  if (_crcValid && crc.value() == _lastCrc) {
+    _stats.skipped++;
+    _dirty = false;
+    return true;
+  }
+
+  File file = LittleFS.open(_tempPath, "w");
+  if (!file) {
+    _stats.failures++;
+    return false;
+  }
+  size_t bytes = serialize(file, context);
+  file.close();
+
+  // Rename replaces the old file atomically, so a reset at any point leaves
+  // either the old or the new settings intact. A short write (e.g. the
+  // filesystem is full) must not replace them with a truncated file.
+  if (bytes == 0 || bytes != crc.length() ||
+      !LittleFS.rename(_tempPath, _path)) {
+    LittleFS.remove(_tempPath);
+    _stats.failures++;
+    return false;
+  }
+
+  uint32_t elapsed = micros() - start;
+  _stats.writes++;
+  _stats.lastWriteUs = elapsed;
+  _stats.totalWriteUs += elapsed;
+  if (elapsed > _stats.maxWriteUs) {
+    _stats.maxWriteUs = elapsed;
+  }
+  _lastCrc = crc.value();
+  _crcValid = true;
+  _dirty = false;
+  return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * Source code for the non-blocking TCP reachability probe
+ */
+
+#include "TcpProbe.h"
+
+// The W5500 is wired to SPI1 (see main.cpp)
+#define PROBE_SPI SPI1
+
+TcpProbe::TcpProbe()
+    : _state(State::IDLE), _socket(MAX_SOCK_NUM), _startMs(0), _timeoutMs(0),
+      _connectTimeMs(0) {}
+
+uint8_t TcpProbe::readStatus() {
+  PROBE_SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  uint8_t status = W5100.readSnSR(_socket);
+  PROBE_SPI.endTransaction();
+  return status;
+}
+
+void TcpProbe::command(SockCMD cmd) {
+  PROBE_SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  W5100.execCmdSn(_socket, cmd);
+  PROBE_SPI.endTransaction();
+}
+
+bool TcpProbe::begin(const IPAddress &ip, uint16_t port,
+                     unsigned long timeoutMs) {
+  stop();
+
+  // Take a closed socket from the top; the Ethernet library allocates from
+  // socket 0 upwards and never takes one that is connecting or connected
+  PROBE_SPI.beginTransaction(SPI_ETHERNET_SETTINGS);
+  for (int s = MAX_SOCK_NUM - 1; s >= 0; s--) {
+    if (W5100.readSnSR(s) == SnSR::CLOSED) {
+      _socket = s;
+      break;
+    }
+  }
+  if (_socket >= MAX_SOCK_NUM) {
+    PROBE_SPI.endTransaction();
+    return false;
+  }
+
+  uint8_t address[4] = {ip[0], ip[1], ip[2], ip[3]};
+  W5100.writeSnMR(_socket, SnMR::TCP);
+  W5100.writeSnIR(_socket, 0xFF);
+  W5100.writeSnPORT(_socket, 49152 + random(16384)); // Ephemeral range
+  W5100.execCmdSn(_socket, Sock_OPEN);
+  W5100.writeSnDIPR(_socket, address);
+  W5100.writeSnDPORT(_socket, port);
+  W5100.execCmdSn(_socket, Sock_CONNECT);
+  PROBE_SPI.endTransaction();
+
+  _state = State::CONNECTING;
+  _startMs = millis();
+  _timeoutMs = timeoutMs;
+  _connectTimeMs = 0;
+  return true;
+}
+
+TcpProbe::State TcpProbe::poll() {
+  if (_state != State::CONNECTING) {
+    return _state;
+  }
+
+  uint8_t status = readStatus();
+  if (status == SnSR::ESTABLISHED || status == SnSR::CLOSE_WAIT) {
+    _connectTimeMs = millis() - _startMs;
+    _state = State::CONNECTED;
+  } else if (status == SnSR::CLOSED) {
+    _state = State::FAILED; // Refused (RST) or the chip gave up retrying
+  } else if (millis() - _startMs >= _timeoutMs) {
+    _state = State::FAILED; // Black-holed: no answer to the SYN
+  }
+  return _state;
+}
+
+void TcpProbe::stop() {
+  if (_socket < MAX_SOCK_NUM) {
+    // Say goodbye politely to a server that accepted; just drop a SYN
+    command(_state == State::CONNECTED ? Sock_DISCON : Sock_CLOSE);
+  }
+  _socket = MAX_SOCK_NUM;
+  _state = State::IDLE;
+}
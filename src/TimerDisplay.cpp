@@ -3,18 +3,22 @@
  */
 
 #include "TimerDisplay.h"
+#include "Gamma.h"
 #include <Arduino.h>
 
 TimerDisplay::TimerDisplay(Adafruit_Protomatter &matrix, Mode mode)
-    : _matrix(matrix), _timer(), _mode(mode), _text_size(1),
+    : _matrix(matrix), _refresh(matrix), _timer(), _mode(mode),
+      _text_size(1),
       _current_font(NULL), // Start with default bitmap font
+      _font_id(4),         // Default to Sans Bold 12pt (ID 4)
       _letter_spacing(3),  // Default letter spacing of 3 pixels
       _color(matrix.color565(255, 255, 255)),        // Default white
       _default_r(0), _default_g(255), _default_b(0), // Default green
-      _brightness(255),                              // Default full brightness
-      _font_id(4), // Default to Sans Bold 12pt (ID 4)
-      _threshold_count(0), _last_blink_ms(0), _blink_state(true),
-      _was_expired(false) {
+      _default_color(0), _threshold_count(0), _last_blink_ms(0),
+      _blink_state(true), _was_expired(false), _message_active(false),
+      _message_start_ms(0), _message_duration_ms(0), _message_width(0),
+      _glyph_cache(GlyphCache::STALE), _colon_offset(0), _frame_mask(NULL),
+      _draw_stats() {
   // Initialize cached positions as invalid
   _pos_single_digit_minutes.valid = false;
   _pos_double_digit_minutes.valid = false;
@@ -31,6 +35,7 @@ void TimerDisplay::setMode(Mode mode) { _mode = mode; }
 
 void TimerDisplay::setTextSize(uint8_t size) {
   _text_size = size;
+  _glyph_cache = GlyphCache::STALE;
   calculateCachedPositions();
 }
 
@@ -38,6 +43,7 @@ void TimerDisplay::setFont(const GFXfont *font, int fontId) {
   _current_font = font; // Track the font
   _font_id = fontId;    // Track the font ID
   _matrix.setFont(font);
+  _glyph_cache = GlyphCache::STALE;
   calculateCachedPositions();
 }
 
@@ -51,7 +57,7 @@ void TimerDisplay::setLetterSpacing(int8_t spacing) {
 int8_t TimerDisplay::getLetterSpacing() const { return _letter_spacing; }
 
 void TimerDisplay::setColor(uint8_t r, uint8_t g, uint8_t b) {
-  _color = _matrix.color565(r, g, b);
+  _color = Gamma::color565(r, g, b, _matrix.getBitDepth());
 }
 
 void TimerDisplay::addColorThreshold(unsigned int seconds, uint8_t r, uint8_t g,
@@ -75,6 +81,7 @@ void TimerDisplay::addColorThreshold(unsigned int seconds, uint8_t r, uint8_t g,
       }
     }
   }
+  updateColors();
 }
 
 void TimerDisplay::clearColorThresholds() { _threshold_count = 0; }
@@ -95,51 +102,77 @@ void TimerDisplay::setDefaultColor(uint8_t r, uint8_t g, uint8_t b) {
   _default_r = r;
   _default_g = g;
   _default_b = b;
+  updateColors();
 }
 
+void TimerDisplay::updateColors() {
+  uint8_t depth = _matrix.getBitDepth();
+  _default_color = Gamma::color565(_default_r, _default_g, _default_b, depth);
+  for (size_t i = 0; i < _threshold_count; i++) {
+    _threshold_colors[i] = Gamma::color565(_thresholds[i].r, _thresholds[i].g,
+                                           _thresholds[i].b, depth);
+  }
+}
+
+// Scroll speed and pause after a scrolling message
+const unsigned long MESSAGE_SCROLL_STEP_MS = 30;
+const unsigned long MESSAGE_SCROLL_HOLD_MS = 500;
+
 void TimerDisplay::showMessage(const String &msg, uint16_t duration_ms) {
-  // Save current font
-  const GFXfont *oldFont = _current_font;
-  _matrix.setFont(NULL); // Use default 5x7 font for readability
+  // Measure with the default 5x7 font the message is drawn in
+  _matrix.setFont(NULL);
   _matrix.setTextSize(1);
-
-  // Calculate width
   int16_t x1, y1;
   uint16_t w, h;
   _matrix.getTextBounds(msg, 0, 0, &x1, &y1, &w, &h);
+  _matrix.setFont(_current_font);
+  _matrix.setTextSize(_text_size);
+
+  _message = msg;
+  _message_width = w;
+  _message_duration_ms = duration_ms;
+  _message_start_ms = millis();
+  _message_active = true;
+  drawMessage();
+}
 
-  _matrix.setTextColor(_matrix.color565(255, 255, 255)); // White
+bool TimerDisplay::isShowingMessage() const { return _message_active; }
 
-  int16_t y = 0; // setCursor for default font puts top-left at y.
-  // 32 height. Font 8. (32-8)/2 = 12.
-  y = 12;
+void TimerDisplay::drawMessage() {
+  unsigned long elapsed = millis() - _message_start_ms;
+  int16_t width = _matrix.width();
+  int16_t x;
 
-  if (w <= 64) {
+  if (_message_width <= width) {
     // Center text and hold
-    _matrix.fillScreen(0);
-    int16_t x = (64 - w) / 2;
-    _matrix.setCursor(x, y);
-    _matrix.print(msg);
-    _matrix.show();
-    delay(duration_ms);
+    if (elapsed >= _message_duration_ms) {
+      _message_active = false;
+    }
+    x = (width - _message_width) / 2;
   } else {
-    // Scroll text
-    // Start from off-screen right (64) to fully off-screen left (-w)
-    for (int16_t x = 64; x >= -(int16_t)w; x--) {
-      _matrix.fillScreen(0);
-      _matrix.setCursor(x, y);
-      _matrix.print(msg);
-      _matrix.show();
-      delay(30); // Adjust speed as needed
+    // Scroll from off-screen right to fully off-screen left, then pause
+    unsigned long steps = elapsed / MESSAGE_SCROLL_STEP_MS;
+    unsigned long travel = width + _message_width;
+    if (steps > travel &&
+        elapsed >= travel * MESSAGE_SCROLL_STEP_MS + MESSAGE_SCROLL_HOLD_MS) {
+      _message_active = false;
     }
-    // Wait a bit after scroll
-    delay(500);
+    x = width - (int16_t)min(steps, travel);
   }
 
-  // Restore font
-  _matrix.setFont(oldFont);
-  // Clear screen
   _matrix.fillScreen(0);
+  if (_message_active) {
+    // 32 height. Font 8. (32-8)/2 = 12.
+    _matrix.setFont(NULL); // Use default 5x7 font for readability
+    _matrix.setTextSize(1);
+    _matrix.setTextColor(_matrix.color565(255, 255, 255)); // White
+    _matrix.setCursor(x, 12);
+    _matrix.print(_message);
+    _matrix.setFont(_current_font);
+    _matrix.setTextSize(_text_size);
+  } else {
+    _message = String(); // Free the text
+  }
   _matrix.show();
 }
 
@@ -214,7 +247,29 @@ void TimerDisplay::drawTimeWithCenteredColon(const String &time_str,
 
 Timer &TimerDisplay::getTimer() { return _timer; }
 
+Adafruit_Protomatter &TimerDisplay::getMatrix() { return _matrix; }
+
+RefreshControl &TimerDisplay::getRefresh() { return _refresh; }
+
 void TimerDisplay::update() {
+  if (_refresh.service()) {
+    updateColors(); // Levels differ per bit depth
+    if (_glyph_cache == GlyphCache::UNAVAILABLE) {
+      // The matrix may take masks at the new bit depth
+      _glyph_cache = GlyphCache::STALE;
+    }
+  }
+
+  // A message never hides a running timer
+  if (_message_active && _timer.isRunning()) {
+    _message_active = false;
+    _message = String();
+  }
+  if (_message_active) {
+    drawMessage();
+    return;
+  }
+
   unsigned long current_ms = millis();
 
   // Handle flashing when expired (check this first, even if running)
@@ -255,7 +310,7 @@ void TimerDisplay::update() {
 }
 
 void TimerDisplay::draw() {
-  _matrix.fillScreen(0); // Clear screen for double buffering
+  unsigned long start = micros();
 
   Timer::Components time_to_show = getDisplayTime();
 
@@ -274,23 +329,174 @@ void TimerDisplay::draw() {
   // Get cached position for this format
   CachedPosition pos = getCachedPosition(show_ms);
 
-  // Draw text only if blink state is true
-  if (_blink_state) {
-    _matrix.setTextColor(getCurrentColor());
+  uint16_t color = _blink_state ? getCurrentColor() : 0;
+  bool masked = drawMask(time_str, pos, color);
+  if (!masked) {
+    _matrix.fillScreen(0); // Clear screen for double buffering
+
+    // Draw text only if blink state is true
+    if (_blink_state) {
+      _matrix.setTextColor(color);
+
+      // For GFX fonts, we need to draw the colon separately with vertical
+      // centering The default 5x7 font doesn't need this adjustment
+      if (_current_font != NULL) {
+        // Using a custom GFX font - need to center the colon vertically
+        drawTimeWithCenteredColon(time_str, pos.x, pos.y, show_ms);
+      } else {
+        // Using default bitmap font - draw normally
+        _matrix.setCursor(pos.x, pos.y);
+        _matrix.print(time_str);
+      }
+    }
 
-    // For GFX fonts, we need to draw the colon separately with vertical
-    // centering The default 5x7 font doesn't need this adjustment
-    if (_current_font != NULL) {
-      // Using a custom GFX font - need to center the colon vertically
-      drawTimeWithCenteredColon(time_str, pos.x, pos.y, show_ms);
-    } else {
-      // Using default bitmap font - draw normally
-      _matrix.setCursor(pos.x, pos.y);
-      _matrix.print(time_str);
+    _matrix.show(); // Swap buffers to display
+  }
+
+  uint32_t elapsed = micros() - start;
+  _draw_stats.frames++;
+  if (masked) {
+    _draw_stats.maskFrames++;
+  }
+  _draw_stats.lastUs = elapsed;
+  if (elapsed > _draw_stats.maxUs) {
+    _draw_stats.maxUs = elapsed;
+  }
+}
+
+const TimerDisplay::DrawStats &TimerDisplay::getDrawStats() const {
+  return _draw_stats;
+}
+
+// Characters a time string is made of, in _glyphs order
+static int glyphIndex(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  return c == ':' ? 10 : 11;
+}
+
+bool TimerDisplay::rasteriseGlyphs() {
+  static const char CHARS[GLYPH_COUNT + 1] = "0123456789:.";
+  size_t used = 0;
+
+  _matrix.setFont(_current_font);
+  _matrix.setTextSize(_text_size);
+  for (size_t i = 0; i < GLYPH_COUNT; i++) {
+    Glyph &glyph = _glyphs[i];
+    char str[2] = {CHARS[i], '\0'};
+    _matrix.getTextBounds(str, 0, 0, &glyph.x1, &glyph.y1, &glyph.w,
+                          &glyph.h);
+    size_t size = ((glyph.w + 7) / 8) * glyph.h;
+    if (used + size > GLYPH_POOL_SIZE) {
+      return false;
+    }
+
+    // Print the character at the bitmap origin, exactly as it would be
+    // printed on the matrix
+    GFXcanvas1 canvas(max(glyph.w, (uint16_t)1), max(glyph.h, (uint16_t)1));
+    if (canvas.getBuffer() == NULL) {
+      return false;
+    }
+    canvas.fillScreen(0);
+    canvas.setTextWrap(false);
+    canvas.setFont(_current_font);
+    canvas.setTextSize(_text_size);
+    canvas.setCursor(-glyph.x1, -glyph.y1);
+    canvas.print(CHARS[i]);
+    glyph.advance = canvas.getCursorX() + glyph.x1;
+    glyph.offset = used;
+    memcpy(_glyph_bits + used, canvas.getBuffer(), size);
+    used += size;
+  }
+
+  // Same centering as drawTimeWithCenteredColon()
+  const Glyph &digit = _glyphs[glyphIndex('8')];
+  const Glyph &colon = _glyphs[glyphIndex(':')];
+  _colon_offset =
+      (digit.y1 + digit.h / 2) - (colon.y1 + colon.h / 2) + 1;
+  return true;
+}
+
+void TimerDisplay::blitGlyph(const Glyph &glyph, int16_t x, int16_t y) {
+  int16_t width = _matrix.width();
+  int16_t height = _matrix.height();
+  int16_t stride = (width + 7) / 8;
+  uint16_t glyph_stride = (glyph.w + 7) / 8;
+  const uint8_t *src = _glyph_bits + glyph.offset;
+
+  for (uint16_t row = 0; row < glyph.h; row++, src += glyph_stride) {
+    int16_t dest_y = y + row;
+    if (dest_y < 0 || dest_y >= height) {
+      continue;
+    }
+    uint8_t *dest = _frame_mask + dest_y * stride;
+    for (uint16_t i = 0; i < glyph_stride; i++) {
+      uint8_t bits = src[i];
+      int16_t dest_x = x + i * 8;
+      // Drop the pixels left or right of the display
+      if (dest_x < 0) {
+        bits = dest_x > -8 ? bits & (0xFF >> -dest_x) : 0;
+      }
+      if (dest_x + 8 > width) {
+        bits = dest_x < width ? bits & (0xFF << (dest_x + 8 - width)) : 0;
+      }
+      if (!bits) {
+        continue;
+      }
+      // The 8 pixels straddle two mask bytes unless byte-aligned
+      int16_t byte = dest_x >> 3;
+      uint8_t shift = dest_x & 7;
+      if (byte >= 0) {
+        dest[byte] |= bits >> shift;
+      }
+      if (shift && byte + 1 < stride) {
+        dest[byte + 1] |= bits << (8 - shift);
+      }
+    }
+  }
+}
+
+bool TimerDisplay::drawMask(const String &time_str, const CachedPosition &pos,
+                            uint16_t color) {
+  if (_glyph_cache == GlyphCache::STALE) {
+    _glyph_cache = rasteriseGlyphs() ? GlyphCache::READY
+                                     : GlyphCache::UNAVAILABLE;
+  }
+  if (_glyph_cache != GlyphCache::READY || _matrix.getRotation() != 0) {
+    return false;
+  }
+
+  size_t mask_size = ((_matrix.width() + 7) / 8) * _matrix.height();
+  if (_frame_mask == NULL) {
+    _frame_mask = (uint8_t *)malloc(mask_size);
+    if (_frame_mask == NULL) {
+      _glyph_cache = GlyphCache::UNAVAILABLE;
+      return false;
+    }
+  }
+  memset(_frame_mask, 0, mask_size);
+
+  if (_blink_state) {
+    // Same layout as the canvas drawing: GFX fonts are drawn character by
+    // character with letter spacing and a centered colon, the default font
+    // as one string
+    bool gfx_font = _current_font != NULL;
+    int16_t x = pos.x;
+    for (unsigned int i = 0; i < time_str.length(); i++) {
+      char c = time_str.charAt(i);
+      const Glyph &glyph = _glyphs[glyphIndex(c)];
+      int16_t y = pos.y + ((gfx_font && c == ':') ? _colon_offset : 0);
+      blitGlyph(glyph, x + glyph.x1, y + glyph.y1);
+      x += glyph.advance + (gfx_font ? _letter_spacing : 0);
     }
   }
 
-  _matrix.show(); // Swap buffers to display
+  if (!_matrix.showMask(_frame_mask, color)) {
+    _glyph_cache = GlyphCache::UNAVAILABLE; // Use the canvas from now on
+    return false;
+  }
+  return true;
 }
 
 void TimerDisplay::calculateCachedPositions() {
@@ -412,7 +618,7 @@ Timer::Components TimerDisplay::getDisplayTime() {
 uint16_t TimerDisplay::getCurrentColor() {
   // Only apply color thresholds in TIMER mode
   if (_mode != Mode::TIMER || _threshold_count == 0) {
-    return _matrix.color565(_default_r, _default_g, _default_b);
+    return _default_color;
   }
 
   // Get remaining time in seconds
@@ -422,33 +628,38 @@ uint16_t TimerDisplay::getCurrentColor() {
   // Check thresholds (already sorted descending, so we check highest first)
   for (size_t i = _threshold_count; i > 0; i--) {
     if (total_seconds <= _thresholds[i - 1].seconds) {
-      uint8_t r = _thresholds[i - 1].r;
-      uint8_t g = _thresholds[i - 1].g;
-      uint8_t b = _thresholds[i - 1].b;
-      applyBrightness(r, g, b);
-      return _matrix.color565(r, g, b);
+      return _threshold_colors[i - 1];
     }
   }
 
   // No threshold matched, use default color
-  uint8_t r = _default_r;
-  uint8_t g = _default_g;
-  uint8_t b = _default_b;
-  applyBrightness(r, g, b);
-  return _matrix.color565(r, g, b);
+  return _default_color;
 }
 
 void TimerDisplay::setBrightness(uint8_t brightness) {
-  _brightness = brightness;
+  _matrix.setBrightness(brightness);
+}
+
+uint8_t TimerDisplay::getBrightness() const {
+  return _matrix.getBrightness();
 }
 
-uint8_t TimerDisplay::getBrightness() const { return _brightness; }
+void TimerDisplay::setRotation(uint8_t rotation) {
+  rotation &= 3;
+  if (rotation == _matrix.getMatrixRotation()) {
+    return;
+  }
+  _matrix.setMatrixRotation(rotation);
 
-void TimerDisplay::applyBrightness(uint8_t &r, uint8_t &g, uint8_t &b) {
-  if (_brightness < 255) {
-    // Scale RGB values by brightness (0-255)
-    r = (r * _brightness) / 255;
-    g = (g * _brightness) / 255;
-    b = (b * _brightness) / 255;
+  // A quarter turn swaps width and height: new layout and frame mask
+  free(_frame_mask);
+  _frame_mask = NULL;
+  if (_glyph_cache == GlyphCache::UNAVAILABLE) {
+    _glyph_cache = GlyphCache::STALE; // Masks may fit the new layout
   }
+  calculateCachedPositions();
+}
+
+uint8_t TimerDisplay::getRotation() const {
+  return _matrix.getMatrixRotation();
 }
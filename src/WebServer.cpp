@@ -1,4 +1,12 @@
 #include "WebServer.h"
+#include "Capture.h"
+#include "HttpRequest.h"
+#include "ConfigStore.h"
+#include "HttpConnection.h"
+#include "HttpResponse.h"
+#include "HttpRouter.h"
+#include "Log.h"
+#include "Network.h"
 // #include "RGBMatrix.h"
 #include "WebSocketClient.h"
 #include <ArduinoJson.h>
@@ -6,18 +14,6 @@
 #include <LittleFS.h>
 #include <SPI.h>
 
-// Debug flag - set to false to disable debug messages for better timing
-#define DEBUG_WEBSERVER true
-
-// Debug printing macros
-#if DEBUG_WEBSERVER
-#define DEBUG_PRINT(x) Serial.print(x)
-#define DEBUG_PRINTLN(x) Serial.println(x)
-#else
-#define DEBUG_PRINT(x)
-#define DEBUG_PRINTLN(x)
-#endif
-
 // Font includes (12pt and below for 64x32 display)
 #include <Fonts/FreeMono12pt7b.h>
 #include <Fonts/FreeMono9pt7b.h>
@@ -50,81 +46,48 @@ namespace WebServer {
 EthernetServer *server = nullptr;
 bool mdns_initialized = false;
 WebSocketClient *wsClient = nullptr;
-int current_orientation = 180; // Track current display orientation
 
-bool init(uint8_t mac[6], uint8_t ip[4]) {
+// Staging buffer for outgoing responses (one response is built at a time)
+uint8_t txBuffer[HTTP_TX_BUFFER_SIZE];
+
+// Persistent (keep-alive) HTTP connections; see HttpConnection.h for the
+// timeouts and recycling policy
+const uint8_t MAX_HTTP_CONNECTIONS = 2;
+HttpConnectionPool<EthernetClient, MAX_HTTP_CONNECTIONS> connections;
+
+bool initStorage() {
   // Initialize LittleFS - format if mount fails (e.g. first boot with 1M quota)
   if (!LittleFS.begin()) {
-    DEBUG_PRINTLN("LittleFS mount failed, attempting to format...");
-    if (LittleFS.format()) {
-      DEBUG_PRINTLN("LittleFS formatted successfully");
-      if (LittleFS.begin()) {
-        DEBUG_PRINTLN("LittleFS mounted after format");
-      } else {
-        DEBUG_PRINTLN("ERROR: LittleFS mount failed even after format");
-      }
-    } else {
-      DEBUG_PRINTLN("ERROR: LittleFS format failed");
+    LOG_WARN(Log::TAG_CONFIG, "LittleFS mount failed, formatting");
+    if (!LittleFS.format()) {
+      LOG_ERROR(Log::TAG_CONFIG, "LittleFS format failed");
+      return false;
     }
-  } else {
-    DEBUG_PRINTLN("LittleFS initialized successfully");
-    // Show stats
-    FSInfo info;
-    if (LittleFS.info(info)) {
-      DEBUG_PRINT("FS Total: ");
-      DEBUG_PRINT(info.totalBytes);
-      DEBUG_PRINT(" Used: ");
-      DEBUG_PRINTLN(info.usedBytes);
+    if (!LittleFS.begin()) {
+      LOG_ERROR(Log::TAG_CONFIG, "LittleFS mount failed after format");
+      return false;
     }
+    LOG_INFO(Log::TAG_CONFIG, "LittleFS formatted and mounted");
+    return true;
   }
 
-  // HARDWARE INIT REMOVED - Handled by main.cpp / platformio.ini
-  // No SPI.setSCK etc.
-
-  // Try DHCP first, fall back to static IP if DHCP fails
-  DEBUG_PRINTLN("Attempting DHCP...");
-
-  // Pass &SPI1 because we are using the non-default SPI instance
-  // Note: Ethernet_Generic 2.8.1 supports begin(mac, startTimeout, &SPI) for
-  // DHCP
-  if (Ethernet.begin(mac, &SPI1) == 0) {
-    DEBUG_PRINTLN("DHCP failed, using static IP");
-    // Fallback to static IP
-    // For static IP without specific gateway/dns: begin(mac, ip)
-    Ethernet.begin(mac, ip);
-  } else {
-    DEBUG_PRINTLN("DHCP successful");
-  }
-
-  // Give Ethernet time to initialize and establish link
-  delay(2000);
-
-  // Check if Ethernet is connected
-  if (Ethernet.hardwareStatus() == EthernetNoHardware) {
-    DEBUG_PRINTLN("ERROR: Ethernet hardware not found");
-    return false;
-  }
-
-  if (Ethernet.linkStatus() == LinkOFF) {
-    DEBUG_PRINTLN("WARNING: Ethernet cable not connected");
+  // Show stats
+  FSInfo info;
+  if (LittleFS.info(info)) {
+    LOG_INFO(Log::TAG_CONFIG, "LittleFS mounted: %u of %u bytes used",
+             (uint32_t)info.usedBytes, (uint32_t)info.totalBytes);
   }
-
-  DEBUG_PRINT("Ethernet initialized - IP: ");
-  DEBUG_PRINTLN(Ethernet.localIP());
-
   return true;
 }
 
 bool initMDNS(const char *hostname) {
   if (!EthernetBonjour.begin(hostname)) {
-    DEBUG_PRINTLN("ERROR: Failed to start mDNS responder");
+    LOG_ERROR(Log::TAG_NETWORK, "Failed to start mDNS responder");
     mdns_initialized = false;
     return false;
   }
 
-  DEBUG_PRINT("mDNS responder started: ");
-  DEBUG_PRINT(hostname);
-  DEBUG_PRINTLN(".local");
+  LOG_INFO(Log::TAG_NETWORK, "mDNS responder started: %s.local", hostname);
   mdns_initialized = true;
   return true;
 }
@@ -147,58 +110,35 @@ void startWebServer(uint16_t port) {
   }
   server = new EthernetServer(port);
   server->begin();
-  DEBUG_PRINT("Web server started on port ");
-  DEBUG_PRINTLN(port);
+  LOG_INFO(Log::TAG_HTTP, "Web server started on port %u", port);
 }
 
 EthernetServer &getServer() { return *server; }
 
 void setWebSocketClient(WebSocketClient *client) {
   wsClient = client;
-  DEBUG_PRINTLN("WebSocket client registered with WebServer");
+  LOG_DEBUG(Log::TAG_HTTP, "WebSocket client registered with WebServer");
 }
 
 // Helper function to send HTTP response
-void sendHTTPResponse(EthernetClient &client, int code, const char *contentType,
-                      const String &body) {
-  client.print("HTTP/1.1 ");
-  client.print(code);
-  client.println(code == 200 ? " OK" : " Error");
-  client.print("Content-Type: ");
-  client.println(contentType);
-  client.println("Connection: close");
-  client.println();
-  client.print(body);
-}
-
-// Helper function to URL decode a string
-String urlDecode(const String &str) {
-  String decoded = "";
-  char temp[] = "00";
-  for (unsigned int i = 0; i < str.length(); i++) {
-    char c = str.charAt(i);
-    if (c == '%' && i + 2 < str.length()) {
-      temp[0] = str.charAt(i + 1);
-      temp[1] = str.charAt(i + 2);
-      decoded += (char)strtol(temp, NULL, 16);
-      i += 2;
-    } else if (c == '+') {
-      decoded += ' ';
-    } else {
-      decoded += c;
-    }
-  }
-  return decoded;
+void sendHTTPResponse(HttpResponseWriter &out, int code,
+                      const char *contentType, const String &body) {
+  out.begin(code, contentType);
+  out.print(body);
+  out.end();
 }
 
 // Helper function to parse hex color string to RGB
-void parseColor(const String &hexColor, uint8_t &r, uint8_t &g, uint8_t &b) {
-  String color = hexColor;
-  if (color.startsWith("#")) {
-    color = color.substring(1);
+void parseColor(const char *hexColor, uint8_t &r, uint8_t &g, uint8_t &b) {
+  if (hexColor == nullptr) {
+    r = g = b = 0;
+    return;
+  }
+  if (*hexColor == '#') {
+    hexColor++;
   }
 
-  long number = strtol(color.c_str(), NULL, 16);
+  long number = strtol(hexColor, NULL, 16);
   r = (number >> 16) & 0xFF;
   g = (number >> 8) & 0xFF;
   b = number & 0xFF;
@@ -265,1028 +205,1473 @@ uint8_t getTextSizeForFont(int fontId) {
   return 1;   // All other fonts @ 1x
 }
 
-bool saveSettings(TimerDisplay &timerDisplay) {
-  JsonDocument doc;
-  doc["duration"] = timerDisplay.getTimer().getDurationSeconds();
-  doc["font"] = timerDisplay.getFontId();
-  doc["spacing"] = timerDisplay.getLetterSpacing();
-  doc["brightness"] = timerDisplay.getBrightness();
+// The record's limits must match what the display accepts
+static_assert(ConfigStore::MAX_BIT_DEPTH == RefreshControl::MAX_BIT_DEPTH,
+              "Bit depth limits differ");
+static_assert(ConfigStore::MAX_REFRESH_HZ == RefreshControl::MAX_BROADCAST_HZ,
+              "Refresh rate limits differ");
+
+// Copy the display settings into the config record
+void captureSettings(TimerDisplay &timerDisplay) {
+  ConfigStore::Config &config = ConfigStore::get();
+  config.durationSeconds = timerDisplay.getTimer().getDurationSeconds();
+  config.fontId = timerDisplay.getFontId();
+  config.letterSpacing = timerDisplay.getLetterSpacing();
+  config.brightness = timerDisplay.getBrightness();
+  config.bitDepth = timerDisplay.getRefresh().getBitDepth();
+  config.refreshTargetHz = timerDisplay.getRefresh().getTargetHz();
+  config.broadcast = timerDisplay.getRefresh().isBroadcast() ? 1 : 0;
+  config.broadcastHz = timerDisplay.getRefresh().getBroadcastHz();
+  config.rotation = timerDisplay.getRotation();
+  timerDisplay.getDefaultColor(config.defaultR, config.defaultG,
+                               config.defaultB);
 
-  JsonArray thresholds = doc["thresholds"].to<JsonArray>();
   size_t count = 0;
   const TimerDisplay::ColorThreshold *data =
       timerDisplay.getColorThresholds(count);
-  if (data != nullptr) {
-    for (size_t i = 0; i < count; i++) {
-      JsonObject t = thresholds.add<JsonObject>();
-      t["seconds"] = data[i].seconds;
-      char colorHex[8];
-      snprintf(colorHex, sizeof(colorHex), "#%02X%02X%02X", data[i].r,
-               data[i].g, data[i].b);
-      t["color"] = String(colorHex); // Robust copy
-    }
+  config.thresholdCount = min(count, ConfigStore::MAX_THRESHOLDS);
+  for (size_t i = 0; i < config.thresholdCount; i++) {
+    config.thresholds[i] = {data[i].seconds, data[i].r, data[i].g, data[i].b,
+                            0};
   }
+  config.sections |= ConfigStore::SECTION_DISPLAY;
+}
 
-  uint8_t dr, dg, db;
-  timerDisplay.getDefaultColor(dr, dg, db);
-  char defaultHex[8];
-  snprintf(defaultHex, sizeof(defaultHex), "#%02X%02X%02X", dr, dg, db);
-  doc["defaultColor"] = defaultHex;
-
-  File file = LittleFS.open("/settings.json", "w");
-  if (!file) {
-    DEBUG_PRINTLN("ERROR: Failed to open /settings.json for writing");
-    return false;
+// Apply the display settings from the config record
+void applySettings(TimerDisplay &timerDisplay) {
+  const ConfigStore::Config &config = ConfigStore::get();
+
+  Timer::Components comp;
+  comp.minutes = config.durationSeconds / 60;
+  comp.seconds = config.durationSeconds % 60;
+  comp.milliseconds = 0;
+  timerDisplay.getTimer().setDuration(comp);
+  timerDisplay.getTimer().reset();
+
+  timerDisplay.setFont(getFontById(config.fontId), config.fontId);
+  timerDisplay.setTextSize(getTextSizeForFont(config.fontId));
+  timerDisplay.setLetterSpacing(config.letterSpacing);
+  timerDisplay.setBrightness(config.brightness);
+  timerDisplay.getRefresh().setTargetHz(config.refreshTargetHz);
+  timerDisplay.getRefresh().setBitDepth(config.bitDepth);
+  timerDisplay.getRefresh().setBroadcastHz(config.broadcastHz);
+  timerDisplay.getRefresh().setBroadcast(config.broadcast != 0);
+  timerDisplay.setRotation(config.rotation);
+
+  timerDisplay.clearColorThresholds();
+  for (size_t i = 0; i < config.thresholdCount; i++) {
+    const ConfigStore::Threshold &t = config.thresholds[i];
+    timerDisplay.addColorThreshold(t.seconds, t.r, t.g, t.b);
   }
 
-  size_t bytes = serializeJson(doc, file);
-  file.close();
+  timerDisplay.setDefaultColor(config.defaultR, config.defaultG,
+                               config.defaultB);
+  timerDisplay.setColor(config.defaultR, config.defaultG, config.defaultB);
+}
 
-  if (bytes == 0) {
-    DEBUG_PRINTLN("ERROR: Failed to write JSON to /settings.json");
+bool saveSettings(TimerDisplay &timerDisplay) {
+  captureSettings(timerDisplay);
+  if (!ConfigStore::saveNow()) {
+    LOG_ERROR(Log::TAG_CONFIG, "Failed to write configuration");
     return false;
   }
 
-  DEBUG_PRINT("Settings saved to /settings.json (");
-  DEBUG_PRINT(bytes);
-  DEBUG_PRINTLN(" bytes)");
+  LOG_INFO(Log::TAG_CONFIG, "Settings saved (%u us)",
+           ConfigStore::getPersistence().getStats().lastWriteUs);
   return true;
 }
 
+void scheduleSave(TimerDisplay &timerDisplay) {
+  captureSettings(timerDisplay);
+  ConfigStore::scheduleSave();
+}
+
+void servicePersistence(TimerDisplay &timerDisplay) {
+  // Flash writes stall XIP on both cores, so writes wait for the timer to
+  // stop. One that has waited too long is written anyway: loop() calls this
+  // right after update() has shown a frame, so it lands in the gap before
+  // the next one.
+  bool idle = !timerDisplay.getTimer().isRunning();
+  Capture::service(idle);
+  if (ConfigStore::service(idle)) {
+    LOG_INFO(Log::TAG_CONFIG, "Settings persisted in %u us",
+             ConfigStore::getPersistence().getStats().lastWriteUs);
+  }
+}
+
 bool loadSettings(TimerDisplay &timerDisplay) {
-  if (!LittleFS.exists("/settings.json")) {
-    DEBUG_PRINTLN("No settings file found");
+  // One binary read; legacy JSON/EEPROM data is only parsed if no record
+  // exists yet
+  ConfigStore::load();
+  if ((ConfigStore::get().sections & ConfigStore::SECTION_DISPLAY) == 0) {
     return false;
   }
+  applySettings(timerDisplay);
+  LOG_INFO(Log::TAG_CONFIG, "Settings loaded from configuration record");
+  return true;
+}
+
+// Per-request state handed to route handlers
+struct RequestContext {
+  const HttpRequest &request;
+  HttpResponseWriter &out;
+  TimerDisplay &timerDisplay;
+  const RouteParams &params;
+};
+
+typedef void (*RouteHandler)(RequestContext &ctx);
+
+// GET / - Serve the web interface
+void handleRoot(RequestContext &ctx) {
+  HttpResponseWriter &out = ctx.out;
+  out.begin(200, "text/html");
+
+  // Page fragments are coalesced by the writer and streamed as chunks
+  out.print(F("<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'>"));
+  out.print(F("<meta name='viewport' content='width=device-width, "
+              "initial-scale=1.0'>"));
+  out.print(F("<title>Arena Timer Control</title><style>"));
+  out.print(F("body{font-family:Arial,sans-serif;margin:0;padding:20px;"));
+  out.print(F("background:linear-gradient(135deg,#667eea 0%,#764ba2 100%);"));
+  out.print(F("min-height:100vh}"));
+  out.print(F(".container{background:white;border-radius:10px;padding:30px;"));
+  out.print(F("box-shadow:0 10px 40px "
+              "rgba(0,0,0,0.2);max-width:1400px;margin:0 auto}"));
+  out.print(F("h1{text-align:center;color:#333;margin-bottom:30px}"));
+  out.print(
+      F(".grid-container{display:grid;grid-template-columns:repeat(3,1fr);"));
+  out.print(F("gap:20px;margin-top:20px}"));
+  out.print(
+      F("@media "
+        "(max-width:1200px){.grid-container{grid-template-columns:1fr}}"));
+  out.print(F(".section{margin-bottom:25px;padding:20px;background:#f5f5f5;"));
+  out.print(F("border-radius:8px}.section "
+              "h2{margin-top:0;color:#667eea;font-size:18px}"));
+  out.print(F(".controls{display:grid;grid-template-columns:1fr "
+              "1fr;gap:10px;margin-bottom:15px}"));
+  out.print(F("button{padding:15px "
+              "20px;border:none;border-radius:6px;font-size:16px;"));
+  out.print(F("cursor:pointer;transition:all 0.3s;font-weight:bold}"));
+  out.print(F(".btn-start{background:#4CAF50;color:white;grid-column:1/-1}"));
+  out.print(F(".btn-start:hover{background:#45a049}"));
+  out.print(F(".btn-pause{background:#FF9800;color:white}"));
+  out.print(F(".btn-pause:hover{background:#e68900}"));
+  out.print(F(".btn-reset{background:#f44336;color:white}"));
+  out.print(F(".btn-reset:hover{background:#da190b}"));
+  out.print(F(".form-group{margin-bottom:15px}"));
+  out.print(F("label{display:block;margin-bottom:5px;color:#555;font-"
+              "weight:bold}"));
+  out.print(F("input[type='number'],input[type='color'],select{width:"
+              "100%;padding:10px;"));
+  out.print(F("border:2px solid "
+              "#ddd;border-radius:6px;font-size:14px;box-sizing:border-box}"));
+  out.print(F("input[type='number']:focus,input[type='color']:focus,"
+              "select:focus{"));
+  out.print(F("border-color:#667eea;outline:none}"));
+  out.print(F("input[type='color']{height:45px;cursor:pointer;border-"
+              "radius:6px;min-width:60px}"));
+  out.print(F(".threshold-list{margin-bottom:15px}"));
+  out.print(F(".threshold-item{display:flex;align-items:center;gap:10px;"));
+  out.print(F("margin-bottom:10px;padding:12px;background:white;border-"
+              "radius:8px;"));
+  out.print(F("border-left:4px solid #667eea;box-shadow:0 2px 4px "
+              "rgba(0,0,0,0.05)}"));
+  out.print(F(".threshold-item "
+              ".time-inputs{display:flex;gap:5px;align-items:center;"));
+  out.print(F("flex:1;white-space:nowrap}"));
+  out.print(F(".threshold-item "
+              ".when-label{color:#666;font-weight:500;white-space:nowrap}"));
+  out.print(
+      F(".threshold-item "
+        "input[type='number']{width:60px;padding:8px;text-align:center;"));
+  out.print(F("font-size:16px;font-weight:bold;flex-shrink:0}"));
+  out.print(F(".threshold-item "
+              ".time-label{font-size:12px;color:#999;font-weight:normal}"));
+  out.print(
+      F(".threshold-item .arrow{color:#667eea;font-size:20px;margin:0 8px}"));
+  out.print(F(".threshold-default{display:flex;align-items:center;gap:10px;"));
+  out.print(F("padding:12px;background:white;border-radius:8px;"));
+  out.print(F("border-left:4px solid #667eea;box-shadow:0 2px 4px "
+              "rgba(0,0,0,0.05);margin-bottom:10px}"));
+  out.print(F(".threshold-default .label{flex:1;color:#666;font-weight:500}"));
+  out.print(
+      F(".duration-card{padding:20px;background:white;border-radius:8px;"));
+  out.print(F("box-shadow:0 2px 4px rgba(0,0,0,0.05);margin-top:15px}"));
+  out.print(F(".duration-inputs{display:flex;gap:8px;align-items:center;"
+              "margin-top:10px}"));
+  out.print(F(".duration-inputs "
+              "input{width:80px;text-align:center;font-size:16px;font-"
+              "weight:bold}"));
+  out.print(F(".duration-inputs span{color:#666;font-size:14px}"));
+  out.print(F(".btn-remove{background:#ff5252;color:white;padding:8px "
+              "12px;border:none;"));
+  out.print(
+      F("border-radius:6px;cursor:pointer;font-size:14px;font-weight:bold;"));
+  out.print(F("transition:background 0.2s}"));
+  out.print(F(".btn-remove:hover{background:#ff1744}"));
+  out.print(
+      F(".btn-add{background:#4CAF50;color:white;padding:12px;border:none;"));
+  out.print(F("border-radius:8px;cursor:pointer;width:100%;font-size:"
+              "14px;font-weight:bold;"));
+  out.print(F("margin-bottom:15px;transition:background 0.2s}"));
+  out.print(F(".btn-add:hover{background:#45a049}"));
+  out.print(F(".console{background:#1e1e1e;color:#d4d4d4;padding:15px;"
+              "border-radius:8px;"));
+  out.print(
+      F("font-family:'Courier New',monospace;font-size:12px;height:200px;"));
+  out.print(F("overflow-y:auto;box-shadow:inset 0 2px 4px rgba(0,0,0,0.3)}"));
+  out.print(F(".console-entry{margin-bottom:8px;line-height:1.4}"));
+  out.print(F(".console-time{color:#858585;margin-right:8px}"));
+  out.print(F(".console-success{color:#4CAF50}"));
+  out.print(F(".console-error{color:#f44336}"));
+  out.print(F(".console-info{color:#2196F3}"));
+  out.print(F(".console-warning{color:#FF9800}"));
+  out.print(
+      F(".info-display{background:white;padding:12px;border-radius:8px;"));
+  out.print(F("margin-bottom:15px;border-left:4px solid #667eea;"));
+  out.print(F("box-shadow:0 2px 4px rgba(0,0,0,0.05)}"));
+  out.print(F(".info-label{color:#666;font-size:12px;font-weight:500;"
+              "text-transform:uppercase}"));
+  out.print(F(".info-value{color:#333;font-size:16px;font-weight:bold;"
+              "margin-top:4px;"));
+  out.print(F("font-family:monospace}"));
+  out.print(F(".apply-button{margin-top:20px;width:100%}"));
+  out.print(F(".apply-button.sticky{position:fixed;bottom:20px;left:50%;"
+              "transform:translateX(-50%);"));
+  out.print(F("width:300px;max-width:90vw;z-index:1000;box-shadow:0 4px "
+              "15px rgba(0,0,0,0.3)!important}"));
+  out.print(F(".content-with-sticky{padding-bottom:80px}"));
+  out.print(F("</style></head><body><div class='container'>"));
+  out.print(F("<h1>⏱️ Arena Timer Control</h1>"));
+  out.print(F("<div class='grid-container'>"));
+
+  // Column 1: Timer Controls & Duration & Console
+  out.print(F("<div class='grid-column'>"));
+  out.print(F("<div class='section'><h2>🎮 Timer Controls</h2><div "
+              "class='controls'>"));
+  out.print(F("<button id='startBtn' class='btn-start' "
+              "onclick='sendCommand(\"start\")'>▶️ Start</button>"));
+  out.print(F("<button class='btn-pause' "
+              "onclick='sendCommand(\"pause\")'>⏸️ Pause</button>"));
+  out.print(F("<button class='btn-reset' "
+              "onclick='sendCommand(\"reset\")'>🔄 Reset</button>"));
+  out.print(F("<button class='btn-pause' onclick='toggleOrientation()' "
+              "style='grid-column:1/-1'>"));
+  out.print(F("🔄 Flip Display</button>"));
+  out.print(F("</div></div>"));
+  out.print(F("<div class='section'><h2>⏲️ Timer Duration</h2>"));
+  out.print(F("<div class='duration-inputs'>"));
+  out.print(
+      F("<input type='number' id='durationMin' value='3' min='0' max='60'>"));
+  out.print(F("<span>min</span>"));
+  out.print(
+      F("<input type='number' id='durationSec' value='0' min='0' max='59'>"));
+  out.print(F("<span>sec</span></div></div>"));
+
+  // Console Card
+  out.print(F("<div class='section'><h2>📝 Console</h2>"));
+  out.print(F("<div id='console' class='console'>"));
+  out.print(F("<div class='console-entry console-info'>"));
+  out.print(F("<span class='console-time'>--:--:--</span>System ready</div>"));
+  out.print(F("</div></div>")); // End Console section
+
+  out.print(F("</div>")); // End column 1
+
+  // Column 2: Color Thresholds & Font Selection
+  out.print(F("<div class='grid-column'>"));
+  out.print(F("<div class='section'><h2>⏱️ Color Thresholds</h2>"));
+  out.print(F("<p style='font-size:13px;color:#666;margin-bottom:20px'>"));
+  out.print(F("The timer automatically changes color as time runs out</p>"));
+  out.print(F("<div id='thresholds' class='threshold-list'></div>"));
+  out.print(F("<button class='btn-add' onclick='addThreshold()'>+ Add "
+              "Threshold</button>"));
+  out.print(F("<p style='font-size:13px;color:#666;margin:15px 0 10px "
+              "0;font-style:italic'>"));
+  out.print(F("When no threshold matches:</p>"));
+  out.print(F("<div class='threshold-default'>"));
+  out.print(F("<span class='label'>Default Color</span>"));
+  out.print(F("<span class='arrow'>→</span>"));
+  out.print(F("<input type='color' id='defaultColor' value='#00FF00'>"));
+  out.print(F("</div></div>"));
+
+  out.print(F("<div class='section'><h2>🔤 Font Selection</h2>"));
+  out.print(F("<div class='duration-card'>"));
+  out.print(F("<label for='fontSelect' "
+              "style='margin-bottom:10px'>Display Font:</label>"));
+  out.print(F("<select id='fontSelect' style='font-size:16px'>"));
+  out.print(F("<option value='0'>Adafruit Default (5x7 @ 2x scale)</option>"));
+  out.print(F("<optgroup label='Sans-Serif'>"));
+  out.print(F("<option value='1'>Sans 9pt</option>"));
+  out.print(F("<option value='2'>Sans 12pt</option>"));
+  out.print(F("<option value='3'>Sans Bold 9pt</option>"));
+  out.print(F("<option value='4' selected>Sans Bold 12pt (default)</option>"));
+  out.print(F("</optgroup>"));
+  out.print(F("<optgroup label='Monospace'>"));
+  out.print(F("<option value='5'>Mono 9pt</option>"));
+  out.print(F("<option value='6'>Mono 12pt</option>"));
+  out.print(F("<option value='7'>Mono Bold 9pt</option>"));
+  out.print(F("<option value='8'>Mono Bold 12pt</option>"));
+  out.print(F("</optgroup>"));
+  out.print(F("<optgroup label='Serif'>"));
+  out.print(F("<option value='9'>Serif 9pt</option>"));
+  out.print(F("<option value='10'>Serif 12pt</option>"));
+  out.print(F("<option value='11'>Serif Bold 9pt</option>"));
+  out.print(F("<option value='12'>Serif Bold 12pt</option>"));
+  out.print(F("</optgroup>"));
+  out.print(F("<optgroup label='Retro/Pixel'>"));
+  out.print(F("<option value='13'>Org_01 (Retro @ 3x)</option>"));
+  out.print(F("<option value='14'>Picopixel (Tiny @ 3x)</option>"));
+  out.print(F("<option value='15'>TomThumb (Pixel @ 3x)</option>"));
+  out.print(F("</optgroup>"));
+  out.print(F("<optgroup label='Custom Fonts'>"));
+  out.print(F("<option value='16'>Aquire (12pt)</option>"));
+  out.print(F("<option value='17'>Aquire Bold (12pt)</option>"));
+  out.print(F("<option value='18'>Aquire Light (12pt)</option>"));
+  out.print(F("</optgroup>"));
+  out.print(F("</select>"));
+  out.print(F("<label for='letterSpacing' "
+              "style='margin-top:15px;margin-bottom:5px'>Character "
+              "Spacing:</label>"));
+  out.print(F("<div style='display:flex;align-items:center;gap:10px'>"));
+  out.print(F("<input type='range' id='letterSpacing' min='-2' max='5' "
+              "value='3' style='flex:1'>"));
+  out.print(F("<span id='spacingValue' "
+              "style='min-width:30px;text-align:center'>3</span>"));
+  out.print(F("</div>"));
+  out.print(F("<label for='brightness' "
+              "style='margin-top:15px;margin-bottom:5px'>Display "
+              "Brightness:</label>"));
+  out.print(F("<div style='display:flex;align-items:center;gap:10px'>"));
+  out.print(F("<input type='range' id='brightness' min='0' max='255' "
+              "value='255' style='flex:1'>"));
+  out.print(F("<span id='brightnessValue' "
+              "style='min-width:30px;text-align:center'>100%</span>"));
+  out.print(
+      F("</div></div></div></div>")); // End duration-card, Font Selection
+                                      // section, and column 2
+
+  // Column 3: System Status & WebSocket Connection
+  out.print(F("<div class='grid-column'>"));
+
+  // System Status Card
+  out.print(F("<div class='section'><h2>📊 System Status</h2>"));
+  out.print(F("<div class='info-display'>"));
+  out.print(F("<div class='form-group'>IP Address</div>"));
+  out.print(F("<div class='info-value' id='ipAddress'>Loading...</div>"));
+  out.print(F("</div>"));
+  out.print(F("<div class='info-display'>"));
+  out.print(F("<div class='form-group'>FightTimer Connection</div>"));
+  out.print(F("<div class='info-value' id='wsStatus'>"));
+  out.print(F("<span style='color:#888'>Checking...</span></div>"));
+  out.print(F("</div></div>")); // End System Status section
+
+  // WebSocket Connection Card
+  out.print(F("<div class='section'><h2>🔗 WebSocket Connection</h2>"));
+  out.print(F("<div class='form-group'><label>Server Host / IP:</label>"));
+  if (wsClient && wsClient->getHost().length() > 0) {
+    out.print(F("<input type='text' id='wsHost' value='"));
+    out.print(wsClient->getHost());
+    out.print(F("'>"));
+  } else {
+    out.print(F("<input type='text' id='wsHost' value='172.17.17.156'>"));
+  }
+
+  out.print(F("</div><div class='form-group'><label>Port:</label>"));
+  if (wsClient && wsClient->getPort() > 0) {
+    out.print(F("<input type='number' id='wsPort' value='"));
+    out.print(wsClient->getPort());
+    out.print(F("' min='1' max='65535'>"));
+  } else {
+    out.print(F("<input type='number' id='wsPort' value='8766' min='1' "
+                "max='65535'>"));
+  }
+
+  out.print(F("</div><div class='form-group'><label>Path:</label>"));
+  if (wsClient && wsClient->getPath().length() > 0) {
+    out.print(F("<input type='text' id='wsPath' value='"));
+    out.print(wsClient->getPath());
+    out.print(F("'>"));
+  } else {
+    out.print(F("<input type='text' id='wsPath' value='/socket.io/'>"));
+  }
+  out.print(F("</div><div style='display:flex;gap:10px'>"));
+  out.print(F("<button class='btn-start' onclick='connectWebSocket()' "
+              "style='flex:1'>"));
+  out.print(F("🔗 Connect</button>"));
+  out.print(F("<button class='btn-reset' "
+              "onclick='disconnectWebSocket()' style='flex:1'>"));
+  out.print(
+      F("❌ Disconnect</button></div></div>")); // End WebSocket Connection
+                                                // section
+
+  out.print(F("</div>")); // End column 3
+
+  out.print(F("</div>")); // End grid-container
+
+  out.print(F("<button id='applyButton' class='btn-start apply-button' "
+                 "onclick='applySettings()'>"));
+  out.print(F("✓ Apply All Settings</button>"));
+
+  out.print(F("</div>")); // End container
+  out.print(F("<script>"));
+  out.print(F("let thresholds=[];"));
+  out.print(F("let consoleMessages=[];"));
+  out.print(F("function addConsoleMessage(message,type='info'){"));
+  out.print(F("const now=new Date();"));
+  out.print(F("const time=now.toLocaleTimeString('en-US',{hour12:false});"));
+  out.print(F("consoleMessages.push({time:time,message:message,type:type});"));
+  out.print(F("if(consoleMessages.length>50)consoleMessages.shift();"));
+  out.print(F("const console=document.getElementById('console');"));
+  out.print(F("console.innerHTML='';"));
+  out.print(F("consoleMessages.forEach(m=>{"));
+  out.print(F("const entry=document.createElement('div');"));
+  out.print(F("entry.className='console-entry console-'+m.type;"));
+  out.print(F("entry.innerHTML='<span "
+              "class=\"console-time\">'+m.time+'</span>'+m.message;"));
+  out.print(F("console.appendChild(entry);});"));
+  out.print(F("console.scrollTop=console.scrollHeight;}"));
+  out.print(F("function updateButtonState(){"));
+  out.print(F("fetch('/api/status').then(r=>r.json()).then(data=>{"));
+  out.print(F("const btn=document.getElementById('startBtn');"));
+  out.print(F("if(data.isPaused){btn.textContent='▶️ Resume';}"));
+  out.print(F("else{btn.textContent='▶️ Start';}"));
+  out.print(F("}).catch(err=>console.log('Status check failed'));}"));
+  out.print(F("function loadSettings(){"));
+  out.print(F("fetch('/api/settings').then(r=>r.json()).then(data=>{"));
+  out.print(F("if(data.duration){"));
+  out.print(F("document.getElementById('durationMin').value=Math.floor("
+              "data.duration/60);"));
+  out.print(
+      F("document.getElementById('durationSec').value=data.duration%60;"));
+  out.print(F("}"));
+  out.print(F("if(data.fontId!==undefined){"));
+  out.print(F("document.getElementById('fontSelect').value=data.fontId;"));
+  out.print(F("}"));
+  out.print(F("if(data.spacing!==undefined){"));
+  out.print(F("document.getElementById('letterSpacing').value=data.spacing;"));
+  out.print(
+      F("document.getElementById('spacingValue').textContent=data.spacing;"));
+  out.print(F("}"));
+  out.print(F("if(data.brightness!==undefined){"));
+  out.print(F("document.getElementById('brightness').value=data.brightness;"));
+  out.print(F("const percent=Math.round((data.brightness/255)*100);"));
+  out.print(F("document.getElementById('brightnessValue').textContent="
+              "percent+'%';"));
+  out.print(F("}"));
+  out.print(F("}).catch(err=>console.log('Load settings failed'));}"));
+  out.print(F("function loadThresholds(){"));
+  out.print(F("fetch('/api/thresholds').then(r=>r.json()).then(data=>{"));
+  out.print(F("thresholds=data.thresholds||[];"));
+  out.print(F("if(data.defaultColor){document.getElementById('"
+              "defaultColor').value=data.defaultColor;}"));
+  out.print(F("renderThresholds();"));
+  out.print(F("}).catch(err=>console.log('Load failed'));}"));
+  out.print(F("function renderThresholds(){"));
+  out.print(F("const container=document.getElementById('thresholds');"));
+  out.print(F("container.innerHTML='';"));
+  out.print(F("thresholds.forEach((t,i)=>{"));
+  out.print(F("const div=document.createElement('div');"));
+  out.print(F("div.className='threshold-item';"));
+  out.print(F("const mins=Math.floor(t.seconds/60);const secs=t.seconds%60;"));
+  out.print(F("div.innerHTML=`<div class='time-inputs'>"));
+  out.print(F("<span class='when-label'>When ≤</span>"));
+  out.print(F("<input type='number' value='${mins}' min='0' max='60' "));
+  out.print(F("onchange='updateThreshold(${i},\"minutes\",this.value)'>"));
+  out.print(F("<span class='time-label'>min</span>"));
+  out.print(F("<input type='number' value='${secs}' min='0' max='59' "));
+  out.print(F("onchange='updateThreshold(${i},\"seconds\",this.value)'>"));
+  out.print(F("<span class='time-label'>sec</span></div>"));
+  out.print(F("<span class='arrow'>→</span>"));
+  out.print(F("<input type='color' value='${t.color}' "));
+  out.print(F("onchange='updateThreshold(${i},\"color\",this.value)'>"));
+  out.print(F("<button class='btn-remove' "
+              "onclick='removeThreshold(${i})'>✕</button>`;"));
+  out.print(F("container.appendChild(div);});}"));
+  out.print(F("function addThreshold(){"));
+  out.print(F("thresholds.push({seconds:60,color:'#FFFF00'});"
+              "renderThresholds();}"));
+  out.print(
+      F("function "
+        "removeThreshold(i){thresholds.splice(i,1);renderThresholds();}"));
+  out.print(F("function updateThreshold(i,field,value){"));
+  out.print(F("if(field==='minutes'){const s=thresholds[i].seconds%60;"));
+  out.print(F("thresholds[i].seconds=parseInt(value)*60+s;}"));
+  out.print(F("else if(field==='seconds'){const "
+              "m=Math.floor(thresholds[i].seconds/60);"));
+  out.print(F("thresholds[i].seconds=m*60+parseInt(value);}"));
+  out.print(F("else if(field==='color'){thresholds[i].color=value;}}"));
+  out.print(F("function sendCommand(cmd){"));
+  out.print(
+      F("fetch('/api',{method:'POST',headers:{'Content-Type':'application/"
+        "x-www-form-urlencoded'},"));
+  out.print(F("body:'action='+cmd}).then(r=>r.text()).then(data=>{"));
+  out.print(F("addConsoleMessage('Command: "
+              "'+cmd,data.includes('Error')?'error':'success');"
+              "updateButtonState();})"));
+  out.print(F(".catch(()=>addConsoleMessage('Error sending command: "
+              "'+cmd,'error'))}"));
+  out.print(F("function toggleOrientation(){"));
+  out.print(
+      F("fetch('/api',{method:'POST',headers:{'Content-Type':'application/"
+        "x-www-form-urlencoded'},"));
+  out.print(F("body:'action=flip'}).then(r=>r.text()).then(data=>{"));
+  out.print(F("addConsoleMessage('Display "
+              "flipped',data.includes('Error')?'error':'success');})"));
+  out.print(
+      F(".catch(()=>addConsoleMessage('Error flipping display','error'))}"));
+  out.print(F("function applySettings(){"));
+  out.print(F("const "
+              "durationMin=parseInt(document.getElementById('"
+              "durationMin').value)||0;"));
+  out.print(F("const "
+              "durationSec=parseInt(document.getElementById('"
+              "durationSec').value)||0;"));
+  out.print(F("const duration=durationMin*60+durationSec;"));
+  out.print(
+      F("const defaultColor=document.getElementById('defaultColor').value;"));
+  out.print(F("const font=document.getElementById('fontSelect').value;"));
+  out.print(F("const spacing=document.getElementById('letterSpacing').value;"));
+  out.print(F("const brightness=document.getElementById('brightness').value;"));
+  out.print(F("const "
+              "thresholdData=thresholds.map(t=>t.seconds+':'+t.color)."
+              "join('|');"));
+  out.print(F("let params='action=settings&duration='+duration"
+              "+'&font='+font+'&spacing='+spacing+'&brightness='+"
+              "brightness+'&thresholds='+"
+              "encodeURIComponent(thresholdData)+'&default='+"
+              "encodeURIComponent(defaultColor);"));
+  out.print(F("fetch('/api/"
+              "settings',{method:'POST',headers:{'Content-Type':'application/"
+              "x-www-form-urlencoded'},"));
+  out.print(F("body:params}).then(r=>r.text()).then(data=>{"
+              "addConsoleMessage('Settings saved successfully',"
+              "'success');}).catch(()=>addConsoleMessage('Error "
+              "saving settings','error'))}"));
+  out.print(F("document.getElementById('letterSpacing')."
+              "addEventListener('input',function(){"));
+  out.print(F("document.getElementById('spacingValue').textContent=this."
+              "value;});"));
+  out.print(F("document.getElementById('brightness').addEventListener('"
+              "input',function(){"));
+  out.print(F("const percent=Math.round((this.value/255)*100);"));
+  out.print(F("document.getElementById('brightnessValue').textContent="
+              "percent+'%';});"));
+
+  // Network and WebSocket status functions
+  out.print(F("function updateNetworkStatus(){"));
+  out.print(F("fetch('/api/network/status').then(r=>r.json()).then(data=>{"));
+  out.print(F("document.getElementById('ipAddress').textContent=data.ip;"));
+  out.print(F("}).catch(()=>{document.getElementById('ipAddress')."
+              "textContent='Error';});}"));
+
+  out.print(F("function updateWebSocketStatus(){"));
+  out.print(F("fetch('/api/websocket/status').then(r=>r.json()).then(data=>{"));
+  out.print(F("const wsStatus=document.getElementById('wsStatus');"));
+  out.print(F("if(data.connected){"));
+  out.print(F("wsStatus.innerHTML='<span style=\"color:#4CAF50\">✅ "
+              "Connected to '+data.url+'</span>';}"));
+  out.print(F("else{wsStatus.innerHTML='<span style=\"color:#888\">⚪ "
+              "Not connected</span>';}"));
+  out.print(F("}).catch(()=>{});}"));
+
+  out.print(F("function connectWebSocket(){"));
+  out.print(F("const host=document.getElementById('wsHost').value;"));
+  out.print(F("const port=document.getElementById('wsPort').value;"));
+  out.print(F("const path=document.getElementById('wsPath').value;"));
+  out.print(F("if(!host){addConsoleMessage('Please enter a "
+              "host','error');return;}"));
+  out.print(F("const params=new "
+              "URLSearchParams({host:host,port:port,path:path});"));
+  out.print(F("fetch('/api/websocket/connect',{method:'POST',body:params})"));
+  out.print(F(".then(r=>r.json()).then(data=>{"));
+  out.print(F("addConsoleMessage(data.message,data.status==='success'?'"
+              "success':'error');"));
+  out.print(F("setTimeout(updateWebSocketStatus,1000);"));
+  out.print(
+      F("}).catch(()=>addConsoleMessage('Connection failed','error'));}"));
+
+  out.print(F("function disconnectWebSocket(){"));
+  out.print(F("fetch('/api/websocket/disconnect',{method:'POST'})"));
+  out.print(F(".then(r=>r.json()).then(data=>{"));
+  out.print(F("addConsoleMessage(data.message,data.status==='success'?'"
+              "success':'error');"));
+  out.print(F("setTimeout(updateWebSocketStatus,1000);"));
+  out.print(
+      F("}).catch(()=>addConsoleMessage('Disconnect failed','error'));}"));
+
+  // Sticky button logic
+  out.print(F("function updateStickyButton(){"));
+  out.print(F("const button=document.getElementById('applyButton');"));
+  out.print(F("const container=document.querySelector('.container');"));
+  out.print(
+      F("container.classList.remove('content-with-sticky');")); // Remove
+                                                                // first to
+                                                                // get true
+                                                                // height
+  out.print(
+      F("const scrollDiff=document.body.scrollHeight-window.innerHeight;"));
+  out.print(F("const needsScroll=scrollDiff>100;")); // Only sticky if
+                                                        // >100px overflow
+  out.print(F("if(needsScroll){"));
+  out.print(F("button.classList.add('sticky');"));
+  out.print(F("container.classList.add('content-with-sticky');}"));
+  out.print(F("else{"));
+  out.print(F("button.classList.remove('sticky');"));
+  out.print(F("container.classList.remove('content-with-sticky');}}"));
+  out.print(F("window.addEventListener('resize',updateStickyButton);"));
+
+  out.print(F("loadSettings();"));
+  out.print(F("loadThresholds();"));
+  out.print(F("updateButtonState();"));
+  out.print(F("updateNetworkStatus();"));
+  out.print(F("updateWebSocketStatus();"));
+  out.print(F("updateStickyButton();"));
+  out.print(F("setInterval(updateButtonState, 1000);"));
+  out.print(F("setInterval(updateNetworkStatus, 5000);"));
+  out.print(F("setInterval(updateWebSocketStatus, 5000);"));
+  out.print(F("setInterval(updateStickyButton, 500);"));
+  // Overwrite updateWebSocketStatus with logging version
+  out.print(F("let lastWsState=false;"));
+  out.print(F("updateWebSocketStatus=function(){"));
+  out.print(F("fetch('/api/websocket/status').then(r=>r.json()).then(data=>{"));
+  out.print(F("const wsStatus=document.getElementById('wsStatus');"));
+  out.print(F("if(data.connected){"));
+  out.print(F("wsStatus.innerHTML='<span style=\"color:#4CAF50\">✅ "
+              "Connected to '+data.url+'</span>';"));
+  out.print(F("if(!lastWsState){addConsoleMessage('WebSocket Connected "
+              "to '+data.url, 'success');}"));
+  out.print(F("lastWsState=true;"));
+  out.print(F("}else{"));
+  out.print(F("wsStatus.innerHTML='<span style=\"color:#888\">⚪ "
+              "Not connected</span>';"));
+  out.print(F("if(lastWsState){addConsoleMessage('WebSocket "
+              "Disconnected', 'warning');}"));
+  out.print(F("lastWsState=false;"));
+  out.print(F("}"));
+  out.print(F("}).catch(()=>{});};"));
+
+  out.print(F("</script></body></html>"));
+
+  out.end();
+  LOG_DEBUG(Log::TAG_HTTP, "Web page served (%u bytes in %u writes)",
+            out.getByteCount(), out.getWriteCount());
+}
+
+// POST /api - Timer control
+void handleTimerAction(RequestContext &ctx) {
+  // Action may come from the form body or the query string
+  char action[16] = "";
+  if (!ctx.request.formField("action", action, sizeof(action))) {
+    ctx.request.queryParam("action", action, sizeof(action));
+  }
+
+  LOG_INFO(Log::TAG_HTTP, "Timer action: %s", action);
+
+  String response = "{";
+  if (strcmp(action, "start") == 0) {
+    ctx.timerDisplay.getTimer().start();
+    response += "\"status\":\"success\",\"message\":\"Timer started\"";
+  } else if (strcmp(action, "pause") == 0) {
+    ctx.timerDisplay.getTimer().stop();
+    response += "\"status\":\"success\",\"message\":\"Timer paused\"";
+  } else if (strcmp(action, "reset") == 0) {
+    ctx.timerDisplay.getTimer().reset();
+    response += "\"status\":\"success\",\"message\":\"Timer reset\"";
+  } else if (strcmp(action, "flip") == 0) {
+    // Half a turn from wherever it is; the setting is saved
+    TimerDisplay &display = ctx.timerDisplay;
+    display.setRotation(display.getRotation() + 2);
+    scheduleSave(display);
+    response += "\"status\":\"success\",\"message\":\"Orientation flipped\"";
+  } else {
+    response += "\"status\":\"error\",\"message\":\"Unknown action: " +
+                String(action) + "\"";
+  }
+  response += "}";
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
 
-  File file = LittleFS.open("/settings.json", "r");
-  if (!file) {
-    DEBUG_PRINTLN("Failed to open settings file for reading");
+// Parse "seconds:#RRGGBB|..." into thresholds sorted like TimerDisplay keeps
+// them (descending seconds)
+size_t parseThresholds(char *data, TimerDisplay::ColorThreshold *out,
+                       size_t max) {
+  size_t count = 0;
+  char *token = data;
+  while (token != nullptr && *token != '\0' && count < max) {
+    char *next = strchr(token, '|');
+    if (next != nullptr)
+      *next++ = '\0';
+
+    char *colon = strchr(token, ':');
+    if (colon != nullptr && colon != token) {
+      *colon = '\0';
+      TimerDisplay::ColorThreshold t;
+      t.seconds = atoi(token);
+      parseColor(colon + 1, t.r, t.g, t.b);
+
+      size_t i = count++;
+      while (i > 0 && out[i - 1].seconds < t.seconds) {
+        out[i] = out[i - 1];
+        i--;
+      }
+      out[i] = t;
+    }
+    token = next;
+  }
+  return count;
+}
+
+// Parse a whole form value as a decimal integer (atoi() would read "abc" as
+// 0 and "5x" as 5)
+bool parseInteger(const char *text, long &out) {
+  char *end = nullptr;
+  long value = strtol(text, &end, 10);
+  if (end == text || *end != '\0') {
     return false;
   }
+  out = value;
+  return true;
+}
 
+// POST/PATCH /api/settings - Apply only the fields that are present and differ
+// from the current state. The timer is only reset when the duration changes
+// and a save is only scheduled when something was applied.
+void handleSettingsPost(RequestContext &ctx) {
+  TimerDisplay &display = ctx.timerDisplay;
   JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, file);
-  file.close();
+  JsonObject applied = doc["applied"].to<JsonObject>();
+  char value[16];
+
+  if (ctx.request.formField("duration", value, sizeof(value))) {
+    long seconds = 0;
+    if (!parseInteger(value, seconds)) {
+      // atoi() would have read this as 0 and reset the timer to 0:00
+      doc["rejected"].add("duration");
+    } else {
+      unsigned int duration =
+          constrain(seconds, 0L, (long)ConfigStore::MAX_DURATION_SECONDS);
+      if (duration != display.getTimer().getDurationSeconds()) {
+        Timer::Components comp;
+        comp.minutes = duration / 60;
+        comp.seconds = duration % 60;
+        comp.milliseconds = 0;
+        display.getTimer().setDuration(comp);
+        display.getTimer().reset();
+        applied["duration"] = duration;
+      }
+    }
+  }
 
-  if (error) {
-    DEBUG_PRINTLN("Failed to parse settings file");
-    return false;
+  if (ctx.request.formField("font", value, sizeof(value))) {
+    long fontId = 0;
+    if (!parseInteger(value, fontId) || fontId < 0 ||
+        fontId >= ConfigStore::FONT_COUNT) {
+      // getFontById() would silently fall back to the default font
+      doc["rejected"].add("font");
+    } else if (fontId != display.getFontId()) {
+      display.setFont(getFontById(fontId), fontId);
+      display.setTextSize(getTextSizeForFont(fontId));
+      applied["font"] = fontId;
+    }
   }
 
-  if (!doc["duration"].isNull()) {
-    int duration = doc["duration"];
-    Timer::Components comp;
-    comp.minutes = duration / 60;
-    comp.seconds = duration % 60;
-    comp.milliseconds = 0;
-    timerDisplay.getTimer().setDuration(comp);
-    timerDisplay.getTimer().reset();
+  if (ctx.request.formField("spacing", value, sizeof(value))) {
+    int8_t spacing = constrain(atoi(value), ConfigStore::MIN_LETTER_SPACING,
+                               ConfigStore::MAX_LETTER_SPACING);
+    if (spacing != display.getLetterSpacing()) {
+      display.setLetterSpacing(spacing);
+      applied["spacing"] = spacing;
+    }
   }
 
-  if (!doc["font"].isNull()) {
-    int fontId = doc["font"];
-    timerDisplay.setFont(getFontById(fontId), fontId);
-    timerDisplay.setTextSize(getTextSizeForFont(fontId));
+  if (ctx.request.formField("brightness", value, sizeof(value))) {
+    uint8_t brightness = constrain(atoi(value), 0, 255);
+    if (brightness != display.getBrightness()) {
+      display.setBrightness(brightness);
+      applied["brightness"] = brightness;
+    }
   }
 
-  if (!doc["spacing"].isNull()) {
-    timerDisplay.setLetterSpacing(doc["spacing"]);
+  RefreshControl &refresh = display.getRefresh();
+  if (ctx.request.formField("refreshHz", value, sizeof(value))) {
+    uint16_t hz = constrain(atoi(value), 1, ConfigStore::MAX_REFRESH_HZ);
+    if (hz != refresh.getTargetHz()) {
+      refresh.setTargetHz(hz);
+      applied["refreshHz"] = hz;
+    }
   }
 
-  if (!doc["brightness"].isNull()) {
-    timerDisplay.setBrightness(doc["brightness"]);
+  if (ctx.request.formField("bitDepth", value, sizeof(value))) {
+    // "auto" (or 0) picks the depth from the refresh rate
+    uint8_t depth = constrain(atoi(value), 0, ConfigStore::MAX_BIT_DEPTH);
+    if (depth != refresh.getBitDepth()) {
+      refresh.setBitDepth(depth);
+      if (depth == RefreshControl::AUTO) {
+        applied["bitDepth"] = "auto";
+      } else {
+        applied["bitDepth"] = depth;
+      }
+    }
   }
 
-  if (!doc["thresholds"].isNull()) {
-    timerDisplay.clearColorThresholds();
-    JsonArray thresholds = doc["thresholds"];
-    int count = 0;
-    for (JsonVariant v : thresholds) {
-      JsonObject t = v.as<JsonObject>();
-      if (!t.isNull()) {
-        unsigned int seconds = t["seconds"];
-        const char *color = t["color"];
-        if (color) {
-          uint8_t r, g, b;
-          parseColor(color, r, g, b);
-          timerDisplay.addColorThreshold(seconds, r, g, b);
-          count++;
-          DEBUG_PRINT("Threshold Loaded: ");
-          DEBUG_PRINT(seconds);
-          DEBUG_PRINT("s -> ");
-          DEBUG_PRINTLN(color);
-        }
+  if (ctx.request.formField("broadcastHz", value, sizeof(value))) {
+    uint16_t hz = constrain(atoi(value), 1, ConfigStore::MAX_REFRESH_HZ);
+    if (hz != refresh.getBroadcastHz()) {
+      refresh.setBroadcastHz(hz);
+      applied["broadcastHz"] = hz;
+    }
+  }
+
+  if (ctx.request.formField("broadcast", value, sizeof(value))) {
+    bool broadcast = atoi(value) != 0;
+    if (broadcast != refresh.isBroadcast()) {
+      refresh.setBroadcast(broadcast);
+      applied["broadcast"] = broadcast;
+    }
+  }
+
+  if (ctx.request.formField("orientation", value, sizeof(value))) {
+    // Degrees, rounded to a quarter turn
+    uint8_t rotation = ((atoi(value) % 360 + 360 + 45) / 90) & 3;
+    if (rotation != display.getRotation()) {
+      display.setRotation(rotation);
+      applied["orientation"] = rotation * 90;
+    }
+  }
+
+  char thresholdsData[256];
+  if (ctx.request.formField("thresholds", thresholdsData,
+                            sizeof(thresholdsData)) &&
+      thresholdsData[0] != '\0') {
+    TimerDisplay::ColorThreshold parsed[TimerDisplay::MAX_THRESHOLDS];
+    size_t count = parseThresholds(thresholdsData, parsed,
+                                   TimerDisplay::MAX_THRESHOLDS);
+
+    size_t currentCount = 0;
+    const TimerDisplay::ColorThreshold *current =
+        display.getColorThresholds(currentCount);
+    bool changed = count != currentCount;
+    for (size_t i = 0; !changed && i < count; i++) {
+      changed = parsed[i].seconds != current[i].seconds ||
+                parsed[i].r != current[i].r || parsed[i].g != current[i].g ||
+                parsed[i].b != current[i].b;
+    }
+
+    if (changed) {
+      display.clearColorThresholds();
+      for (size_t i = 0; i < count; i++) {
+        display.addColorThreshold(parsed[i].seconds, parsed[i].r, parsed[i].g,
+                                  parsed[i].b);
       }
+      applied["thresholds"] = count;
     }
-    DEBUG_PRINT("Loaded ");
-    DEBUG_PRINT(count);
-    DEBUG_PRINTLN(" thresholds");
   }
 
-  if (!doc["defaultColor"].isNull()) {
-    uint8_t r, g, b;
-    parseColor(doc["defaultColor"].as<const char *>(), r, g, b);
-    timerDisplay.setDefaultColor(r, g, b);
-    timerDisplay.setColor(r, g, b);
+  char defaultColorData[16];
+  if (ctx.request.formField("default", defaultColorData,
+                            sizeof(defaultColorData)) &&
+      defaultColorData[0] != '\0') {
+    uint8_t r, g, b, cr, cg, cb;
+    parseColor(defaultColorData, r, g, b);
+    display.getDefaultColor(cr, cg, cb);
+    if (r != cr || g != cg || b != cb) {
+      display.setDefaultColor(r, g, b);
+      // Also set current color to default if timer is idle
+      if (display.getTimer().isIdle()) {
+        display.setColor(r, g, b);
+      }
+      char hex[8];
+      snprintf(hex, sizeof(hex), "#%02X%02X%02X", r, g, b);
+      applied["default"] = hex;
+    }
   }
 
-  DEBUG_PRINTLN("Settings loaded from /settings.json");
-  return true;
+  // Persist only when something actually changed; rapid updates (e.g. a
+  // slider being dragged) are coalesced into one write
+  bool scheduled = applied.size() > 0;
+  if (scheduled) {
+    scheduleSave(display);
+  }
+
+  // Fields that were valid are still applied; the client is told which
+  // ones were not
+  bool rejected = !doc["rejected"].isNull();
+  doc["status"] = rejected ? "error" : "success";
+  doc["scheduled"] = scheduled;
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, rejected ? 400 : 200, "application/json",
+                   response);
 }
 
-void handleClient(TimerDisplay &timerDisplay) {
-  // Update mDNS responder to keep hostname resolution alive
-  updateMDNS();
+// POST /api/websocket/connect
+void handleWebSocketConnect(RequestContext &ctx) {
+  char host[101] = "";
+  int port = 8765;
+  char path[101] = "/socket.io/";
+
+  char value[8];
+  ctx.request.formField("host", host, sizeof(host));
+  if (ctx.request.formField("port", value, sizeof(value)))
+    port = atoi(value);
+  ctx.request.formField("path", path, sizeof(path));
+
+  if (wsClient && host[0] != '\0') {
+    wsClient->connect(host, port, path);
+    sendHTTPResponse(
+        ctx.out, 200, "application/json",
+        "{\"status\":\"success\",\"message\":\"Connecting...\"}");
+  } else {
+    sendHTTPResponse(
+        ctx.out, 400, "application/json",
+        "{\"status\":\"error\",\"message\":\"Missing host\"}");
+  }
+}
 
-  if (server == nullptr)
+// POST /api/websocket/disconnect
+void handleWebSocketDisconnect(RequestContext &ctx) {
+  if (wsClient) {
+    wsClient->disconnect();
+    sendHTTPResponse(
+        ctx.out, 200, "application/json",
+        "{\"status\":\"success\",\"message\":\"Disconnected\"}");
+  } else {
+    sendHTTPResponse(
+        ctx.out, 500, "application/json",
+        "{\"status\":\"error\",\"message\":\"No Client\"}");
+  }
+}
+
+// GET /api/status
+void handleStatus(RequestContext &ctx) {
+  String json = "{";
+  json += "\"isPaused\":" +
+          String(ctx.timerDisplay.getTimer().isPaused() ? "true" : "false");
+  json += "}";
+  sendHTTPResponse(ctx.out, 200, "application/json", json);
+}
+
+// GET /api/config - Export the stored configuration as JSON
+void handleConfigGet(RequestContext &ctx) {
+  captureSettings(ctx.timerDisplay);
+  JsonDocument doc;
+  ConfigStore::toJson(doc);
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// POST /api/config - Import configuration from a JSON body (any subset of
+// the exported fields)
+void handleConfigPost(RequestContext &ctx) {
+  JsonDocument doc;
+  DeserializationError error =
+      deserializeJson(doc, ctx.request.body, ctx.request.bodyLength);
+  if (error) {
+    sendHTTPResponse(ctx.out, 400, "application/json",
+                     "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
     return;
+  }
 
-  EthernetClient client = server->available();
-  if (client) {
-    String currentLine = "";
-    String requestType = "";
-    String requestPath = "";
-    String postData = "";
-    bool isPost = false;
-    int contentLength = 0;
-
-    // Read HTTP request
-    while (client.connected()) {
-      if (client.available()) {
-        char c = client.read();
-
-        if (c == '\n') {
-          if (currentLine.length() == 0) {
-            // End of headers, read POST data if needed
-            if (isPost && contentLength > 0) {
-              postData.reserve(contentLength);
-              unsigned long startTime = millis();
-              int bytesRead = 0;
-              while (bytesRead < contentLength && millis() - startTime < 1000) {
-                if (client.available()) {
-                  postData += (char)client.read();
-                  bytesRead++;
-                }
-              }
-            }
-            break;
-          } else {
-            // Parse request line
-            if (requestType == "") {
-              int firstSpace = currentLine.indexOf(' ');
-              int secondSpace = currentLine.indexOf(' ', firstSpace + 1);
-              if (firstSpace > 0 && secondSpace > firstSpace) {
-                requestType = currentLine.substring(0, firstSpace);
-                requestPath =
-                    currentLine.substring(firstSpace + 1, secondSpace);
-                isPost = (requestType == "POST");
-              }
-            }
-            // Check for Content-Length header
-            // Check for Content-Length header
-            String lineLower = currentLine;
-            lineLower.toLowerCase();
-            if (lineLower.startsWith("content-length: ")) {
-              contentLength = currentLine.substring(16).toInt();
-            }
-            currentLine = "";
-          }
-        } else if (c != '\r') {
-          currentLine += c;
-        }
-      }
+  // Out-of-range numbers are clamped like the settings form's; fields that
+  // can't be used are left out and reported, the rest still applied
+  JsonDocument reply;
+  JsonArray rejected = reply["rejected"].to<JsonArray>();
+  captureSettings(ctx.timerDisplay);
+  uint8_t changed = ConfigStore::fromJson(doc, rejected);
+  if (changed & ConfigStore::SECTION_DISPLAY) {
+    applySettings(ctx.timerDisplay);
+  }
+  const ConfigStore::Config &config = ConfigStore::get();
+  if ((changed & ConfigStore::SECTION_WEBSOCKET) && wsClient) {
+    if (config.sections & ConfigStore::SECTION_WEBSOCKET) {
+      wsClient->connect(config.wsHost, config.wsPort, config.wsPath);
+    } else {
+      wsClient->disconnect();
     }
+  }
+  if (changed) {
+    ConfigStore::scheduleSave();
+  }
 
-    // Handle different endpoints
-    if (requestPath == "/" || requestPath.startsWith("/?")) {
-      // Serve web page
-      DEBUG_PRINTLN("Client connected - serving web page");
-      client.println("HTTP/1.1 200 OK");
-      client.println("Content-Type: text/html");
-      client.println("Connection: close");
-      client.println();
-
-      // Send HTML in chunks using F() to save RAM
-      client.print(
-          F("<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'>"));
-      client.print(F("<meta name='viewport' content='width=device-width, "
-                     "initial-scale=1.0'>"));
-      client.print(F("<title>Arena Timer Control</title><style>"));
-      client.print(
-          F("body{font-family:Arial,sans-serif;margin:0;padding:20px;"));
-      client.print(
-          F("background:linear-gradient(135deg,#667eea 0%,#764ba2 100%);"));
-      client.print(F("min-height:100vh}"));
-      client.print(
-          F(".container{background:white;border-radius:10px;padding:30px;"));
-      client.print(F("box-shadow:0 10px 40px "
-                     "rgba(0,0,0,0.2);max-width:1400px;margin:0 auto}"));
-      client.print(F("h1{text-align:center;color:#333;margin-bottom:30px}"));
-      client.print(F(
-          ".grid-container{display:grid;grid-template-columns:repeat(3,1fr);"));
-      client.print(F("gap:20px;margin-top:20px}"));
-      client.print(
-          F("@media "
-            "(max-width:1200px){.grid-container{grid-template-columns:1fr}}"));
-      client.print(
-          F(".section{margin-bottom:25px;padding:20px;background:#f5f5f5;"));
-      client.print(F("border-radius:8px}.section "
-                     "h2{margin-top:0;color:#667eea;font-size:18px}"));
-      client.print(F(".controls{display:grid;grid-template-columns:1fr "
-                     "1fr;gap:10px;margin-bottom:15px}"));
-      client.print(F("button{padding:15px "
-                     "20px;border:none;border-radius:6px;font-size:16px;"));
-      client.print(F("cursor:pointer;transition:all 0.3s;font-weight:bold}"));
-      client.print(
-          F(".btn-start{background:#4CAF50;color:white;grid-column:1/-1}"));
-      client.print(F(".btn-start:hover{background:#45a049}"));
-      client.print(F(".btn-pause{background:#FF9800;color:white}"));
-      client.print(F(".btn-pause:hover{background:#e68900}"));
-      client.print(F(".btn-reset{background:#f44336;color:white}"));
-      client.print(F(".btn-reset:hover{background:#da190b}"));
-      client.print(F(".form-group{margin-bottom:15px}"));
-      client.print(F("label{display:block;margin-bottom:5px;color:#555;font-"
-                     "weight:bold}"));
-      client.print(F("input[type='number'],input[type='color'],select{width:"
-                     "100%;padding:10px;"));
-      client.print(
-          F("border:2px solid "
-            "#ddd;border-radius:6px;font-size:14px;box-sizing:border-box}"));
-      client.print(F("input[type='number']:focus,input[type='color']:focus,"
-                     "select:focus{"));
-      client.print(F("border-color:#667eea;outline:none}"));
-      client.print(F("input[type='color']{height:45px;cursor:pointer;border-"
-                     "radius:6px;min-width:60px}"));
-      client.print(F(".threshold-list{margin-bottom:15px}"));
-      client.print(
-          F(".threshold-item{display:flex;align-items:center;gap:10px;"));
-      client.print(F("margin-bottom:10px;padding:12px;background:white;border-"
-                     "radius:8px;"));
-      client.print(F("border-left:4px solid #667eea;box-shadow:0 2px 4px "
-                     "rgba(0,0,0,0.05)}"));
-      client.print(F(".threshold-item "
-                     ".time-inputs{display:flex;gap:5px;align-items:center;"));
-      client.print(F("flex:1;white-space:nowrap}"));
-      client.print(
-          F(".threshold-item "
-            ".when-label{color:#666;font-weight:500;white-space:nowrap}"));
-      client.print(
-          F(".threshold-item "
-            "input[type='number']{width:60px;padding:8px;text-align:center;"));
-      client.print(F("font-size:16px;font-weight:bold;flex-shrink:0}"));
-      client.print(
-          F(".threshold-item "
-            ".time-label{font-size:12px;color:#999;font-weight:normal}"));
-      client.print(F(
-          ".threshold-item .arrow{color:#667eea;font-size:20px;margin:0 8px}"));
-      client.print(
-          F(".threshold-default{display:flex;align-items:center;gap:10px;"));
-      client.print(F("padding:12px;background:white;border-radius:8px;"));
-      client.print(F("border-left:4px solid #667eea;box-shadow:0 2px 4px "
-                     "rgba(0,0,0,0.05);margin-bottom:10px}"));
-      client.print(
-          F(".threshold-default .label{flex:1;color:#666;font-weight:500}"));
-      client.print(
-          F(".duration-card{padding:20px;background:white;border-radius:8px;"));
-      client.print(F("box-shadow:0 2px 4px rgba(0,0,0,0.05);margin-top:15px}"));
-      client.print(F(".duration-inputs{display:flex;gap:8px;align-items:center;"
-                     "margin-top:10px}"));
-      client.print(F(".duration-inputs "
-                     "input{width:80px;text-align:center;font-size:16px;font-"
-                     "weight:bold}"));
-      client.print(F(".duration-inputs span{color:#666;font-size:14px}"));
-      client.print(F(".btn-remove{background:#ff5252;color:white;padding:8px "
-                     "12px;border:none;"));
-      client.print(F(
-          "border-radius:6px;cursor:pointer;font-size:14px;font-weight:bold;"));
-      client.print(F("transition:background 0.2s}"));
-      client.print(F(".btn-remove:hover{background:#ff1744}"));
-      client.print(F(
-          ".btn-add{background:#4CAF50;color:white;padding:12px;border:none;"));
-      client.print(F("border-radius:8px;cursor:pointer;width:100%;font-size:"
-                     "14px;font-weight:bold;"));
-      client.print(F("margin-bottom:15px;transition:background 0.2s}"));
-      client.print(F(".btn-add:hover{background:#45a049}"));
-      client.print(F(".console{background:#1e1e1e;color:#d4d4d4;padding:15px;"
-                     "border-radius:8px;"));
-      client.print(F(
-          "font-family:'Courier New',monospace;font-size:12px;height:200px;"));
-      client.print(
-          F("overflow-y:auto;box-shadow:inset 0 2px 4px rgba(0,0,0,0.3)}"));
-      client.print(F(".console-entry{margin-bottom:8px;line-height:1.4}"));
-      client.print(F(".console-time{color:#858585;margin-right:8px}"));
-      client.print(F(".console-success{color:#4CAF50}"));
-      client.print(F(".console-error{color:#f44336}"));
-      client.print(F(".console-info{color:#2196F3}"));
-      client.print(F(".console-warning{color:#FF9800}"));
-      client.print(
-          F(".info-display{background:white;padding:12px;border-radius:8px;"));
-      client.print(F("margin-bottom:15px;border-left:4px solid #667eea;"));
-      client.print(F("box-shadow:0 2px 4px rgba(0,0,0,0.05)}"));
-      client.print(F(".info-label{color:#666;font-size:12px;font-weight:500;"
-                     "text-transform:uppercase}"));
-      client.print(F(".info-value{color:#333;font-size:16px;font-weight:bold;"
-                     "margin-top:4px;"));
-      client.print(F("font-family:monospace}"));
-      client.print(F(".apply-button{margin-top:20px;width:100%}"));
-      client.print(F(".apply-button.sticky{position:fixed;bottom:20px;left:50%;"
-                     "transform:translateX(-50%);"));
-      client.print(F("width:300px;max-width:90vw;z-index:1000;box-shadow:0 4px "
-                     "15px rgba(0,0,0,0.3)!important}"));
-      client.print(F(".content-with-sticky{padding-bottom:80px}"));
-      client.print(F("</style></head><body><div class='container'>"));
-      client.print(F("<h1>⏱️ Arena Timer Control</h1>"));
-      client.print(F("<div class='grid-container'>"));
-
-      // Column 1: Timer Controls & Duration & Console
-      client.print(F("<div class='grid-column'>"));
-      client.print(F("<div class='section'><h2>🎮 Timer Controls</h2><div "
-                     "class='controls'>"));
-      client.print(F("<button id='startBtn' class='btn-start' "
-                     "onclick='sendCommand(\"start\")'>▶️ Start</button>"));
-      client.print(F("<button class='btn-pause' "
-                     "onclick='sendCommand(\"pause\")'>⏸️ Pause</button>"));
-      client.print(F("<button class='btn-reset' "
-                     "onclick='sendCommand(\"reset\")'>🔄 Reset</button>"));
-      client.print(F("<button class='btn-pause' onclick='toggleOrientation()' "
-                     "style='grid-column:1/-1'>"));
-      client.print(F("🔄 Flip Display</button>"));
-      client.print(F("</div></div>"));
-      client.print(F("<div class='section'><h2>⏲️ Timer Duration</h2>"));
-      client.print(F("<div class='duration-inputs'>"));
-      client.print(F(
-          "<input type='number' id='durationMin' value='3' min='0' max='60'>"));
-      client.print(F("<span>min</span>"));
-      client.print(F(
-          "<input type='number' id='durationSec' value='0' min='0' max='59'>"));
-      client.print(F("<span>sec</span></div></div>"));
-
-      // Console Card
-      client.print(F("<div class='section'><h2>📝 Console</h2>"));
-      client.print(F("<div id='console' class='console'>"));
-      client.print(F("<div class='console-entry console-info'>"));
-      client.print(
-          F("<span class='console-time'>--:--:--</span>System ready</div>"));
-      client.print(F("</div></div>")); // End Console section
-
-      client.print(F("</div>")); // End column 1
-
-      // Column 2: Color Thresholds & Font Selection
-      client.print(F("<div class='grid-column'>"));
-      client.print(F("<div class='section'><h2>⏱️ Color Thresholds</h2>"));
-      client.print(
-          F("<p style='font-size:13px;color:#666;margin-bottom:20px'>"));
-      client.print(
-          F("The timer automatically changes color as time runs out</p>"));
-      client.print(F("<div id='thresholds' class='threshold-list'></div>"));
-      client.print(F("<button class='btn-add' onclick='addThreshold()'>+ Add "
-                     "Threshold</button>"));
-      client.print(F("<p style='font-size:13px;color:#666;margin:15px 0 10px "
-                     "0;font-style:italic'>"));
-      client.print(F("When no threshold matches:</p>"));
-      client.print(F("<div class='threshold-default'>"));
-      client.print(F("<span class='label'>Default Color</span>"));
-      client.print(F("<span class='arrow'>→</span>"));
-      client.print(F("<input type='color' id='defaultColor' value='#00FF00'>"));
-      client.print(F("</div></div>"));
-
-      client.print(F("<div class='section'><h2>🔤 Font Selection</h2>"));
-      client.print(F("<div class='duration-card'>"));
-      client.print(F("<label for='fontSelect' "
-                     "style='margin-bottom:10px'>Display Font:</label>"));
-      client.print(F("<select id='fontSelect' style='font-size:16px'>"));
-      client.print(
-          F("<option value='0'>Adafruit Default (5x7 @ 2x scale)</option>"));
-      client.print(F("<optgroup label='Sans-Serif'>"));
-      client.print(F("<option value='1'>Sans 9pt</option>"));
-      client.print(F("<option value='2'>Sans 12pt</option>"));
-      client.print(F("<option value='3'>Sans Bold 9pt</option>"));
-      client.print(
-          F("<option value='4' selected>Sans Bold 12pt (default)</option>"));
-      client.print(F("</optgroup>"));
-      client.print(F("<optgroup label='Monospace'>"));
-      client.print(F("<option value='5'>Mono 9pt</option>"));
-      client.print(F("<option value='6'>Mono 12pt</option>"));
-      client.print(F("<option value='7'>Mono Bold 9pt</option>"));
-      client.print(F("<option value='8'>Mono Bold 12pt</option>"));
-      client.print(F("</optgroup>"));
-      client.print(F("<optgroup label='Serif'>"));
-      client.print(F("<option value='9'>Serif 9pt</option>"));
-      client.print(F("<option value='10'>Serif 12pt</option>"));
-      client.print(F("<option value='11'>Serif Bold 9pt</option>"));
-      client.print(F("<option value='12'>Serif Bold 12pt</option>"));
-      client.print(F("</optgroup>"));
-      client.print(F("<optgroup label='Retro/Pixel'>"));
-      client.print(F("<option value='13'>Org_01 (Retro @ 3x)</option>"));
-      client.print(F("<option value='14'>Picopixel (Tiny @ 3x)</option>"));
-      client.print(F("<option value='15'>TomThumb (Pixel @ 3x)</option>"));
-      client.print(F("</optgroup>"));
-      client.print(F("<optgroup label='Custom Fonts'>"));
-      client.print(F("<option value='16'>Aquire (12pt)</option>"));
-      client.print(F("<option value='17'>Aquire Bold (12pt)</option>"));
-      client.print(F("<option value='18'>Aquire Light (12pt)</option>"));
-      client.print(F("</optgroup>"));
-      client.print(F("</select>"));
-      client.print(F("<label for='letterSpacing' "
-                     "style='margin-top:15px;margin-bottom:5px'>Character "
-                     "Spacing:</label>"));
-      client.print(F("<div style='display:flex;align-items:center;gap:10px'>"));
-      client.print(F("<input type='range' id='letterSpacing' min='-2' max='5' "
-                     "value='3' style='flex:1'>"));
-      client.print(F("<span id='spacingValue' "
-                     "style='min-width:30px;text-align:center'>3</span>"));
-      client.print(F("</div>"));
-      client.print(F("<label for='brightness' "
-                     "style='margin-top:15px;margin-bottom:5px'>Display "
-                     "Brightness:</label>"));
-      client.print(F("<div style='display:flex;align-items:center;gap:10px'>"));
-      client.print(F("<input type='range' id='brightness' min='0' max='255' "
-                     "value='255' style='flex:1'>"));
-      client.print(F("<span id='brightnessValue' "
-                     "style='min-width:30px;text-align:center'>100%</span>"));
-      client.print(
-          F("</div></div></div></div>")); // End duration-card, Font Selection
-                                          // section, and column 2
-
-      // Column 3: System Status & WebSocket Connection
-      client.print(F("<div class='grid-column'>"));
-
-      // System Status Card
-      client.print(F("<div class='section'><h2>📊 System Status</h2>"));
-      client.print(F("<div class='info-display'>"));
-      client.print(F("<div class='form-group'>IP Address</div>"));
-      client.print(
-          F("<div class='info-value' id='ipAddress'>Loading...</div>"));
-      client.print(F("</div>"));
-      client.print(F("<div class='info-display'>"));
-      client.print(F("<div class='form-group'>FightTimer Connection</div>"));
-      client.print(F("<div class='info-value' id='wsStatus'>"));
-      client.print(F("<span style='color:#888'>Checking...</span></div>"));
-      client.print(F("</div></div>")); // End System Status section
-
-      // WebSocket Connection Card
-      client.print(F("<div class='section'><h2>🔗 WebSocket Connection</h2>"));
-      client.print(
-          F("<div class='form-group'><label>Server Host / IP:</label>"));
-      if (wsClient && wsClient->getHost().length() > 0) {
-        client.print(F("<input type='text' id='wsHost' value='"));
-        client.print(wsClient->getHost());
-        client.print(F("'>"));
-      } else {
-        client.print(
-            F("<input type='text' id='wsHost' value='172.17.17.156'>"));
-      }
+  bool invalid = rejected.size() > 0;
+  if (!invalid) {
+    reply.remove("rejected");
+  }
+  reply["status"] = invalid ? "error" : "success";
+  reply["scheduled"] = changed != 0;
+  String response;
+  serializeJson(reply, response);
+  sendHTTPResponse(ctx.out, invalid ? 400 : 200, "application/json",
+                   response);
+}
 
-      client.print(F("</div><div class='form-group'><label>Port:</label>"));
-      if (wsClient && wsClient->getPort() > 0) {
-        client.print(F("<input type='number' id='wsPort' value='"));
-        client.print(wsClient->getPort());
-        client.print(F("' min='1' max='65535'>"));
-      } else {
-        client.print(F("<input type='number' id='wsPort' value='8766' min='1' "
-                       "max='65535'>"));
-      }
+// Replayed frames go to the WebSocket client as if just received
+void replayToClient(uint8_t type, const uint8_t *payload, size_t length) {
+  if (wsClient) {
+    wsClient->replayFrame(type, payload, length);
+  }
+}
 
-      client.print(F("</div><div class='form-group'><label>Path:</label>"));
-      if (wsClient && wsClient->getPath().length() > 0) {
-        client.print(F("<input type='text' id='wsPath' value='"));
-        client.print(wsClient->getPath());
-        client.print(F("'>"));
-      } else {
-        client.print(F("<input type='text' id='wsPath' value='/socket.io/'>"));
-      }
-      client.print(F("</div><div style='display:flex;gap:10px'>"));
-      client.print(F("<button class='btn-start' onclick='connectWebSocket()' "
-                     "style='flex:1'>"));
-      client.print(F("🔗 Connect</button>"));
-      client.print(F("<button class='btn-reset' "
-                     "onclick='disconnectWebSocket()' style='flex:1'>"));
-      client.print(
-          F("❌ Disconnect</button></div></div>")); // End WebSocket Connection
-                                                    // section
-
-      client.print(F("</div>")); // End column 3
-
-      client.print(F("</div>")); // End grid-container
-
-      client.print(F("<button id='applyButton' class='btn-start apply-button' "
-                     "onclick='applySettings()'>"));
-      client.print(F("✓ Apply All Settings</button>"));
-
-      client.print(F("</div>")); // End container
-      client.print(F("<script>"));
-      client.print(F("let thresholds=[];"));
-      client.print(F("let consoleMessages=[];"));
-      client.print(F("function addConsoleMessage(message,type='info'){"));
-      client.print(F("const now=new Date();"));
-      client.print(
-          F("const time=now.toLocaleTimeString('en-US',{hour12:false});"));
-      client.print(
-          F("consoleMessages.push({time:time,message:message,type:type});"));
-      client.print(F("if(consoleMessages.length>50)consoleMessages.shift();"));
-      client.print(F("const console=document.getElementById('console');"));
-      client.print(F("console.innerHTML='';"));
-      client.print(F("consoleMessages.forEach(m=>{"));
-      client.print(F("const entry=document.createElement('div');"));
-      client.print(F("entry.className='console-entry console-'+m.type;"));
-      client.print(F("entry.innerHTML='<span "
-                     "class=\"console-time\">'+m.time+'</span>'+m.message;"));
-      client.print(F("console.appendChild(entry);});"));
-      client.print(F("console.scrollTop=console.scrollHeight;}"));
-      client.print(F("function updateButtonState(){"));
-      client.print(F("fetch('/api/status').then(r=>r.json()).then(data=>{"));
-      client.print(F("const btn=document.getElementById('startBtn');"));
-      client.print(F("if(data.isPaused){btn.textContent='▶️ Resume';}"));
-      client.print(F("else{btn.textContent='▶️ Start';}"));
-      client.print(F("}).catch(err=>console.log('Status check failed'));}"));
-      client.print(F("function loadSettings(){"));
-      client.print(F("fetch('/api/settings').then(r=>r.json()).then(data=>{"));
-      client.print(F("if(data.duration){"));
-      client.print(F("document.getElementById('durationMin').value=Math.floor("
-                     "data.duration/60);"));
-      client.print(
-          F("document.getElementById('durationSec').value=data.duration%60;"));
-      client.print(F("}"));
-      client.print(F("if(data.fontId!==undefined){"));
-      client.print(
-          F("document.getElementById('fontSelect').value=data.fontId;"));
-      client.print(F("}"));
-      client.print(F("if(data.spacing!==undefined){"));
-      client.print(
-          F("document.getElementById('letterSpacing').value=data.spacing;"));
-      client.print(F(
-          "document.getElementById('spacingValue').textContent=data.spacing;"));
-      client.print(F("}"));
-      client.print(F("if(data.brightness!==undefined){"));
-      client.print(
-          F("document.getElementById('brightness').value=data.brightness;"));
-      client.print(F("const percent=Math.round((data.brightness/255)*100);"));
-      client.print(F("document.getElementById('brightnessValue').textContent="
-                     "percent+'%';"));
-      client.print(F("}"));
-      client.print(F("}).catch(err=>console.log('Load settings failed'));}"));
-      client.print(F("function loadThresholds(){"));
-      client.print(
-          F("fetch('/api/thresholds').then(r=>r.json()).then(data=>{"));
-      client.print(F("thresholds=data.thresholds||[];"));
-      client.print(F("if(data.defaultColor){document.getElementById('"
-                     "defaultColor').value=data.defaultColor;}"));
-      client.print(F("renderThresholds();"));
-      client.print(F("}).catch(err=>console.log('Load failed'));}"));
-      client.print(F("function renderThresholds(){"));
-      client.print(F("const container=document.getElementById('thresholds');"));
-      client.print(F("container.innerHTML='';"));
-      client.print(F("thresholds.forEach((t,i)=>{"));
-      client.print(F("const div=document.createElement('div');"));
-      client.print(F("div.className='threshold-item';"));
-      client.print(
-          F("const mins=Math.floor(t.seconds/60);const secs=t.seconds%60;"));
-      client.print(F("div.innerHTML=`<div class='time-inputs'>"));
-      client.print(F("<span class='when-label'>When ≤</span>"));
-      client.print(F("<input type='number' value='${mins}' min='0' max='60' "));
-      client.print(
-          F("onchange='updateThreshold(${i},\"minutes\",this.value)'>"));
-      client.print(F("<span class='time-label'>min</span>"));
-      client.print(F("<input type='number' value='${secs}' min='0' max='59' "));
-      client.print(
-          F("onchange='updateThreshold(${i},\"seconds\",this.value)'>"));
-      client.print(F("<span class='time-label'>sec</span></div>"));
-      client.print(F("<span class='arrow'>→</span>"));
-      client.print(F("<input type='color' value='${t.color}' "));
-      client.print(F("onchange='updateThreshold(${i},\"color\",this.value)'>"));
-      client.print(F("<button class='btn-remove' "
-                     "onclick='removeThreshold(${i})'>✕</button>`;"));
-      client.print(F("container.appendChild(div);});}"));
-      client.print(F("function addThreshold(){"));
-      client.print(F("thresholds.push({seconds:60,color:'#FFFF00'});"
-                     "renderThresholds();}"));
-      client.print(
-          F("function "
-            "removeThreshold(i){thresholds.splice(i,1);renderThresholds();}"));
-      client.print(F("function updateThreshold(i,field,value){"));
-      client.print(
-          F("if(field==='minutes'){const s=thresholds[i].seconds%60;"));
-      client.print(F("thresholds[i].seconds=parseInt(value)*60+s;}"));
-      client.print(F("else if(field==='seconds'){const "
-                     "m=Math.floor(thresholds[i].seconds/60);"));
-      client.print(F("thresholds[i].seconds=m*60+parseInt(value);}"));
-      client.print(F("else if(field==='color'){thresholds[i].color=value;}}"));
-      client.print(F("function sendCommand(cmd){"));
-      client.print(
-          F("fetch('/api',{method:'POST',headers:{'Content-Type':'application/"
-            "x-www-form-urlencoded'},"));
-      client.print(F("body:'action='+cmd}).then(r=>r.text()).then(data=>{"));
-      client.print(F("addConsoleMessage('Command: "
-                     "'+cmd,data.includes('Error')?'error':'success');"
-                     "updateButtonState();})"));
-      client.print(F(".catch(()=>addConsoleMessage('Error sending command: "
-                     "'+cmd,'error'))}"));
-      client.print(F("function toggleOrientation(){"));
-      client.print(
-          F("fetch('/api',{method:'POST',headers:{'Content-Type':'application/"
-            "x-www-form-urlencoded'},"));
-      client.print(F("body:'action=flip'}).then(r=>r.text()).then(data=>{"));
-      client.print(F("addConsoleMessage('Display "
-                     "flipped',data.includes('Error')?'error':'success');})"));
-      client.print(F(
-          ".catch(()=>addConsoleMessage('Error flipping display','error'))}"));
-      client.print(F("function applySettings(){"));
-      client.print(F("const "
-                     "durationMin=parseInt(document.getElementById('"
-                     "durationMin').value)||0;"));
-      client.print(F("const "
-                     "durationSec=parseInt(document.getElementById('"
-                     "durationSec').value)||0;"));
-      client.print(F("const duration=durationMin*60+durationSec;"));
-      client.print(F(
-          "const defaultColor=document.getElementById('defaultColor').value;"));
-      client.print(
-          F("const font=document.getElementById('fontSelect').value;"));
-      client.print(
-          F("const spacing=document.getElementById('letterSpacing').value;"));
-      client.print(
-          F("const brightness=document.getElementById('brightness').value;"));
-      client.print(F("const "
-                     "thresholdData=thresholds.map(t=>t.seconds+':'+t.color)."
-                     "join('|');"));
-      client.print(F("let params='action=settings&duration='+duration"
-                     "+'&font='+font+'&spacing='+spacing+'&brightness='+"
-                     "brightness+'&thresholds='+"
-                     "encodeURIComponent(thresholdData)+'&default='+"
-                     "encodeURIComponent(defaultColor);"));
-      client.print(
-          F("fetch('/api/"
-            "settings',{method:'POST',headers:{'Content-Type':'application/"
-            "x-www-form-urlencoded'},"));
-      client.print(F("body:params}).then(r=>r.text()).then(data=>{"
-                     "addConsoleMessage('Settings saved successfully',"
-                     "'success');}).catch(()=>addConsoleMessage('Error "
-                     "saving settings','error'))}"));
-      client.print(F("document.getElementById('letterSpacing')."
-                     "addEventListener('input',function(){"));
-      client.print(F("document.getElementById('spacingValue').textContent=this."
-                     "value;});"));
-      client.print(F("document.getElementById('brightness').addEventListener('"
-                     "input',function(){"));
-      client.print(F("const percent=Math.round((this.value/255)*100);"));
-      client.print(F("document.getElementById('brightnessValue').textContent="
-                     "percent+'%';});"));
-
-      // Network and WebSocket status functions
-      client.print(F("function updateNetworkStatus(){"));
-      client.print(
-          F("fetch('/api/network/status').then(r=>r.json()).then(data=>{"));
-      client.print(
-          F("document.getElementById('ipAddress').textContent=data.ip;"));
-      client.print(F("}).catch(()=>{document.getElementById('ipAddress')."
-                     "textContent='Error';});}"));
-
-      client.print(F("function updateWebSocketStatus(){"));
-      client.print(
-          F("fetch('/api/websocket/status').then(r=>r.json()).then(data=>{"));
-      client.print(F("const wsStatus=document.getElementById('wsStatus');"));
-      client.print(F("if(data.connected){"));
-      client.print(F("wsStatus.innerHTML='<span style=\"color:#4CAF50\">✅ "
-                     "Connected to '+data.url+'</span>';}"));
-      client.print(F("else{wsStatus.innerHTML='<span style=\"color:#888\">⚪ "
-                     "Not connected</span>';}"));
-      client.print(F("}).catch(()=>{});}"));
-
-      client.print(F("function connectWebSocket(){"));
-      client.print(F("const host=document.getElementById('wsHost').value;"));
-      client.print(F("const port=document.getElementById('wsPort').value;"));
-      client.print(F("const path=document.getElementById('wsPath').value;"));
-      client.print(F("if(!host){addConsoleMessage('Please enter a "
-                     "host','error');return;}"));
-      client.print(F("const params=new "
-                     "URLSearchParams({host:host,port:port,path:path});"));
-      client.print(
-          F("fetch('/api/websocket/connect',{method:'POST',body:params})"));
-      client.print(F(".then(r=>r.json()).then(data=>{"));
-      client.print(F("addConsoleMessage(data.message,data.status==='success'?'"
-                     "success':'error');"));
-      client.print(F("setTimeout(updateWebSocketStatus,1000);"));
-      client.print(
-          F("}).catch(()=>addConsoleMessage('Connection failed','error'));}"));
-
-      client.print(F("function disconnectWebSocket(){"));
-      client.print(F("fetch('/api/websocket/disconnect',{method:'POST'})"));
-      client.print(F(".then(r=>r.json()).then(data=>{"));
-      client.print(F("addConsoleMessage(data.message,data.status==='success'?'"
-                     "success':'error');"));
-      client.print(F("setTimeout(updateWebSocketStatus,1000);"));
-      client.print(
-          F("}).catch(()=>addConsoleMessage('Disconnect failed','error'));}"));
-
-      // Sticky button logic
-      client.print(F("function updateStickyButton(){"));
-      client.print(F("const button=document.getElementById('applyButton');"));
-      client.print(F("const container=document.querySelector('.container');"));
-      client.print(
-          F("container.classList.remove('content-with-sticky');")); // Remove
-                                                                    // first to
-                                                                    // get true
-                                                                    // height
-      client.print(
-          F("const scrollDiff=document.body.scrollHeight-window.innerHeight;"));
-      client.print(F("const needsScroll=scrollDiff>100;")); // Only sticky if
-                                                            // >100px overflow
-      client.print(F("if(needsScroll){"));
-      client.print(F("button.classList.add('sticky');"));
-      client.print(F("container.classList.add('content-with-sticky');}"));
-      client.print(F("else{"));
-      client.print(F("button.classList.remove('sticky');"));
-      client.print(F("container.classList.remove('content-with-sticky');}}"));
-      client.print(F("window.addEventListener('resize',updateStickyButton);"));
-
-      client.print(F("loadSettings();"));
-      client.print(F("loadThresholds();"));
-      client.print(F("updateButtonState();"));
-      client.print(F("updateNetworkStatus();"));
-      client.print(F("updateWebSocketStatus();"));
-      client.print(F("updateStickyButton();"));
-      client.print(F("setInterval(updateButtonState, 1000);"));
-      client.print(F("setInterval(updateNetworkStatus, 5000);"));
-      client.print(F("setInterval(updateWebSocketStatus, 5000);"));
-      client.print(F("setInterval(updateStickyButton, 500);"));
-      // Overwrite updateWebSocketStatus with logging version
-      client.print(F("let lastWsState=false;"));
-      client.print(F("updateWebSocketStatus=function(){"));
-      client.print(
-          F("fetch('/api/websocket/status').then(r=>r.json()).then(data=>{"));
-      client.print(F("const wsStatus=document.getElementById('wsStatus');"));
-      client.print(F("if(data.connected){"));
-      client.print(F("wsStatus.innerHTML='<span style=\"color:#4CAF50\">✅ "
-                     "Connected to '+data.url+'</span>';"));
-      client.print(F("if(!lastWsState){addConsoleMessage('WebSocket Connected "
-                     "to '+data.url, 'success');}"));
-      client.print(F("lastWsState=true;"));
-      client.print(F("}else{"));
-      client.print(F("wsStatus.innerHTML='<span style=\"color:#888\">⚪ "
-                     "Not connected</span>';"));
-      client.print(F("if(lastWsState){addConsoleMessage('WebSocket "
-                     "Disconnected', 'warning');}"));
-      client.print(F("lastWsState=false;"));
-      client.print(F("}"));
-      client.print(F("}).catch(()=>{});};"));
-
-      client.print(F("</script></body></html>"));
-
-      client.stop();
-      DEBUG_PRINTLN("Web page served");
-    } else if (requestPath.startsWith("/api")) {
-      DEBUG_PRINT("API Request: ");
-      DEBUG_PRINT(requestType);
-      DEBUG_PRINT(" ");
-      DEBUG_PRINTLN(requestPath);
-
-      if (requestType == "POST") {
-        if (requestPath == "/api") {
-          // Timer Control
-          String action = "";
-          int equalIndex = postData.indexOf('=');
-          if (equalIndex > 0 && postData.substring(0, equalIndex) == "action") {
-            action = postData.substring(equalIndex + 1);
-          }
-
-          DEBUG_PRINT("Timer Action: ");
-          DEBUG_PRINTLN(action);
-
-          String response = "{";
-          if (action == "start") {
-            timerDisplay.getTimer().start();
-            response += "\"status\":\"success\",\"message\":\"Timer started\"";
-          } else if (action == "pause") {
-            timerDisplay.getTimer().stop();
-            response += "\"status\":\"success\",\"message\":\"Timer paused\"";
-          } else if (action == "reset") {
-            timerDisplay.getTimer().reset();
-            response += "\"status\":\"success\",\"message\":\"Timer reset\"";
-          } else if (action == "flip") {
-            current_orientation = (current_orientation == 0) ? 180 : 0;
-            // RGBMatrix::setOrientation(current_orientation);
-            response +=
-                "\"status\":\"success\",\"message\":\"Orientation flipped\"";
-          } else {
-            response +=
-                "\"status\":\"error\",\"message\":\"Unknown action: " + action +
-                "\"";
-          }
-          response += "}";
-          sendHTTPResponse(client, 200, "application/json", response);
-
-        } else if (requestPath == "/api/settings") {
-          // Parse all settings from consolidated POST
-          int duration = 180;
-          int fontId = 0;
-          int spacing = 3;
-          int brightness = 255;
-          String thresholdsData = "";
-          String defaultColorData = "";
-
-          // Robust key-value parsing
-          int pos = 0;
-          while (pos < postData.length()) {
-            int amp = postData.indexOf('&', pos);
-            if (amp == -1)
-              amp = postData.length();
-            String pair = postData.substring(pos, amp);
-            int eq = pair.indexOf('=');
-            if (eq > 0) {
-              String key = pair.substring(0, eq);
-              String val = urlDecode(pair.substring(eq + 1));
-              if (key == "duration")
-                duration = val.toInt();
-              else if (key == "font")
-                fontId = val.toInt();
-              else if (key == "spacing")
-                spacing = val.toInt();
-              else if (key == "brightness")
-                brightness = val.toInt();
-              else if (key == "thresholds")
-                thresholdsData = val;
-              else if (key == "default")
-                defaultColorData = val;
-            }
-            pos = amp + 1;
-          }
-
-          // Apply Timer Duration
-          Timer::Components comp;
-          comp.minutes = duration / 60;
-          comp.seconds = duration % 60;
-          comp.milliseconds = 0;
-          timerDisplay.getTimer().setDuration(comp);
-          timerDisplay.getTimer().reset();
-
-          // Apply Display Settings
-          timerDisplay.setFont(getFontById(fontId), fontId); // Fix: Pass fontId
-          timerDisplay.setTextSize(getTextSizeForFont(fontId));
-          timerDisplay.setLetterSpacing(spacing);
-          timerDisplay.setBrightness(brightness);
-
-          // Apply Color Thresholds
-          if (thresholdsData.length() > 0) {
-            timerDisplay.clearColorThresholds();
-            int start = 0;
-            while (start < thresholdsData.length()) {
-              int end = thresholdsData.indexOf('|', start);
-              if (end == -1)
-                end = thresholdsData.length();
-
-              String token = thresholdsData.substring(start, end);
-              int colon = token.indexOf(':');
-              if (colon > 0) {
-                int seconds = token.substring(0, colon).toInt();
-                String color = token.substring(colon + 1);
-                uint8_t r, g, b;
-                parseColor(color, r, g, b);
-                timerDisplay.addColorThreshold(seconds, r, g, b);
-              }
-              start = end + 1;
-            }
-          }
-
-          // Apply Default Color
-          if (defaultColorData.length() > 0) {
-            uint8_t r, g, b;
-            parseColor(defaultColorData, r, g, b);
-            timerDisplay.setDefaultColor(r, g, b);
-            // Also set current color to default if timer is idle
-            if (timerDisplay.getTimer().isIdle()) {
-              timerDisplay.setColor(r, g, b);
-            }
-          }
-
-          // Persist all changes
-          if (saveSettings(timerDisplay)) {
-            sendHTTPResponse(client, 200, "text/plain", "Settings saved");
-          } else {
-            sendHTTPResponse(client, 500, "text/plain",
-                             "Error saving settings");
-          }
-        } else if (requestPath == "/api/websocket/connect") {
-          // WebSocket Connect
-          String host = "";
-          int port = 8765;
-          String path = "/socket.io/";
-
-          // Simple parser for urlencoded body
-          int pos = 0;
-          while (pos < postData.length()) {
-            int amp = postData.indexOf('&', pos);
-            if (amp == -1)
-              amp = postData.length();
-            String pair = postData.substring(pos, amp);
-            int eq = pair.indexOf('=');
-            if (eq > 0) {
-              String key = pair.substring(0, eq);
-              String val = urlDecode(pair.substring(eq + 1));
-              if (key == "host")
-                host = val;
-              else if (key == "port")
-                port = val.toInt();
-              else if (key == "path")
-                path = val;
-            }
-            pos = amp + 1;
-          }
-
-          if (wsClient && host.length() > 0) {
-            wsClient->connect(host.c_str(), port, path.c_str());
-            sendHTTPResponse(
-                client, 200, "application/json",
-                "{\"status\":\"success\",\"message\":\"Connecting...\"}");
-          } else {
-            sendHTTPResponse(
-                client, 400, "application/json",
-                "{\"status\":\"error\",\"message\":\"Missing host\"}");
-          }
-        } else if (requestPath == "/api/websocket/disconnect") {
-          if (wsClient) {
-            wsClient->disconnect();
-            sendHTTPResponse(
-                client, 200, "application/json",
-                "{\"status\":\"success\",\"message\":\"Disconnected\"}");
-          } else {
-            sendHTTPResponse(
-                client, 500, "application/json",
-                "{\"status\":\"error\",\"message\":\"No Client\"}");
-          }
-        } else {
-          sendHTTPResponse(client, 404, "text/plain", "Not Found");
-        }
-      } else {
-        // GET Requests
-        if (requestPath == "/api/status") {
-          String json = "{";
-          json += "\"isPaused\":" +
-                  String(timerDisplay.getTimer().isPaused() ? "true" : "false");
-          json += "}";
-          sendHTTPResponse(client, 200, "application/json", json);
-        } else if (requestPath == "/api/thresholds") {
-          JsonDocument doc;
-          JsonArray thresholds = doc["thresholds"].to<JsonArray>();
-          size_t count = 0;
-          const TimerDisplay::ColorThreshold *data =
-              timerDisplay.getColorThresholds(count);
-          for (size_t i = 0; i < count; i++) {
-            JsonObject t = thresholds.add<JsonObject>();
-            t["seconds"] = data[i].seconds;
-            char colorHex[8];
-            snprintf(colorHex, sizeof(colorHex), "#%02X%02X%02X", data[i].r,
-                     data[i].g, data[i].b);
-            t["color"] = colorHex;
-          }
-
-          uint8_t dr, dg, db;
-          timerDisplay.getDefaultColor(dr, dg, db);
-          char defaultHex[8];
-          snprintf(defaultHex, sizeof(defaultHex), "#%02X%02X%02X", dr, dg, db);
-          doc["defaultColor"] = defaultHex;
-
-          String response;
-          serializeJson(doc, response);
-          sendHTTPResponse(client, 200, "application/json", response);
-        } else if (requestPath == "/api/settings") {
-          JsonDocument doc;
-          doc["fontId"] = timerDisplay.getFontId();
-          doc["spacing"] = timerDisplay.getLetterSpacing();
-          doc["brightness"] = timerDisplay.getBrightness();
-          doc["duration"] = timerDisplay.getTimer().getDurationSeconds();
-
-          String response;
-          serializeJson(doc, response);
-          sendHTTPResponse(client, 200, "application/json", response);
-        } else if (requestPath == "/api/network/status") {
-          String json = "{\"ip\":\"" + getIPAddressString() + "\"}";
-          sendHTTPResponse(client, 200, "application/json", json);
-        } else if (requestPath == "/api/websocket/status") {
-          String json = "{";
-          if (wsClient) {
-            bool connected = wsClient->isConnected();
-            Serial.print("API Status: ");
-            Serial.println(connected ? "Connected" : "Not Connected");
-            json +=
-                "\"connected\":" + String(connected ? "true" : "false") + ",";
-            json += "\"url\":\"" + String(wsClient->getServerUrl()) + "\"";
-          } else {
-            json += "\"connected\":false";
-          }
-          json += "}";
-          sendHTTPResponse(client, 200, "application/json", json);
-        } else {
-          sendHTTPResponse(client, 404, "text/plain", "Not Found");
-        }
-      }
-      client.stop();
-      DEBUG_PRINTLN("API request handled");
+// GET /api/capture - Download the captured WebSocket traffic
+void handleCaptureGet(RequestContext &ctx) {
+  ctx.out.begin(200, "application/octet-stream");
+  Capture::download(ctx.out);
+  ctx.out.end();
+}
+
+// POST /api/capture - action=start|stop|clear
+void handleCapturePost(RequestContext &ctx) {
+  char action[8] = "";
+  ctx.request.formField("action", action, sizeof(action));
+
+  if (strcmp(action, "start") == 0) {
+    Capture::setEnabled(true);
+  } else if (strcmp(action, "stop") == 0) {
+    Capture::setEnabled(false);
+  } else if (strcmp(action, "clear") == 0) {
+    Capture::clear();
+  } else {
+    sendHTTPResponse(ctx.out, 400, "application/json",
+                     "{\"status\":\"error\",\"message\":\"Unknown action\"}");
+    return;
+  }
+  sendHTTPResponse(ctx.out, 200, "application/json",
+                   Capture::isEnabled()
+                       ? "{\"status\":\"success\",\"capturing\":true}"
+                       : "{\"status\":\"success\",\"capturing\":false}");
+}
+
+// POST /api/capture/replay - mode=fast|realtime|stop
+void handleCaptureReplay(RequestContext &ctx) {
+  char mode[10] = "fast";
+  ctx.request.formField("mode", mode, sizeof(mode));
+
+  if (strcmp(mode, "stop") == 0) {
+    Capture::stopReplay();
+  } else if (!Capture::startReplay(replayToClient,
+                                   strcmp(mode, "realtime") == 0)) {
+    sendHTTPResponse(ctx.out, 409, "application/json",
+                     "{\"status\":\"error\",\"message\":\"Stop capturing "
+                     "first, or nothing captured\"}");
+    return;
+  }
+  sendHTTPResponse(ctx.out, 200, "application/json",
+                   "{\"status\":\"success\"}");
+}
+
+// GET /api/capture/status - Capture and replay statistics, and the timer
+// state a replay left behind
+void handleCaptureStatus(RequestContext &ctx) {
+  JsonDocument doc;
+  const Capture::Stats &stats = Capture::getStats();
+  doc["capturing"] = Capture::isEnabled();
+  doc["bytes"] = Capture::storedBytes();
+  doc["frames"] = stats.frames;
+  doc["truncated"] = stats.truncated;
+  doc["dropped"] = stats.dropped;
+  doc["flushes"] = stats.flushes;
+  doc["failedWrites"] = stats.failedWrites;
+  doc["maxFlushUs"] = stats.maxFlushUs;
+
+  const Capture::ReplayStats &replay = Capture::getReplayStats();
+  JsonObject r = doc["replay"].to<JsonObject>();
+  r["active"] = replay.active;
+  r["realtime"] = replay.realtime;
+  r["frames"] = replay.frames;
+  r["avgUs"] = replay.frames ? replay.totalUs / replay.frames : 0;
+  r["maxUs"] = replay.maxUs;
+  r["durationMs"] = replay.durationMs;
+
+  Timer &timer = ctx.timerDisplay.getTimer();
+  Timer::Components remaining = timer.getRemainingTime();
+  JsonObject t = doc["timer"].to<JsonObject>();
+  t["running"] = timer.isRunning();
+  t["remainingMs"] = (remaining.minutes * 60 + remaining.seconds) * 1000UL +
+                     remaining.milliseconds;
+
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// GET /api/display/status - Frame conversion statistics
+void handleDisplayStatus(RequestContext &ctx) {
+  const Adafruit_Protomatter::ConvertStats &stats =
+      ctx.timerDisplay.getMatrix().getConvertStats();
+  JsonDocument doc;
+  doc["frames"] = stats.frames;
+  doc["rowPairs"] = stats.rowPairs;
+  doc["skipped"] = stats.skipped;
+  doc["lastUs"] = stats.lastUs;
+  doc["maxUs"] = stats.maxUs;
+  doc["fullUs"] = stats.fullUs;
+
+  const TimerDisplay::DrawStats &draw = ctx.timerDisplay.getDrawStats();
+  JsonObject timer = doc["draw"].to<JsonObject>();
+  timer["frames"] = draw.frames;
+  timer["maskFrames"] = draw.maskFrames;
+  timer["lastUs"] = draw.lastUs;
+  timer["maxUs"] = draw.maxUs;
+
+  const RefreshControl &control = ctx.timerDisplay.getRefresh();
+  const RefreshControl::Stats &refresh = control.getStats();
+  JsonObject matrix = doc["refresh"].to<JsonObject>();
+  matrix["hz"] = refresh.refreshHz;
+  matrix["bitDepth"] = refresh.bitDepth;
+  matrix["auto"] = control.getBitDepth() == RefreshControl::AUTO;
+  matrix["targetHz"] = control.getTargetHz();
+  matrix["settled"] = refresh.settled;
+  matrix["changes"] = refresh.changes;
+  matrix["failures"] = refresh.failures;
+  matrix["broadcast"] = control.isBroadcast();
+  matrix["broadcastHz"] = control.getBroadcastHz();
+  matrix["isrLoad"] = refresh.isrLoad / 10.0f; // Percent
+
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// GET /api/storage - Settings persistence statistics
+void handleStorage(RequestContext &ctx) {
+  const SettingsPersistence &store = ConfigStore::getPersistence();
+  const SettingsPersistence::Stats &stats = store.getStats();
+  char json[256];
+  snprintf(json, sizeof(json),
+           "{\"pending\":%s,\"quietPeriodMs\":%lu,\"maxDeferMs\":%lu,"
+           "\"writes\":%lu,\"failures\":%lu,\"coalesced\":%lu,"
+           "\"skipped\":%lu,\"forced\":%lu,"
+           "\"lastWriteUs\":%lu,\"maxWriteUs\":%lu,\"totalWriteUs\":%lu}",
+           store.isDirty() ? "true" : "false", store.getQuietPeriod(),
+           store.getMaxDefer(), (unsigned long)stats.writes,
+           (unsigned long)stats.failures, (unsigned long)stats.coalesced,
+           (unsigned long)stats.skipped, (unsigned long)stats.forced,
+           (unsigned long)stats.lastWriteUs, (unsigned long)stats.maxWriteUs,
+           (unsigned long)stats.totalWriteUs);
+  sendHTTPResponse(ctx.out, 200, "application/json", json);
+}
+
+// GET /api/thresholds
+void handleThresholds(RequestContext &ctx) {
+  JsonDocument doc;
+  JsonArray thresholds = doc["thresholds"].to<JsonArray>();
+  size_t count = 0;
+  const TimerDisplay::ColorThreshold *data =
+      ctx.timerDisplay.getColorThresholds(count);
+  for (size_t i = 0; i < count; i++) {
+    JsonObject t = thresholds.add<JsonObject>();
+    t["seconds"] = data[i].seconds;
+    char colorHex[8];
+    snprintf(colorHex, sizeof(colorHex), "#%02X%02X%02X", data[i].r,
+             data[i].g, data[i].b);
+    t["color"] = colorHex;
+  }
+
+  uint8_t dr, dg, db;
+  ctx.timerDisplay.getDefaultColor(dr, dg, db);
+  char defaultHex[8];
+  snprintf(defaultHex, sizeof(defaultHex), "#%02X%02X%02X", dr, dg, db);
+  doc["defaultColor"] = defaultHex;
+
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// GET /api/thresholds/{index} - Single color threshold
+void handleThresholdByIndex(RequestContext &ctx) {
+  char value[8];
+  size_t count = 0;
+  const TimerDisplay::ColorThreshold *data =
+      ctx.timerDisplay.getColorThresholds(count);
+
+  char *end = nullptr;
+  unsigned long index = 0;
+  if (ctx.params.get(0, value, sizeof(value))) {
+    index = strtoul(value, &end, 10);
+  }
+  if (end == nullptr || *end != '\0' || index >= count) {
+    sendHTTPResponse(
+        ctx.out, 404, "application/json",
+        "{\"status\":\"error\",\"message\":\"No such threshold\"}");
+    return;
+  }
+
+  char json[64];
+  snprintf(json, sizeof(json),
+           "{\"index\":%lu,\"seconds\":%u,\"color\":\"#%02X%02X%02X\"}", index,
+           data[index].seconds, data[index].r, data[index].g, data[index].b);
+  sendHTTPResponse(ctx.out, 200, "application/json", json);
+}
+
+// GET /api/settings
+void handleSettingsGet(RequestContext &ctx) {
+  JsonDocument doc;
+  doc["fontId"] = ctx.timerDisplay.getFontId();
+  doc["spacing"] = ctx.timerDisplay.getLetterSpacing();
+  doc["brightness"] = ctx.timerDisplay.getBrightness();
+  const RefreshControl &refresh = ctx.timerDisplay.getRefresh();
+  if (refresh.getBitDepth() == RefreshControl::AUTO) {
+    doc["bitDepth"] = "auto";
+  } else {
+    doc["bitDepth"] = refresh.getBitDepth();
+  }
+  doc["refreshHz"] = refresh.getTargetHz();
+  doc["broadcast"] = refresh.isBroadcast();
+  doc["broadcastHz"] = refresh.getBroadcastHz();
+  doc["orientation"] = ctx.timerDisplay.getRotation() * 90;
+  doc["duration"] = ctx.timerDisplay.getTimer().getDurationSeconds();
+
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// Most log records returned by one /api/logs request
+const uint32_t LOGS_PER_RESPONSE = 32;
+
+// Print a string as a quoted JSON string
+void printJsonString(Print &out, const char *text) {
+  out.print('"');
+  for (const char *p = text; *p != '\0'; p++) {
+    char c = *p;
+    if (c == '"' || c == '\\') {
+      out.print('\\');
+      out.print(c);
+    } else if ((uint8_t)c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)c);
+      out.print(escaped);
     } else {
-      sendHTTPResponse(client, 404, "text/plain", "Not Found");
-      client.stop();
+      out.print(c);
+    }
+  }
+  out.print('"');
+}
+
+// GET /api/logs?since=N - Log records with sequence number >= N, oldest
+// first; pass the returned "next" as since to continue
+void handleLogs(RequestContext &ctx) {
+  char value[12];
+  uint32_t since = 0;
+  if (ctx.request.queryParam("since", value, sizeof(value))) {
+    since = strtoul(value, nullptr, 10);
+  }
+  uint32_t first = max(since, Log::oldestSeq());
+  uint32_t end = min(Log::nextSeq(), first + LOGS_PER_RESPONSE);
+
+  HttpResponseWriter &out = ctx.out;
+  out.begin(200, "application/json");
+  out.print(F("{\"logs\":["));
+
+  char line[Log::LINE_SIZE];
+  Log::Record record;
+  bool comma = false;
+  for (uint32_t seq = first; seq < end; seq++) {
+    if (!Log::get(seq, record)) {
+      continue;
     }
+    snprintf(line, sizeof(line),
+             "%s{\"seq\":%lu,\"t\":%lu,\"level\":\"%s\",\"tag\":\"%s\","
+             "\"msg\":",
+             comma ? "," : "", (unsigned long)record.seq,
+             (unsigned long)record.timeMs, Log::levelName(record.level),
+             Log::tagName(record.tag));
+    out.print(line);
+    Log::formatMessage(record, line, sizeof(line));
+    printJsonString(out, line);
+    out.print('}');
+    comma = true;
+  }
+
+  // "missed" counts records overwritten before this poll could read them
+  snprintf(line, sizeof(line),
+           "],\"next\":%lu,\"missed\":%lu,\"unprinted\":%lu}",
+           (unsigned long)end,
+           (unsigned long)(since != 0 && first > since ? first - since : 0),
+           (unsigned long)Log::getDropped());
+  out.print(line);
+  out.end();
+}
+
+// GET /api/network/status
+void handleNetworkStatus(RequestContext &ctx) {
+  JsonDocument doc;
+  doc["ip"] = getIPAddressString();
+  doc["mode"] = Network::getStateString();
+  doc["upMs"] = Network::getUpTimeMs();
+
+  const Network::Stats &stats = Network::getStats();
+  JsonObject link = doc["link"].to<JsonObject>();
+  link["up"] = Network::getState() != Network::State::LINK_DOWN;
+  link["flaps"] = stats.linkFlaps;
+  link["downMs"] = stats.linkDownMs;
+  link["lastChangeMs"] = stats.lastLinkChange;
+
+  JsonObject dhcp = doc["dhcp"].to<JsonObject>();
+  dhcp["leases"] = stats.dhcpLeases;
+  dhcp["renewals"] = stats.dhcpRenewals;
+  dhcp["failures"] = stats.dhcpFailures;
+  dhcp["failovers"] = stats.staticFailovers;
+
+  JsonObject http = doc["http"].to<JsonObject>();
+  http["open"] = connections.getOpenCount();
+  http["connections"] = connections.getConnectionsOpened();
+  http["requests"] = connections.getRequestsServed();
+  http["reused"] = connections.getRequestsReused();
+
+  // Time spent in each kind of network call
+  JsonObject calls = doc["calls"].to<JsonObject>();
+  for (uint8_t i = 0; i < Network::CALL_COUNT; i++) {
+    Network::Call call = static_cast<Network::Call>(i);
+    const Network::CallStats &c = Network::getCallStats(call);
+    JsonObject entry = calls[Network::getCallName(call)].to<JsonObject>();
+    entry["count"] = c.count;
+    entry["totalUs"] = c.totalUs;
+    entry["maxUs"] = c.maxUs;
   }
+
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// GET /api/websocket/status
+void handleWebSocketStatus(RequestContext &ctx) {
+  JsonDocument doc;
+  if (wsClient == nullptr) {
+    doc["connected"] = false;
+  } else {
+    bool connected = wsClient->isConnected();
+    doc["connected"] = connected;
+    doc["url"] = wsClient->getServerUrl();
+
+    const WebSocketClient::ParserStats &stats = wsClient->getParserStats();
+    JsonObject parser = doc["parser"].to<JsonObject>();
+    parser["messages"] = stats.messages;
+    parser["errors"] = stats.parseErrors;
+    parser["avgUs"] = stats.messages ? stats.totalUs / stats.messages : 0;
+    parser["maxUs"] = stats.maxUs;
+    parser["reassembled"] = stats.reassembled;
+    parser["oversized"] = stats.oversized;
+    parser["fragmentsDropped"] = stats.dropped;
+    parser["poolPeak"] = (unsigned)wsClient->getJsonPoolPeak();
+
+    if (connected) {
+      doc["lastMessageAgeMs"] = wsClient->getLastMessageAgeMs();
+    }
+
+    const WebSocketClient::HeartbeatStats &beat =
+        wsClient->getHeartbeatStats();
+    JsonObject heartbeat = doc["heartbeat"].to<JsonObject>();
+    heartbeat["pingIntervalMs"] = beat.pingIntervalMs;
+    heartbeat["pingTimeoutMs"] = beat.pingTimeoutMs;
+    heartbeat["rttMs"] = beat.lastRttMs;
+    heartbeat["maxRttMs"] = beat.maxRttMs;
+    heartbeat["timeouts"] = beat.timeouts;
+
+    WebSocketClient::AckStats ackStats = wsClient->getAckStats();
+    JsonObject acks = doc["acks"].to<JsonObject>();
+    acks["commands"] = ackStats.commands;
+    acks["sendFailures"] = ackStats.sendFailures;
+    acks["lastSeq"] = ackStats.lastSeq;
+    acks["lastUs"] = ackStats.lastUs;
+    acks["avgUs"] = ackStats.avgUs;
+    acks["maxUs"] = ackStats.maxUs;
+
+    doc["failovers"] = wsClient->getFailovers();
+    JsonArray upstreams = doc["upstreams"].to<JsonArray>();
+    for (uint8_t i = 0; i < wsClient->getUpstreamCount(); i++) {
+      const WebSocketClient::Upstream &u = wsClient->getUpstream(i);
+      JsonObject entry = upstreams.add<JsonObject>();
+      entry["host"] = u.host; // Configured text, escaped by the serializer
+      entry["port"] = u.port;
+      entry["active"] = i == wsClient->getActiveUpstream();
+      entry["score"] = u.score();
+      entry["connects"] = u.connects;
+      entry["failures"] = u.failures;
+      entry["heartbeatMisses"] = u.heartbeatMisses;
+      entry["rttMs"] = u.srttMs;
+    }
+  }
+
+  String response;
+  serializeJson(doc, response);
+  sendHTTPResponse(ctx.out, 200, "application/json", response);
+}
+
+// Route table: exact paths sorted by path then method, patterns last
+constexpr Route<RouteHandler> routes[] = {
+    {HTTP_GET, "/", handleRoot},
+    {HTTP_POST, "/api", handleTimerAction},
+    {HTTP_GET, "/api/capture", handleCaptureGet},
+    {HTTP_POST, "/api/capture", handleCapturePost},
+    {HTTP_POST, "/api/capture/replay", handleCaptureReplay},
+    {HTTP_GET, "/api/capture/status", handleCaptureStatus},
+    {HTTP_GET, "/api/config", handleConfigGet},
+    {HTTP_POST, "/api/config", handleConfigPost},
+    {HTTP_GET, "/api/display/status", handleDisplayStatus},
+    {HTTP_GET, "/api/logs", handleLogs},
+    {HTTP_GET, "/api/network/status", handleNetworkStatus},
+    {HTTP_GET, "/api/settings", handleSettingsGet},
+    {HTTP_POST, "/api/settings", handleSettingsPost},
+    {HTTP_PATCH, "/api/settings", handleSettingsPost},
+    {HTTP_GET, "/api/status", handleStatus},
+    {HTTP_GET, "/api/storage", handleStorage},
+    {HTTP_GET, "/api/thresholds", handleThresholds},
+    {HTTP_POST, "/api/websocket/connect", handleWebSocketConnect},
+    {HTTP_POST, "/api/websocket/disconnect", handleWebSocketDisconnect},
+    {HTTP_GET, "/api/websocket/status", handleWebSocketStatus},
+    {HTTP_GET, "/api/thresholds/{index}", handleThresholdByIndex},
+};
+
+constexpr RouteTable<RouteHandler, sizeof(routes) / sizeof(routes[0])>
+    routeTable(routes);
+static_assert(routeTable.isValid(),
+              "Route table must list exact paths sorted, then patterns");
+
+// Answer one request through the route table
+void dispatchRequest(const HttpRequest &request, HttpResponseWriter &out,
+                     TimerDisplay &timerDisplay) {
+  HttpMethod method = httpMethodFromString(request.method);
+  RouteMatch<RouteHandler> match = routeTable.match(method, request.path);
+  LOG_DEBUG(Log::TAG_HTTP, "Request %s (method %u)", request.path, method);
+
+  if (match.result == RouteMatch<RouteHandler>::FOUND) {
+    RequestContext ctx{request, out, timerDisplay, match.params};
+    match.handler(ctx);
+  } else if (match.result == RouteMatch<RouteHandler>::METHOD_NOT_ALLOWED) {
+    char allow[48];
+    formatAllowHeader(match.allowed, allow, sizeof(allow));
+    out.begin(405, "text/plain");
+    out.setExtraHeader(allow);
+    out.print("Method Not Allowed");
+    out.end();
+  } else {
+    sendHTTPResponse(out, 404, "text/plain", "Not Found");
+  }
+}
+
+void handleClient(TimerDisplay &timerDisplay) {
+  // Update mDNS responder to keep hostname resolution alive
+  updateMDNS();
+
+  if (server == nullptr)
+    return;
+
+  // available() returns any socket with unread data, including ones that
+  // are already being kept alive
+  EthernetClient client = server->available();
+  if (client) {
+    connections.accept(client);
+  }
+
+  connections.serviceAll(
+      txBuffer, sizeof(txBuffer),
+      [&timerDisplay](const HttpRequest &request, HttpResponseWriter &out) {
+        dispatchRequest(request, out, timerDisplay);
+      });
 }
 
 } // namespace WebServer
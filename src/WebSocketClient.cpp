@@ -1,25 +1,56 @@
 #include "WebSocketClient.h"
-
-// Debug flag - ENABLED temporarily for debugging
-#define DEBUG_WEBSOCKET true
-
-// Debug printing macros
-#if DEBUG_WEBSOCKET
-#define DEBUG_PRINT(x) Serial.print(x)
-#define DEBUG_PRINTLN(x) Serial.println(x)
-#else
-#define DEBUG_PRINT(x)
-#define DEBUG_PRINTLN(x)
-#endif
+#include "Capture.h"
+#include "ConfigStore.h"
+#include "Log.h"
+#include "SocketIOPacket.h"
+
+// Engine.IO v4 defaults, used until the open packet says otherwise (and for
+// plain WebSocket servers)
+const uint32_t DEFAULT_PING_INTERVAL_MS = 25000;
+const uint32_t DEFAULT_PING_TIMEOUT_MS = 20000;
+
+// Reconnect timing
+const unsigned long DNS_TIMEOUT_MS = 3000;       // Query retried each second
+const uint32_t DNS_CACHE_MAX_S = 300;            // Longest a name is cached
+const unsigned long PROBE_TIMEOUT_MS = 3000;     // SYN unanswered: host down
+const unsigned long HANDSHAKE_TIMEOUT_MS = 5000; // WebSocket upgrade
+const unsigned long MAX_BACKOFF_MS = 60000;
+
+// Upstream health (reliability points, 0-100)
+const int RELIABILITY_CONNECT = 20;    // Connection established
+const int RELIABILITY_PROBE = 10;      // Failback probe answered
+const int RELIABILITY_FAILURE = -30;   // Failed attempt or dropped link
+const int RELIABILITY_HEARTBEAT = -40; // Watchdog declared the link dead
+const uint32_t RTT_PENALTY_MAX = 20;   // Points lost at 200 ms RTT or more
+const unsigned long FAILBACK_INTERVAL_MS = 60000;
+
+uint8_t WebSocketClient::Upstream::score() const {
+  uint32_t penalty = min(srttMs / 10, RTT_PENALTY_MAX);
+  return reliability > penalty ? reliability - penalty : 0;
+}
 
 // Static instance pointer for callback
 WebSocketClient *WebSocketClient::_instance = nullptr;
 
 WebSocketClient::WebSocketClient(Timer *timer)
-    : _timer(timer), _connected(false), _connectionAttempted(false),
-      _manuallyDisconnected(false), _lastReconnectAttempt(0),
-      _reconnectInterval(10000), _autoReconnect(true), _serverPort(8765),
-      _connectInProgress(false), _consecutiveFailures(0) {
+    : _timer(timer), _serverPort(8765), _connected(false),
+      _connectionAttempted(false), _manuallyDisconnected(false),
+      _lastReconnectAttempt(0), _reconnectInterval(2000), _reconnectDelay(0),
+      _consecutiveFailures(0), _autoReconnect(true), _phase(Phase::IDLE),
+      _phaseStartMs(0), _upstreamCount(1), _active(0), _roundFailures(0),
+      _failovers(0), _failbackProbing(false), _lastFailbackProbe(0),
+      _heartbeat(), _parserStats(), _replaying(false),
+      _fragments(Fragments::NONE), _fragmentLength(0), _frameStartUs(0),
+      _commandCount(0), _ackFailures(0), _lastSeq(0), _latencyUs(),
+      _latencyIndex(0) {
+
+#ifdef ARDUINO_ARCH_RP2040
+  // Spread out the reconnect jitter of timers that boot together
+  randomSeed(rp2040.hwrand32());
+#endif
+
+  buildFilter();
+  resetHeartbeat();
 
   // Load saved settings
   loadSettings();
@@ -44,41 +75,20 @@ bool WebSocketClient::connect(const char *host, uint16_t port,
 
   _connectionAttempted = true; // Mark that user has attempted connection
   _manuallyDisconnected =
-      false;                  // Clear manual disconnect flag when reconnecting
-  _connectInProgress = false; // Reset connection progress flag
-  _consecutiveFailures = 0;   // Reset failure counter for new connection
-  _serverHost = String(host);
-  _serverPort = port;
-  _serverPath = String(path);
-
-  // Build URL for display
-  _fullUrl = "ws://" + _serverHost + ":" + String(_serverPort) + _serverPath;
+      false;                // Clear manual disconnect flag when reconnecting
+  _consecutiveFailures = 0; // Reset failure counter for new connection
+  loadUpstreams(host, port, path);
 
-  DEBUG_PRINT("Connecting to server: ");
-  DEBUG_PRINTLN(_fullUrl);
+  LOG_INFO(Log::TAG_WEBSOCKET, "Connecting to %s:%u", _serverHost.c_str(),
+           _serverPort);
 
-  // Check for Socket.IO request
-  bool isSocketIO = (_serverPath.indexOf("/socket.io") >= 0);
-
-  if (isSocketIO) {
-    DEBUG_PRINTLN(
-        "Detected Socket.IO path - trying direct WebSocket connection");
-    DEBUG_PRINTLN("Socket.IO will be handled at message level");
-    String socketIOPath = _serverPath + "?EIO=4&transport=websocket";
-    DEBUG_PRINT("Using path: ");
-    DEBUG_PRINTLN(socketIOPath);
-    _client.begin(_serverHost.c_str(), _serverPort, socketIOPath.c_str());
-  } else {
-    DEBUG_PRINTLN("Using standard WebSocket connection");
-    _client.begin(_serverHost.c_str(), _serverPort, _serverPath.c_str());
-  }
-
-  // CRITICAL: Set library's internal reconnect interval to 60 seconds
-  // This prevents the library's loop() from retrying too fast when writes fail
-  _client.setReconnectInterval(60000);
-
-  // Connection result will come via callback
-  Serial.println("Connection initiated with 60s retry interval...");
+  // The attempt is started from poll(), which also runs it to completion
+  _dns.stop();
+  _probe.stop();
+  _failbackProbing = false;
+  _phase = Phase::IDLE;
+  _lastReconnectAttempt = millis();
+  _reconnectDelay = 0;
 
   // Save settings on successful initiation (user intent)
   saveSettings();
@@ -87,85 +97,142 @@ bool WebSocketClient::connect(const char *host, uint16_t port,
 }
 
 void WebSocketClient::loadSettings() {
-  EEPROM.begin(512);            // Initialize EEPROM
-  if (EEPROM.read(0) == 0x42) { // Magic byte
-    // Host
-    int len = EEPROM.read(1);
-    char buf[128];
-    for (int i = 0; i < len && i < 127; i++) {
-      buf[i] = EEPROM.read(2 + i);
-    }
-    buf[len] = 0;
-    _serverHost = String(buf);
-
-    // Port
-    uint8_t low = EEPROM.read(120);
-    uint8_t high = EEPROM.read(121);
-    _serverPort = (high << 8) | low;
-
-    // Path
-    len = EEPROM.read(122);
-    for (int i = 0; i < len && i < 127; i++) {
-      buf[i] = EEPROM.read(123 + i);
-    }
-    buf[len] = 0;
-    _serverPath = String(buf);
-
-    Serial.println("Loaded saved WebSocket settings:");
-    Serial.print("Host: ");
-    Serial.println(_serverHost);
-    Serial.print("Port: ");
-    Serial.println(_serverPort);
-    Serial.print("Path: ");
-    Serial.println(_serverPath);
+  // The config record is loaded (and legacy EEPROM data migrated) at boot
+  const ConfigStore::Config &config = ConfigStore::get();
+  if (config.sections & ConfigStore::SECTION_WEBSOCKET) {
+    loadUpstreams(config.wsHost, config.wsPort, config.wsPath);
 
-    // Update full URL
-    _fullUrl = "ws://" + _serverHost + ":" + String(_serverPort) + _serverPath;
+    LOG_INFO(Log::TAG_WEBSOCKET, "Saved server %s:%u", _serverHost.c_str(),
+             _serverPort);
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Saved path %s (%u spares)",
+              _serverPath.c_str(), _upstreamCount - 1);
 
     // Auto-connect on boot
     _connectionAttempted = true;
   } else {
-    Serial.println("No saved settings found in EEPROM");
+    LOG_INFO(Log::TAG_WEBSOCKET, "No saved WebSocket settings");
   }
 }
 
-void WebSocketClient::saveSettings() {
-  EEPROM.begin(512);
-  EEPROM.write(0, 0x42); // Magic byte
+void WebSocketClient::loadUpstreams(const char *host, uint16_t port,
+                                    const char *path) {
+  const ConfigStore::Config &config = ConfigStore::get();
+  _upstreamCount = 0;
+  for (int i = -1; i < (int)config.wsSpareCount; i++) {
+    Upstream &u = _upstreams[_upstreamCount++];
+    if (i < 0) {
+      u.host = String(host);
+      u.port = port;
+      u.path = String(path);
+    } else {
+      u.host = String(config.wsSpares[i].host);
+      u.port = config.wsSpares[i].port;
+      u.path = String(config.wsSpares[i].path);
+    }
+    u.reliability = 100;
+    u.srttMs = 0;
+    u.connects = 0;
+    u.failures = 0;
+    u.heartbeatMisses = 0;
+    u.address = IPAddress(0, 0, 0, 0);
+    u.resolvedMs = 0;
+    u.ttlMs = 0;
+  }
+  _roundFailures = 0;
+  selectUpstream(0);
+}
+
+void WebSocketClient::selectUpstream(uint8_t index) {
+  _active = index;
+  _serverHost = _upstreams[index].host;
+  _serverPort = _upstreams[index].port;
+  _serverPath = _upstreams[index].path;
+  _fullUrl = "ws://" + _serverHost + ":" + String(_serverPort) + _serverPath;
+}
+
+uint8_t WebSocketClient::bestUpstream(int exclude) {
+  // Highest score wins; ties go to the earlier (preferred) server
+  int best = -1;
+  for (int i = 0; i < _upstreamCount; i++) {
+    if (i != exclude && (best < 0 || _upstreams[i].score() >
+                                         _upstreams[best].score())) {
+      best = i;
+    }
+  }
+  return best >= 0 ? best : _active;
+}
+
+void WebSocketClient::adjustReliability(int delta) {
+  Upstream &u = _upstreams[_active];
+  u.reliability = constrain((int)u.reliability + delta, 0, 100);
+}
 
-  // Host
-  int len = _serverHost.length();
-  if (len > 100)
-    len = 100; // Cap length
-  EEPROM.write(1, len);
-  for (int i = 0; i < len; i++) {
-    EEPROM.write(2 + i, _serverHost[i]);
+void WebSocketClient::pollFailback() {
+  if (_active == 0 || _upstreamCount < 2) {
+    return;
   }
 
-  // Port
-  EEPROM.write(120, _serverPort & 0xFF);
-  EEPROM.write(121, (_serverPort >> 8) & 0xFF);
+  if (!_failbackProbing) {
+    IPAddress ip;
+    unsigned long now = millis();
+    if (now - _lastFailbackProbe >= FAILBACK_INTERVAL_MS &&
+        upstreamAddress(_upstreams[0], ip) &&
+        _probe.begin(ip, _upstreams[0].port, PROBE_TIMEOUT_MS)) {
+      _failbackProbing = true;
+    }
+    _lastFailbackProbe = now;
+    return;
+  }
 
-  // Path
-  len = _serverPath.length();
-  if (len > 100)
-    len = 100; // Cap length
-  EEPROM.write(122, len);
-  for (int i = 0; i < len; i++) {
-    EEPROM.write(123 + i, _serverPath[i]);
+  TcpProbe::State state = _probe.poll();
+  if (state == TcpProbe::State::CONNECTING) {
+    return;
+  }
+  _probe.stop();
+  _failbackProbing = false;
+  if (state != TcpProbe::State::CONNECTED) {
+    return;
   }
 
-  EEPROM.commit();
-  Serial.println("Saved WebSocket settings to EEPROM");
+  Upstream &primary = _upstreams[0];
+  primary.reliability = min(primary.reliability + RELIABILITY_PROBE, 100);
+  if (primary.score() < _upstreams[_active].score()) {
+    return;
+  }
+
+  LOG_INFO(Log::TAG_WEBSOCKET, "Primary %s is back - failing back",
+           primary.host.c_str());
+  _failovers++;
+  _connected = false; // Not a failure of the spare
+  _client.disconnect();
+  selectUpstream(0);
+  _phase = Phase::IDLE;
+  _lastReconnectAttempt = millis();
+  _reconnectDelay = 0;
+}
+
+void WebSocketClient::saveSettings() {
+  // Only the primary is set from the UI; spares come from /api/config
+  ConfigStore::Config &config = ConfigStore::get();
+  strlcpy(config.wsHost, _upstreams[0].host.c_str(), sizeof(config.wsHost));
+  config.wsPort = _upstreams[0].port;
+  strlcpy(config.wsPath, _upstreams[0].path.c_str(), sizeof(config.wsPath));
+  config.sections |= ConfigStore::SECTION_WEBSOCKET;
+  ConfigStore::scheduleSave();
+  LOG_DEBUG(Log::TAG_WEBSOCKET, "WebSocket settings scheduled for saving");
 }
 
 void WebSocketClient::disconnect() {
-  DEBUG_PRINTLN("Disconnect requested...");
+  LOG_INFO(Log::TAG_WEBSOCKET, "Disconnect requested");
 
   // Set flags first to prevent any race conditions
   _manuallyDisconnected = true; // Mark as manually disconnected
   _connectionAttempted = false; // Clear connection attempt flag
   _connected = false;           // Set disconnected state
+  _dns.stop();
+  _probe.stop();
+  _failbackProbing = false;
+  _phase = Phase::IDLE;
 
   // Now disconnect from the WebSocket
   _client.disconnect();
@@ -175,55 +242,257 @@ void WebSocketClient::disconnect() {
   _client.onEvent(webSocketEvent); // Reattach event handler
   _client.setReconnectInterval(0); // Disable auto-reconnect
 
-  DEBUG_PRINTLN("WebSocket forcibly disconnected and reset");
-  DEBUG_PRINT("Manual disconnect flag set: ");
-  DEBUG_PRINTLN(_manuallyDisconnected ? "true" : "false");
+  LOG_DEBUG(Log::TAG_WEBSOCKET, "Client reset (manual disconnect %u)",
+            _manuallyDisconnected);
 }
 
 bool WebSocketClient::isConnected() { return _connected; }
 
+void WebSocketClient::reconnectNow() {
+  if (!_connectionAttempted || _manuallyDisconnected ||
+      _serverHost.length() == 0) {
+    return;
+  }
+
+  LOG_INFO(Log::TAG_WEBSOCKET, "Network changed - reconnecting now");
+  // The old TCP connection died with the link/address; drop it (not the
+  // server's fault, so no failover)
+  _dns.stop();
+  _probe.stop();
+  _failbackProbing = false;
+  _connected = false;
+  _client.disconnect();
+  _phase = Phase::IDLE;
+  _consecutiveFailures = 0;
+  // Make the next poll() retry immediately
+  _lastReconnectAttempt = millis();
+  _reconnectDelay = 0;
+}
+
 void WebSocketClient::poll() {
-  // Only poll if we've actually attempted a connection
-  // Otherwise the library fires continuous disconnect events
-  if (_connectionAttempted && !_connectInProgress) {
+  // The library only runs while connected or connecting to a server the
+  // probe found reachable; left to itself it retries (and blocks) on its own
+  if (_connected || _phase == Phase::HANDSHAKE) {
     _client.loop();
   }
+  if (_connected) {
+    checkHeartbeat();
+    if (_connected) {
+      pollFailback();
+    }
+    return;
+  }
 
-  // Handle manual reconnection with exponential backoff
-  // Only if not manually disconnected and not already connecting
-  if (!_connected && _connectionAttempted && !_manuallyDisconnected &&
-      _autoReconnect && _serverHost.length() > 0 && !_connectInProgress) {
-    unsigned long now = millis();
+  switch (_phase) {
+  case Phase::RESOLVING:
+    switch (_dns.poll()) {
+    case DnsLookup::State::RESOLVED: {
+      Upstream &u = _upstreams[_active];
+      u.address = _dns.getAddress();
+      u.resolvedMs = millis();
+      u.ttlMs = constrain(_dns.getTtl(), 1U, DNS_CACHE_MAX_S) * 1000UL;
+      LOG_DEBUG(Log::TAG_WEBSOCKET, "Resolved %s (%u ms)", _serverHost.c_str(),
+                _dns.getResolveTimeMs());
+      _dns.stop();
+      probeServer(u.address);
+      break;
+    }
+    case DnsLookup::State::FAILED:
+      LOG_WARN(Log::TAG_WEBSOCKET, "Cannot resolve %s", _serverHost.c_str());
+      _dns.stop();
+      connectFailed();
+      break;
+    default:
+      break;
+    }
+    return;
+
+  case Phase::PROBING:
+    switch (_probe.poll()) {
+    case TcpProbe::State::CONNECTED:
+      LOG_DEBUG(Log::TAG_WEBSOCKET, "Server reachable (%u ms)",
+                _probe.getConnectTimeMs());
+      _probe.stop();
+      beginHandshake();
+      break;
+    case TcpProbe::State::FAILED:
+      LOG_DEBUG(Log::TAG_WEBSOCKET, "Server unreachable");
+      _probe.stop();
+      connectFailed();
+      break;
+    default:
+      break;
+    }
+    return;
 
-    // Calculate backoff interval: base * 2^failures, capped at 60 seconds
-    unsigned long backoff =
-        _reconnectInterval * (1 << min(_consecutiveFailures, (unsigned int)3));
-    if (backoff > 60000)
-      backoff = 60000;
-
-    if (now - _lastReconnectAttempt > backoff) {
-      _lastReconnectAttempt = now;
-      _connectInProgress = true;
-      _consecutiveFailures++;
-
-      Serial.print("Auto-reconnect: Attempting in ");
-      Serial.print(backoff / 1000);
-      Serial.print("s (attempt #");
-      Serial.print(_consecutiveFailures);
-      Serial.println(")");
-
-      // Retry the connection
-      bool isSocketIO = (_serverPath.indexOf("/socket.io") >= 0);
-      if (isSocketIO) {
-        String socketIOPath = _serverPath + "?EIO=4&transport=websocket";
-        _client.begin(_serverHost.c_str(), _serverPort, socketIOPath.c_str());
-      } else {
-        _client.begin(_serverHost.c_str(), _serverPort, _serverPath.c_str());
+  case Phase::HANDSHAKE:
+    if (millis() - _phaseStartMs >= HANDSHAKE_TIMEOUT_MS) {
+      LOG_WARN(Log::TAG_WEBSOCKET, "WebSocket handshake timed out");
+      _client.disconnect();
+      if (_phase == Phase::HANDSHAKE) {
+        connectFailed();
       }
+    }
+    return;
 
-      // Reset connect in progress after a short delay
-      // This prevents the tight loop while allowing the library to process
-      _connectInProgress = false;
+  case Phase::IDLE:
+    break;
+  }
+
+  // Handle reconnection with jittered exponential backoff
+  // Only if not manually disconnected
+  if (_connectionAttempted && !_manuallyDisconnected && _autoReconnect &&
+      _serverHost.length() > 0 &&
+      millis() - _lastReconnectAttempt >= _reconnectDelay) {
+    startAttempt();
+  }
+}
+
+void WebSocketClient::startAttempt() {
+  _consecutiveFailures++;
+  LOG_INFO(Log::TAG_WEBSOCKET, "Connection attempt #%u",
+           _consecutiveFailures);
+
+  const Upstream &u = _upstreams[_active];
+  IPAddress ip;
+  if (!ip.fromString(_serverHost.c_str()) &&
+      (u.ttlMs == 0 || millis() - u.resolvedMs >= u.ttlMs)) {
+    if (!_dns.begin(_serverHost.c_str(), Ethernet.dnsServerIP(),
+                    DNS_TIMEOUT_MS)) {
+      LOG_WARN(Log::TAG_WEBSOCKET, "Cannot resolve %s (no DNS server)",
+               _serverHost.c_str());
+      connectFailed();
+      return;
+    }
+    _phase = Phase::RESOLVING;
+    _phaseStartMs = millis();
+    return;
+  }
+  upstreamAddress(u, ip);
+  probeServer(ip);
+}
+
+void WebSocketClient::probeServer(const IPAddress &ip) {
+  _serverAddress = ip;
+  if (_probe.begin(ip, _serverPort, PROBE_TIMEOUT_MS)) {
+    _phase = Phase::PROBING;
+    _phaseStartMs = millis();
+    return;
+  }
+  // No hardware socket free for the probe: let the library connect
+  beginHandshake();
+}
+
+bool WebSocketClient::upstreamAddress(const Upstream &u, IPAddress &ip) {
+  // An address as configured, or the last one the name resolved to
+  if (ip.fromString(u.host.c_str())) {
+    return true;
+  }
+  ip = u.address;
+  return u.ttlMs != 0;
+}
+
+void WebSocketClient::beginHandshake() {
+  // The address, not the name, or the library would resolve it again
+  // (blocking)
+  String host = _serverAddress.toString();
+  bool isSocketIO = (_serverPath.indexOf("/socket.io") >= 0);
+  if (isSocketIO) {
+    // Socket.IO is handled at message level over a direct WebSocket
+    String socketIOPath = _serverPath + "?EIO=4&transport=websocket";
+    _client.begin(host.c_str(), _serverPort, socketIOPath.c_str());
+  } else {
+    _client.begin(host.c_str(), _serverPort, _serverPath.c_str());
+  }
+
+  // Keep the library from retrying on its own if its connect fails; the
+  // handshake timeout hands the retry back to the backoff in poll()
+  _client.setReconnectInterval(60000);
+  _phase = Phase::HANDSHAKE;
+  _phaseStartMs = millis();
+}
+
+void WebSocketClient::connectFailed() {
+  _upstreams[_active].failures++;
+  adjustReliability(RELIABILITY_FAILURE);
+  _phase = Phase::IDLE;
+  _lastReconnectAttempt = millis();
+
+  // Try the next server straight away until every one failed in a row
+  if (++_roundFailures < _upstreamCount) {
+    _failovers++;
+    selectUpstream(bestUpstream(_active));
+    _reconnectDelay = 0;
+    LOG_WARN(Log::TAG_WEBSOCKET, "Failing over to %s:%u", _serverHost.c_str(),
+             _serverPort);
+    return;
+  }
+
+  _roundFailures = 0;
+  selectUpstream(bestUpstream(-1));
+  _reconnectDelay = backoffDelay();
+  LOG_DEBUG(Log::TAG_WEBSOCKET, "Next attempt in %u ms", _reconnectDelay);
+}
+
+unsigned long WebSocketClient::backoffDelay() {
+  // base * 2^failures, capped; half of it is random so that timers which
+  // lost the same server don't all come back at the same instant
+  unsigned int doublings = min(_consecutiveFailures, 5U);
+  unsigned long ceiling = min(_reconnectInterval << doublings, MAX_BACKOFF_MS);
+  return ceiling / 2 + random(ceiling / 2 + 1);
+}
+
+void WebSocketClient::resetHeartbeat() {
+  unsigned long now = millis();
+  _heartbeat.pingIntervalMs = DEFAULT_PING_INTERVAL_MS;
+  _heartbeat.pingTimeoutMs = DEFAULT_PING_TIMEOUT_MS;
+  _lastMessageMs = now;
+  _lastEnginePingMs = now;
+  _lastProbeMs = now;
+  _probeSentMs = now;
+  _probePending = false;
+  _engineOpen = false;
+}
+
+void WebSocketClient::checkHeartbeat() {
+  unsigned long now = millis();
+  unsigned long interval = _heartbeat.pingIntervalMs;
+  // Probe after half an interval of silence and give it at most the other
+  // half, so a dead link is noticed within one ping interval
+  unsigned long probeTimeout = min((unsigned long)_heartbeat.pingTimeoutMs,
+                                   interval / 2);
+
+  bool dead = false;
+  if (_probePending && now - _probeSentMs >= probeTimeout) {
+    // Other traffic also proves the link alive (some servers never pong)
+    dead = now - _lastMessageMs >= probeTimeout;
+    _probePending = false;
+  }
+  if (_engineOpen &&
+      now - _lastEnginePingMs > interval + _heartbeat.pingTimeoutMs) {
+    dead = true; // The server stopped pinging
+  }
+
+  if (dead) {
+    _heartbeat.timeouts++;
+    _upstreams[_active].heartbeatMisses++;
+    adjustReliability(RELIABILITY_HEARTBEAT);
+    LOG_WARN(Log::TAG_WEBSOCKET, "Heartbeat lost (silent %u ms) - reconnecting",
+             now - _lastMessageMs);
+    _connected = false;
+    _client.disconnect();
+    connectFailed(); // Fails over if there is a spare
+    // Retry (this server or the spare) immediately
+    _reconnectDelay = 0;
+    return;
+  }
+
+  bool quiet = now - _lastMessageMs >= interval / 2;
+  if (!_probePending && (quiet || now - _lastProbeMs >= interval)) {
+    _lastProbeMs = now;
+    if (_client.sendPing()) {
+      _probeSentMs = now;
+      _probePending = true;
     }
   }
 }
@@ -234,6 +503,8 @@ const char *WebSocketClient::getStatus() {
   } else if (_manuallyDisconnected) {
     return "Disconnected"; // Don't show "Reconnecting..." if manually
                            // disconnected
+  } else if (_phase != Phase::IDLE) {
+    return "Connecting...";
   } else if (_connectionAttempted && _autoReconnect &&
              _serverHost.length() > 0) {
     return "Reconnecting...";
@@ -252,8 +523,27 @@ void WebSocketClient::webSocketEvent(WStype_t type, uint8_t *payload,
   }
 }
 
+void WebSocketClient::replayFrame(uint8_t type, const uint8_t *payload,
+                                  size_t length) {
+  if (type != WStype_TEXT) {
+    return; // Connection events belong to the live link
+  }
+  _replaying = true;
+  _frameStartUs = micros();
+  handleText(reinterpret_cast<const char *>(payload), length);
+  _replaying = false;
+}
+
 void WebSocketClient::handleWebSocketEvent(WStype_t type, uint8_t *payload,
                                            size_t length) {
+  // Fragments are captured once reassembled, as the text frame they make
+  bool fragment = type == WStype_FRAGMENT_TEXT_START ||
+                  type == WStype_FRAGMENT_BIN_START ||
+                  type == WStype_FRAGMENT || type == WStype_FRAGMENT_FIN;
+  if (!fragment) {
+    Capture::record(type, payload, length);
+  }
+
   switch (type) {
   case WStype_DISCONNECTED:
     // Rate limit disconnect logging to prevent flood
@@ -262,127 +552,288 @@ void WebSocketClient::handleWebSocketEvent(WStype_t type, uint8_t *payload,
       unsigned long now = millis();
       if (now - lastDisconnectLog > 10000) { // Log at most every 10 seconds
         lastDisconnectLog = now;
-        Serial.println("WebSocket: Connection failed/disconnected");
+        LOG_WARN(Log::TAG_WEBSOCKET, "Connection failed/disconnected");
       }
     }
-    _connected = false;
-    _connectInProgress = false; // Allow new connection attempts
-
     // If this was a manual disconnect, ensure we stay disconnected
     if (_manuallyDisconnected) {
       _connectionAttempted = false; // Prevent any reconnection attempts
       _consecutiveFailures = 0;     // Reset failure counter
+      _phase = Phase::IDLE;
+    } else if (_connected || _phase == Phase::HANDSHAKE) {
+      // Server dropped us or refused the upgrade (disconnects we caused
+      // ourselves have already cleared _connected)
+      _connected = false;
+      connectFailed();
+    }
+    _connected = false;
+    if (_fragments == Fragments::TEXT) {
+      _parserStats.dropped++; // Link closed mid-message
     }
+    _fragments = Fragments::NONE;
     break;
 
   case WStype_CONNECTED:
-    Serial.print("WebSocket: Connected to: ");
-    Serial.println((char *)payload);
+    LOG_INFO(Log::TAG_WEBSOCKET, "Connected to %s", (const char *)payload);
     _connected = true;
-    _connectInProgress = false;
+    _phase = Phase::IDLE;
     _consecutiveFailures = 0; // Reset failure counter on successful connection
+    _roundFailures = 0;
+    _upstreams[_active].connects++;
+    adjustReliability(RELIABILITY_CONNECT);
+    _lastFailbackProbe = millis();
+    resetHeartbeat();
+    break;
 
-    // Connection is managed by the library
-    Serial.println("WebSocket: Ready to receive timer events");
+  case WStype_TEXT:
+    dispatchText(reinterpret_cast<const char *>(payload), length);
     break;
 
-  case WStype_TEXT: {
-    // Force connected state if we receive data (in case CONNECTED event was
-    // missed)
-    if (!_connected) {
-      _connected = true;
-      _consecutiveFailures = 0;
+  case WStype_BIN:
+    _lastMessageMs = millis();
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Binary message ignored (%u bytes)", length);
+    break;
 
-      // Also define start time for reconnect backoff just in case
-      _lastReconnectAttempt = millis();
+  case WStype_PING:
+    _lastMessageMs = millis();
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Ping received");
+    break;
 
-      Serial.println("WebSocket: Connected (inferred from data)");
+  case WStype_PONG:
+    _lastMessageMs = millis();
+    if (_probePending) {
+      uint32_t rtt = _lastMessageMs - _probeSentMs;
+      _heartbeat.lastRttMs = rtt;
+      if (rtt > _heartbeat.maxRttMs) {
+        _heartbeat.maxRttMs = rtt;
+      }
+      Upstream &u = _upstreams[_active];
+      u.srttMs = u.srttMs == 0 ? rtt : (7 * u.srttMs + rtt) / 8;
+      _probePending = false;
     }
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Pong received (rtt %u ms)",
+              _heartbeat.lastRttMs);
+    break;
 
-    String data = String((char *)payload);
-    DEBUG_PRINT("Message received: ");
-    DEBUG_PRINTLN(data);
+  case WStype_ERROR:
+    LOG_WARN(Log::TAG_WEBSOCKET, "WebSocket error");
+    _connected = false;
+    break;
 
-    // Handle Socket.IO protocol messages
-    if (data.startsWith("0")) {
-      DEBUG_PRINTLN("Socket.IO: Connection request");
-      // Send connection response
-      _client.sendTXT("40");
-      return;
-    } else if (data.startsWith("40")) {
-      DEBUG_PRINTLN("Socket.IO: Connected successfully");
-      return;
-    } else if (data.startsWith("2")) {
-      DEBUG_PRINTLN("Socket.IO: Ping - sending pong");
-      _client.sendTXT("3");
-      return;
-    } else if (data.startsWith("42")) {
-      DEBUG_PRINTLN("Socket.IO: Event message");
-      // Extract JSON from Socket.IO event format: 42["event_name", data]
-      int bracketPos = data.indexOf('[');
-      if (bracketPos > 0) {
-        data = data.substring(bracketPos);
-      }
-    } else if (!data.startsWith("{") && !data.startsWith("[")) {
-      DEBUG_PRINT("Socket.IO: Unknown packet type - ");
-      DEBUG_PRINTLN(data.substring(0, 2));
+  case WStype_FRAGMENT_TEXT_START:
+  case WStype_FRAGMENT_BIN_START:
+  case WStype_FRAGMENT:
+  case WStype_FRAGMENT_FIN:
+    _lastMessageMs = millis();
+    handleFragment(type, payload, length);
+    break;
+  }
+}
+
+void WebSocketClient::handleFragment(WStype_t type, const uint8_t *payload,
+                                     size_t length) {
+  switch (type) {
+  case WStype_FRAGMENT_TEXT_START:
+    if (_fragments == Fragments::TEXT) {
+      _parserStats.dropped++; // Previous message never finished
+    }
+    _fragments = Fragments::TEXT;
+    _fragmentLength = 0;
+    break;
+
+  case WStype_FRAGMENT_BIN_START:
+    if (_fragments == Fragments::TEXT) {
+      _parserStats.dropped++;
+    }
+    _fragments = Fragments::SKIP; // Binary messages are not used
+    return;
+
+  default:
+    if (_fragments == Fragments::NONE) {
+      // Continuation without a start (e.g. joined mid-message)
+      _parserStats.dropped++;
       return;
     }
+    break;
+  }
 
-    // Parse JSON message
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, data);
+  if (_fragments == Fragments::TEXT) {
+    if (length > WS_MAX_MESSAGE_SIZE - _fragmentLength) {
+      LOG_WARN(Log::TAG_WEBSOCKET, "Fragmented message over %u bytes dropped",
+               (uint32_t)WS_MAX_MESSAGE_SIZE);
+      _parserStats.oversized++;
+      _fragments = Fragments::SKIP; // Ignore the rest of it
+    } else {
+      memcpy(_fragmentBuffer + _fragmentLength, payload, length);
+      _fragmentLength += length;
+    }
+  }
+
+  if (type != WStype_FRAGMENT_FIN) {
+    return;
+  }
+  if (_fragments == Fragments::TEXT) {
+    _fragmentBuffer[_fragmentLength] = '\0';
+    _parserStats.reassembled++;
+    Capture::record(WStype_TEXT,
+                    reinterpret_cast<const uint8_t *>(_fragmentBuffer),
+                    _fragmentLength);
+    dispatchText(_fragmentBuffer, _fragmentLength);
+  }
+  _fragments = Fragments::NONE;
+}
+
+void WebSocketClient::dispatchText(const char *data, size_t length) {
+  // Force connected state if we receive data (in case CONNECTED event was
+  // missed)
+  if (!_connected) {
+    _connected = true;
+    _phase = Phase::IDLE;
+    _consecutiveFailures = 0;
+    _roundFailures = 0;
+
+    LOG_INFO(Log::TAG_WEBSOCKET, "Connected (inferred from data)");
+    resetHeartbeat();
+  }
+  _lastMessageMs = millis();
+
+  _frameStartUs = micros();
+  handleText(data, length);
+  uint32_t elapsed = micros() - _frameStartUs;
+  _parserStats.messages++;
+  _parserStats.totalUs += elapsed;
+  if (elapsed > _parserStats.maxUs) {
+    _parserStats.maxUs = elapsed;
+  }
+}
+
+void WebSocketClient::buildFilter() {
+  // Keep only what handleTimerUpdate reads, both at the top level (plain
+  // WebSocket and Socket.IO event argument) and under "timer_update"
+  auto addFields = [](JsonObject fields) {
+    fields["action"] = true;
+    fields["minutes"] = true;
+    fields["seconds"] = true;
+    fields["seq"] = true;
+    fields["settings"]["endMessage"] = true;
+  };
+  JsonObject top = _filter.to<JsonObject>();
+  addFields(top);
+  addFields(top["timer_update"].to<JsonObject>());
+}
+
+void WebSocketClient::handleText(const char *data, size_t length) {
+  LOG_DEBUG(Log::TAG_WEBSOCKET, "Message %s (%u bytes)", data, length);
+
+  SocketIO::Packet packet;
+  if (!SocketIO::parse(data, length, packet)) {
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Unknown packet %s", data);
+    return;
+  }
 
-    if (error) {
-      DEBUG_PRINT("JSON parse error: ");
-      DEBUG_PRINTLN(error.c_str());
-      DEBUG_PRINT("Raw data: ");
-      DEBUG_PRINTLN(data);
+  // A replay only drives the timer; the live connection's handshake and
+  // heartbeat are left alone
+  if (_replaying && packet.engine != SocketIO::EngineType::MESSAGE &&
+      packet.engine != SocketIO::EngineType::JSON) {
+    return;
+  }
+
+  switch (packet.engine) {
+  case SocketIO::EngineType::OPEN:
+    handleOpen(packet.body, packet.bodyLength);
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Socket.IO open - connecting namespace");
+    _client.sendTXT("40");
+    return;
+
+  case SocketIO::EngineType::PING:
+    _lastEnginePingMs = millis();
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Socket.IO ping");
+    _client.sendTXT("3");
+    return;
+
+  case SocketIO::EngineType::MESSAGE:
+    if (packet.type == SocketIO::PacketType::CONNECT) {
+      LOG_INFO(Log::TAG_WEBSOCKET, "Socket.IO connected");
       return;
     }
+    if (packet.type != SocketIO::PacketType::EVENT) {
+      LOG_DEBUG(Log::TAG_WEBSOCKET, "Socket.IO packet type %u ignored",
+                (uint32_t)packet.type);
+      return;
+    }
+    // 42["event_name", data]: only timer_update is handled
+    {
+      const char *args;
+      size_t argsLength;
+      if (SocketIO::matchEvent(packet.body, packet.bodyLength,
+                               "timer_update", &args, &argsLength)) {
+        handleMessage(args, argsLength);
+      }
+    }
+    return;
 
-    // Check if this is a timer_update event
-    // Socket.IO format can vary, handle both direct and wrapped formats
-    if (doc.is<JsonArray>()) {
-      JsonArray arr = doc.as<JsonArray>();
-      if (arr.size() >= 2 && arr[0] == "timer_update" &&
-          arr[1].is<JsonObject>()) {
-        DEBUG_PRINTLN("Processing timer_update event");
-        JsonObject obj = arr[1];
-        handleTimerUpdate(obj);
+  case SocketIO::EngineType::JSON:
+    if (data[0] == '[') {
+      const char *args;
+      size_t argsLength;
+      if (SocketIO::matchEvent(data, length, "timer_update", &args,
+                               &argsLength)) {
+        handleMessage(args, argsLength);
       }
-    } else if (doc["timer_update"].is<JsonObject>()) {
-      JsonObject obj = doc["timer_update"];
-      handleTimerUpdate(obj);
-    } else if (doc["action"].is<const char *>()) {
-      JsonObject obj = doc.as<JsonObject>();
-      handleTimerUpdate(obj);
+      return;
     }
-  } break;
+    handleMessage(data, length);
+    return;
 
-  case WStype_BIN:
-    DEBUG_PRINTLN("WebSocket binary message received (ignored)");
-    break;
+  default:
+    return;
+  }
+}
 
-  case WStype_PING:
-    DEBUG_PRINTLN("WebSocket ping received");
-    break;
+void WebSocketClient::handleOpen(const char *json, size_t length) {
+  // 0{"sid":"...","upgrades":[],"pingInterval":25000,"pingTimeout":20000}
+  _engineOpen = true;
+  _lastEnginePingMs = millis();
 
-  case WStype_PONG:
-    DEBUG_PRINTLN("WebSocket pong received");
-    break;
+  _jsonPool.reset();
+  JsonDocument doc(&_jsonPool);
+  if (deserializeJson(doc, json, length)) {
+    _parserStats.parseErrors++;
+    LOG_WARN(Log::TAG_WEBSOCKET, "Bad Engine.IO handshake, using defaults");
+    return;
+  }
+  uint32_t interval = doc["pingInterval"] | 0U;
+  uint32_t timeout = doc["pingTimeout"] | 0U;
+  if (interval > 0) {
+    _heartbeat.pingIntervalMs = interval;
+  }
+  if (timeout > 0) {
+    _heartbeat.pingTimeoutMs = timeout;
+  }
+  LOG_INFO(Log::TAG_WEBSOCKET, "Heartbeat every %u ms, timeout %u ms",
+           _heartbeat.pingIntervalMs, _heartbeat.pingTimeoutMs);
+}
 
-  case WStype_ERROR:
-    DEBUG_PRINTLN("WebSocket error occurred");
-    _connected = false;
-    break;
+void WebSocketClient::handleMessage(const char *json, size_t length) {
+  // Parses straight from the frame buffer; the parser stops after the first
+  // value, so the closing "]" of an event array is left alone
+  _jsonPool.reset();
+  JsonDocument doc(&_jsonPool);
+  DeserializationError error = deserializeJson(
+      doc, json, length, DeserializationOption::Filter(_filter));
+
+  if (error) {
+    _parserStats.parseErrors++;
+    LOG_WARN(Log::TAG_WEBSOCKET, "JSON parse error: %s", error.c_str());
+    return;
+  }
 
-  case WStype_FRAGMENT_TEXT_START:
-  case WStype_FRAGMENT_BIN_START:
-  case WStype_FRAGMENT:
-  case WStype_FRAGMENT_FIN:
-    DEBUG_PRINTLN("WebSocket fragment received");
-    break;
+  if (doc["timer_update"].is<JsonObject>()) {
+    JsonObject obj = doc["timer_update"];
+    handleTimerUpdate(obj);
+  } else if (doc["action"].is<const char *>()) {
+    JsonObject obj = doc.as<JsonObject>();
+    handleTimerUpdate(obj);
   }
 }
 
@@ -390,33 +841,28 @@ void WebSocketClient::handleTimerUpdate(JsonObject &obj) {
   const char *action = obj["action"];
 
   if (action == nullptr) {
-    DEBUG_PRINTLN("No action field in timer_update");
+    LOG_WARN(Log::TAG_WEBSOCKET, "timer_update without action");
     return;
   }
 
-  DEBUG_PRINT("Timer action: ");
-  DEBUG_PRINTLN(action);
+  LOG_INFO(Log::TAG_WEBSOCKET, "Timer action: %s", action);
+
+  // Commands without a sequence from the controller are numbered locally
+  uint32_t seq = obj["seq"] | (_commandCount + 1);
 
   if (strcmp(action, "start") == 0) {
     // Just start the timer - duration setting and reset are handled by reset
     // events
-    DEBUG_PRINTLN("Starting timer (resume if paused, or start if reset)");
     _timer->start();
 
   } else if (strcmp(action, "stop") == 0) {
-    DEBUG_PRINTLN("Stopping timer");
     _timer->stop();
 
   } else if (strcmp(action, "reset") == 0) {
     int minutes = obj["minutes"] | 3;
     int seconds = obj["seconds"] | 0;
 
-    DEBUG_PRINT("Resetting timer: ");
-    DEBUG_PRINT(minutes);
-    DEBUG_PRINT(":");
-    if (seconds < 10)
-      DEBUG_PRINT("0");
-    DEBUG_PRINTLN(seconds);
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Reset to %u:%02u", minutes, seconds);
 
     // Set duration and reset - timer will stop and not auto-restart
     _timer->setDuration({(unsigned int)minutes, (unsigned int)seconds, 0});
@@ -429,15 +875,80 @@ void WebSocketClient::handleTimerUpdate(JsonObject &obj) {
     if (!settings.isNull()) {
       // Could update display settings here if needed
       // For now, we'll just log it
-      DEBUG_PRINTLN("Settings update received (not applied to physical timer)");
+      LOG_DEBUG(Log::TAG_WEBSOCKET, "Settings update (not applied)");
 
       // Optionally extract endMessage or other relevant settings
       if (settings["endMessage"].is<const char *>()) {
         const char *endMsg = settings["endMessage"];
-        DEBUG_PRINT("End message: ");
-        DEBUG_PRINTLN(endMsg);
+        LOG_DEBUG(Log::TAG_WEBSOCKET, "End message: %s", endMsg);
         // Could call _timer->setEndMessage(endMsg) if that method exists
       }
     }
+
+  } else {
+    LOG_DEBUG(Log::TAG_WEBSOCKET, "Unknown action %s not acknowledged",
+              action);
+    return;
+  }
+
+  sendAck(action, seq, micros() - _frameStartUs);
+}
+
+void WebSocketClient::sendAck(const char *action, uint32_t seq,
+                              uint32_t latencyUs) {
+  if (_replaying) {
+    return; // Replayed commands were acknowledged when they happened
+  }
+
+  _commandCount++;
+  _lastSeq = seq;
+  _latencyUs[_latencyIndex] = latencyUs;
+  _latencyIndex = (_latencyIndex + 1) % WS_LATENCY_WINDOW;
+
+  Timer::Components remaining = _timer->getRemainingTime();
+  unsigned long remainingMs =
+      (remaining.minutes * 60UL + remaining.seconds) * 1000UL +
+      remaining.milliseconds;
+
+  // Formatted on the stack; action is one of the handled names
+  char body[128];
+  snprintf(body, sizeof(body),
+           "{\"seq\":%lu,\"action\":\"%s\",\"appliedMs\":%lu,"
+           "\"latencyUs\":%lu,\"remainingMs\":%lu,\"running\":%s}",
+           (unsigned long)seq, action, millis(), (unsigned long)latencyUs,
+           remainingMs, _timer->isRunning() ? "true" : "false");
+
+  char frame[160];
+  if (_engineOpen) {
+    snprintf(frame, sizeof(frame), "42[\"timer_ack\",%s]", body);
+  } else {
+    snprintf(frame, sizeof(frame), "{\"timer_ack\":%s}", body);
+  }
+  if (!_client.sendTXT(frame)) {
+    _ackFailures++;
+  }
+}
+
+WebSocketClient::AckStats WebSocketClient::getAckStats() {
+  AckStats stats = {};
+  stats.commands = _commandCount;
+  stats.sendFailures = _ackFailures;
+  stats.lastSeq = _lastSeq;
+  if (_commandCount == 0) {
+    return stats;
+  }
+
+  uint8_t samples = _commandCount < WS_LATENCY_WINDOW ? _commandCount
+                                                       : WS_LATENCY_WINDOW;
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < samples; i++) {
+    total += _latencyUs[i];
+    if (_latencyUs[i] > stats.maxUs) {
+      stats.maxUs = _latencyUs[i];
+    }
   }
+  stats.avgUs = total / samples;
+  stats.lastUs =
+      _latencyUs[(_latencyIndex + WS_LATENCY_WINDOW - 1) % WS_LATENCY_WINDOW];
+  return stats;
 }
@@ -1,3 +1,6 @@
+#include "Capture.h"
+#include "Log.h"
+#include "Network.h"
 #include "TimerDisplay.h"
 #include "WebServer.h"
 #include "WebSocketClient.h"
@@ -38,26 +41,73 @@ uint8_t mac[] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
 uint8_t ip[] = {10, 0, 0, 21}; // Fallback static IP
 const char *hostname = "arenatimer";
 
+// Boot is measured from reset; the timer must be on screen within this
+const unsigned long FIRST_FRAME_TARGET_MS = 500;
+
+// ----------------------------------------------------------------------------
+// HELPERS
+// ----------------------------------------------------------------------------
+
+// Log a boot milestone (the record's timestamp is milliseconds since reset)
+void bootMilestone(const char *name) {
+  LOG_INFO(Log::TAG_SYSTEM, "[boot] %s", name);
+}
+
+// Start everything that needs an address once the network is up
+void startNetworkServices() {
+  WebServer::startWebServer(80);
+  WebServer::initMDNS(hostname);
+  bootMilestone("network up");
+
+  if (!timerDisplay.getTimer().isRunning()) {
+    timerDisplay.showMessage(WebServer::getIPAddressString());
+  }
+}
+
+// Link back or new address: re-announce the hostname and reconnect to the
+// WebSocket server right away instead of waiting for the backoff
+void restartNetworkServices() {
+  WebServer::initMDNS(hostname);
+  if (wsClient) {
+    wsClient->reconnectNow();
+  }
+}
+
 // ----------------------------------------------------------------------------
 // SETUP
 // ----------------------------------------------------------------------------
 void setup() {
   Serial.begin(115200);
-  Serial.println("\n=== Arena Timer Booting ===");
+  LOG_INFO(Log::TAG_SYSTEM, "=== Arena Timer Booting ===");
+  bootMilestone("setup");
 
   // 1. Matrix Init
   ProtomatterStatus status = matrix.begin();
-  Serial.print("Matrix Status: ");
-  Serial.println((int)status);
+  LOG_INFO(Log::TAG_SYSTEM, "Matrix status %u", (uint32_t)status);
+  bootMilestone("matrix");
+
+  // 2. Load Persistent Settings (before the first frame and before the
+  // WebSocket client reads them)
+  WebServer::initStorage();
+  if (!WebServer::loadSettings(timerDisplay)) {
+    LOG_INFO(Log::TAG_SYSTEM, "Using default display settings");
+    // Default initial setup if no settings exist
+    timerDisplay.getTimer().setDuration(Timer::Components{3, 0, 0});
+    timerDisplay.clearColorThresholds();
+    timerDisplay.addColorThreshold(60, 255, 0, 0);
+    timerDisplay.addColorThreshold(120, 255, 255, 0);
+  }
+  bootMilestone("settings");
 
-  matrix.fillScreen(0);
-  matrix.setCursor(0, 0);
-  matrix.setTextColor(matrix.color565(0, 0, 255));
-  matrix.println("Arena");
-  matrix.println("Timer");
-  matrix.show();
+  // 3. First frame: the timer is usable from here on
+  timerDisplay.update();
+  bootMilestone("first frame");
+  if (millis() > FIRST_FRAME_TARGET_MS) {
+    LOG_WARN(Log::TAG_SYSTEM, "First frame later than %u ms target",
+             FIRST_FRAME_TARGET_MS);
+  }
 
-  // 2. Ethernet Hardware Init (SPI1)
+  // 4. Ethernet Hardware Init (SPI1)
   SPI1.setSCK(ETH_SCK);
   SPI1.setTX(ETH_TX);
   SPI1.setRX(ETH_RX);
@@ -65,48 +115,14 @@ void setup() {
 
   Ethernet.init(ETH_CS);
 
-  // 3. Network Logic Init
-  Serial.print("Initializing Network...");
-  timerDisplay.showMessage("DHCP...");
-  if (WebServer::init(mac, ip)) {
-    Serial.println("OK");
-    WebServer::startWebServer(80);
-    WebServer::initMDNS(hostname);
-
-    Serial.print("IP: ");
-    Serial.println(Ethernet.localIP());
-    timerDisplay.showMessage(String(Ethernet.localIP()[0]) + "." +
-                             String(Ethernet.localIP()[1]) + "." +
-                             String(Ethernet.localIP()[2]) + "." +
-                             String(Ethernet.localIP()[3]));
-    matrix.show();
-    delay(2000);
-  } else {
-    Serial.println("FAIL");
-    matrix.fillScreen(0);
-    matrix.setTextColor(matrix.color565(255, 0, 0));
-    matrix.println("Net Err");
-    matrix.show();
-  }
+  // 5. Network bring-up and supervision (DHCP, static fallback, link
+  // monitoring, web server, mDNS) run in the background from loop()
+  Network::begin(mac, ip);
 
-  // 4. WebSocket Init
+  // 6. WebSocket Init (auto-connect starts once the network is up)
   wsClient = new WebSocketClient(&timerDisplay.getTimer());
   WebServer::setWebSocketClient(wsClient);
-
-  // 5. Load Persistent Settings
-  Serial.print("Loading saved settings...");
-  if (WebServer::loadSettings(timerDisplay)) {
-    Serial.println("OK");
-  } else {
-    Serial.println("Using defaults");
-    // Default initial setup if no settings exist
-    timerDisplay.getTimer().setDuration(Timer::Components{3, 0, 0});
-    timerDisplay.clearColorThresholds();
-    timerDisplay.addColorThreshold(60, 255, 0, 0);
-    timerDisplay.addColorThreshold(120, 255, 255, 0);
-  }
-
-  matrix.fillScreen(0);
+  bootMilestone("setup done");
 }
 
 // ----------------------------------------------------------------------------
@@ -114,9 +130,44 @@ void setup() {
 // ----------------------------------------------------------------------------
 void loop() {
   timerDisplay.update();
-  Ethernet.maintain();
-  WebServer::handleClient(timerDisplay);
-  if (wsClient) {
-    wsClient->poll();
+  WebServer::servicePersistence(timerDisplay);
+
+  static bool servicesStarted = false;
+  Network::State previous = Network::getState();
+  switch (Network::service()) {
+  case Network::Event::UP:
+  case Network::Event::ADDRESS_CHANGED:
+    if (!servicesStarted) {
+      startNetworkServices();
+      servicesStarted = true;
+    } else {
+      restartNetworkServices();
+    }
+    break;
+  case Network::Event::DOWN:
+    break; // Services are restarted on the next UP
+  case Network::Event::NONE:
+    if (Network::getState() == Network::State::NO_HARDWARE &&
+        previous != Network::State::NO_HARDWARE) {
+      timerDisplay.showMessage("Net Err");
+    }
+    break;
   }
+
+  if (Network::isUp()) {
+    unsigned long start = micros();
+    WebServer::handleClient(timerDisplay);
+    Network::recordCall(Network::CALL_HTTP, micros() - start);
+    if (wsClient) {
+      start = micros();
+      wsClient->poll();
+      Network::recordCall(Network::CALL_WEBSOCKET, micros() - start);
+    }
+  }
+
+  // Feed a capture replay (if one was started over HTTP) to the client
+  Capture::serviceReplay();
+
+  // Idle time: print pending log records without blocking
+  Log::drain();
 }
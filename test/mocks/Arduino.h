@@ -0,0 +1,284 @@
+/**
+ * Host stand-in for the Arduino core, used by the native unit tests
+ *
+ * Covers what the modules under test use: a clock the tests move forward
+ * by hand, Print/Stream, String, Serial and a seeded random(). The C part
+ * is what the Protomatter core needs when it is compiled on the host.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+#ifndef __cplusplus
+
+// Pins are not driven on the host
+static inline void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+static inline void digitalWrite(uint8_t pin, uint8_t value) {
+  (void)pin;
+  (void)value;
+}
+static inline void delayMicroseconds(unsigned int us) { (void)us; }
+
+#else // C++
+
+#include <algorithm>
+#include <stdarg.h>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define constrain(x, low, high)                                                \
+  ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+// glibc 2.38 and macOS already have it
+#if !defined(__APPLE__) &&                                                     \
+    !(defined(__GLIBC__) &&                                                    \
+      (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38)))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t length = strlen(src);
+  if (size > 0) {
+    size_t n = length < size - 1 ? length : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return length;
+}
+#endif
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PSTR(s) (s)
+
+// Simulated time. Nothing advances it but the tests (and delay()).
+namespace Mock {
+inline unsigned long long nowUs = 0;
+inline uint32_t randomState = 1;
+
+inline void advanceUs(unsigned long us) { nowUs += us; }
+inline void advanceMs(unsigned long ms) { nowUs += 1000ULL * ms; }
+} // namespace Mock
+
+inline unsigned long millis() { return (unsigned long)(Mock::nowUs / 1000); }
+inline unsigned long micros() { return (unsigned long)Mock::nowUs; }
+inline void delay(unsigned long ms) { Mock::advanceMs(ms); }
+inline void delayMicroseconds(unsigned int us) { Mock::advanceUs(us); }
+inline void yield() {}
+
+inline void randomSeed(unsigned long seed) {
+  Mock::randomState = seed != 0 ? (uint32_t)seed : 1;
+}
+inline long random(long howBig) {
+  // xorshift32, so runs are repeatable
+  uint32_t x = Mock::randomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  Mock::randomState = x;
+  return howBig > 0 ? (long)(x % (uint32_t)howBig) : 0;
+}
+inline long random(long howSmall, long howBig) {
+  return howSmall + random(howBig - howSmall);
+}
+
+class String {
+public:
+  String() {}
+  String(const char *s) : _s(s != nullptr ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  String(char c) : _s(1, c) {}
+  String(int v) : _s(std::to_string(v)) {}
+  String(unsigned int v) : _s(std::to_string(v)) {}
+  String(long v) : _s(std::to_string(v)) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+
+  const char *c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  void reserve(unsigned int size) { _s.reserve(size); }
+  char charAt(unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  char operator[](unsigned int i) const { return charAt(i); }
+
+  bool concat(const char *s) {
+    _s += s;
+    return true;
+  }
+  bool concat(const char *s, unsigned int n) {
+    _s.append(s, n);
+    return true;
+  }
+  bool concat(char c) {
+    _s += c;
+    return true;
+  }
+  String &operator+=(const String &s) {
+    _s += s._s;
+    return *this;
+  }
+  String &operator+=(const char *s) {
+    _s += s;
+    return *this;
+  }
+  String &operator+=(char c) {
+    _s += c;
+    return *this;
+  }
+  friend String operator+(const String &a, const String &b) {
+    return String(a._s + b._s);
+  }
+  friend String operator+(const String &a, const char *b) {
+    return String(a._s + b);
+  }
+  friend String operator+(const char *a, const String &b) {
+    return String(a + b._s);
+  }
+
+  bool operator==(const String &s) const { return _s == s._s; }
+  bool operator==(const char *s) const { return _s == s; }
+  bool operator!=(const String &s) const { return _s != s._s; }
+  bool operator!=(const char *s) const { return _s != s; }
+  bool equals(const String &s) const { return _s == s._s; }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    return position(_s.find(c, from));
+  }
+  int indexOf(const char *s, unsigned int from = 0) const {
+    return position(_s.find(s, from));
+  }
+  bool startsWith(const char *s) const { return _s.rfind(s, 0) == 0; }
+  String substring(unsigned int from) const {
+    return from < _s.size() ? String(_s.substr(from)) : String();
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < to && from < _s.size() ? String(_s.substr(from, to - from))
+                                         : String();
+  }
+  long toInt() const { return atol(_s.c_str()); }
+
+private:
+  std::string _s;
+
+  static int position(size_t p) {
+    return p == std::string::npos ? -1 : (int)p;
+  }
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size-- > 0 && write(*buffer++) == 1) {
+      n++;
+    }
+    return n;
+  }
+  size_t write(const char *s) {
+    return s != nullptr ? write(reinterpret_cast<const uint8_t *>(s),
+                                strlen(s))
+                        : 0;
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write(reinterpret_cast<const uint8_t *>(buffer), size);
+  }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const __FlashStringHelper *s) {
+    return write(reinterpret_cast<const char *>(s));
+  }
+  size_t print(const String &s) { return write(s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T &v) {
+    size_t n = print(v);
+    return n + println();
+  }
+
+  __attribute__((format(printf, 2, 3))) size_t printf(const char *format,
+                                                      ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (n < 0) {
+      return 0;
+    }
+    return write(buffer, (size_t)n < sizeof(buffer) ? n : sizeof(buffer) - 1);
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { (void)timeout; }
+  size_t readBytes(char *buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+      int c = read();
+      if (c < 0) {
+        break;
+      }
+      buffer[n++] = (char)c;
+    }
+    return n;
+  }
+  size_t readBytes(uint8_t *buffer, size_t length) {
+    return readBytes(reinterpret_cast<char *>(buffer), length);
+  }
+};
+
+// Counts what is written; the log drain is the only user
+class HardwareSerial : public Stream {
+public:
+  size_t written = 0;
+
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c) override {
+    (void)c;
+    written++;
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    (void)buffer;
+    written += size;
+    return size;
+  }
+  using Print::write;
+  int availableForWrite() override { return 4096; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  operator bool() { return true; }
+};
+
+inline HardwareSerial Serial;
+
+#endif // __cplusplus
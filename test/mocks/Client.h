@@ -0,0 +1,30 @@
+/**
+ * Host stand-in for the Arduino Client interface
+ */
+
+#pragma once
+
+#include "IPAddress.h"
+#include <Arduino.h>
+
+class Client : public Stream {
+public:
+  virtual int connect(IPAddress ip, uint16_t port) {
+    (void)ip;
+    (void)port;
+    return 0;
+  }
+  virtual int connect(const char *host, uint16_t port) {
+    (void)host;
+    (void)port;
+    return 0;
+  }
+  virtual size_t write(uint8_t c) override = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) override = 0;
+  using Print::write;
+  virtual int read(uint8_t *buffer, size_t size) = 0;
+  using Stream::read;
+  virtual uint8_t connected() = 0;
+  virtual void stop() = 0;
+  virtual operator bool() = 0;
+};
@@ -0,0 +1,21 @@
+/**
+ * Host stand-in for the emulated EEPROM (blank unless a test fills it)
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+  uint8_t data[4096];
+
+  EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+  void begin(size_t size) { (void)size; }
+  uint8_t read(int address) { return data[address]; }
+  void write(int address, uint8_t value) { data[address] = value; }
+  bool commit() { return true; }
+  void end() {}
+};
+
+inline EEPROMClass EEPROM;
@@ -0,0 +1,198 @@
+/**
+ * Host stand-in for the Ethernet_Generic W5500 socket registers
+ *
+ * Only the register access TcpProbe uses, and UDP for DnsLookup. A CONNECT
+ * command looks the destination up in the simulated network (MockNetwork.h)
+ * and the socket status then follows what that server does; a datagram to
+ * port 53 is answered by the simulated DNS server.
+ */
+
+#pragma once
+
+#include "IPAddress.h"
+#include "MockNetwork.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include <deque>
+#include <string>
+
+#ifndef MAX_SOCK_NUM
+#define MAX_SOCK_NUM 8
+#endif
+
+#define SPI_ETHERNET_SETTINGS SPISettings(14000000, MSBFIRST, SPI_MODE0)
+
+typedef uint8_t SOCKET;
+
+enum SockCMD {
+  Sock_OPEN = 0x01,
+  Sock_LISTEN = 0x02,
+  Sock_CONNECT = 0x04,
+  Sock_DISCON = 0x08,
+  Sock_CLOSE = 0x10,
+};
+
+class SnMR {
+public:
+  static const uint8_t TCP = 0x21;
+};
+
+class SnSR {
+public:
+  static const uint8_t CLOSED = 0x00;
+  static const uint8_t INIT = 0x13;
+  static const uint8_t SYNSENT = 0x15;
+  static const uint8_t ESTABLISHED = 0x17;
+  static const uint8_t CLOSE_WAIT = 0x1C;
+};
+
+class W5100Class {
+public:
+  // Mode, interrupt flags and source port don't affect the simulation
+  void writeSnMR(SOCKET, uint8_t) {}
+  void writeSnIR(SOCKET, uint8_t) {}
+  void writeSnPORT(SOCKET, uint16_t) {}
+
+  void writeSnDIPR(SOCKET s, const uint8_t *address) {
+    memcpy(_sockets[s].address, address, 4);
+  }
+  void writeSnDPORT(SOCKET s, uint16_t port) { _sockets[s].port = port; }
+
+  void execCmdSn(SOCKET s, SockCMD cmd) {
+    Socket &socket = _sockets[s];
+    switch (cmd) {
+    case Sock_OPEN:
+      socket.status = SnSR::INIT;
+      break;
+    case Sock_CONNECT: {
+      char host[16];
+      snprintf(host, sizeof(host), "%u.%u.%u.%u", socket.address[0],
+               socket.address[1], socket.address[2], socket.address[3]);
+      socket.key = Mock::serverKey(host, socket.port);
+      socket.status = SnSR::SYNSENT;
+      socket.startMs = millis();
+      Mock::socketConnects.push_back({socket.key, socket.startMs});
+      break;
+    }
+    default: // DISCON, CLOSE
+      socket.status = SnSR::CLOSED;
+      break;
+    }
+  }
+
+  uint8_t readSnSR(SOCKET s) {
+    Socket &socket = _sockets[s];
+    if (socket.status == SnSR::SYNSENT) {
+      Mock::Server *server = Mock::findServer(socket.key);
+      if (server != nullptr && server->mode != Mock::HostMode::BLACKHOLE &&
+          millis() - socket.startMs >= server->latencyMs) {
+        socket.status = server->mode == Mock::HostMode::ACCEPT
+                            ? SnSR::ESTABLISHED
+                            : SnSR::CLOSED;
+      }
+    }
+    return socket.status;
+  }
+
+  /// @brief Sockets not closed (probes leaking a socket show up here)
+  int openSockets() const {
+    int open = 0;
+    for (const Socket &socket : _sockets) {
+      open += socket.status != SnSR::CLOSED;
+    }
+    return open;
+  }
+
+private:
+  struct Socket {
+    uint8_t status = SnSR::CLOSED;
+    uint8_t address[4] = {0, 0, 0, 0};
+    uint16_t port = 0;
+    unsigned long startMs = 0;
+    std::string key;
+  };
+  Socket _sockets[MAX_SOCK_NUM];
+};
+
+inline W5100Class W5100;
+
+/// @brief UDP socket; only DNS queries get answers
+class EthernetUDP {
+public:
+  uint8_t begin(uint16_t port) {
+    (void)port;
+    _open = true;
+    return 1;
+  }
+  void stop() {
+    _open = false;
+    _queries.clear();
+    _rx.clear();
+  }
+
+  int beginPacket(IPAddress ip, uint16_t port) {
+    (void)ip;
+    _tx.clear();
+    _txPort = port;
+    return _open ? 1 : 0;
+  }
+  size_t write(const uint8_t *buffer, size_t size) {
+    _tx.append(reinterpret_cast<const char *>(buffer), size);
+    return size;
+  }
+  int endPacket() {
+    if (_txPort == 53) {
+      Mock::dnsQueries++;
+      _queries.push_back({_tx, millis()});
+    }
+    return 1;
+  }
+
+  /// @brief Next answer whose round trip has passed (the server answers
+  /// every query it gets, retransmissions too)
+  int parsePacket() {
+    _rx.clear();
+    if (Mock::dnsDown || _queries.empty() ||
+        millis() - _queries.front().sentMs < Mock::dnsLatencyMs) {
+      return 0;
+    }
+    _rx = Mock::answerDns(_queries.front().data);
+    _queries.pop_front();
+    return (int)_rx.size();
+  }
+  int available() { return (int)_rx.size(); }
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  int read(uint8_t *buffer, size_t size) {
+    size_t n = std::min(size, _rx.size());
+    memcpy(buffer, _rx.data(), n);
+    _rx.erase(0, n);
+    return (int)n;
+  }
+  uint16_t remotePort() { return 53; }
+
+private:
+  struct Query {
+    std::string data;
+    unsigned long sentMs;
+  };
+  bool _open = false;
+  std::string _tx;
+  uint16_t _txPort = 0;
+  std::deque<Query> _queries;
+  std::string _rx;
+};
+
+/// @brief The interface settings DnsLookup's callers read
+class EthernetClass {
+public:
+  IPAddress dnsServerIP() { return _dnsServer; }
+  void setDnsServerIP(const IPAddress &address) { _dnsServer = address; }
+
+private:
+  IPAddress _dnsServer = IPAddress(10, 0, 0, 1);
+};
+
+inline EthernetClass Ethernet;
@@ -0,0 +1,57 @@
+/**
+ * Counts heap allocations, for tests that check a code path doesn't
+ * allocate. Replaces the global operator new/delete, so include it from
+ * exactly one file of a test.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+namespace HeapCounter {
+size_t allocations = 0; // Calls to operator new
+size_t live = 0;        // Bytes currently allocated
+size_t peak = 0;        // Most bytes allocated at once
+
+/// @brief Start a measurement: counts and peak from here
+inline void reset() {
+  allocations = 0;
+  peak = live;
+}
+} // namespace HeapCounter
+
+// Each block carries its size in front so delete can account for it
+void *operator new(size_t size) {
+  size_t *block = static_cast<size_t *>(malloc(sizeof(max_align_t) + size));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *block = size;
+  HeapCounter::allocations++;
+  HeapCounter::live += size;
+  if (HeapCounter::live > HeapCounter::peak) {
+    HeapCounter::peak = HeapCounter::live;
+  }
+  return reinterpret_cast<char *>(block) + sizeof(max_align_t);
+}
+
+void operator delete(void *pointer) noexcept {
+  if (pointer == nullptr) {
+    return;
+  }
+  size_t *block = reinterpret_cast<size_t *>(static_cast<char *>(pointer) -
+                                             sizeof(max_align_t));
+  HeapCounter::live -= *block;
+  free(block);
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *pointer) noexcept { operator delete(pointer); }
+void operator delete(void *pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+void operator delete[](void *pointer, size_t) noexcept {
+  operator delete(pointer);
+}
@@ -0,0 +1,156 @@
+/**
+ * Host stand-in for LittleFS: files live in memory
+ *
+ * A capacity limit lets tests fill the filesystem: writes past it come
+ * back short, as on a full flash.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class LittleFSClass;
+
+class File : public Stream {
+public:
+  File() {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  int available() override {
+    return _data ? (int)(_data->size() - _position) : 0;
+  }
+  int read() override {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t read(uint8_t *buffer, size_t size) {
+    size_t n = available() < (int)size ? available() : size;
+    if (n > 0) {
+      memcpy(buffer, _data->data() + _position, n);
+      _position += n;
+    }
+    return n;
+  }
+  int peek() override {
+    return available() > 0 ? (uint8_t)(*_data)[_position] : -1;
+  }
+
+  bool seek(uint32_t position) {
+    if (!_data || position > _data->size()) {
+      return false;
+    }
+    _position = position;
+    return true;
+  }
+  size_t position() const { return _position; }
+  size_t size() const { return _data ? _data->size() : 0; }
+  bool truncate(uint32_t size) {
+    if (!_data || size > _data->size()) {
+      return false;
+    }
+    _data->resize(size);
+    _position = _position < size ? _position : size;
+    return true;
+  }
+  void close() { _data.reset(); }
+  operator bool() const { return (bool)_data; }
+
+private:
+  friend class LittleFSClass;
+  std::shared_ptr<std::string> _data;
+  size_t _position = 0;
+  bool _writable = false;
+};
+
+class LittleFSClass {
+public:
+  /// @brief Bytes the files may hold in total
+  size_t capacity = 1024 * 1024;
+
+  bool begin() { return true; }
+  void end() {}
+  bool format() {
+    _files.clear();
+    return true;
+  }
+
+  File open(const char *path, const char *mode) {
+    File file;
+    auto it = _files.find(path);
+    if (mode[0] == 'r' && mode[1] != '+') {
+      if (it == _files.end()) {
+        return file;
+      }
+      file._data = it->second;
+      return file;
+    }
+    if (it == _files.end() || mode[0] == 'w') {
+      _files[path] = std::make_shared<std::string>();
+    }
+    file._data = _files[path];
+    file._writable = true;
+    file._position = mode[0] == 'a' ? file._data->size() : 0;
+    return file;
+  }
+
+  bool exists(const char *path) { return _files.count(path) > 0; }
+  bool remove(const char *path) { return _files.erase(path) > 0; }
+  bool rename(const char *from, const char *to) {
+    auto it = _files.find(from);
+    if (it == _files.end()) {
+      return false;
+    }
+    _files[to] = it->second;
+    _files.erase(from);
+    return true;
+  }
+
+  size_t usedBytes() const {
+    size_t used = 0;
+    for (const auto &entry : _files) {
+      used += entry.second->size();
+    }
+    return used;
+  }
+  bool info(FSInfo &info) {
+    memset(&info, 0, sizeof(info));
+    info.totalBytes = capacity;
+    info.usedBytes = usedBytes();
+    return true;
+  }
+
+private:
+  std::map<std::string, std::shared_ptr<std::string>> _files;
+};
+
+inline LittleFSClass LittleFS;
+
+inline size_t File::write(const uint8_t *buffer, size_t size) {
+  if (!_data || !_writable) {
+    return 0;
+  }
+  size_t used = LittleFS.usedBytes();
+  size_t room = LittleFS.capacity > used ? LittleFS.capacity - used : 0;
+  size_t n = size < room ? size : room;
+  if (_position + n > _data->size()) {
+    _data->resize(_position + n);
+  }
+  memcpy(&(*_data)[_position], buffer, n);
+  _position += n;
+  return n;
+}
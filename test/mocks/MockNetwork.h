@@ -0,0 +1,213 @@
+/**
+ * Simulated servers for the host tests
+ *
+ * Both the W5500 socket registers (Ethernet_Generic.hpp) and the WebSocket
+ * library (WebSocketsClient.h) look servers up here by address and port,
+ * so a test can make a host answer, refuse or swallow connections, and
+ * script the Socket.IO traffic it sends. Host names are resolved by a
+ * simulated DNS server (EthernetUDP queries to port 53). Browsers
+ * connecting to the device's own web server are PeerClients.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace Mock {
+
+/// @brief How a server answers a TCP connect
+enum class HostMode {
+  ACCEPT,    // SYN/ACK after latencyMs
+  REFUSE,    // RST after latencyMs (and a live connection is reset)
+  BLACKHOLE, // No answer at all (and a live connection goes silent)
+};
+
+struct Server {
+  HostMode mode = HostMode::ACCEPT;
+  unsigned long latencyMs = 2; // Connect and WebSocket ping round trip
+
+  // Socket.IO behaviour: an Engine.IO open packet on connect, an answer to
+  // the namespace connect ("40") and a ping every pingIntervalMs
+  bool socketIO = true;
+  uint32_t pingIntervalMs = 25000;
+  uint32_t pingTimeoutMs = 20000;
+
+  std::deque<std::string> outbox; // Text frames still to send to the client
+  uint32_t connects = 0;          // WebSocket connections accepted
+  uint32_t received = 0;          // Text frames the client sent
+  std::string lastReceived;
+
+  /// @brief Queue a text frame for the connected client
+  void send(const char *text) { outbox.push_back(text); }
+};
+
+/// @brief Servers by "address:port"
+inline std::map<std::string, Server> servers;
+
+/// @brief How long the WebSocket library blocks in a connect that nobody
+/// answers (its own TCP timeout), during which loop() does not return
+inline unsigned long libraryConnectTimeoutMs = 5000;
+
+/// @brief TCP connects issued through the W5500 sockets (probes), with the
+/// time each was started
+struct ConnectRecord {
+  std::string key;
+  unsigned long timeMs;
+};
+inline std::deque<ConnectRecord> socketConnects;
+
+inline std::string serverKey(const char *host, uint16_t port) {
+  return std::string(host) + ":" + std::to_string(port);
+}
+
+inline Server &addServer(const char *host, uint16_t port) {
+  return servers[serverKey(host, port)];
+}
+
+/// @brief Look up a server; unknown hosts behave like a black hole
+inline Server *findServer(const std::string &key) {
+  auto it = servers.find(key);
+  return it != servers.end() ? &it->second : nullptr;
+}
+
+inline HostMode modeOf(const std::string &key) {
+  Server *server = findServer(key);
+  return server != nullptr ? server->mode : HostMode::BLACKHOLE;
+}
+
+/// @brief Connections browsers opened to the device's web server
+inline uint32_t peersOpened = 0;
+
+/// @brief The DNS server: names it knows (anything else is NXDOMAIN), its
+/// round trip, and whether it answers at all
+inline std::map<std::string, std::string> hostNames;
+inline unsigned long dnsLatencyMs = 2;
+inline bool dnsDown = false;
+inline uint32_t dnsQueries = 0; // Queries sent, retransmissions included
+
+/// @brief Forget all servers, names and connect records
+inline void resetNetwork() {
+  servers.clear();
+  socketConnects.clear();
+  peersOpened = 0;
+  hostNames.clear();
+  dnsLatencyMs = 2;
+  dnsDown = false;
+  dnsQueries = 0;
+}
+
+/// @brief Answer a DNS query as the simulated server would: an A record
+/// for a known name (TTL 60 s), otherwise NXDOMAIN
+inline std::string answerDns(const std::string &query) {
+  std::string answer = query;
+  if (answer.size() < 12) {
+    return std::string();
+  }
+  std::string name;
+  for (size_t i = 12; i < query.size() && query[i] != 0;
+       i += 1 + (uint8_t)query[i]) {
+    if (!name.empty()) {
+      name += ".";
+    }
+    name += query.substr(i + 1, (uint8_t)query[i]);
+  }
+
+  auto it = hostNames.find(name);
+  IPAddress address;
+  bool found = it != hostNames.end() && address.fromString(it->second.c_str());
+  answer[2] = (char)(0x80 | query[2]); // Response, recursion desired echoed
+  answer[3] = (char)(found ? 0x80 : 0x83); // Recursion available, NXDOMAIN
+  answer[7] = found ? 1 : 0;
+  if (found) {
+    const uint8_t record[] = {0xC0, 12,   // Name: pointer to the question
+                              0,    1,    // Type A
+                              0,    1,    // Class IN
+                              0,    0,    0, 60, // TTL
+                              0,    4,    // Address length
+                              address[0], address[1], address[2], address[3]};
+    answer.append(reinterpret_cast<const char *>(record), sizeof(record));
+  }
+  return answer;
+}
+
+/// @brief One browser connection to the device's web server, as the server
+/// sees it (what EthernetServer::available() returns). Copies refer to the
+/// same socket and compare equal, like EthernetClient's socket number.
+class PeerClient : public Client {
+public:
+  struct Socket {
+    std::string toServer;   // Sent by the browser and not read yet
+    std::string fromServer; // Written by the server
+    bool closed = false;    // Closed by the server
+    uint32_t writes = 0;    // Server write() calls (one SPI burst each)
+  };
+
+  PeerClient() {}
+
+  /// @brief Open a new connection from a browser
+  static PeerClient open() {
+    peersOpened++;
+    PeerClient client;
+    client._socket = std::make_shared<Socket>();
+    return client;
+  }
+
+  Socket &socket() { return *_socket; }
+
+  /// @brief Queue bytes sent by the browser
+  void send(const std::string &data) { _socket->toServer += data; }
+
+  bool operator==(const PeerClient &other) const {
+    return _socket == other._socket;
+  }
+
+  int available() override {
+    return _socket != nullptr ? (int)_socket->toServer.size() : 0;
+  }
+  int read() override {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  int read(uint8_t *buffer, size_t size) override {
+    if (_socket == nullptr || _socket->toServer.empty()) {
+      return -1;
+    }
+    size_t n = std::min(size, _socket->toServer.size());
+    memcpy(buffer, _socket->toServer.data(), n);
+    _socket->toServer.erase(0, n);
+    return (int)n;
+  }
+  int peek() override {
+    return available() > 0 ? (uint8_t)_socket->toServer[0] : -1;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    if (_socket == nullptr || _socket->closed) {
+      return 0;
+    }
+    _socket->fromServer.append(reinterpret_cast<const char *>(buffer), size);
+    _socket->writes++;
+    return size;
+  }
+  using Print::write;
+  uint8_t connected() override {
+    return _socket != nullptr && !_socket->closed;
+  }
+  void stop() override {
+    if (_socket != nullptr) {
+      _socket->closed = true;
+    }
+  }
+  operator bool() override { return _socket != nullptr; }
+
+private:
+  std::shared_ptr<Socket> _socket;
+};
+
+} // namespace Mock
@@ -0,0 +1,29 @@
+/**
+ * Host stand-in for the Arduino SPI library (transactions do nothing)
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+    (void)clock;
+    (void)bitOrder;
+    (void)dataMode;
+  }
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void beginTransaction(const SPISettings &settings) { (void)settings; }
+  void endTransaction() {}
+};
+
+inline SPIClass SPI;
+inline SPIClass SPI1;
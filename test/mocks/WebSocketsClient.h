@@ -0,0 +1,182 @@
+/**
+ * Host stand-in for the links2004 WebSocketsClient
+ *
+ * Connects to the simulated servers in MockNetwork.h from loop(), like the
+ * real library: a server that accepts gets a connection (and, for
+ * Socket.IO, the Engine.IO handshake and pings); one that refuses fails
+ * at once; one that never answers blocks loop() for the library's connect
+ * timeout, which the test clock shows.
+ */
+
+#pragma once
+
+#include "MockNetwork.h"
+#include <Arduino.h>
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG,
+} WStype_t;
+
+class WebSocketsClient {
+public:
+  typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t *payload,
+                                       size_t length);
+
+  void begin(const char *host, uint16_t port, const char *url = "/",
+             const char *protocol = "arduino") {
+    (void)protocol;
+    _key = Mock::serverKey(host, port);
+    _url = url;
+    _begun = true;
+    _connected = false;
+    _nextAttemptMs = millis();
+  }
+
+  void onEvent(WebSocketClientEvent callback) { _callback = callback; }
+  void setReconnectInterval(unsigned long ms) { _reconnectIntervalMs = ms; }
+  bool isConnected() { return _connected; }
+
+  void loop() {
+    if (!_begun) {
+      return;
+    }
+    if (!_connected) {
+      if ((long)(millis() - _nextAttemptMs) >= 0) {
+        connect();
+      }
+      return;
+    }
+
+    Mock::Server *server = Mock::findServer(_key);
+    Mock::HostMode mode =
+        server != nullptr ? server->mode : Mock::HostMode::BLACKHOLE;
+    if (mode == Mock::HostMode::REFUSE) {
+      closed(); // Reset by the server
+      return;
+    }
+    if (mode == Mock::HostMode::BLACKHOLE) {
+      return; // Crashed or unplugged: nothing arrives any more
+    }
+
+    unsigned long now = millis();
+    if (server->socketIO && now - _lastServerPingMs >= server->pingIntervalMs) {
+      _lastServerPingMs = now;
+      server->send("2");
+    }
+    if (_pongPending && now - _pingSentMs >= server->latencyMs) {
+      _pongPending = false;
+      event(WStype_PONG, "");
+    }
+    while (_connected && !server->outbox.empty()) {
+      std::string frame = server->outbox.front();
+      server->outbox.pop_front();
+      event(WStype_TEXT, frame.c_str(), frame.size());
+    }
+  }
+
+  void disconnect() {
+    if (_connected) {
+      closed();
+    }
+  }
+
+  bool sendTXT(const char *payload) {
+    if (!_connected) {
+      return false;
+    }
+    Mock::Server *server = Mock::findServer(_key);
+    if (server == nullptr || server->mode != Mock::HostMode::ACCEPT) {
+      return true; // Sent into the void
+    }
+    server->received++;
+    server->lastReceived = payload;
+    if (server->socketIO && strcmp(payload, "40") == 0) {
+      server->send("40{\"sid\":\"namespace\"}");
+    }
+    return true;
+  }
+  bool sendTXT(String &payload) { return sendTXT(payload.c_str()); }
+
+  bool sendPing(uint8_t *payload = nullptr, size_t length = 0) {
+    (void)payload;
+    (void)length;
+    if (!_connected) {
+      return false;
+    }
+    _pingSentMs = millis();
+    _pongPending = true;
+    return true;
+  }
+
+private:
+  WebSocketClientEvent _callback = nullptr;
+  std::string _key;
+  std::string _url;
+  bool _begun = false;
+  bool _connected = false;
+  unsigned long _reconnectIntervalMs = 500;
+  unsigned long _nextAttemptMs = 0;
+  unsigned long _lastServerPingMs = 0;
+  unsigned long _pingSentMs = 0;
+  bool _pongPending = false;
+
+  void event(WStype_t type, const char *payload, size_t length) {
+    if (_callback != nullptr) {
+      _callback(type, reinterpret_cast<uint8_t *>(const_cast<char *>(payload)),
+                length);
+    }
+  }
+  void event(WStype_t type, const char *payload) {
+    event(type, payload, strlen(payload));
+  }
+
+  void connect() {
+    Mock::Server *server = Mock::findServer(_key);
+    Mock::HostMode mode =
+        server != nullptr ? server->mode : Mock::HostMode::BLACKHOLE;
+    if (mode != Mock::HostMode::ACCEPT) {
+      // The library's connect is synchronous: a refusal costs a round
+      // trip, an unanswered SYN its whole timeout
+      Mock::advanceMs(mode == Mock::HostMode::REFUSE
+                          ? server->latencyMs
+                          : Mock::libraryConnectTimeoutMs);
+      _nextAttemptMs = millis() + _reconnectIntervalMs;
+      event(WStype_DISCONNECTED, "");
+      return;
+    }
+
+    Mock::advanceMs(server->latencyMs);
+    _connected = true;
+    _pongPending = false;
+    _lastServerPingMs = millis();
+    server->connects++;
+    server->outbox.clear();
+    event(WStype_CONNECTED, _url.c_str());
+    if (server->socketIO) {
+      char open[128];
+      snprintf(open, sizeof(open),
+               "0{\"sid\":\"session\",\"upgrades\":[],\"pingInterval\":%u,"
+               "\"pingTimeout\":%u,\"maxPayload\":1000000}",
+               (unsigned int)server->pingIntervalMs,
+               (unsigned int)server->pingTimeoutMs);
+      server->send(open);
+    }
+  }
+
+  void closed() {
+    _connected = false;
+    _pongPending = false;
+    _nextAttemptMs = millis() + _reconnectIntervalMs;
+    event(WStype_DISCONNECTED, "");
+  }
+};
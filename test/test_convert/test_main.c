@@ -0,0 +1,387 @@
+/**
+ * Host tests for the Protomatter bitplane converters
+ *
+ * Builds the library core for the host and checks every element the 565
+ * and mask converters write (byte, word and long layouts; 1-6 bitplanes;
+ * tiled and serpentine chains; parallel chains; all rotations; partial row
+ * updates) against a model of the HUB75 data stream written out pixel by
+ * pixel. Also times the table-driven path against the bit-test loops.
+ *
+ * Compiled without a GPIO toggle register (plain data format); the
+ * test_convert_toggle suite builds this same file with one (the toggle
+ * format the RP2040 uses).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+// Host "PORT": one 32-bit register set, pin N is bit N
+static volatile uint32_t hostRegisters[4];
+
+#ifndef ARDUINO
+#define ARDUINO
+#endif
+#define _PM_timerFreq 1000000
+#define _PM_portOutRegister(pin) ((void *)&hostRegisters[0])
+#define _PM_portSetRegister(pin) (&hostRegisters[1])
+#define _PM_portClearRegister(pin) (&hostRegisters[2])
+#if defined(CONVERT_TOGGLE)
+#define _PM_portToggleRegister(pin) (&hostRegisters[3])
+#endif
+#define _PM_portBitMask(pin) (1UL << (pin))
+#define _PM_byteOffset(pin) ((pin) / 8)
+#define _PM_wordOffset(pin) ((pin) / 16)
+#define _PM_timerInit(core) ((void)(core))
+
+#include "core.c"
+
+// Timer hooks declared in core.h; nothing is refreshed on the host
+void _PM_timerStart(Protomatter_core *core, uint32_t period) {
+  (void)core;
+  (void)period;
+}
+uint32_t _PM_timerStop(Protomatter_core *core) {
+  (void)core;
+  return 0;
+}
+uint32_t _PM_timerGetCount(Protomatter_core *core) {
+  (void)core;
+  return 0;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Pin sets (6 per chain, clock last) that make _PM_begin() pick each
+// element size. The long one is this project's RP2040 wiring.
+static uint8_t bytePins[] = {13, 9, 11, 8, 12, 10, 14};
+static uint8_t wordPins[] = {4, 5, 6, 9, 10, 11, 0, 1, 2, 3, 7, 8, 15};
+static uint8_t longPins[] = {16, 17, 20, 6, 19, 25, 0, 1, 2, 3, 4, 5, 22};
+static uint8_t addrPins[] = {26, 27, 28, 29, 30};
+static int timerDummy;
+
+static uint32_t rng = 1;
+static uint32_t nextRandom(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+typedef struct {
+  Protomatter_core core;
+  uint8_t *pins; // RGB pins of all chains
+  uint8_t clockPin;
+  uint16_t width;  // Matrix (chain) width in pixels
+  uint16_t height; // Parallel * tiles * row pairs * 2
+  uint32_t portShift; // Bit offset of the element within the PORT
+  uint32_t bitplaneSize;
+  uint8_t pad;
+  char name[96];
+} Matrix;
+
+static void matrixBegin(Matrix *m, uint8_t bytes, uint8_t planes,
+                        int8_t tile, uint16_t width, uint8_t addrLines,
+                        uint8_t parallel) {
+  uint8_t *pins = bytes == 1 ? bytePins : bytes == 2 ? wordPins : longPins;
+  uint8_t rgb[12];
+  memcpy(rgb, pins, 6 * parallel);
+  m->pins = pins;
+  m->clockPin = pins[bytes == 1 ? 6 : 12];
+  memset(&m->core, 0, sizeof(m->core));
+  TEST_ASSERT_EQUAL_INT(PROTOMATTER_OK,
+                        _PM_init(&m->core, width, planes, parallel, rgb,
+                                 addrLines, addrPins, m->clockPin, 31, 31,
+                                 false, tile, &timerDummy));
+  TEST_ASSERT_EQUAL_INT(PROTOMATTER_OK, _PM_begin(&m->core));
+  TEST_ASSERT_EQUAL_UINT8(bytes, m->core.bytesPerElement);
+
+  m->width = width;
+  m->height = parallel * abs(tile) * (2 << addrLines);
+  m->portShift = bytes == 4 ? 0 : (pins[0] / (8 * bytes)) * 8 * bytes;
+  m->bitplaneSize = (m->core.chainBits + 7) / 8 * 8;
+  m->pad = m->bitplaneSize - m->core.chainBits;
+  snprintf(m->name, sizeof(m->name),
+           "%u-byte, %u planes, tile %d, %ux%u, %u chain(s)", bytes, planes,
+           tile, width, m->height, parallel);
+}
+
+static void matrixEnd(Matrix *m) { _PM_deallocate(&m->core); }
+
+// ---------------------------------------------------------------------------
+// Model: what the matrix must be sent, from a canvas in scan order (width x
+// height, chain 0's tiles on top, no rotation)
+
+static uint32_t pinMask(const Matrix *m, uint8_t chain, uint8_t i) {
+  return (uint32_t)(1UL << m->pins[chain * 6 + i]) >> m->portShift;
+}
+
+// Color bits of a 565 pixel shown in a plane: red, green, blue in bits 0-2
+static uint8_t planeBits(uint16_t rgb, uint8_t plane, uint8_t planes) {
+  uint8_t r = rgb >> 11, g = (rgb >> 5) & 0x3F, b = rgb & 0x1F;
+  uint8_t r6, b6, g6 = g;
+  if (planes == 6) {
+    r6 = (r << 1) | (r >> 4); // 5 to 6 bits, MSB repeated as LSB
+    b6 = (b << 1) | (b >> 4);
+  } else {
+    r6 = r << 1; // Plane 0 shows the numPlanes'th bit from the top
+    b6 = b << 1;
+    plane += 6 - planes;
+  }
+  return ((r6 >> plane) & 1) | (((g6 >> plane) & 1) << 1) |
+         (((b6 >> plane) & 1) << 2);
+}
+
+// RGB pin bits of shift register bit j (0 = shifted in first) of a row pair
+// and plane. Data shifts right to left, bottom tile first; the pad comes
+// first and is dark.
+static uint32_t shiftBits(const Matrix *m, const uint16_t *canvas,
+                          uint8_t row, uint8_t plane, uint32_t j) {
+  if (j < m->pad)
+    return 0;
+  uint32_t k = j - m->pad;
+  uint8_t tiles = abs(m->core.tile);
+  uint8_t rows = m->core.numRowPairs;
+  int tile = tiles - 1 - k / m->width;
+  uint32_t x = k % m->width;
+  uint32_t bits = 0;
+  for (uint8_t chain = 0; chain < m->core.parallel; chain++) {
+    uint32_t top = (chain * tiles + tile) * rows * 2, upperY, lowerY;
+    uint32_t px = x;
+    if ((tile & 1) && m->core.tile < 0) { // Serpentine: this tile is rotated
+      lowerY = top + rows - 1 - row;
+      upperY = lowerY + rows;
+      px = m->width - 1 - x;
+    } else {
+      upperY = top + row;
+      lowerY = upperY + rows;
+    }
+    uint8_t upper = planeBits(canvas[upperY * m->width + px], plane,
+                              m->core.numPlanes);
+    uint8_t lower = planeBits(canvas[lowerY * m->width + px], plane,
+                              m->core.numPlanes);
+    for (uint8_t i = 0; i < 3; i++) {
+      if (upper & (1 << i))
+        bits |= pinMask(m, chain, i);
+      if (lower & (1 << i))
+        bits |= pinMask(m, chain, i + 3);
+    }
+  }
+  return bits;
+}
+
+// Buffer element for bit j. With a toggle register each element holds the
+// bits that change from the previous one, clock included (except the first,
+// so the clock idles low).
+static uint32_t expected(const Matrix *m, const uint16_t *canvas, uint8_t row,
+                         uint8_t plane, uint32_t j) {
+  uint32_t bits = shiftBits(m, canvas, row, plane, j);
+#if defined(CONVERT_TOGGLE)
+  if (j > 0) {
+    uint32_t clock = (uint32_t)(1UL << m->clockPin) >> m->portShift;
+    bits ^= shiftBits(m, canvas, row, plane, j - 1) ^ clock;
+  }
+#endif
+  return bits;
+}
+
+static uint32_t element(const Matrix *m, uint32_t index) {
+  switch (m->core.bytesPerElement) {
+  case 1:
+    return ((uint8_t *)m->core.screenData)[index];
+  case 2:
+    return ((uint16_t *)m->core.screenData)[index];
+  default:
+    return ((uint32_t *)m->core.screenData)[index];
+  }
+}
+
+// Compare the row pairs in rowMask with the model of canvas
+static void checkRows(const Matrix *m, const uint16_t *canvas,
+                      uint32_t rowMask, const char *what) {
+  for (uint8_t row = 0; row < m->core.numRowPairs; row++) {
+    if (!(rowMask & (1UL << row)))
+      continue;
+    for (uint8_t plane = 0; plane < m->core.numPlanes; plane++) {
+      uint32_t base = (row * m->core.numPlanes + plane) * m->bitplaneSize;
+      for (uint32_t j = 0; j < m->bitplaneSize; j++) {
+        uint32_t want = expected(m, canvas, row, plane, j);
+        uint32_t got = element(m, base + j);
+        if (got != want) {
+          char message[200];
+          snprintf(message, sizeof(message),
+                   "%s, rotation %u, %s: row %u plane %u element %u", m->name,
+                   m->core.rotation, what, row, plane, j);
+          TEST_ASSERT_EQUAL_HEX32_MESSAGE(want, got, message);
+        }
+      }
+    }
+  }
+}
+
+// Canvas as drawn (rotated the way GFX's setRotation() draws) holding the
+// scan-order image. Rotations 1 and 3 swap width and height.
+static void rotate(const Matrix *m, const uint16_t *scan, uint16_t *drawn,
+                   uint8_t rotation) {
+  uint16_t w = m->width, h = m->height;
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++) {
+      uint32_t index;
+      switch (rotation) {
+      case 1:
+        index = (w - 1 - x) * h + y;
+        break;
+      case 2:
+        index = (h - 1 - y) * w + (w - 1 - x);
+        break;
+      case 3:
+        index = x * h + (h - 1 - y);
+        break;
+      default:
+        index = y * w + x;
+      }
+      drawn[index] = scan[y * w + x];
+    }
+  }
+}
+
+static void randomImage(uint16_t *image, uint32_t pixels) {
+  for (uint32_t i = 0; i < pixels; i++)
+    image[i] = (nextRandom() & 3) ? (uint16_t)nextRandom() : 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static void checkConfig(uint8_t bytes, uint8_t planes, int8_t tile,
+                        uint16_t width, uint8_t addrLines, uint8_t parallel) {
+  Matrix m;
+  matrixBegin(&m, bytes, planes, tile, width, addrLines, parallel);
+  uint32_t pixels = (uint32_t)m.width * m.height;
+  uint16_t *a = malloc(pixels * 2), *b = malloc(pixels * 2);
+  uint16_t *drawn = malloc(pixels * 2), *masked = malloc(pixels * 2);
+  uint8_t *mask = malloc(pixels / 8 + 1);
+  uint32_t all = (1UL << m.core.numRowPairs) - 1;
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    _PM_setRotation(&m.core, rotation);
+    randomImage(a, pixels);
+    randomImage(b, pixels);
+
+    // Full frame
+    rotate(&m, a, drawn, rotation);
+    _PM_convert_565(&m.core, drawn, m.width);
+    checkRows(&m, a, all, "full frame");
+
+    // Some rows of another frame; the rest must be left alone
+    uint32_t rowMask = nextRandom() & all;
+    rotate(&m, b, drawn, rotation);
+    _PM_convert_565_rows(&m.core, drawn, m.width, rowMask);
+    checkRows(&m, b, rowMask, "changed rows");
+    checkRows(&m, a, all & ~rowMask, "unchanged rows");
+
+    // A 1-bit mask in one color, where supported
+    uint16_t color = (uint16_t)nextRandom() | 0x8421;
+    for (uint32_t i = 0; i < pixels; i++)
+      masked[i] = (nextRandom() & 1) ? color : 0;
+    rotate(&m, masked, drawn, rotation);
+    memset(mask, 0, pixels / 8 + 1);
+    for (uint32_t i = 0; i < pixels; i++) {
+      if (drawn[i])
+        mask[i >> 3] |= 0x80 >> (i & 7);
+    }
+    uint16_t maskWidth = (rotation & 1) ? m.height : m.width;
+    bool supported = planes <= 5 && parallel == 1 && !(maskWidth & 7);
+    bool converted = _PM_convert_mask(&m.core, mask, m.width, color, all);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(supported, converted, m.name);
+    checkRows(&m, converted ? masked : b, rowMask, "mask");
+  }
+
+  free(a);
+  free(b);
+  free(drawn);
+  free(masked);
+  free(mask);
+  matrixEnd(&m);
+}
+
+static void test_single_chain(void) {
+  static const int8_t tiles[] = {1, 2, -2, -3};
+  for (uint8_t bytes = 1; bytes <= 4; bytes *= 2) {
+    for (uint8_t planes = 1; planes <= 6; planes++) {
+      for (uint8_t t = 0; t < sizeof(tiles); t++) {
+        checkConfig(bytes, planes, tiles[t], 64, 4, 1);
+        checkConfig(bytes, planes, tiles[t], 70, 3, 1); // Padded rows
+        checkConfig(bytes, planes, tiles[t], 33, 2, 1);
+      }
+    }
+  }
+}
+
+static void test_parallel_chains(void) {
+  static const int8_t tiles[] = {1, 2, -2};
+  for (uint8_t bytes = 2; bytes <= 4; bytes *= 2) {
+    for (uint8_t planes = 1; planes <= 6; planes++) {
+      for (uint8_t t = 0; t < sizeof(tiles); t++) {
+        checkConfig(bytes, planes, tiles[t], 64, 4, 2);
+        checkConfig(bytes, planes, tiles[t], 40, 3, 2);
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// ns per full frame of the 64x32 panel this project drives
+static double timeFrame(uint8_t planes, bool useMask) {
+  Matrix m;
+  matrixBegin(&m, 4, planes, 1, 64, 4, 1);
+  static uint16_t canvas[64 * 32];
+  static uint8_t mask[64 * 32 / 8];
+  randomImage(canvas, 64 * 32);
+  for (uint32_t i = 0; i < sizeof(mask); i++)
+    mask[i] = (uint8_t)nextRandom();
+
+  const int frames = 2000;
+  double start = seconds();
+  for (int i = 0; i < frames; i++) {
+    if (useMask)
+      _PM_convert_mask(&m.core, mask, 64, 0xFFE0, 0xFFFFFFFF);
+    else
+      _PM_convert_565(&m.core, canvas, 64);
+  }
+  double ns = (seconds() - start) / frames * 1e9;
+  matrixEnd(&m);
+  return ns;
+}
+
+static void test_benchmark(void) {
+  // 6 planes always take the bit-test loops, 5 or fewer the table path;
+  // per plane the two are directly comparable
+  double table = timeFrame(5, false);
+  double loops = timeFrame(6, false);
+  double mask = timeFrame(4, true);
+  char line[160];
+  snprintf(line, sizeof(line),
+           "64x32 frame (host): table path %.0f ns (%.0f ns/plane), "
+           "bit-test loops %.0f ns (%.0f ns/plane), 4-plane mask %.0f ns",
+           table, table / 5, loops, loops / 6, mask);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_TRUE(table / 5 < loops / 6);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_chain);
+  RUN_TEST(test_parallel_chains);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
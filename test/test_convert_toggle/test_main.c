@@ -0,0 +1,9 @@
+/**
+ * Host tests for the Protomatter bitplane converters, toggle format
+ *
+ * The test_convert suite built with a GPIO toggle register, as on the
+ * RP2040: each buffer element holds the bits that change.
+ */
+
+#define CONVERT_TOGGLE
+#include "../test_convert/test_main.c"
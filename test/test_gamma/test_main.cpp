@@ -0,0 +1,106 @@
+/**
+ * Host tests for the gamma lookup tables
+ *
+ * Compares every table (bit depths 1-6) with the exact 2.2 curve from
+ * <cmath> and reports the largest and mean error in levels of that depth,
+ * and checks the case the tables were built for: orange and yellow, which
+ * uncorrected and truncated to 4 planes lit green for almost the same time.
+ */
+
+#include "Gamma.h"
+#include <cmath>
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+// Level the table stores for a value at a depth
+static int level(uint8_t value, uint8_t depth) {
+  return Gamma::correct(value, depth) >> (8 - depth);
+}
+
+// Exact on-time of a value, in levels of a depth
+static double exact(int value, uint8_t depth) {
+  return std::pow(value / 255.0, (double)Gamma::GAMMA) * ((1 << depth) - 1);
+}
+
+static void test_error_per_depth() {
+  for (uint8_t depth = Gamma::MIN_DEPTH; depth <= Gamma::MAX_DEPTH; depth++) {
+    double maxError = 0;
+    double totalError = 0;
+    for (int v = 0; v < 256; v++) {
+      double error = std::fabs(level(v, depth) - exact(v, depth));
+      maxError = std::max(maxError, error);
+      totalError += error;
+    }
+    double meanError = totalError / 256;
+
+    char line[96];
+    snprintf(line, sizeof(line),
+             "%u planes: max error %.3f levels, mean %.3f levels (%.2f%% of "
+             "full scale)",
+             depth, maxError, meanError,
+             100.0 * meanError / ((1 << depth) - 1));
+    TEST_MESSAGE(line);
+
+    // Rounded to the nearest level, so never more than half a level off
+    TEST_ASSERT_TRUE_MESSAGE(maxError <= 0.5 + 1e-6, line);
+    TEST_ASSERT_TRUE_MESSAGE(meanError < 0.3, line);
+
+    // Black and full scale are exact, and no level is skipped backwards
+    TEST_ASSERT_EQUAL_INT(0, level(0, depth));
+    TEST_ASSERT_EQUAL_INT((1 << depth) - 1, level(255, depth));
+    for (int v = 1; v < 256; v++) {
+      TEST_ASSERT_TRUE(level(v, depth) >= level(v - 1, depth));
+    }
+  }
+}
+
+static void test_orange_and_yellow_at_4_planes() {
+  // Orange #FFA500 and yellow #FFFF00 differ only in green
+  const uint8_t depth = 4;
+  int orange = level(165, depth);
+  int yellow = level(255, depth);
+
+  // Truncated without correction, orange's green was 10 of 15 levels: two
+  // thirds of yellow's on-time, which looks almost as bright
+  TEST_ASSERT_EQUAL_INT(10, 165 >> (8 - depth));
+
+  // Corrected it is the level nearest the exact curve, well apart
+  char line[80];
+  snprintf(line, sizeof(line),
+           "Orange green: level %d (exact %.2f), yellow: level %d", orange,
+           exact(165, depth), yellow);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_INT(6, orange);
+  TEST_ASSERT_EQUAL_INT(15, yellow);
+  TEST_ASSERT_TRUE(std::fabs(orange - exact(165, depth)) <= 0.5);
+
+  // And the RGB565 colors the display draws differ
+  TEST_ASSERT_TRUE(Gamma::color565(255, 165, 0, depth) !=
+                   Gamma::color565(255, 255, 0, depth));
+}
+
+static void test_color565_packing() {
+  // Red and blue have 5 bits in RGB565, so 6 planes use the 5-bit table
+  TEST_ASSERT_EQUAL_HEX32(0xFFFF, Gamma::color565(255, 255, 255, 6));
+  TEST_ASSERT_EQUAL_HEX32(0x0000, Gamma::color565(0, 0, 0, 6));
+  TEST_ASSERT_EQUAL_HEX32(Gamma::correct(200, 5) >> 3,
+                          Gamma::color565(0, 0, 200, 6));
+  TEST_ASSERT_EQUAL_HEX32((Gamma::correct(200, 6) & 0xFC) << 3,
+                          Gamma::color565(0, 200, 0, 6));
+
+  // Depths outside 1-6 are clamped
+  for (int v = 0; v < 256; v++) {
+    TEST_ASSERT_EQUAL_UINT8(Gamma::correct(v, 1), Gamma::correct(v, 0));
+    TEST_ASSERT_EQUAL_UINT8(Gamma::correct(v, 6), Gamma::correct(v, 8));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_error_per_depth);
+  RUN_TEST(test_orange_and_yellow_at_4_planes);
+  RUN_TEST(test_color565_packing);
+  return UNITY_END();
+}
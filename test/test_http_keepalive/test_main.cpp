@@ -0,0 +1,181 @@
+/**
+ * Host benchmark for persistent HTTP connections
+ *
+ * Drives the web server's connection pool with simulated browsers
+ * (MockNetwork's PeerClient) polling /api/status, and compares requests per
+ * second and sockets opened when every request closes its connection (the
+ * server's behaviour before keep-alive), when the connection is kept alive,
+ * and when requests are pipelined. Each TCP handshake and each request
+ * round trip costs RTT_MS on the test clock; host CPU time is reported
+ * separately.
+ */
+
+#include "HttpConnection.h"
+#include "MockNetwork.h"
+#include <chrono>
+#include <string>
+#include <unity.h>
+
+typedef HttpConnectionPool<Mock::PeerClient, 2> Pool;
+
+// LAN round trip between a browser and the W5500
+static const unsigned long RTT_MS = 2;
+static const uint32_t REQUESTS = 640;
+
+static uint8_t txBuffer[HTTP_TX_BUFFER_SIZE];
+
+void setUp() {
+  Mock::resetNetwork();
+  Mock::nowUs = 0;
+}
+void tearDown() {}
+
+// A status poll answered like GET /api/status
+static void dispatch(const HttpRequest &request, HttpResponseWriter &out) {
+  (void)request;
+  out.begin(200, "application/json");
+  out.print("{\"state\":\"running\",\"time\":\"2:31\",\"round\":2,"
+            "\"color\":\"#00ff00\"}");
+  out.end();
+}
+
+static size_t countResponses(const std::string &data) {
+  size_t count = 0;
+  for (size_t pos = data.find("HTTP/1.1 200"); pos != std::string::npos;
+       pos = data.find("HTTP/1.1 200", pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+struct Result {
+  uint32_t sockets;    // Connections the server accepted
+  uint32_t writes;     // Server socket writes
+  double simulatedRps; // Requests per second of test-clock time
+  double hostRps;      // Requests per second of host CPU time
+};
+
+// Serve REQUESTS polls, batch at a time per round trip, reconnecting
+// whenever the server closes the connection
+static Result run(const char *name, bool keepAlive, uint32_t batch) {
+  std::string request = "GET /api/status HTTP/1.1\r\nHost: timer.local\r\n";
+  if (!keepAlive) {
+    request += "Connection: close\r\n";
+  }
+  request += "\r\n";
+
+  Mock::resetNetwork();
+  Mock::nowUs = 0;
+  Pool pool;
+  Result result = {};
+  Mock::PeerClient client;
+  uint32_t answered = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  while (answered < REQUESTS) {
+    if (!client || !client.connected()) {
+      if (client) {
+        result.writes += client.socket().writes;
+      }
+      client = Mock::PeerClient::open();
+      Mock::advanceMs(RTT_MS); // SYN, SYN/ACK
+    }
+    uint32_t count = std::min(batch, REQUESTS - answered);
+    for (uint32_t i = 0; i < count; i++) {
+      client.send(request);
+    }
+    Mock::advanceMs(RTT_MS); // Requests out, responses back
+
+    pool.accept(client);
+    pool.serviceAll(txBuffer, sizeof(txBuffer), dispatch);
+
+    // Requests behind one that closed the connection go unanswered and are
+    // sent again on the next one
+    size_t responses = countResponses(client.socket().fromServer);
+    TEST_ASSERT_TRUE_MESSAGE(responses > 0, name);
+    answered += responses;
+    client.socket().fromServer.clear();
+  }
+  result.writes += client.socket().writes;
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  result.sockets = pool.getConnectionsOpened();
+  result.simulatedRps = answered / (Mock::nowUs / 1e6);
+  result.hostRps = answered / elapsed;
+  TEST_ASSERT_EQUAL_UINT32(REQUESTS, pool.getRequestsServed());
+  TEST_ASSERT_EQUAL_UINT32(Mock::peersOpened, result.sockets);
+
+  char line[160];
+  snprintf(line, sizeof(line),
+           "%-16s %4u sockets, %4u writes, %6.0f req/s at %lu ms RTT, "
+           "%.0f req/s host CPU",
+           name, (unsigned int)result.sockets, (unsigned int)result.writes,
+           result.simulatedRps, RTT_MS, result.hostRps);
+  TEST_MESSAGE(line);
+  return result;
+}
+
+static void test_close_keepalive_pipelined() {
+  Result close = run("close/request", false, 1);
+  Result keepAlive = run("keep-alive", true, 1);
+  Result pipelined = run("pipelined x8", true, 8);
+
+  // The baseline pays a socket and a handshake for every request
+  TEST_ASSERT_EQUAL_UINT32(REQUESTS, close.sockets);
+
+  // Kept-alive connections are recycled every KEEPALIVE_MAX_REQUESTS
+  uint32_t recycled = (REQUESTS + Pool::KEEPALIVE_MAX_REQUESTS - 1) /
+                      Pool::KEEPALIVE_MAX_REQUESTS;
+  TEST_ASSERT_EQUAL_UINT32(recycled, keepAlive.sockets);
+  TEST_ASSERT_EQUAL_UINT32(recycled, pipelined.sockets);
+
+  // No handshake per request: close to twice the rate; pipelining answers a
+  // whole batch per round trip
+  TEST_ASSERT_TRUE(keepAlive.simulatedRps > 1.8 * close.simulatedRps);
+  TEST_ASSERT_TRUE(pipelined.simulatedRps > 6 * keepAlive.simulatedRps);
+
+  // Pipelined responses still go out one write each
+  TEST_ASSERT_EQUAL_UINT32(REQUESTS, pipelined.writes);
+}
+
+static void test_idle_connection_closed() {
+  Pool pool;
+  Mock::PeerClient client = Mock::PeerClient::open();
+  client.send("GET /api/status HTTP/1.1\r\n\r\n");
+  pool.accept(client);
+  pool.serviceAll(txBuffer, sizeof(txBuffer), dispatch);
+  TEST_ASSERT_TRUE(client.connected());
+  TEST_ASSERT_EQUAL_UINT8(1, pool.getOpenCount());
+
+  Mock::advanceMs(Pool::KEEPALIVE_TIMEOUT_MS + 1);
+  pool.serviceAll(txBuffer, sizeof(txBuffer), dispatch);
+  TEST_ASSERT_FALSE(client.connected());
+  TEST_ASSERT_EQUAL_UINT8(0, pool.getOpenCount());
+}
+
+static void test_least_recently_used_recycled() {
+  // A third browser takes the slot of the one idle the longest
+  Pool pool;
+  Mock::PeerClient clients[3];
+  for (Mock::PeerClient &client : clients) {
+    client = Mock::PeerClient::open();
+    client.send("GET /api/status HTTP/1.1\r\n\r\n");
+    pool.accept(client);
+    pool.serviceAll(txBuffer, sizeof(txBuffer), dispatch);
+    Mock::advanceMs(10);
+  }
+  TEST_ASSERT_FALSE(clients[0].connected());
+  TEST_ASSERT_TRUE(clients[1].connected());
+  TEST_ASSERT_TRUE(clients[2].connected());
+  TEST_ASSERT_EQUAL_UINT8(2, pool.getOpenCount());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_close_keepalive_pipelined);
+  RUN_TEST(test_idle_connection_closed);
+  RUN_TEST(test_least_recently_used_recycled);
+  return UNITY_END();
+}
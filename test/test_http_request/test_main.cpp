@@ -0,0 +1,293 @@
+/**
+ * Host tests for the block-reading HTTP request parser
+ *
+ * Delivers requests split at every byte offset (the W5500 hands over
+ * whatever arrived, so a read can end anywhere) and checks the result
+ * matches a one-shot parse, and that bodies the server can't frame are
+ * rejected. Also measures parse throughput and checks the parser never
+ * touches the heap.
+ */
+
+#include "HeapCounter.h"
+#include "HttpRequest.h"
+#include <Client.h>
+#include <chrono>
+#include <string>
+#include <unity.h>
+
+// Hands out a scripted byte stream, only up to what has "arrived"
+class ScriptedClient : public Client {
+public:
+  std::string data;
+  size_t pos = 0;
+  size_t arrived = 0;
+
+  void load(const std::string &request) {
+    data = request;
+    pos = 0;
+    arrived = 0;
+  }
+  void arrive(size_t count) {
+    arrived = arrived + count < data.size() ? arrived + count : data.size();
+  }
+
+  int available() override { return (int)(arrived - pos); }
+  int read() override { return pos < arrived ? (uint8_t)data[pos++] : -1; }
+  int read(uint8_t *buffer, size_t size) override {
+    size_t n = arrived - pos < size ? arrived - pos : size;
+    memcpy(buffer, data.data() + pos, n);
+    pos += n;
+    return (int)n;
+  }
+  int peek() override { return pos < arrived ? (uint8_t)data[pos] : -1; }
+  size_t write(uint8_t c) override {
+    (void)c;
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    (void)buffer;
+    return size;
+  }
+  using Print::write;
+  uint8_t connected() override { return 1; }
+  void stop() override {}
+  operator bool() override { return true; }
+};
+
+// Owned copy of a parsed request, so results of two parses can be compared
+struct Parsed {
+  std::string method, path, query, body;
+  size_t length = 0;
+  bool keepAlive = false;
+  bool http11 = false;
+
+  bool operator==(const Parsed &o) const {
+    return method == o.method && path == o.path && query == o.query &&
+           body == o.body && length == o.length && keepAlive == o.keepAlive &&
+           http11 == o.http11;
+  }
+};
+
+static Parsed copy(const HttpRequest &request) {
+  Parsed parsed;
+  parsed.method = request.method;
+  parsed.path = request.path;
+  parsed.query = request.query;
+  parsed.body.assign(request.body, request.bodyLength);
+  parsed.length = request.length;
+  parsed.keepAlive = request.keepAlive;
+  parsed.http11 = request.http11;
+  return parsed;
+}
+
+static char rxBuffer[HTTP_RX_BUFFER_SIZE];
+static ScriptedClient client;
+
+void setUp() {}
+void tearDown() {}
+
+static const char *const REQUESTS[] = {
+    // CRLF line endings, keep-alive by default
+    "GET /api/status?verbose=1 HTTP/1.1\r\n"
+    "Host: timer.local\r\n"
+    "Accept: */*\r\n\r\n",
+    // Form body
+    "POST /api/settings HTTP/1.1\r\n"
+    "Host: timer.local\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 29\r\n"
+    "Connection: close\r\n\r\n"
+    "brightness=80&name=Arena+%231",
+    // Bare LF line endings, HTTP/1.0
+    "GET / HTTP/1.0\n"
+    "User-Agent: probe\n\n",
+    // Mixed: LF then CRLF before the blank line
+    "GET /favicon.ico HTTP/1.1\n"
+    "Connection: close\r\n\r\n",
+};
+
+// Deliver a request in two parts, split at offset, polling after each
+static bool parseSplit(const std::string &request, size_t split,
+                       Parsed &parsed) {
+  HttpRequestReader reader(rxBuffer, sizeof(rxBuffer));
+  HttpRequest result;
+  client.load(request);
+
+  client.arrive(split);
+  HttpRequestReader::Status status = reader.poll(client, result);
+  if (status == HttpRequestReader::Status::READY) {
+    // Only legitimate if everything up to the end had already arrived
+    parsed = copy(result);
+    return split >= result.length;
+  }
+  if (status != HttpRequestReader::Status::INCOMPLETE) {
+    return false;
+  }
+  client.arrive(request.size());
+  if (reader.poll(client, result) != HttpRequestReader::Status::READY) {
+    return false;
+  }
+  parsed = copy(result);
+  return true;
+}
+
+static void test_split_at_every_offset() {
+  for (const char *text : REQUESTS) {
+    std::string request = text;
+    Parsed expected;
+    TEST_ASSERT_TRUE(parseSplit(request, request.size(), expected));
+
+    for (size_t split = 0; split <= request.size(); split++) {
+      Parsed parsed;
+      char message[96];
+      snprintf(message, sizeof(message), "Request \"%.20s...\" split at %u",
+               text, (unsigned int)split);
+      TEST_ASSERT_TRUE_MESSAGE(parseSplit(request, split, parsed), message);
+      TEST_ASSERT_TRUE_MESSAGE(parsed == expected, message);
+    }
+  }
+}
+
+static void test_byte_at_a_time() {
+  for (const char *text : REQUESTS) {
+    std::string request = text;
+    Parsed expected;
+    TEST_ASSERT_TRUE(parseSplit(request, request.size(), expected));
+
+    HttpRequestReader reader(rxBuffer, sizeof(rxBuffer));
+    HttpRequest result;
+    HttpRequestReader::Status status = HttpRequestReader::Status::INCOMPLETE;
+    client.load(request);
+    while (status == HttpRequestReader::Status::INCOMPLETE &&
+           client.arrived < request.size()) {
+      client.arrive(1);
+      status = reader.poll(client, result);
+    }
+    TEST_ASSERT_TRUE(status == HttpRequestReader::Status::READY);
+    TEST_ASSERT_TRUE(copy(result) == expected);
+  }
+}
+
+static void test_parsed_fields() {
+  Parsed get, post, http10;
+  TEST_ASSERT_TRUE(parseSplit(REQUESTS[0], 0, get));
+  TEST_ASSERT_EQUAL_STRING("GET", get.method.c_str());
+  TEST_ASSERT_EQUAL_STRING("/api/status", get.path.c_str());
+  TEST_ASSERT_EQUAL_STRING("verbose=1", get.query.c_str());
+  TEST_ASSERT_TRUE(get.keepAlive);
+  TEST_ASSERT_TRUE(get.http11);
+
+  TEST_ASSERT_TRUE(parseSplit(REQUESTS[1], 0, post));
+  TEST_ASSERT_EQUAL_STRING("brightness=80&name=Arena+%231", post.body.c_str());
+  TEST_ASSERT_FALSE(post.keepAlive);
+
+  TEST_ASSERT_TRUE(parseSplit(REQUESTS[2], 0, http10));
+  TEST_ASSERT_FALSE(http10.keepAlive);
+  TEST_ASSERT_FALSE(http10.http11);
+}
+
+static void test_pipelined_requests() {
+  std::string stream = std::string(REQUESTS[0]) + REQUESTS[1] + REQUESTS[3];
+  HttpRequestReader reader(rxBuffer, sizeof(rxBuffer));
+  HttpRequest result;
+  client.load(stream);
+  client.arrive(stream.size());
+
+  const char *paths[] = {"/api/status", "/api/settings", "/favicon.ico"};
+  for (const char *path : paths) {
+    TEST_ASSERT_TRUE(reader.poll(client, result) ==
+                     HttpRequestReader::Status::READY);
+    TEST_ASSERT_EQUAL_STRING(path, result.path);
+    reader.consume(result.length);
+  }
+  TEST_ASSERT_FALSE(reader.hasPartial());
+}
+
+static HttpRequestReader::Status parseStatus(const char *text) {
+  HttpRequestReader reader(rxBuffer, sizeof(rxBuffer));
+  HttpRequest result;
+  client.load(text);
+  client.arrive(strlen(text));
+  return reader.poll(client, result);
+}
+
+static void test_content_length_validation() {
+  using Status = HttpRequestReader::Status;
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length: 3 \r\n\r\nabc") ==
+                   Status::READY);
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length: 3x\r\n\r\nabc") ==
+                   Status::MALFORMED);
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length: -1\r\n\r\n") ==
+                   Status::MALFORMED);
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length:\r\n\r\n") ==
+                   Status::MALFORMED);
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length: 3\r\n"
+                               "Content-Length: 4\r\n\r\nabcd") ==
+                   Status::MALFORMED);
+  // Would wrap to a small value if accumulated in a size_t
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length: 18446744073709551619\r\n"
+                               "\r\nabc") == Status::TOO_LARGE);
+  TEST_ASSERT_TRUE(parseStatus("POST /x HTTP/1.1\r\n"
+                               "Content-Length: 100000\r\n\r\n") ==
+                   Status::TOO_LARGE);
+}
+
+static void test_chunked_body_rejected() {
+  // Must not be answered as a bodiless request: the chunks would then be
+  // read as the next request on the connection
+  TEST_ASSERT_TRUE(parseStatus("POST /api/settings HTTP/1.1\r\n"
+                               "Transfer-Encoding: chunked\r\n\r\n"
+                               "5\r\nhello\r\n0\r\n\r\n") ==
+                   HttpRequestReader::Status::UNSUPPORTED);
+}
+
+static void test_throughput_without_heap() {
+  const int rounds = 20000;
+  std::string request = REQUESTS[1];
+  HttpRequestReader reader(rxBuffer, sizeof(rxBuffer));
+  HttpRequest result;
+  size_t bytes = 0;
+  int ready = 0;
+
+  HeapCounter::reset();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    // Two reads per request, split inside the headers
+    client.load(request);
+    client.arrive(request.size() / 2);
+    reader.poll(client, result);
+    client.arrive(request.size());
+    ready += reader.poll(client, result) == HttpRequestReader::Status::READY;
+    reader.consume(result.length);
+    bytes += request.size();
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  size_t allocations = HeapCounter::allocations;
+
+  char line[128];
+  snprintf(line, sizeof(line), "%d requests in %.1f ms: %.0f req/s, %.1f MB/s",
+           rounds, elapsed * 1000, rounds / elapsed, bytes / elapsed / 1e6);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_INT(rounds, ready);
+  TEST_ASSERT_EQUAL_size_t(0, allocations);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_split_at_every_offset);
+  RUN_TEST(test_byte_at_a_time);
+  RUN_TEST(test_parsed_fields);
+  RUN_TEST(test_pipelined_requests);
+  RUN_TEST(test_content_length_validation);
+  RUN_TEST(test_chunked_body_rejected);
+  RUN_TEST(test_throughput_without_heap);
+  return UNITY_END();
+}
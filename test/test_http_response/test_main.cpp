@@ -0,0 +1,193 @@
+/**
+ * Host tests for the buffered HTTP response writer
+ *
+ * Counts the client writes (one W5500 SPI burst each) and bytes a response
+ * costs, against the unbuffered print() sequence the server used before,
+ * and checks the header overflow fallback and HTTP/1.0 bodies.
+ */
+
+#include "HttpResponse.h"
+#include <Client.h>
+#include <string>
+#include <unity.h>
+
+// Records what the writer sends instead of putting it on the wire
+class RecordingClient : public Client {
+public:
+  std::string data;
+  uint32_t writes = 0;
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    data.append(reinterpret_cast<const char *>(buffer), size);
+    writes++;
+    return size;
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int read(uint8_t *buffer, size_t size) override {
+    (void)buffer;
+    (void)size;
+    return -1;
+  }
+  int peek() override { return -1; }
+  uint8_t connected() override { return 1; }
+  void stop() override {}
+  operator bool() override { return true; }
+};
+
+static uint8_t txBuffer[HTTP_TX_BUFFER_SIZE];
+static RecordingClient client;
+
+void setUp() { client = RecordingClient(); }
+void tearDown() {}
+
+// The page is sent as many small fragments, like handleRoot() does
+static const char *const PAGE_PART =
+    "<div class='row'><label>Minutes</label><input id='m'></div>\n";
+static const int PAGE_PARTS = 80;
+
+// The response sequence the server used before the writer: every print()
+// and println() went to the socket on its own
+static void sendUnbuffered(int code, const char *contentType,
+                           const char *body, int parts) {
+  client.print("HTTP/1.1 ");
+  client.print(code);
+  client.println(code == 200 ? " OK" : " Error");
+  client.print("Content-Type: ");
+  client.println(contentType);
+  client.println("Connection: close");
+  client.println();
+  for (int i = 0; i < parts; i++) {
+    client.print(body);
+  }
+}
+
+static void sendBuffered(int code, const char *contentType, const char *body,
+                         int parts) {
+  HttpResponseWriter out(client, txBuffer, sizeof(txBuffer));
+  out.begin(code, contentType);
+  for (int i = 0; i < parts; i++) {
+    out.print(body);
+  }
+  out.end();
+}
+
+static void report(const char *name, uint32_t beforeWrites,
+                   size_t beforeBytes, uint32_t afterWrites,
+                   size_t afterBytes) {
+  char line[160];
+  snprintf(line, sizeof(line),
+           "%s: %u writes / %u bytes before, %u writes / %u bytes after",
+           name, (unsigned int)beforeWrites, (unsigned int)beforeBytes,
+           (unsigned int)afterWrites, (unsigned int)afterBytes);
+  TEST_MESSAGE(line);
+}
+
+static void test_small_json_response_is_one_write() {
+  const char *body = "{\"status\":\"ok\",\"running\":true}";
+  sendUnbuffered(200, "application/json", body, 1);
+  uint32_t beforeWrites = client.writes;
+  size_t beforeBytes = client.data.size();
+
+  client = RecordingClient();
+  sendBuffered(200, "application/json", body, 1);
+  report("JSON status", beforeWrites, beforeBytes, client.writes,
+         client.data.size());
+
+  TEST_ASSERT_EQUAL_UINT32(1, client.writes);
+  TEST_ASSERT_LESS_THAN_UINT32(beforeWrites, client.writes);
+  TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: 30\r\n"
+                           "Connection: close\r\n\r\n"
+                           "{\"status\":\"ok\",\"running\":true}",
+                           client.data.c_str());
+}
+
+static void test_page_is_sent_in_full_buffers() {
+  sendUnbuffered(200, "text/html", PAGE_PART, PAGE_PARTS);
+  uint32_t beforeWrites = client.writes;
+  size_t beforeBytes = client.data.size();
+
+  client = RecordingClient();
+  sendBuffered(200, "text/html", PAGE_PART, PAGE_PARTS);
+  report("Page", beforeWrites, beforeBytes, client.writes,
+         client.data.size());
+
+  // Every write but the last carries a full buffer of body
+  size_t bodyBytes = strlen(PAGE_PART) * PAGE_PARTS;
+  size_t perWrite = HTTP_TX_BUFFER_SIZE - HttpResponseWriter::HEADER_RESERVE;
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32((bodyBytes + perWrite - 1) / perWrite + 1,
+                                   client.writes);
+  TEST_ASSERT_LESS_THAN_UINT32(beforeWrites / 10, client.writes);
+  TEST_ASSERT_TRUE(client.data.find("Transfer-Encoding: chunked\r\n") !=
+                   std::string::npos);
+  TEST_ASSERT_TRUE(client.data.size() >= bodyBytes);
+  TEST_ASSERT_EQUAL_STRING("\r\n0\r\n\r\n",
+                           client.data.c_str() + client.data.size() - 7);
+}
+
+static void test_http10_body_ends_with_close() {
+  HttpResponseWriter out(client, txBuffer, sizeof(txBuffer));
+  out.setKeepAlive(true);
+  out.setHttp11(false);
+  out.begin(200, "text/html");
+  for (int i = 0; i < PAGE_PARTS; i++) {
+    out.print(PAGE_PART);
+  }
+  out.end();
+
+  size_t bodyBytes = strlen(PAGE_PART) * PAGE_PARTS;
+  const char *headers = "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: text/html\r\n"
+                        "Connection: close\r\n\r\n";
+  TEST_ASSERT_FALSE(out.getKeepAlive());
+  TEST_ASSERT_EQUAL_size_t(strlen(headers) + bodyBytes, client.data.size());
+  TEST_ASSERT_EQUAL_STRING_LEN(headers, client.data.c_str(), strlen(headers));
+  TEST_ASSERT_EQUAL_STRING_LEN(PAGE_PART, client.data.c_str() + strlen(headers),
+                               strlen(PAGE_PART));
+}
+
+static void test_oversized_headers_send_500() {
+  static char header[HttpResponseWriter::HEADER_RESERVE];
+  memset(header, 'x', sizeof(header) - 1);
+  header[sizeof(header) - 1] = '\0';
+  memcpy(header, "X-Long: ", 8);
+
+  const char *expected = "HTTP/1.1 500 Internal Server Error\r\n"
+                         "Content-Length: 0\r\n"
+                         "Connection: close\r\n\r\n";
+
+  // Body that fits: the error goes out alone
+  HttpResponseWriter out(client, txBuffer, sizeof(txBuffer));
+  out.setKeepAlive(true);
+  out.begin(200, "text/plain");
+  out.setExtraHeader(header);
+  out.print("dropped");
+  out.end();
+  TEST_ASSERT_FALSE(out.getKeepAlive());
+  TEST_ASSERT_EQUAL_UINT32(1, client.writes);
+  TEST_ASSERT_EQUAL_STRING(expected, client.data.c_str());
+
+  // Body that overflows the buffer: the rest of it is dropped too
+  client = RecordingClient();
+  out.begin(200, "text/html");
+  out.setExtraHeader(header);
+  for (int i = 0; i < PAGE_PARTS; i++) {
+    out.print(PAGE_PART);
+  }
+  out.end();
+  TEST_ASSERT_EQUAL_UINT32(1, client.writes);
+  TEST_ASSERT_EQUAL_STRING(expected, client.data.c_str());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_small_json_response_is_one_write);
+  RUN_TEST(test_page_is_sent_in_full_buffers);
+  RUN_TEST(test_http10_body_ends_with_close);
+  RUN_TEST(test_oversized_headers_send_500);
+  return UNITY_END();
+}
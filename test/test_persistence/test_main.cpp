@@ -0,0 +1,112 @@
+/**
+ * Host tests for when settings and captures reach flash
+ *
+ * Writes wait for the timer to stop, but only for so long: a change made
+ * early in a bout must be on flash well before the bout ends, or a reset
+ * loses it.
+ */
+
+#include "Capture.h"
+#include "SettingsPersistence.h"
+#include <LittleFS.h>
+#include <unity.h>
+
+static const char *PATH = "/test.bin";
+static uint8_t brightness = 0;
+
+static size_t writeSettings(Print &out, void *context) {
+  (void)context;
+  return out.write(&brightness, 1);
+}
+
+void setUp() {
+  Mock::nowUs = 0;
+  LittleFS.format();
+}
+void tearDown() {}
+
+// Run loop() iterations (one every 5 ms, as the display refresh allows) for
+// ms, returning when the save was written
+static bool runFor(SettingsPersistence &store, bool idle, unsigned long ms) {
+  unsigned long end = millis() + ms;
+  while (millis() < end) {
+    Mock::advanceMs(5);
+    if (store.service(idle, writeSettings, nullptr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void test_idle_save_after_quiet_period() {
+  SettingsPersistence store(PATH, 2000, 10000);
+  brightness = 80;
+  store.markDirty();
+  TEST_ASSERT_FALSE(runFor(store, true, 1990));
+  TEST_ASSERT_TRUE(runFor(store, true, 20));
+  TEST_ASSERT_TRUE(LittleFS.exists(PATH));
+  TEST_ASSERT_EQUAL_UINT32(0, store.getStats().forced);
+}
+
+static void test_running_save_deferred_then_forced() {
+  // Brightness changed mid-round: no write while the quiet period and the
+  // deferral last, then one in the next gap, long before a 5 minute bout
+  // would end
+  SettingsPersistence store(PATH, 2000, 10000);
+  brightness = 40;
+  store.markDirty();
+  TEST_ASSERT_FALSE(runFor(store, false, 11990));
+  TEST_ASSERT_TRUE(store.isDirty());
+  TEST_ASSERT_FALSE(LittleFS.exists(PATH));
+  TEST_ASSERT_TRUE(runFor(store, false, 20));
+  TEST_ASSERT_FALSE(store.isDirty());
+  TEST_ASSERT_EQUAL_UINT32(1, store.getStats().forced);
+
+  // The timer stopping in the meantime writes at once
+  brightness = 60;
+  store.markDirty();
+  TEST_ASSERT_FALSE(runFor(store, false, 3000));
+  TEST_ASSERT_TRUE(runFor(store, true, 5));
+  TEST_ASSERT_EQUAL_UINT32(1, store.getStats().forced);
+}
+
+static void test_slider_drag_coalesced_while_running() {
+  // Changes keep restarting the quiet period, so a drag is one write
+  SettingsPersistence store(PATH, 2000, 10000);
+  for (int i = 0; i < 50; i++) {
+    brightness = i;
+    store.markDirty();
+    TEST_ASSERT_FALSE(runFor(store, false, 100));
+  }
+  TEST_ASSERT_TRUE(runFor(store, false, 12005));
+  TEST_ASSERT_EQUAL_UINT32(1, store.getStats().writes);
+  TEST_ASSERT_EQUAL_UINT32(49, store.getStats().coalesced);
+}
+
+static void test_capture_flushed_mid_bout() {
+  Capture::clear();
+  Capture::setEnabled(true);
+  const char frame[] = "42[\"timer\",{\"running\":true}]";
+  Capture::record(1, (const uint8_t *)frame, sizeof(frame) - 1);
+
+  // A few frames never fill the buffer; without the cap they would wait
+  // for the end of the bout
+  unsigned long start = millis();
+  bool flushed = false;
+  while (!flushed && millis() - start < 60000) {
+    Mock::advanceMs(5);
+    flushed = Capture::service(false);
+  }
+  TEST_ASSERT_TRUE(flushed);
+  TEST_ASSERT_UINT32_WITHIN(10, 10000, millis() - start);
+  Capture::setEnabled(false);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_save_after_quiet_period);
+  RUN_TEST(test_running_save_deferred_then_forced);
+  RUN_TEST(test_slider_drag_coalesced_while_running);
+  RUN_TEST(test_capture_flushed_mid_bout);
+  return UNITY_END();
+}
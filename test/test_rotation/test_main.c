@@ -0,0 +1,153 @@
+/**
+ * Host tests for matrix rotation in the Protomatter converters
+ *
+ * Lights one pixel of the canvas as drawn at each rotation of this
+ * project's 64x32 panel and checks that exactly that LED's bits come out:
+ * the row pair, upper or lower half and column are worked out by hand from
+ * GFX's rotation convention (rotation 1 is a quarter turn clockwise, so the
+ * canvas origin is the panel's top right corner).
+ *
+ * Built without a GPIO toggle register so each buffer element holds the
+ * pin levels directly; test_convert covers the toggle encoding.
+ */
+
+#include <unity.h>
+
+static volatile uint32_t hostRegisters[3];
+
+#ifndef ARDUINO
+#define ARDUINO
+#endif
+#define _PM_timerFreq 1000000
+#define _PM_portOutRegister(pin) ((void *)&hostRegisters[0])
+#define _PM_portSetRegister(pin) (&hostRegisters[1])
+#define _PM_portClearRegister(pin) (&hostRegisters[2])
+#define _PM_portBitMask(pin) (1UL << (pin))
+#define _PM_byteOffset(pin) ((pin) / 8)
+#define _PM_wordOffset(pin) ((pin) / 16)
+#define _PM_timerInit(core) ((void)(core))
+
+#include "core.c"
+
+void _PM_timerStart(Protomatter_core *core, uint32_t period) {
+  (void)core;
+  (void)period;
+}
+uint32_t _PM_timerStop(Protomatter_core *core) {
+  (void)core;
+  return 0;
+}
+uint32_t _PM_timerGetCount(Protomatter_core *core) {
+  (void)core;
+  return 0;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// The panel as main.cpp wires it
+#define WIDTH 64
+#define HEIGHT 32
+#define ROW_PAIRS 16
+static uint8_t rgbPins[] = {16, 17, 20, 6, 19, 25};
+static uint8_t addrPins[] = {29, 28, 27, 26};
+static int timerDummy;
+
+#define UPPER ((1UL << 16) | (1UL << 17) | (1UL << 20))
+#define LOWER ((1UL << 6) | (1UL << 19) | (1UL << 25))
+
+typedef struct {
+  uint8_t rotation;
+  uint8_t x, y;       // On the canvas as drawn (32x64 for rotations 1 and 3)
+  uint8_t rowPair;    // Where the LED is on the panel
+  uint32_t half;      // UPPER or LOWER
+  uint8_t column;
+} LitPixel;
+
+static const LitPixel cases[] = {
+    {0, 5, 3, 3, UPPER, 5},     // Panel (5, 3)
+    {0, 63, 31, 15, LOWER, 63}, // Bottom right
+    {1, 5, 3, 5, UPPER, 60},    // Panel (63 - 3, 5)
+    {1, 31, 0, 15, LOWER, 63},  // Canvas top right is the panel's bottom right
+    {1, 0, 63, 0, UPPER, 0},    // Canvas bottom left is the panel's top left
+    {2, 5, 3, 12, LOWER, 58},   // Panel (63 - 5, 31 - 3)
+    {2, 0, 0, 15, LOWER, 63},
+    {3, 5, 3, 10, LOWER, 3},    // Panel (3, 31 - 5)
+    {3, 0, 0, 15, LOWER, 0},    // Canvas origin is the panel's bottom left
+    {3, 31, 63, 0, UPPER, 63},
+};
+
+static Protomatter_core core;
+
+static void begin(uint8_t planes) {
+  memset(&core, 0, sizeof(core));
+  TEST_ASSERT_EQUAL_INT(PROTOMATTER_OK,
+                        _PM_init(&core, WIDTH, planes, 1, rgbPins, 4,
+                                 addrPins, 22, 1, 0, false, 1, &timerDummy));
+  TEST_ASSERT_EQUAL_INT(PROTOMATTER_OK, _PM_begin(&core));
+  TEST_ASSERT_EQUAL_UINT8(4, core.bytesPerElement);
+}
+
+// Every element is dark except the one LED, which is white in every plane
+static void checkLit(const LitPixel *lit, const char *path) {
+  const uint32_t *data = (const uint32_t *)core.screenData;
+  char message[96];
+  for (uint8_t row = 0; row < ROW_PAIRS; row++) {
+    for (uint8_t plane = 0; plane < core.numPlanes; plane++) {
+      for (uint8_t x = 0; x < WIDTH; x++) {
+        uint32_t want = 0;
+        if (row == lit->rowPair && x == lit->column)
+          want = lit->half;
+        snprintf(message, sizeof(message),
+                 "%s, rotation %u, canvas (%u, %u): row %u plane %u x %u",
+                 path, lit->rotation, lit->x, lit->y, row, plane, x);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(
+            want, data[(row * core.numPlanes + plane) * WIDTH + x], message);
+      }
+    }
+  }
+}
+
+static void checkRgb(uint8_t planes, const char *path) {
+  static uint16_t canvas[WIDTH * HEIGHT];
+  begin(planes);
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const LitPixel *lit = &cases[i];
+    uint16_t canvasWidth = (lit->rotation & 1) ? HEIGHT : WIDTH;
+    memset(canvas, 0, sizeof(canvas));
+    canvas[lit->y * canvasWidth + lit->x] = 0xFFFF;
+    _PM_setRotation(&core, lit->rotation);
+    _PM_convert_565(&core, canvas, WIDTH);
+    checkLit(lit, path);
+  }
+  _PM_deallocate(&core);
+}
+
+static void test_rotation_table_path(void) { checkRgb(4, "565 table"); }
+
+static void test_rotation_bit_test_path(void) { checkRgb(6, "565 loops"); }
+
+static void test_rotation_mask(void) {
+  static uint8_t mask[WIDTH * HEIGHT / 8];
+  begin(4);
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const LitPixel *lit = &cases[i];
+    uint16_t canvasWidth = (lit->rotation & 1) ? HEIGHT : WIDTH;
+    uint32_t bit = lit->y * canvasWidth + lit->x;
+    memset(mask, 0, sizeof(mask));
+    mask[bit >> 3] = 0x80 >> (bit & 7);
+    _PM_setRotation(&core, lit->rotation);
+    TEST_ASSERT_TRUE(_PM_convert_mask(&core, mask, WIDTH, 0xFFFF,
+                                      (1UL << ROW_PAIRS) - 1));
+    checkLit(lit, "mask");
+  }
+  _PM_deallocate(&core);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rotation_table_path);
+  RUN_TEST(test_rotation_bit_test_path);
+  RUN_TEST(test_rotation_mask);
+  return UNITY_END();
+}
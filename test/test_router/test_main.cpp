@@ -0,0 +1,174 @@
+/**
+ * Host tests for the compile-time HTTP route table
+ *
+ * Uses a table laid out like the web server's (exact paths sorted, then
+ * {param} patterns) with numbered handlers, and checks lookups by binary
+ * search, parameter capture, 404s and the Allow header sent with 405s.
+ */
+
+#include "HttpRouter.h"
+#include <unity.h>
+
+// Handlers are numbered so a match can be identified
+enum Handler {
+  NONE,
+  ROOT,
+  ACTION,
+  CONFIG_GET,
+  CONFIG_POST,
+  SETTINGS_GET,
+  SETTINGS_POST,
+  SETTINGS_PATCH,
+  STATUS,
+  THRESHOLDS,
+  THRESHOLD,
+  THRESHOLD_PUT,
+  CHAIN_ITEM,
+};
+
+constexpr Route<Handler> routes[] = {
+    {HTTP_GET, "/", ROOT},
+    {HTTP_POST, "/api", ACTION},
+    {HTTP_GET, "/api/config", CONFIG_GET},
+    {HTTP_POST, "/api/config", CONFIG_POST},
+    {HTTP_GET, "/api/settings", SETTINGS_GET},
+    {HTTP_POST, "/api/settings", SETTINGS_POST},
+    {HTTP_PATCH, "/api/settings", SETTINGS_PATCH},
+    {HTTP_GET, "/api/status", STATUS},
+    {HTTP_GET, "/api/thresholds", THRESHOLDS},
+    {HTTP_GET, "/api/thresholds/{index}", THRESHOLD},
+    {HTTP_PUT, "/api/thresholds/{index}", THRESHOLD_PUT},
+    {HTTP_GET, "/api/chains/{chain}/items/{item}", CHAIN_ITEM},
+};
+
+constexpr RouteTable<Handler, sizeof(routes) / sizeof(routes[0])>
+    routeTable(routes);
+static_assert(routeTable.isValid(), "Test table must be valid");
+
+// Tables isValid() must refuse
+constexpr Route<Handler> unsorted[] = {
+    {HTTP_GET, "/api/status", STATUS},
+    {HTTP_GET, "/api/config", CONFIG_GET},
+};
+static_assert(!RouteTable<Handler, 2>(unsorted).isValid(),
+              "Unsorted exact paths must be rejected");
+constexpr Route<Handler> patternFirst[] = {
+    {HTTP_GET, "/api/thresholds/{index}", THRESHOLD},
+    {HTTP_GET, "/api/status", STATUS},
+};
+static_assert(!RouteTable<Handler, 2>(patternFirst).isValid(),
+              "Exact paths after a pattern must be rejected");
+constexpr Route<Handler> duplicate[] = {
+    {HTTP_GET, "/api/status", STATUS},
+    {HTTP_GET, "/api/status", STATUS},
+};
+static_assert(!RouteTable<Handler, 2>(duplicate).isValid(),
+              "Duplicate routes must be rejected");
+
+void setUp() {}
+void tearDown() {}
+
+static RouteMatch<Handler> match(const char *method, const char *path) {
+  return routeTable.match(httpMethodFromString(method), path);
+}
+
+static void test_exact_paths() {
+  // Every exact route is found, including the first and last entries the
+  // binary search can land on
+  for (const Route<Handler> &route : routes) {
+    if (RouteTableDetail::isPattern(route.path)) {
+      continue;
+    }
+    RouteMatch<Handler> m = routeTable.match(route.method, route.path);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(RouteMatch<Handler>::FOUND, m.result,
+                                  route.path);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(route.handler, m.handler, route.path);
+    TEST_ASSERT_EQUAL_UINT8(0, m.params.count);
+  }
+
+  // Same path, method picks the handler
+  TEST_ASSERT_EQUAL_INT(SETTINGS_PATCH,
+                        match("PATCH", "/api/settings").handler);
+  TEST_ASSERT_EQUAL_INT(CONFIG_POST, match("POST", "/api/config").handler);
+}
+
+static void test_param_capture() {
+  RouteMatch<Handler> m = match("GET", "/api/thresholds/3");
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::FOUND, m.result);
+  TEST_ASSERT_EQUAL_INT(THRESHOLD, m.handler);
+  TEST_ASSERT_EQUAL_UINT8(1, m.params.count);
+  char value[8];
+  TEST_ASSERT_TRUE(m.params.get(0, value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("3", value);
+
+  m = match("PUT", "/api/thresholds/12");
+  TEST_ASSERT_EQUAL_INT(THRESHOLD_PUT, m.handler);
+  TEST_ASSERT_TRUE(m.params.get(0, value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("12", value);
+
+  // Two segments, and a value too long for the caller's buffer
+  m = match("GET", "/api/chains/left/items/1234567890");
+  TEST_ASSERT_EQUAL_INT(CHAIN_ITEM, m.handler);
+  TEST_ASSERT_EQUAL_UINT8(2, m.params.count);
+  TEST_ASSERT_TRUE(m.params.get(0, value, sizeof(value)));
+  TEST_ASSERT_EQUAL_STRING("left", value);
+  TEST_ASSERT_FALSE(m.params.get(1, value, sizeof(value)));
+  TEST_ASSERT_FALSE(m.params.get(2, value, sizeof(value)));
+
+  // A parameter is exactly one non-empty segment
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::NOT_FOUND,
+                        match("GET", "/api/thresholds/").result);
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::NOT_FOUND,
+                        match("GET", "/api/thresholds/3/extra").result);
+}
+
+static void test_unknown_path() {
+  const char *paths[] = {"/api/missing", "/api/statu", "/api/status/",
+                         "/a", "/zzz", ""};
+  for (const char *path : paths) {
+    RouteMatch<Handler> m = match("GET", path);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(RouteMatch<Handler>::NOT_FOUND, m.result,
+                                  path);
+    TEST_ASSERT_EQUAL_UINT8(0, m.allowed);
+  }
+}
+
+static void test_wrong_method() {
+  char allow[48];
+
+  RouteMatch<Handler> m = match("DELETE", "/api/settings");
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::METHOD_NOT_ALLOWED, m.result);
+  formatAllowHeader(m.allowed, allow, sizeof(allow));
+  TEST_ASSERT_EQUAL_STRING("Allow: GET, POST, PATCH", allow);
+
+  m = match("GET", "/api");
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::METHOD_NOT_ALLOWED, m.result);
+  formatAllowHeader(m.allowed, allow, sizeof(allow));
+  TEST_ASSERT_EQUAL_STRING("Allow: POST", allow);
+
+  // Pattern routes collect their methods the same way
+  m = match("POST", "/api/thresholds/2");
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::METHOD_NOT_ALLOWED, m.result);
+  formatAllowHeader(m.allowed, allow, sizeof(allow));
+  TEST_ASSERT_EQUAL_STRING("Allow: GET, PUT", allow);
+
+  // An unrecognised method token is a wrong method, not a missing path
+  m = match("BREW", "/api/status");
+  TEST_ASSERT_EQUAL_INT(RouteMatch<Handler>::METHOD_NOT_ALLOWED, m.result);
+  formatAllowHeader(m.allowed, allow, sizeof(allow));
+  TEST_ASSERT_EQUAL_STRING("Allow: GET", allow);
+
+  // A buffer too small for every method keeps whole names only
+  char small[20];
+  formatAllowHeader(HTTP_GET | HTTP_POST | HTTP_PATCH, small, sizeof(small));
+  TEST_ASSERT_EQUAL_STRING("Allow: GET, POST", small);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_exact_paths);
+  RUN_TEST(test_param_capture);
+  RUN_TEST(test_unknown_path);
+  RUN_TEST(test_wrong_method);
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+/**
+ * Host test for connecting to a black-holed FightTimer server
+ *
+ * A server that never answers the SYN used to stall loop() inside the
+ * WebSocket library's connect. With the TcpProbe in front, poll() must
+ * return at once every time, and retries must follow the jittered
+ * exponential backoff.
+ */
+
+#include "ConfigStore.h"
+#include "Timer.h"
+#include "WebSocketClient.h"
+#include <unity.h>
+#include <vector>
+
+// Mirrors the reconnect timing in WebSocketClient.cpp
+static const unsigned long PROBE_TIMEOUT_MS = 3000;
+static const unsigned long BACKOFF_BASE_MS = 2000;
+static const unsigned long MAX_BACKOFF_MS = 60000;
+
+static const char *const HOST = "10.0.0.9";
+static const uint16_t PORT = 8765;
+static const unsigned long MAX_STEP_MS = 5; // Simulated loop() period
+
+static Timer timer;
+
+void setUp() {
+  Mock::resetNetwork();
+  Mock::addServer(HOST, PORT).mode = Mock::HostMode::BLACKHOLE;
+  ConfigStore::setDefaults(ConfigStore::get());
+  randomSeed(42);
+}
+void tearDown() {}
+
+// Spread the loop period like a busy main loop does
+static void step() { Mock::advanceMs(1 + random(MAX_STEP_MS)); }
+
+static void test_library_alone_blocks() {
+  // What loop() looked like before: the library's connect blocks until
+  // its own timeout
+  WebSocketsClient library;
+  library.begin(HOST, PORT, "/socket.io/?EIO=4&transport=websocket");
+  unsigned long before = millis();
+  library.loop();
+  unsigned long blocked = millis() - before;
+
+  char line[80];
+  snprintf(line, sizeof(line), "Library connect blocked loop() for %lu ms",
+           blocked);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_UINT32(Mock::libraryConnectTimeoutMs, blocked);
+}
+
+static void test_poll_never_blocks() {
+  WebSocketClient client(&timer);
+  client.connect(HOST, PORT, "/socket.io/");
+
+  unsigned long longest = 0;
+  unsigned long end = millis() + 10 * 60000UL;
+  while (millis() < end) {
+    unsigned long before = micros();
+    client.poll();
+    unsigned long blocked = micros() - before;
+    if (blocked > longest) {
+      longest = blocked;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, W5100.openSockets());
+    step();
+  }
+
+  char line[80];
+  snprintf(line, sizeof(line), "Longest poll() over 10 min: %lu us, %u probes",
+           longest, (unsigned int)Mock::socketConnects.size());
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_UINT32(0, longest);
+  TEST_ASSERT_FALSE(client.isConnected());
+}
+
+static void test_retries_back_off() {
+  WebSocketClient client(&timer);
+  client.connect(HOST, PORT, "/socket.io/");
+
+  unsigned long end = millis() + 10 * 60000UL;
+  while (millis() < end) {
+    client.poll();
+    step();
+  }
+
+  // Attempt n waits the probe timeout, then a delay in [ceiling / 2,
+  // ceiling] with ceiling = base * 2^min(n, 5), capped
+  std::vector<unsigned long> gaps;
+  for (size_t i = 1; i < Mock::socketConnects.size(); i++) {
+    TEST_ASSERT_EQUAL_STRING(Mock::serverKey(HOST, PORT).c_str(),
+                             Mock::socketConnects[i].key.c_str());
+    gaps.push_back(Mock::socketConnects[i].timeMs -
+                   Mock::socketConnects[i - 1].timeMs);
+  }
+  TEST_ASSERT_GREATER_OR_EQUAL(8, gaps.size());
+
+  for (size_t i = 0; i < gaps.size(); i++) {
+    unsigned int doublings = min(i + 1, (size_t)5);
+    unsigned long ceiling = min(BACKOFF_BASE_MS << doublings, MAX_BACKOFF_MS);
+    char message[64];
+    snprintf(message, sizeof(message), "Gap %u: %lu ms", (unsigned int)i,
+             gaps[i]);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(
+        PROBE_TIMEOUT_MS + ceiling / 2, gaps[i], message);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(
+        PROBE_TIMEOUT_MS + ceiling + 2 * MAX_STEP_MS, gaps[i], message);
+    // Until the cap the ranges don't overlap, so the waits only grow
+    if (i > 0 && ceiling < MAX_BACKOFF_MS) {
+      TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(gaps[i - 1], gaps[i],
+                                                  message);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_library_alone_blocks);
+  RUN_TEST(test_poll_never_blocks);
+  RUN_TEST(test_retries_back_off);
+  return UNITY_END();
+}
@@ -0,0 +1,126 @@
+/**
+ * Host test for connecting to a FightTimer server configured by name
+ *
+ * The WebSocket library resolves a host name with a DNS query it waits
+ * for, then connects synchronously. The client must resolve the name with
+ * a DnsLookup first, probe the address it got and hand the library that
+ * address, so poll() never waits on DNS or on the connect, whether the
+ * server answers, is black-holed, or the DNS server is down.
+ */
+
+#include "ConfigStore.h"
+#include "Timer.h"
+#include "WebSocketClient.h"
+#include <unity.h>
+
+static const char *const NAME = "fighttimer.lan";
+static const char *const HOST = "10.0.0.9";
+static const uint16_t PORT = 8765;
+static const unsigned long MAX_STEP_MS = 5; // Simulated loop() period
+
+static Timer timer;
+
+void setUp() {
+  Mock::resetNetwork();
+  Mock::hostNames[NAME] = HOST;
+  ConfigStore::setDefaults(ConfigStore::get());
+  randomSeed(42);
+}
+void tearDown() {}
+
+// Poll for ms of test time; returns the longest time one poll() took
+static unsigned long run(WebSocketClient &client, unsigned long ms) {
+  unsigned long longest = 0;
+  unsigned long end = millis() + ms;
+  while (millis() < end) {
+    unsigned long before = micros();
+    client.poll();
+    unsigned long blocked = micros() - before;
+    if (blocked > longest) {
+      longest = blocked;
+    }
+    Mock::advanceMs(1 + random(MAX_STEP_MS));
+  }
+  return longest;
+}
+
+static void test_name_resolved_then_connected() {
+  Mock::Server &server = Mock::addServer(HOST, PORT);
+  WebSocketClient client(&timer);
+  client.connect(NAME, PORT, "/socket.io/");
+
+  // The library only blocks for its (simulated) connect round trip
+  unsigned long longest = run(client, 1000);
+  TEST_ASSERT_TRUE(client.isConnected());
+  TEST_ASSERT_EQUAL_UINT32(1, server.connects);
+  TEST_ASSERT_EQUAL_UINT32(1, Mock::dnsQueries);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(server.latencyMs * 1000, longest);
+
+  // Reconnecting within the TTL uses the cached address
+  client.reconnectNow();
+  run(client, 1000);
+  TEST_ASSERT_TRUE(client.isConnected());
+  TEST_ASSERT_EQUAL_UINT32(2, server.connects);
+  TEST_ASSERT_EQUAL_UINT32(1, Mock::dnsQueries);
+}
+
+static void test_blackholed_name_never_blocks() {
+  Mock::addServer(HOST, PORT).mode = Mock::HostMode::BLACKHOLE;
+  WebSocketClient client(&timer);
+  client.connect(NAME, PORT, "/socket.io/");
+
+  unsigned long longest = run(client, 10 * 60000UL);
+  char line[80];
+  snprintf(line, sizeof(line), "%u probes, %u DNS queries over 10 min",
+           (unsigned int)Mock::socketConnects.size(),
+           (unsigned int)Mock::dnsQueries);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_UINT32(0, longest);
+  TEST_ASSERT_FALSE(client.isConnected());
+
+  // Every probe went to the address, and the name was only looked up again
+  // once its 60 s TTL ran out
+  TEST_ASSERT_GREATER_OR_EQUAL(8, Mock::socketConnects.size());
+  for (const Mock::ConnectRecord &record : Mock::socketConnects) {
+    TEST_ASSERT_EQUAL_STRING(Mock::serverKey(HOST, PORT).c_str(),
+                             record.key.c_str());
+  }
+  TEST_ASSERT_LESS_THAN_UINT32(Mock::socketConnects.size(),
+                               Mock::dnsQueries);
+}
+
+static void test_dns_failures_never_block() {
+  Mock::addServer(HOST, PORT);
+
+  // Unknown name: answered at once with NXDOMAIN
+  WebSocketClient unknown(&timer);
+  unknown.connect("nowhere.lan", PORT, "/socket.io/");
+  TEST_ASSERT_EQUAL_UINT32(0, run(unknown, 60000));
+  TEST_ASSERT_FALSE(unknown.isConnected());
+  TEST_ASSERT_TRUE(Mock::socketConnects.empty());
+  unknown.disconnect();
+
+  // DNS server down: each attempt retransmits until the lookup times out
+  Mock::dnsDown = true;
+  Mock::dnsQueries = 0;
+  WebSocketClient client(&timer);
+  client.connect(NAME, PORT, "/socket.io/");
+  TEST_ASSERT_EQUAL_UINT32(0, run(client, 60000));
+  TEST_ASSERT_FALSE(client.isConnected());
+  TEST_ASSERT_TRUE(Mock::socketConnects.empty());
+  TEST_ASSERT_GREATER_THAN_UINT32(3, Mock::dnsQueries);
+
+  // And connects once it is back
+  Mock::dnsDown = false;
+  client.reconnectNow();
+  run(client, 1000);
+  TEST_ASSERT_TRUE(client.isConnected());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_name_resolved_then_connected);
+  RUN_TEST(test_blackholed_name_never_blocks);
+  RUN_TEST(test_dns_failures_never_block);
+  return UNITY_END();
+}
@@ -0,0 +1,134 @@
+/**
+ * Host test for failing over between two FightTimer servers
+ *
+ * The primary goes silent in the middle of a running bout. The heartbeat
+ * watchdog has to notice within the negotiated ping interval and timeout,
+ * the client has to move to the spare straight away, and the timer has to
+ * keep running through it.
+ */
+
+#include "ConfigStore.h"
+#include "Timer.h"
+#include "WebSocketClient.h"
+#include <unity.h>
+
+static const char *const PRIMARY = "10.0.0.1";
+static const char *const SPARE = "10.0.0.2";
+static const uint16_t PORT = 8765;
+static const uint32_t PING_INTERVAL_MS = 2000;
+static const uint32_t PING_TIMEOUT_MS = 1000;
+static const unsigned long MAX_STEP_MS = 5; // Simulated loop() period
+
+static Timer timer;
+
+void setUp() {
+  Mock::resetNetwork();
+  for (const char *host : {PRIMARY, SPARE}) {
+    Mock::Server &server = Mock::addServer(host, PORT);
+    server.pingIntervalMs = PING_INTERVAL_MS;
+    server.pingTimeoutMs = PING_TIMEOUT_MS;
+  }
+
+  ConfigStore::Config &config = ConfigStore::get();
+  ConfigStore::setDefaults(config);
+  config.wsSpareCount = 1;
+  config.wsSpares[0].port = PORT;
+  strlcpy(config.wsSpares[0].host, SPARE, sizeof(config.wsSpares[0].host));
+  strlcpy(config.wsSpares[0].path, "/socket.io/",
+          sizeof(config.wsSpares[0].path));
+  randomSeed(7);
+}
+void tearDown() {}
+
+static void step(WebSocketClient &client) {
+  client.poll();
+  Mock::advanceMs(1 + random(MAX_STEP_MS));
+}
+
+static void runFor(WebSocketClient &client, unsigned long ms) {
+  unsigned long end = millis() + ms;
+  while (millis() < end) {
+    step(client);
+  }
+}
+
+static unsigned long remainingMs() {
+  Timer::Components remaining = timer.getRemainingTime();
+  return (remaining.minutes * 60UL + remaining.seconds) * 1000UL +
+         remaining.milliseconds;
+}
+
+static void test_failover_keeps_timer_running() {
+  WebSocketClient client(&timer);
+  client.connect(PRIMARY, PORT, "/socket.io/");
+  runFor(client, 100);
+  TEST_ASSERT_TRUE(client.isConnected());
+  TEST_ASSERT_EQUAL_UINT8(0, client.getActiveUpstream());
+  TEST_ASSERT_EQUAL_UINT32(PING_INTERVAL_MS,
+                           client.getHeartbeatStats().pingIntervalMs);
+  TEST_ASSERT_EQUAL_UINT32(PING_TIMEOUT_MS,
+                           client.getHeartbeatStats().pingTimeoutMs);
+
+  // Start a five minute bout and let it run with healthy heartbeats
+  Mock::Server &primary = Mock::servers[Mock::serverKey(PRIMARY, PORT)];
+  primary.send("42[\"timer_update\",{\"action\":\"reset\",\"minutes\":5,"
+               "\"seconds\":0,\"seq\":1}]");
+  primary.send("42[\"timer_update\",{\"action\":\"start\",\"seq\":2}]");
+  unsigned long startedMs = millis(); // Applied in the next poll()
+  step(client);
+  TEST_ASSERT_TRUE(timer.isRunning());
+  TEST_ASSERT_EQUAL_UINT32(2, client.getAckStats().lastSeq);
+  runFor(client, 3 * PING_INTERVAL_MS);
+  TEST_ASSERT_TRUE(client.isConnected());
+  TEST_ASSERT_EQUAL_UINT32(0, client.getHeartbeatStats().timeouts);
+
+  // The primary crashes: no more pings, pongs or RSTs
+  primary.mode = Mock::HostMode::BLACKHOLE;
+  unsigned long failedMs = millis();
+  while (!(client.isConnected() && client.getActiveUpstream() == 1) &&
+         millis() - failedMs < 60000) {
+    step(client);
+  }
+  unsigned long failoverMs = millis() - failedMs;
+
+  char line[96];
+  snprintf(line, sizeof(line),
+           "Failover took %lu ms (ping interval %u ms, timeout %u ms)",
+           failoverMs, (unsigned int)PING_INTERVAL_MS,
+           (unsigned int)PING_TIMEOUT_MS);
+  TEST_MESSAGE(line);
+
+  // Dead link noticed within interval + timeout; the spare is probed and
+  // connected at once (a few loop periods for probe and handshake)
+  const WebSocketClient::HeartbeatStats &heartbeat =
+      client.getHeartbeatStats();
+  TEST_ASSERT_TRUE(client.isConnected());
+  TEST_ASSERT_EQUAL_UINT8(1, client.getActiveUpstream());
+  TEST_ASSERT_EQUAL_UINT32(1, heartbeat.timeouts);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(heartbeat.pingIntervalMs +
+                                       heartbeat.pingTimeoutMs +
+                                       10 * MAX_STEP_MS,
+                                   failoverMs);
+  TEST_ASSERT_EQUAL_UINT32(1, client.getFailovers());
+  TEST_ASSERT_EQUAL_UINT32(1, client.getUpstream(0).heartbeatMisses);
+  TEST_ASSERT_EQUAL_UINT32(1, client.getUpstream(1).connects);
+
+  // The bout carried on through the failover, to the millisecond
+  TEST_ASSERT_TRUE(timer.isRunning());
+  TEST_ASSERT_EQUAL_UINT32(5 * 60000UL - (millis() - startedMs),
+                           remainingMs());
+
+  // And the spare's commands are applied
+  Mock::Server &spare = Mock::servers[Mock::serverKey(SPARE, PORT)];
+  spare.send("42[\"timer_update\",{\"action\":\"stop\",\"seq\":3}]");
+  runFor(client, 50);
+  TEST_ASSERT_FALSE(timer.isRunning());
+  TEST_ASSERT_EQUAL_UINT32(3, client.getAckStats().lastSeq);
+  TEST_ASSERT_TRUE(spare.lastReceived.find("\"seq\":3") != std::string::npos);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_failover_keeps_timer_running);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+/**
+ * Host benchmark for the WebSocket message path
+ *
+ * Replays a FightTimer session through WebSocketClient::replayFrame() (the
+ * same handling live frames get, minus the acks) many times over, and
+ * reports messages per second, heap allocations and the JSON pool peak.
+ * Parsing must not touch the heap and the timer must end up where the
+ * session left it.
+ */
+
+#include "ConfigStore.h"
+#include "HeapCounter.h"
+#include "Timer.h"
+#include "WebSocketClient.h"
+#include <chrono>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+// A bout as the FightTimer controller sends it: Socket.IO handshake and
+// pings (ignored by a replay), timer commands as Socket.IO events, plain
+// JSON and wrapped objects, settings and events for other clients
+static const char *const SESSION[] = {
+    "0{\"sid\":\"Xk2jA\",\"upgrades\":[],\"pingInterval\":25000,"
+    "\"pingTimeout\":20000,\"maxPayload\":1000000}",
+    "40{\"sid\":\"q8Lmz\"}",
+    "42[\"timer_update\",{\"action\":\"settings\",\"seq\":1,"
+    "\"settings\":{\"endMessage\":\"TIME\",\"theme\":\"dark\","
+    "\"sound\":true}}]",
+    "42[\"timer_update\",{\"action\":\"reset\",\"minutes\":5,\"seconds\":0,"
+    "\"seq\":2,\"arena\":\"Cage 1\",\"round\":1}]",
+    "42[\"timer_update\",{\"action\":\"start\",\"seq\":3,"
+    "\"sentAt\":1718035200123}]",
+    "2",
+    "42[\"scoreboard\",{\"red\":12,\"blue\":9,\"fouls\":[\"red\",\"blue\"]}]",
+    "42[\"timer_update\",{\"action\":\"stop\",\"seq\":4}]",
+    "{\"action\":\"start\",\"seq\":5}",
+    "2",
+    "{\"timer_update\":{\"action\":\"stop\",\"seq\":6}}",
+    "42[\"timer_update\",{\"action\":\"reset\",\"minutes\":3,\"seconds\":30,"
+    "\"seq\":7,\"arena\":\"Cage 1\",\"round\":2,\"notes\":\"Judges' decision "
+    "pending, next bout on deck\"}]",
+    "42[\"timer_update\",{\"action\":\"start\",\"seq\":8}]",
+};
+
+static Timer timer;
+
+void setUp() { ConfigStore::setDefaults(ConfigStore::get()); }
+void tearDown() {}
+
+static void replay(WebSocketClient &client,
+                   const std::vector<std::string> &frames) {
+  for (const std::string &frame : frames) {
+    client.replayFrame(WStype_TEXT,
+                       reinterpret_cast<const uint8_t *>(frame.data()),
+                       frame.size());
+  }
+}
+
+static void test_session_drives_timer() {
+  WebSocketClient client(&timer);
+  std::vector<std::string> frames(std::begin(SESSION), std::end(SESSION));
+
+  Mock::advanceMs(1000);
+  replay(client, frames);
+  Mock::advanceMs(1500);
+
+  Timer::Components remaining = timer.getRemainingTime();
+  TEST_ASSERT_TRUE(timer.isRunning());
+  TEST_ASSERT_EQUAL_UINT(3, remaining.minutes);
+  TEST_ASSERT_EQUAL_UINT(28, remaining.seconds);
+  TEST_ASSERT_EQUAL_UINT(500, remaining.milliseconds);
+  TEST_ASSERT_EQUAL_UINT32(0, client.getParserStats().parseErrors);
+  // Nothing is acknowledged for replayed commands
+  TEST_ASSERT_EQUAL_UINT32(0, client.getAckStats().commands);
+}
+
+static void test_replay_throughput_without_heap() {
+  const int rounds = 5000;
+  WebSocketClient client(&timer);
+  std::vector<std::string> frames(std::begin(SESSION), std::end(SESSION));
+  size_t bytes = 0;
+  for (const std::string &frame : frames) {
+    bytes += frame.size();
+  }
+
+  replay(client, frames); // Warm up
+  HeapCounter::reset();
+  size_t liveBefore = HeapCounter::live;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    replay(client, frames);
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  size_t allocations = HeapCounter::allocations;
+  size_t peakGrowth = HeapCounter::peak - liveBefore;
+
+  double messages = (double)rounds * frames.size();
+  char line[160];
+  snprintf(line, sizeof(line),
+           "%.0f frames in %.1f ms: %.0f msg/s, %.1f MB/s, %u heap "
+           "allocations, JSON pool peak %u of %u bytes",
+           messages, elapsed * 1000, messages / elapsed,
+           rounds * bytes / elapsed / 1e6, (unsigned int)allocations,
+           (unsigned int)client.getJsonPoolPeak(), WS_JSON_POOL_SIZE);
+  TEST_MESSAGE(line);
+
+  TEST_ASSERT_EQUAL_size_t(0, allocations);
+  TEST_ASSERT_EQUAL_size_t(0, peakGrowth);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(WS_JSON_POOL_SIZE / 2,
+                                   client.getJsonPoolPeak());
+  TEST_ASSERT_EQUAL_UINT32(0, client.getParserStats().parseErrors);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_session_drives_timer);
+  RUN_TEST(test_replay_throughput_without_heap);
+  return UNITY_END();
+}